@@ -0,0 +1,147 @@
+// AccelCalibration.cpp
+#include "AccelCalibration.h"
+
+#include <math.h>
+
+namespace {
+
+// Ось и знак g для положения: X вверх - +1 g по X и т.д.
+const uint8_t POSITION_AXIS[AccelCalibration::POSITION_COUNT] = {0, 0, 1,
+                                                                 1, 2, 2};
+const float POSITION_SIGN[AccelCalibration::POSITION_COUNT] = {
+    1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f};
+
+}  // namespace
+
+AccelCalibration::AccelCalibration()
+    : status(STATUS_IDLE),
+      position(POS_X_UP),
+      capturedMask(0),
+      startMs(0),
+      count(0),
+      restarts(0) {
+  reset();
+}
+
+void AccelCalibration::start(Position p, uint32_t nowMs) {
+  if (p >= POSITION_COUNT) return;
+
+  position = p;
+  capturedMask &= ~(1 << p);
+  status = STATUS_CAPTURING;
+  restarts = 0;
+  restart(nowMs);
+}
+
+void AccelCalibration::restart(uint32_t nowMs) {
+  startMs = nowMs;
+  count = 0;
+  sum[0] = sum[1] = sum[2] = 0.0;
+}
+
+bool AccelCalibration::addSample(float x, float y, float z,
+                                 float motionLevel, uint32_t nowMs) {
+  if (status != STATUS_CAPTURING) return false;
+
+  if (motionLevel > MAX_MOTION_LEVEL) {
+    if (count > 0) restarts++;
+    restart(nowMs);
+    return false;
+  }
+
+  sum[0] += x;
+  sum[1] += y;
+  sum[2] += z;
+  count++;
+  if (nowMs - startMs < CAPTURE_MS || count < MIN_CAPTURE_SAMPLES) {
+    return false;
+  }
+
+  float mean[3];
+  for (int axis = 0; axis < 3; axis++) mean[axis] = sum[axis] / count;
+
+  // Положение перепутано - сохранять нельзя, иначе поправка будет мусором
+  uint8_t axis = POSITION_AXIS[position];
+  if (mean[axis] * POSITION_SIGN[position] < MIN_AXIS_FRACTION * GRAVITY) {
+    status = STATUS_WRONG_AXIS;
+    return true;
+  }
+
+  for (int i = 0; i < 3; i++) means[position][i] = mean[i];
+  capturedMask |= 1 << position;
+  status = STATUS_CAPTURED;
+  return true;
+}
+
+void AccelCalibration::reset() {
+  status = STATUS_IDLE;
+  capturedMask = 0;
+  restarts = 0;
+  for (int p = 0; p < POSITION_COUNT; p++) {
+    means[p][0] = means[p][1] = means[p][2] = 0.0f;
+  }
+  restart(0);
+}
+
+float AccelCalibration::getProgress(uint32_t nowMs) const {
+  if (status != STATUS_CAPTURING) return hasPosition(position) ? 1.0f : 0.0f;
+
+  float progress = (float)(nowMs - startMs) / CAPTURE_MS;
+  return progress < 1.0f ? progress : 1.0f;
+}
+
+uint8_t AccelCalibration::getCapturedCount() const {
+  uint8_t n = 0;
+  for (int p = 0; p < POSITION_COUNT; p++) {
+    if (hasPosition((Position)p)) n++;
+  }
+  return n;
+}
+
+AccelCalibration::SolveResult AccelCalibration::solve(
+    AccelCorrection& out) const {
+  if (getCapturedCount() != POSITION_COUNT) return SOLVE_INCOMPLETE;
+
+  AccelCorrection c;
+  for (int axis = 0; axis < 3; axis++) {
+    float up = means[2 * axis][axis];
+    float down = means[2 * axis + 1][axis];
+    c.bias[axis] = 0.5f * (up + down);
+    c.scale[axis] = 2.0f * GRAVITY / (up - down);
+  }
+
+  if (!isValid(c)) return SOLVE_OUT_OF_RANGE;
+  out = c;
+  return SOLVE_OK;
+}
+
+bool AccelCalibration::isValid(const AccelCorrection& c) {
+  for (int axis = 0; axis < 3; axis++) {
+    // !(a <= b) заодно отсекает NaN
+    if (!(fabsf(c.bias[axis]) <= MAX_BIAS) ||
+        !(c.scale[axis] >= MIN_SCALE && c.scale[axis] <= MAX_SCALE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const char* AccelCalibration::positionName(Position p) {
+  static const char* const NAMES[POSITION_COUNT] = {
+      "x_up", "x_down", "y_up", "y_down", "z_up", "z_down"};
+  return p < POSITION_COUNT ? NAMES[p] : "unknown";
+}
+
+const char* AccelCalibration::statusName(Status s) {
+  switch (s) {
+    case STATUS_IDLE:
+      return "idle";
+    case STATUS_CAPTURING:
+      return "capturing";
+    case STATUS_CAPTURED:
+      return "captured";
+    case STATUS_WRONG_AXIS:
+      return "wrong_axis";
+  }
+  return "unknown";
+}
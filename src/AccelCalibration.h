@@ -0,0 +1,141 @@
+// AccelCalibration.h
+// Калибровка акселерометра по шести положениям: смещение и масштаб осей
+
+#ifndef ACCEL_CALIBRATION_H
+#define ACCEL_CALIBRATION_H
+
+#include <stdint.h>
+
+/**
+ * @brief Поправка осей акселерометра: a = (raw - bias) * scale
+ *
+ * В горячем пути хранится как scale и offset = -bias * scale: одно
+ * умножение-сложение (fmaf) на ось.
+ */
+struct AccelCorrection {
+  float bias[3];   // Показание при 0 g (м/с²)
+  float scale[3];  // Множитель к показанию без смещения
+
+  static AccelCorrection identity() {
+    AccelCorrection c = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+    return c;
+  }
+
+  bool isIdentity() const {
+    for (int axis = 0; axis < 3; axis++) {
+      if (bias[axis] != 0.0f || scale[axis] != 1.0f) return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief Сбор шести неподвижных положений и расчёт поправки
+ *
+ * Каждая ось по очереди смотрит вверх и вниз (±1 g). Среднее показание
+ * положения копится CAPTURE_MS; при движении накопление начинается заново.
+ * По паре положений оси: bias = (up + down) / 2, scale = 2g / (up - down).
+ * Не зависит от железа - работает и на ПК с симулятором.
+ */
+class AccelCalibration {
+ public:
+  enum Position : uint8_t {
+    POS_X_UP,
+    POS_X_DOWN,
+    POS_Y_UP,
+    POS_Y_DOWN,
+    POS_Z_UP,
+    POS_Z_DOWN,
+    POSITION_COUNT
+  };
+
+  enum Status : uint8_t {
+    STATUS_IDLE,       // Ничего не копится
+    STATUS_CAPTURING,  // Идёт накопление
+    STATUS_CAPTURED,   // Положение сохранено
+    STATUS_WRONG_AXIS  // Вниз/вверх смотрит не та ось - не сохранено
+  };
+
+  enum SolveResult : uint8_t {
+    SOLVE_OK,
+    SOLVE_INCOMPLETE,   // Сняты не все шесть положений
+    SOLVE_OUT_OF_RANGE  // Смещение или масштаб вне допустимого
+  };
+
+  static constexpr float GRAVITY = 9.80665f;  // м/с², как Lsm303::GRAVITY
+
+  // Накопление положения: не короче CAPTURE_MS и MIN_CAPTURE_SAMPLES
+  static const uint16_t CAPTURE_MS = 2000;
+  static const uint16_t MIN_CAPTURE_SAMPLES = 10;
+
+  // Уровень движения (SensorPipeline::getMotionLevel), выше - не покой
+  static constexpr float MAX_MOTION_LEVEL = 0.05f;
+
+  // Ось положения должна давать хотя бы столько от 1 g
+  static constexpr float MIN_AXIS_FRACTION = 0.8f;
+
+  // Допуски поправки (LSM303DLHC: смещение нуля до ±60 mg, масштаб ±10%)
+  static constexpr float MAX_BIAS = 0.25f * GRAVITY;
+  static constexpr float MIN_SCALE = 0.8f;
+  static constexpr float MAX_SCALE = 1.2f;
+
+  AccelCalibration();
+
+  /**
+   * @brief Начать накопление положения (прежнее значение отбрасывается)
+   */
+  void start(Position position, uint32_t nowMs);
+
+  /**
+   * @brief Сэмпл без поправки (м/с²) и текущий уровень движения
+   * @return true - накопление положения завершилось на этом сэмпле
+   */
+  bool addSample(float x, float y, float z, float motionLevel,
+                 uint32_t nowMs);
+
+  /**
+   * @brief Забыть все положения и прервать накопление
+   */
+  void reset();
+
+  Status getStatus() const { return status; }
+  bool isCapturing() const { return status == STATUS_CAPTURING; }
+  Position getPosition() const { return position; }
+
+  // Доля накопления 0..1 и число перезапусков из-за движения
+  float getProgress(uint32_t nowMs) const;
+  uint16_t getRestarts() const { return restarts; }
+
+  bool hasPosition(Position p) const { return (capturedMask >> p) & 1; }
+  uint8_t getCapturedCount() const;
+  const float* getMean(Position p) const { return means[p]; }
+
+  /**
+   * @brief Поправка по шести положениям
+   */
+  SolveResult solve(AccelCorrection& out) const;
+
+  /**
+   * @brief Поправка в допустимых пределах (в т.ч. прочитанная из файла)
+   */
+  static bool isValid(const AccelCorrection& correction);
+
+  static const char* positionName(Position p);
+  static const char* statusName(Status s);
+
+ private:
+  Status status;
+  Position position;
+  uint8_t capturedMask;
+  float means[POSITION_COUNT][3];
+
+  // Текущее накопление
+  uint32_t startMs;
+  uint16_t count;
+  uint16_t restarts;
+  double sum[3];
+
+  void restart(uint32_t nowMs);
+};
+
+#endif  // ACCEL_CALIBRATION_H
@@ -0,0 +1,70 @@
+// AngleSnapshot.h
+// Lock-free снимок последнего угла для чтения из другой задачи/таймера
+
+#ifndef ANGLE_SNAPSHOT_H
+#define ANGLE_SNAPSHOT_H
+
+#include <stdint.h>
+
+#include <atomic>
+
+/**
+ * @brief Последний угол и время его измерения (seqlock)
+ *
+ * Один писатель (SensorManager::update() в loop), любое число читателей
+ * (например, таймер индикатора). Писатель никогда не ждёт, читатель
+ * повторяет чтение, если попал на запись.
+ */
+class AngleSnapshot {
+ public:
+  AngleSnapshot() : sequence(0), angle(0.0f), sampleMicros(0) {}
+
+  /**
+   * @brief Опубликовать новое значение (только из одной задачи)
+   * @param value Угол (градусы)
+   * @param timestampMicros micros() момента чтения датчика
+   */
+  void publish(float value, uint32_t timestampMicros) {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);  // Нечётное = запись
+    std::atomic_thread_fence(std::memory_order_release);
+
+    angle.store(value, std::memory_order_relaxed);
+    sampleMicros.store(timestampMicros, std::memory_order_relaxed);
+
+    sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Прочитать согласованную пару (угол, время)
+   * @return false если значение ещё не публиковалось или писатель
+   *         мешал все попытки подряд
+   */
+  bool read(float& value, uint32_t& timestampMicros) const {
+    for (uint8_t attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      if (before == 0) return false;  // Ещё нет данных
+      if (before & 1) continue;       // Идёт запись
+
+      float v = angle.load(std::memory_order_relaxed);
+      uint32_t t = sampleMicros.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == before) {
+        value = v;
+        timestampMicros = t;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static const uint8_t MAX_READ_ATTEMPTS = 4;
+
+  std::atomic<uint32_t> sequence;
+  std::atomic<float> angle;
+  std::atomic<uint32_t> sampleMicros;
+};
+
+#endif  // ANGLE_SNAPSHOT_H
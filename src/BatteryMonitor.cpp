@@ -0,0 +1,123 @@
+// BatteryMonitor.cpp
+#include "BatteryMonitor.h"
+
+namespace {
+
+// Кривая разряда 1S Li-ion при малом токе: напряжение (В) -> заряд (%)
+struct CurvePoint {
+  float volts;
+  float percent;
+};
+
+const CurvePoint DISCHARGE_CURVE[] = {
+    {3.27f, 0.0f},   {3.61f, 5.0f},   {3.69f, 10.0f},  {3.71f, 15.0f},
+    {3.73f, 20.0f},  {3.75f, 25.0f},  {3.77f, 30.0f},  {3.79f, 35.0f},
+    {3.80f, 40.0f},  {3.82f, 45.0f},  {3.84f, 50.0f},  {3.85f, 55.0f},
+    {3.87f, 60.0f},  {3.91f, 65.0f},  {3.95f, 70.0f},  {3.98f, 75.0f},
+    {4.02f, 80.0f},  {4.08f, 85.0f},  {4.11f, 90.0f},  {4.15f, 95.0f},
+    {4.20f, 100.0f},
+};
+
+const uint8_t CURVE_POINTS =
+    sizeof(DISCHARGE_CURVE) / sizeof(DISCHARGE_CURVE[0]);
+
+const uint32_t DEFAULT_VREF_MV = 1100;  // Если в eFuse нет калибровки
+
+}  // namespace
+
+BatteryMonitor::BatteryMonitor(uint8_t pin, float dividerRatio)
+    : pin(pin),
+      dividerRatio(dividerRatio),
+      channel(ADC1_CHANNEL_MAX),
+      calibrationSource(ESP_ADC_CAL_VAL_DEFAULT_VREF),
+      configured(false),
+      voltage(0.0f),
+      percentage(0.0f),
+      rawAdc(0),
+      samples(0),
+      lowReported(false) {
+  memset(&calibration, 0, sizeof(calibration));
+}
+
+bool BatteryMonitor::begin() {
+  int8_t analogChannel = digitalPinToAnalogChannel(pin);
+  if (analogChannel < 0 || analogChannel >= ADC1_CHANNEL_MAX) {
+    Serial.printf("ERROR: GPIO%u is not an ADC1 pin\n", pin);
+    return false;
+  }
+  channel = (adc1_channel_t)analogChannel;
+
+  adc1_config_width(ADC_WIDTH_BIT_12);
+  adc1_config_channel_atten(channel, ADC_ATTEN_DB_11);  // До ~3.1 В на входе
+  calibrationSource =
+      esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                               DEFAULT_VREF_MV, &calibration);
+  configured = true;
+
+  sample();
+  Serial.printf("Battery monitor: GPIO%u, calibration %s, %.2f V (%.0f%%)\n",
+                pin, getCalibrationName(), voltage, percentage);
+  return true;
+}
+
+void BatteryMonitor::sample() {
+  if (!configured) return;
+
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < OVERSAMPLING; i++) {
+    sum += adc1_get_raw(channel);
+  }
+  rawAdc = (sum + OVERSAMPLING / 2) / OVERSAMPLING;
+
+  uint32_t millivolts = esp_adc_cal_raw_to_voltage(rawAdc, &calibration);
+  float measured = millivolts * dividerRatio / 1000.0f;
+
+  // Первый замер - сразу, дальше сглаживание
+  voltage = samples == 0 ? measured
+                         : voltage + FILTER_ALPHA * (measured - voltage);
+  percentage = voltageToPercent(voltage);
+  samples++;
+
+  // Предупреждение один раз при переходе через порог (с запасом 2%)
+  if (isLow() && !lowReported) {
+    Serial.printf("WARNING: Low battery! %.1f%% (%.2fV)\n", percentage,
+                  voltage);
+    lowReported = true;
+  } else if (percentage > LOW_PERCENT + 2.0f) {
+    lowReported = false;
+  }
+}
+
+const char* BatteryMonitor::getStatus() const {
+  if (!isValid()) return "unknown";
+  if (percentage >= 99.0f) return "full";
+  if (voltage > 4.1f) return "charging";
+  return "discharging";
+}
+
+const char* BatteryMonitor::getCalibrationName() const {
+  switch (calibrationSource) {
+    case ESP_ADC_CAL_VAL_EFUSE_VREF:
+      return "eFuse Vref";
+    case ESP_ADC_CAL_VAL_EFUSE_TP:
+      return "eFuse two point";
+    case ESP_ADC_CAL_VAL_DEFAULT_VREF:
+    default:
+      return "default Vref";
+  }
+}
+
+float BatteryMonitor::voltageToPercent(float volts) {
+  if (volts <= DISCHARGE_CURVE[0].volts) return 0.0f;
+  if (volts >= DISCHARGE_CURVE[CURVE_POINTS - 1].volts) return 100.0f;
+
+  for (uint8_t i = 1; i < CURVE_POINTS; i++) {
+    const CurvePoint& upper = DISCHARGE_CURVE[i];
+    if (volts <= upper.volts) {
+      const CurvePoint& lower = DISCHARGE_CURVE[i - 1];
+      float t = (volts - lower.volts) / (upper.volts - lower.volts);
+      return lower.percent + t * (upper.percent - lower.percent);
+    }
+  }
+  return 100.0f;
+}
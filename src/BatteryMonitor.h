@@ -0,0 +1,81 @@
+// BatteryMonitor.h
+// Фоновое измерение напряжения аккумулятора (калиброванный ADC1)
+
+#ifndef BATTERY_MONITOR_H
+#define BATTERY_MONITOR_H
+
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+/**
+ * @brief Напряжение и заряд Li-ion аккумулятора
+ *
+ * sample() вызывается планировщиком: OVERSAMPLING чтений ADC усредняются,
+ * переводятся в милливольты по калибровке из eFuse и сглаживаются
+ * экспоненциальным фильтром. HTTP обработчики читают только кеш.
+ */
+class BatteryMonitor {
+ public:
+  static const uint8_t OVERSAMPLING = 16;
+  static constexpr float FILTER_ALPHA = 0.2f;      // Вес нового замера
+  static constexpr float LOW_PERCENT = 20.0f;      // Предупреждение
+  static constexpr float CRITICAL_PERCENT = 10.0f;
+
+  /**
+   * @param pin GPIO с делителем (только ADC1: ADC2 занят WiFi)
+   * @param dividerRatio Во сколько раз делитель уменьшает напряжение
+   */
+  BatteryMonitor(uint8_t pin, float dividerRatio);
+
+  /**
+   * @brief Настроить ADC и калибровку, сделать первый замер
+   */
+  bool begin();
+
+  /**
+   * @brief Один замер с oversampling (для задачи планировщика)
+   */
+  void sample();
+
+  bool isValid() const { return samples > 0; }
+  float getVoltage() const { return voltage; }      // Сглаженное, В
+  float getPercentage() const { return percentage; }
+  uint16_t getRawAdc() const { return rawAdc; }      // Среднее за замер
+  uint32_t getSampleCount() const { return samples; }
+  bool isLow() const { return isValid() && percentage < LOW_PERCENT; }
+  bool isCritical() const {
+    return isValid() && percentage < CRITICAL_PERCENT;
+  }
+
+  /**
+   * @brief "full", "charging", "discharging" или "unknown"
+   */
+  const char* getStatus() const;
+
+  /**
+   * @brief Источник калибровки ADC ("eFuse Vref", "eFuse two point", ...)
+   */
+  const char* getCalibrationName() const;
+
+  /**
+   * @brief Заряд по кривой разряда Li-ion (линейно между точками)
+   */
+  static float voltageToPercent(float volts);
+
+ private:
+  uint8_t pin;
+  float dividerRatio;
+  adc1_channel_t channel;
+  esp_adc_cal_characteristics_t calibration;
+  esp_adc_cal_value_t calibrationSource;
+  bool configured;
+
+  float voltage;
+  float percentage;
+  uint16_t rawAdc;
+  uint32_t samples;
+  bool lowReported;
+};
+
+#endif  // BATTERY_MONITOR_H
@@ -7,4 +7,26 @@
 float ConfigManager::cachedLevelMin = ConfigManager::DEFAULT_LEVEL_MIN;
 float ConfigManager::cachedLevelMax = ConfigManager::DEFAULT_LEVEL_MAX;
 float ConfigManager::cachedZeroOffset = ConfigManager::DEFAULT_ZERO_OFFSET;
-bool ConfigManager::cachedAxisSwap = ConfigManager::DEFAULT_AXIS_SWAP;
\ No newline at end of file
+bool ConfigManager::cachedAxisSwap = ConfigManager::DEFAULT_AXIS_SWAP;
+uint16_t ConfigManager::cachedFadeTimeMs = ConfigManager::DEFAULT_FADE_TIME_MS;
+float ConfigManager::cachedHysteresisLow = ConfigManager::DEFAULT_HYSTERESIS;
+float ConfigManager::cachedHysteresisHigh = ConfigManager::DEFAULT_HYSTERESIS;
+uint16_t ConfigManager::cachedWsIntervalMs =
+    ConfigManager::DEFAULT_WS_INTERVAL_MS;
+uint8_t ConfigManager::cachedUdpMode = ConfigManager::DEFAULT_UDP_MODE;
+uint16_t ConfigManager::cachedUdpPort = ConfigManager::DEFAULT_UDP_PORT;
+uint16_t ConfigManager::cachedSleepAfterS =
+    ConfigManager::DEFAULT_SLEEP_AFTER_S;
+uint16_t ConfigManager::cachedRecordIntervalMs =
+    ConfigManager::DEFAULT_RECORD_INTERVAL_MS;
+AccelCorrection ConfigManager::cachedAccelCorrection =
+    AccelCorrection::identity();
+bool ConfigManager::cachedHeadingEnabled =
+    ConfigManager::DEFAULT_HEADING_ENABLED;
+MagCorrection ConfigManager::cachedMagCorrection = MagCorrection::identity();
+uint8_t ConfigManager::cachedOrientationEngine =
+    ConfigManager::DEFAULT_ORIENTATION_ENGINE;
+uint8_t ConfigManager::cachedOutlierMode = ConfigManager::DEFAULT_OUTLIER_MODE;
+
+uint32_t ConfigManager::flashWrites = 0;
+HalFileSystem* ConfigManager::fileSystem = nullptr;
\ No newline at end of file
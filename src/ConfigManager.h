@@ -5,9 +5,12 @@
 #define CONFIG_MANAGER_H
 
 #include <Arduino.h>
-#include <LittleFS.h>
 
-#include "FileManager.h"
+#include "AccelCalibration.h"
+#include "Hal.h"
+#include "MagCalibration.h"
+#include "OrientationEngine.h"
+#include "OutlierRejector.h"
 
 class ConfigManager {
  public:
@@ -16,12 +19,43 @@ class ConfigManager {
   static constexpr float DEFAULT_LEVEL_MAX = 5.0f;
   static constexpr float DEFAULT_ZERO_OFFSET = 0.0f;
   static constexpr bool DEFAULT_AXIS_SWAP = false;
+  static constexpr uint16_t DEFAULT_FADE_TIME_MS = 0;  // 0 = по профилю
+  static constexpr uint16_t MAX_FADE_TIME_MS = 2000;
+  static constexpr float DEFAULT_HYSTERESIS = 0.3f;  // Градусы
+  static constexpr float MAX_HYSTERESIS = 5.0f;
+  static constexpr uint16_t DEFAULT_WS_INTERVAL_MS = 200;  // 5 Hz
+  static constexpr uint16_t MIN_WS_INTERVAL_MS = 50;
+  static constexpr uint16_t MAX_WS_INTERVAL_MS = 5000;
+  static constexpr uint8_t DEFAULT_UDP_MODE = 0;  // 0 = выкл
+  static constexpr uint8_t MAX_UDP_MODE = 2;      // 1 = broadcast, 2 = multicast
+  static constexpr uint16_t DEFAULT_UDP_PORT = 4210;
+  static constexpr uint16_t MIN_UDP_PORT = 1024;
+  static constexpr uint16_t DEFAULT_SLEEP_AFTER_S = 300;  // 0 = без сна
+  static constexpr uint16_t DEFAULT_RECORD_INTERVAL_MS = 0;  // 0 = выкл
+  static constexpr uint16_t MIN_RECORD_INTERVAL_MS = 20;     // Сэмпл датчика
+  static constexpr uint16_t MAX_RECORD_INTERVAL_MS = 60000;
+  static constexpr bool DEFAULT_HEADING_ENABLED = false;  // Без магнитометра
+  static constexpr uint8_t DEFAULT_ORIENTATION_ENGINE = ORIENTATION_ENGINE;
+  static constexpr uint8_t DEFAULT_OUTLIER_MODE = OutlierRejector::OFF;
 
   // Пути к файлам
   static constexpr const char* LEVEL_MIN_PATH = "/level_min.txt";
   static constexpr const char* LEVEL_MAX_PATH = "/level_max.txt";
   static constexpr const char* ZERO_OFFSET_PATH = "/zero_offset.txt";
   static constexpr const char* AXIS_SWAP_PATH = "/axis_swap.txt";
+  static constexpr const char* FADE_TIME_PATH = "/fade_ms.txt";
+  static constexpr const char* HYSTERESIS_LOW_PATH = "/hyst_low.txt";
+  static constexpr const char* HYSTERESIS_HIGH_PATH = "/hyst_high.txt";
+  static constexpr const char* WS_INTERVAL_PATH = "/ws_interval.txt";
+  static constexpr const char* UDP_MODE_PATH = "/udp_mode.txt";
+  static constexpr const char* UDP_PORT_PATH = "/udp_port.txt";
+  static constexpr const char* SLEEP_AFTER_PATH = "/sleep_after.txt";
+  static constexpr const char* RECORD_INTERVAL_PATH = "/record_interval.txt";
+  static constexpr const char* ACCEL_CAL_PATH = "/accel_cal.txt";
+  static constexpr const char* HEADING_PATH = "/heading.txt";
+  static constexpr const char* MAG_CAL_PATH = "/mag_cal.txt";
+  static constexpr const char* ORIENTATION_PATH = "/orientation.txt";
+  static constexpr const char* OUTLIER_PATH = "/outlier.txt";
   static constexpr const char* GATEWAY_PATH = "/gateway.txt";
   static constexpr const char* IP_PATH = "/ip.txt";
   static constexpr const char* SSID_PATH = "/ssid.txt";
@@ -30,9 +64,11 @@ class ConfigManager {
   /**
    * @brief Инициализация конфигурации
    * Создаёт файлы с дефолтными значениями и загружает в кеш
+   * @param fs Файловая система настроек (должна жить всё время работы)
    */
-  static void initialize() {
+  static void initialize(HalFileSystem& fs) {
     Serial.println("=== Initializing Configuration ===");
+    fileSystem = &fs;
 
     // Создаём файлы если не существуют
     initializeFiles();
@@ -54,6 +90,17 @@ class ConfigManager {
     writeFloatToFile(LEVEL_MAX_PATH, DEFAULT_LEVEL_MAX);
     writeFloatToFile(ZERO_OFFSET_PATH, DEFAULT_ZERO_OFFSET);
     writeBoolToFile(AXIS_SWAP_PATH, DEFAULT_AXIS_SWAP);
+    writeIntToFile(FADE_TIME_PATH, DEFAULT_FADE_TIME_MS);
+    writeFloatToFile(HYSTERESIS_LOW_PATH, DEFAULT_HYSTERESIS);
+    writeFloatToFile(HYSTERESIS_HIGH_PATH, DEFAULT_HYSTERESIS);
+    writeIntToFile(WS_INTERVAL_PATH, DEFAULT_WS_INTERVAL_MS);
+    writeIntToFile(UDP_MODE_PATH, DEFAULT_UDP_MODE);
+    writeIntToFile(UDP_PORT_PATH, DEFAULT_UDP_PORT);
+    writeIntToFile(SLEEP_AFTER_PATH, DEFAULT_SLEEP_AFTER_S);
+    writeIntToFile(RECORD_INTERVAL_PATH, DEFAULT_RECORD_INTERVAL_MS);
+    writeBoolToFile(HEADING_PATH, DEFAULT_HEADING_ENABLED);
+    writeIntToFile(ORIENTATION_PATH, DEFAULT_ORIENTATION_ENGINE);
+    writeIntToFile(OUTLIER_PATH, DEFAULT_OUTLIER_MODE);
 
     // Сбрасываем строковые настройки к пустым значениям
     writeStringToFile(GATEWAY_PATH, "");
@@ -66,6 +113,19 @@ class ConfigManager {
     cachedLevelMax = DEFAULT_LEVEL_MAX;
     cachedZeroOffset = DEFAULT_ZERO_OFFSET;
     cachedAxisSwap = DEFAULT_AXIS_SWAP;
+    cachedFadeTimeMs = DEFAULT_FADE_TIME_MS;
+    cachedHysteresisLow = DEFAULT_HYSTERESIS;
+    cachedHysteresisHigh = DEFAULT_HYSTERESIS;
+    cachedWsIntervalMs = DEFAULT_WS_INTERVAL_MS;
+    cachedUdpMode = DEFAULT_UDP_MODE;
+    cachedUdpPort = DEFAULT_UDP_PORT;
+    cachedSleepAfterS = DEFAULT_SLEEP_AFTER_S;
+    cachedRecordIntervalMs = DEFAULT_RECORD_INTERVAL_MS;
+    cachedHeadingEnabled = DEFAULT_HEADING_ENABLED;
+    cachedOrientationEngine = DEFAULT_ORIENTATION_ENGINE;
+    cachedOutlierMode = DEFAULT_OUTLIER_MODE;
+
+    // Калибровки датчиков - свойство платы, а не настройка: остаются
 
     Serial.println("Configuration reset complete");
   }
@@ -79,6 +139,21 @@ class ConfigManager {
     Serial.printf("Level Max: %.1f°\n", cachedLevelMax);
     Serial.printf("Zero Offset: %.2f°\n", cachedZeroOffset);
     Serial.printf("Axis Swap: %s\n", cachedAxisSwap ? "ON" : "OFF");
+    Serial.printf("LED Fade: %u ms\n", cachedFadeTimeMs);
+    Serial.printf("Hysteresis: ±%.2f° / ±%.2f°\n", cachedHysteresisLow,
+                  cachedHysteresisHigh);
+    Serial.printf("WS Interval: %u ms\n", cachedWsIntervalMs);
+    Serial.printf("UDP Telemetry: mode %u, port %u\n", cachedUdpMode,
+                  cachedUdpPort);
+    Serial.printf("Light sleep after: %u s\n", cachedSleepAfterS);
+    Serial.printf("Record interval: %u ms\n", cachedRecordIntervalMs);
+    Serial.printf("Heading: %s\n", cachedHeadingEnabled ? "ON" : "OFF");
+    Serial.printf("Orientation: %s\n", OrientationEngine::typeName(
+                                           getOrientationEngine()));
+    Serial.printf("Outliers: %s\n",
+                  OutlierRejector::modeName(getOutlierMode()));
+    printAccelCorrection("");
+    printMagCorrection("");
     Serial.println("======================================\n");
   }
 
@@ -88,6 +163,32 @@ class ConfigManager {
   static float getLevelMax() { return cachedLevelMax; }
   static float getZeroOffset() { return cachedZeroOffset; }
   static bool getAxisSwap() { return cachedAxisSwap; }
+  static uint16_t getFadeTimeMs() { return cachedFadeTimeMs; }
+  static float getHysteresisLow() { return cachedHysteresisLow; }
+  static float getHysteresisHigh() { return cachedHysteresisHigh; }
+  static uint16_t getWsIntervalMs() { return cachedWsIntervalMs; }
+  static uint8_t getUdpMode() { return cachedUdpMode; }
+  static uint16_t getUdpPort() { return cachedUdpPort; }
+  static uint16_t getSleepAfterS() { return cachedSleepAfterS; }
+  static uint16_t getRecordIntervalMs() { return cachedRecordIntervalMs; }
+  static const AccelCorrection& getAccelCorrection() {
+    return cachedAccelCorrection;
+  }
+  static bool getHeadingEnabled() { return cachedHeadingEnabled; }
+  static const MagCorrection& getMagCorrection() {
+    return cachedMagCorrection;
+  }
+  static OrientationEngine::Type getOrientationEngine() {
+    return (OrientationEngine::Type)cachedOrientationEngine;
+  }
+  static OutlierRejector::Mode getOutlierMode() {
+    return (OutlierRejector::Mode)cachedOutlierMode;
+  }
+
+  /**
+   * @brief Количество записей файлов настроек (для метрик)
+   */
+  static uint32_t getFlashWrites() { return flashWrites; }
 
   // ========== СЕТТЕРЫ (обновляют кеш И файл) ==========
 
@@ -132,6 +233,126 @@ class ConfigManager {
     return writeBoolToFile(AXIS_SWAP_PATH, value);
   }
 
+  static bool setFadeTimeMs(uint16_t value) {
+    if (value > MAX_FADE_TIME_MS) {
+      Serial.printf("ERROR: Fade time must be 0..%u ms\n", MAX_FADE_TIME_MS);
+      return false;
+    }
+    cachedFadeTimeMs = value;
+    return writeIntToFile(FADE_TIME_PATH, value);
+  }
+
+  static bool setHysteresis(float low, float high) {
+    if (low < 0.0f || high < 0.0f || low > MAX_HYSTERESIS ||
+        high > MAX_HYSTERESIS) {
+      Serial.printf("ERROR: Hysteresis must be between 0 and %.1f\n",
+                    MAX_HYSTERESIS);
+      return false;
+    }
+    cachedHysteresisLow = low;
+    cachedHysteresisHigh = high;
+    writeFloatToFile(HYSTERESIS_LOW_PATH, low);
+    writeFloatToFile(HYSTERESIS_HIGH_PATH, high);
+    return true;
+  }
+
+  static bool setWsIntervalMs(uint16_t value) {
+    if (value < MIN_WS_INTERVAL_MS || value > MAX_WS_INTERVAL_MS) {
+      Serial.printf("ERROR: WS interval must be %u..%u ms\n",
+                    MIN_WS_INTERVAL_MS, MAX_WS_INTERVAL_MS);
+      return false;
+    }
+    cachedWsIntervalMs = value;
+    return writeIntToFile(WS_INTERVAL_PATH, value);
+  }
+
+  static bool setUdpTelemetry(uint8_t mode, uint16_t port) {
+    if (mode > MAX_UDP_MODE || port < MIN_UDP_PORT) {
+      Serial.printf("ERROR: UDP mode must be 0..%u, port >= %u\n",
+                    MAX_UDP_MODE, MIN_UDP_PORT);
+      return false;
+    }
+    cachedUdpMode = mode;
+    cachedUdpPort = port;
+    writeIntToFile(UDP_MODE_PATH, mode);
+    writeIntToFile(UDP_PORT_PATH, port);
+    return true;
+  }
+
+  static bool setSleepAfterS(uint16_t value) {
+    cachedSleepAfterS = value;
+    return writeIntToFile(SLEEP_AFTER_PATH, value);
+  }
+
+  // 0 выключает запись
+  static bool setRecordIntervalMs(uint16_t value) {
+    if (value != 0 &&
+        (value < MIN_RECORD_INTERVAL_MS || value > MAX_RECORD_INTERVAL_MS)) {
+      Serial.printf("ERROR: Record interval must be 0 or %u..%u ms\n",
+                    MIN_RECORD_INTERVAL_MS, MAX_RECORD_INTERVAL_MS);
+      return false;
+    }
+    cachedRecordIntervalMs = value;
+    return writeIntToFile(RECORD_INTERVAL_PATH, value);
+  }
+
+  // Одной строкой "bx by bz sx sy sz": шесть значений меняются вместе
+  static bool setAccelCorrection(const AccelCorrection& value) {
+    if (!AccelCalibration::isValid(value)) {
+      Serial.println("ERROR: Accel calibration out of range");
+      return false;
+    }
+    cachedAccelCorrection = value;
+
+    char buffer[ACCEL_CAL_BUFFER_SIZE];
+    snprintf(buffer, sizeof(buffer), "%.4f %.4f %.4f %.5f %.5f %.5f",
+             value.bias[0], value.bias[1], value.bias[2], value.scale[0],
+             value.scale[1], value.scale[2]);
+    return writeStringToFile(ACCEL_CAL_PATH, buffer);
+  }
+
+  static bool setHeadingEnabled(bool value) {
+    cachedHeadingEnabled = value;
+    return writeBoolToFile(HEADING_PATH, value);
+  }
+
+  // Одной строкой: смещение (3), затем матрица по строкам (9)
+  static bool setMagCorrection(const MagCorrection& value) {
+    if (!MagCalibration::isValid(value)) {
+      Serial.println("ERROR: Mag calibration out of range");
+      return false;
+    }
+    cachedMagCorrection = value;
+
+    const float* m = &value.matrix[0][0];
+    char buffer[MAG_CAL_BUFFER_SIZE];
+    int length = snprintf(buffer, sizeof(buffer), "%.3f %.3f %.3f",
+                          value.offset[0], value.offset[1], value.offset[2]);
+    for (int i = 0; i < 9; i++) {
+      length += snprintf(buffer + length, sizeof(buffer) - length, " %.5f",
+                         m[i]);
+    }
+    return writeStringToFile(MAG_CAL_PATH, buffer);
+  }
+
+  static bool setOrientationEngine(OrientationEngine::Type value) {
+    if (value >= OrientationEngine::TYPE_COUNT) {
+      Serial.println("ERROR: Unknown orientation engine");
+      return false;
+    }
+    cachedOrientationEngine = value;
+    return writeIntToFile(ORIENTATION_PATH, value);
+  }
+
+  static bool setOutlierMode(OutlierRejector::Mode value) {
+    if (value >= OutlierRejector::MODE_COUNT) {
+      Serial.println("ERROR: Unknown outlier mode");
+      return false;
+    }
+    cachedOutlierMode = value;
+    return writeIntToFile(OUTLIER_PATH, value);
+  }
+
   // ========== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ==========
 
   /**
@@ -157,12 +378,63 @@ class ConfigManager {
     cachedLevelMax = readFloatFromFile(LEVEL_MAX_PATH, DEFAULT_LEVEL_MAX);
     cachedZeroOffset = readFloatFromFile(ZERO_OFFSET_PATH, DEFAULT_ZERO_OFFSET);
     cachedAxisSwap = readBoolFromFile(AXIS_SWAP_PATH, DEFAULT_AXIS_SWAP);
+    cachedFadeTimeMs = constrain(
+        readIntFromFile(FADE_TIME_PATH, DEFAULT_FADE_TIME_MS), 0,
+        MAX_FADE_TIME_MS);
+    cachedHysteresisLow = constrain(
+        readFloatFromFile(HYSTERESIS_LOW_PATH, DEFAULT_HYSTERESIS), 0.0f,
+        MAX_HYSTERESIS);
+    cachedHysteresisHigh = constrain(
+        readFloatFromFile(HYSTERESIS_HIGH_PATH, DEFAULT_HYSTERESIS), 0.0f,
+        MAX_HYSTERESIS);
+    cachedWsIntervalMs = constrain(
+        readIntFromFile(WS_INTERVAL_PATH, DEFAULT_WS_INTERVAL_MS),
+        MIN_WS_INTERVAL_MS, MAX_WS_INTERVAL_MS);
+    cachedUdpMode = constrain(readIntFromFile(UDP_MODE_PATH, DEFAULT_UDP_MODE),
+                              0, MAX_UDP_MODE);
+    cachedUdpPort = constrain(readIntFromFile(UDP_PORT_PATH, DEFAULT_UDP_PORT),
+                              MIN_UDP_PORT, UINT16_MAX);
+    cachedSleepAfterS = constrain(
+        readIntFromFile(SLEEP_AFTER_PATH, DEFAULT_SLEEP_AFTER_S), 0,
+        UINT16_MAX);
+    long recordIntervalMs =
+        readIntFromFile(RECORD_INTERVAL_PATH, DEFAULT_RECORD_INTERVAL_MS);
+    cachedRecordIntervalMs =
+        recordIntervalMs <= 0
+            ? 0
+            : constrain(recordIntervalMs, MIN_RECORD_INTERVAL_MS,
+                        MAX_RECORD_INTERVAL_MS);
+    cachedAccelCorrection = readAccelCorrectionFromFile();
+    cachedHeadingEnabled =
+        readBoolFromFile(HEADING_PATH, DEFAULT_HEADING_ENABLED);
+    cachedMagCorrection = readMagCorrectionFromFile();
+    cachedOrientationEngine = constrain(
+        readIntFromFile(ORIENTATION_PATH, DEFAULT_ORIENTATION_ENGINE), 0,
+        OrientationEngine::TYPE_COUNT - 1);
+    cachedOutlierMode =
+        constrain(readIntFromFile(OUTLIER_PATH, DEFAULT_OUTLIER_MODE), 0,
+                  OutlierRejector::MODE_COUNT - 1);
 
     Serial.println("Configuration loaded from files:");
     Serial.printf("  Level Min: %.1f°\n", cachedLevelMin);
     Serial.printf("  Level Max: %.1f°\n", cachedLevelMax);
     Serial.printf("  Zero Offset: %.2f°\n", cachedZeroOffset);
     Serial.printf("  Axis Swap: %s\n", cachedAxisSwap ? "ON" : "OFF");
+    Serial.printf("  LED Fade: %u ms\n", cachedFadeTimeMs);
+    Serial.printf("  Hysteresis: ±%.2f° / ±%.2f°\n", cachedHysteresisLow,
+                  cachedHysteresisHigh);
+    Serial.printf("  WS Interval: %u ms\n", cachedWsIntervalMs);
+    Serial.printf("  UDP Telemetry: mode %u, port %u\n", cachedUdpMode,
+                  cachedUdpPort);
+    Serial.printf("  Light sleep after: %u s\n", cachedSleepAfterS);
+    Serial.printf("  Record interval: %u ms\n", cachedRecordIntervalMs);
+    Serial.printf("  Heading: %s\n", cachedHeadingEnabled ? "ON" : "OFF");
+    Serial.printf("  Orientation: %s\n", OrientationEngine::typeName(
+                                             getOrientationEngine()));
+    Serial.printf("  Outliers: %s\n",
+                  OutlierRejector::modeName(getOutlierMode()));
+    printAccelCorrection("  ");
+    printMagCorrection("  ");
   }
 
  private:
@@ -171,138 +443,286 @@ class ConfigManager {
   static float cachedLevelMax;
   static float cachedZeroOffset;
   static bool cachedAxisSwap;
+  static uint16_t cachedFadeTimeMs;
+  static float cachedHysteresisLow;
+  static float cachedHysteresisHigh;
+  static uint16_t cachedWsIntervalMs;
+  static uint8_t cachedUdpMode;
+  static uint16_t cachedUdpPort;
+  static uint16_t cachedSleepAfterS;
+  static uint16_t cachedRecordIntervalMs;
+  static AccelCorrection cachedAccelCorrection;
+  static bool cachedHeadingEnabled;
+  static MagCorrection cachedMagCorrection;
+  static uint8_t cachedOrientationEngine;
+  static uint8_t cachedOutlierMode;
+
+  // Счётчик записей во flash
+  static uint32_t flashWrites;
+
+  static HalFileSystem* fileSystem;
+
+  // Максимальная длина числового значения в файле
+  static constexpr size_t VALUE_BUFFER_SIZE = 32;
+  static constexpr size_t ACCEL_CAL_BUFFER_SIZE = 96;
+  static constexpr size_t MAG_CAL_BUFFER_SIZE = 160;
 
   // ========== ПРИВАТНЫЕ МЕТОДЫ ==========
 
   static void initializeFiles() {
     // Числовые настройки
-    if (!LittleFS.exists(LEVEL_MIN_PATH)) {
+    if (!fileSystem->exists(LEVEL_MIN_PATH)) {
       Serial.printf("Creating %s with default: %.1f\n", LEVEL_MIN_PATH,
                     DEFAULT_LEVEL_MIN);
       writeFloatToFile(LEVEL_MIN_PATH, DEFAULT_LEVEL_MIN);
     }
 
-    if (!LittleFS.exists(LEVEL_MAX_PATH)) {
+    if (!fileSystem->exists(LEVEL_MAX_PATH)) {
       Serial.printf("Creating %s with default: %.1f\n", LEVEL_MAX_PATH,
                     DEFAULT_LEVEL_MAX);
       writeFloatToFile(LEVEL_MAX_PATH, DEFAULT_LEVEL_MAX);
     }
 
-    if (!LittleFS.exists(ZERO_OFFSET_PATH)) {
+    if (!fileSystem->exists(ZERO_OFFSET_PATH)) {
       Serial.printf("Creating %s with default: %.1f\n", ZERO_OFFSET_PATH,
                     DEFAULT_ZERO_OFFSET);
       writeFloatToFile(ZERO_OFFSET_PATH, DEFAULT_ZERO_OFFSET);
     }
 
-    if (!LittleFS.exists(AXIS_SWAP_PATH)) {
+    if (!fileSystem->exists(AXIS_SWAP_PATH)) {
       Serial.printf("Creating %s with default: %s\n", AXIS_SWAP_PATH,
                     DEFAULT_AXIS_SWAP ? "true" : "false");
       writeBoolToFile(AXIS_SWAP_PATH, DEFAULT_AXIS_SWAP);
     }
 
+    if (!fileSystem->exists(FADE_TIME_PATH)) {
+      Serial.printf("Creating %s with default: %u\n", FADE_TIME_PATH,
+                    DEFAULT_FADE_TIME_MS);
+      writeIntToFile(FADE_TIME_PATH, DEFAULT_FADE_TIME_MS);
+    }
+
+    if (!fileSystem->exists(HYSTERESIS_LOW_PATH)) {
+      Serial.printf("Creating %s with default: %.2f\n", HYSTERESIS_LOW_PATH,
+                    DEFAULT_HYSTERESIS);
+      writeFloatToFile(HYSTERESIS_LOW_PATH, DEFAULT_HYSTERESIS);
+    }
+
+    if (!fileSystem->exists(HYSTERESIS_HIGH_PATH)) {
+      Serial.printf("Creating %s with default: %.2f\n", HYSTERESIS_HIGH_PATH,
+                    DEFAULT_HYSTERESIS);
+      writeFloatToFile(HYSTERESIS_HIGH_PATH, DEFAULT_HYSTERESIS);
+    }
+
+    if (!fileSystem->exists(WS_INTERVAL_PATH)) {
+      Serial.printf("Creating %s with default: %u\n", WS_INTERVAL_PATH,
+                    DEFAULT_WS_INTERVAL_MS);
+      writeIntToFile(WS_INTERVAL_PATH, DEFAULT_WS_INTERVAL_MS);
+    }
+
+    if (!fileSystem->exists(UDP_MODE_PATH)) {
+      Serial.printf("Creating %s with default: %u\n", UDP_MODE_PATH,
+                    DEFAULT_UDP_MODE);
+      writeIntToFile(UDP_MODE_PATH, DEFAULT_UDP_MODE);
+    }
+
+    if (!fileSystem->exists(UDP_PORT_PATH)) {
+      Serial.printf("Creating %s with default: %u\n", UDP_PORT_PATH,
+                    DEFAULT_UDP_PORT);
+      writeIntToFile(UDP_PORT_PATH, DEFAULT_UDP_PORT);
+    }
+
+    if (!fileSystem->exists(SLEEP_AFTER_PATH)) {
+      Serial.printf("Creating %s with default: %u\n", SLEEP_AFTER_PATH,
+                    DEFAULT_SLEEP_AFTER_S);
+      writeIntToFile(SLEEP_AFTER_PATH, DEFAULT_SLEEP_AFTER_S);
+    }
+
+    if (!fileSystem->exists(RECORD_INTERVAL_PATH)) {
+      Serial.printf("Creating %s with default: %u\n", RECORD_INTERVAL_PATH,
+                    DEFAULT_RECORD_INTERVAL_MS);
+      writeIntToFile(RECORD_INTERVAL_PATH, DEFAULT_RECORD_INTERVAL_MS);
+    }
+
+    if (!fileSystem->exists(HEADING_PATH)) {
+      Serial.printf("Creating %s with default: %s\n", HEADING_PATH,
+                    DEFAULT_HEADING_ENABLED ? "true" : "false");
+      writeBoolToFile(HEADING_PATH, DEFAULT_HEADING_ENABLED);
+    }
+
+    if (!fileSystem->exists(ORIENTATION_PATH)) {
+      Serial.printf("Creating %s with default: %s\n", ORIENTATION_PATH,
+                    OrientationEngine::typeName(
+                        (OrientationEngine::Type)DEFAULT_ORIENTATION_ENGINE));
+      writeIntToFile(ORIENTATION_PATH, DEFAULT_ORIENTATION_ENGINE);
+    }
+
+    if (!fileSystem->exists(OUTLIER_PATH)) {
+      Serial.printf("Creating %s with default: %s\n", OUTLIER_PATH,
+                    OutlierRejector::modeName(
+                        (OutlierRejector::Mode)DEFAULT_OUTLIER_MODE));
+      writeIntToFile(OUTLIER_PATH, DEFAULT_OUTLIER_MODE);
+    }
+
     // Строковые настройки - создаем пустые файлы если не существуют
-    if (!LittleFS.exists(GATEWAY_PATH)) {
+    if (!fileSystem->exists(GATEWAY_PATH)) {
       Serial.printf("Creating empty file: %s\n", GATEWAY_PATH);
       writeStringToFile(GATEWAY_PATH, "");
     }
 
-    if (!LittleFS.exists(IP_PATH)) {
+    if (!fileSystem->exists(IP_PATH)) {
       Serial.printf("Creating empty file: %s\n", IP_PATH);
       writeStringToFile(IP_PATH, "");
     }
 
-    if (!LittleFS.exists(SSID_PATH)) {
+    if (!fileSystem->exists(SSID_PATH)) {
       Serial.printf("Creating empty file: %s\n", SSID_PATH);
       writeStringToFile(SSID_PATH, "");
     }
 
-    if (!LittleFS.exists(PASS_PATH)) {
+    if (!fileSystem->exists(PASS_PATH)) {
       Serial.printf("Creating empty file: %s\n", PASS_PATH);
       writeStringToFile(PASS_PATH, "");
     }
   }
 
-  static float readFloatFromFile(const char* path, float defaultValue) {
-    if (!LittleFS.exists(path)) {
-      return defaultValue;
+  /**
+   * @brief Прочитать значение без пробелов по краям
+   * @return false - файла нет, не открылся или пуст
+   */
+  static bool readValue(const char* path, char* buffer, size_t size) {
+    if (!fileSystem->exists(path)) {
+      return false;
     }
 
-    File file = LittleFS.open(path, "r");
-    if (!file) {
+    int length = fileSystem->read(path, buffer, size);
+    if (length < 0) {
       Serial.printf("ERROR: Failed to open %s for reading\n", path);
-      return defaultValue;
+      return false;
     }
 
-    String content = file.readString();
-    file.close();
+    while (length > 0 && isspace((unsigned char)buffer[length - 1])) {
+      buffer[--length] = '\0';
+    }
+    size_t start = 0;
+    while (buffer[start] != '\0' && isspace((unsigned char)buffer[start])) {
+      start++;
+    }
+    if (start > 0) {
+      memmove(buffer, buffer + start, length - start + 1);
+    }
+    return buffer[0] != '\0';
+  }
 
-    content.trim();
-    if (content.isEmpty()) {
+  static float readFloatFromFile(const char* path, float defaultValue) {
+    char buffer[VALUE_BUFFER_SIZE];
+    if (!readValue(path, buffer, sizeof(buffer))) {
       return defaultValue;
     }
-
-    return content.toFloat();
+    return strtof(buffer, nullptr);
   }
 
-  static bool readBoolFromFile(const char* path, bool defaultValue) {
-    if (!LittleFS.exists(path)) {
+  static long readIntFromFile(const char* path, long defaultValue) {
+    char buffer[VALUE_BUFFER_SIZE];
+    if (!readValue(path, buffer, sizeof(buffer))) {
       return defaultValue;
     }
+    return strtol(buffer, nullptr, 10);
+  }
 
-    File file = LittleFS.open(path, "r");
-    if (!file) {
-      Serial.printf("ERROR: Failed to open %s for reading\n", path);
+  static bool readBoolFromFile(const char* path, bool defaultValue) {
+    char buffer[VALUE_BUFFER_SIZE];
+    if (!readValue(path, buffer, sizeof(buffer))) {
       return defaultValue;
     }
 
-    String content = file.readString();
-    file.close();
-
-    content.trim();
-    content.toLowerCase();
-
-    if (content == "true" || content == "1") {
+    if (strcasecmp(buffer, "true") == 0 || strcmp(buffer, "1") == 0) {
       return true;
-    } else if (content == "false" || content == "0") {
+    } else if (strcasecmp(buffer, "false") == 0 || strcmp(buffer, "0") == 0) {
       return false;
     }
 
     return defaultValue;
   }
 
-  static bool writeFloatToFile(const char* path, float value) {
-    File file = LittleFS.open(path, "w");
-    if (!file) {
-      Serial.printf("ERROR: Failed to open %s for writing\n", path);
-      return false;
+  // Нет файла или значения вне допуска - без поправки
+  static AccelCorrection readAccelCorrectionFromFile() {
+    char buffer[ACCEL_CAL_BUFFER_SIZE];
+    AccelCorrection value;
+    if (!readValue(ACCEL_CAL_PATH, buffer, sizeof(buffer)) ||
+        sscanf(buffer, "%f %f %f %f %f %f", &value.bias[0], &value.bias[1],
+               &value.bias[2], &value.scale[0], &value.scale[1],
+               &value.scale[2]) != 6) {
+      return AccelCorrection::identity();
     }
+    if (!AccelCalibration::isValid(value)) {
+      Serial.printf("WARNING: Ignoring invalid %s\n", ACCEL_CAL_PATH);
+      return AccelCorrection::identity();
+    }
+    return value;
+  }
 
-    file.print(value, 2);  // 2 знака после запятой
-    file.close();
-    return true;
+  static MagCorrection readMagCorrectionFromFile() {
+    char buffer[MAG_CAL_BUFFER_SIZE];
+    MagCorrection value;
+    float* m = &value.matrix[0][0];
+    if (!readValue(MAG_CAL_PATH, buffer, sizeof(buffer)) ||
+        sscanf(buffer, "%f %f %f %f %f %f %f %f %f %f %f %f",
+               &value.offset[0], &value.offset[1], &value.offset[2], &m[0],
+               &m[1], &m[2], &m[3], &m[4], &m[5], &m[6], &m[7],
+               &m[8]) != 12) {
+      return MagCorrection::identity();
+    }
+    if (!MagCalibration::isValid(value)) {
+      Serial.printf("WARNING: Ignoring invalid %s\n", MAG_CAL_PATH);
+      return MagCorrection::identity();
+    }
+    return value;
   }
 
-  static bool writeBoolToFile(const char* path, bool value) {
-    File file = LittleFS.open(path, "w");
-    if (!file) {
-      Serial.printf("ERROR: Failed to open %s for writing\n", path);
-      return false;
+  static void printMagCorrection(const char* indent) {
+    const MagCorrection& c = cachedMagCorrection;
+    if (c.isIdentity()) {
+      Serial.printf("%sMag Calibration: none\n", indent);
+      return;
     }
+    Serial.printf("%sMag Calibration: offset %.1f/%.1f/%.1f uT\n", indent,
+                  c.offset[0], c.offset[1], c.offset[2]);
+  }
 
-    file.print(value ? "true" : "false");
-    file.close();
-    return true;
+  static void printAccelCorrection(const char* indent) {
+    const AccelCorrection& c = cachedAccelCorrection;
+    if (c.isIdentity()) {
+      Serial.printf("%sAccel Calibration: none\n", indent);
+      return;
+    }
+    Serial.printf("%sAccel Calibration: bias %.3f/%.3f/%.3f m/s², "
+                  "scale %.4f/%.4f/%.4f\n",
+                  indent, c.bias[0], c.bias[1], c.bias[2], c.scale[0],
+                  c.scale[1], c.scale[2]);
+  }
+
+  static bool writeFloatToFile(const char* path, float value) {
+    char buffer[VALUE_BUFFER_SIZE];
+    snprintf(buffer, sizeof(buffer), "%.2f", value);  // 2 знака после запятой
+    return writeStringToFile(path, buffer);
+  }
+
+  static bool writeIntToFile(const char* path, long value) {
+    char buffer[VALUE_BUFFER_SIZE];
+    snprintf(buffer, sizeof(buffer), "%ld", value);
+    return writeStringToFile(path, buffer);
   }
 
-  static bool writeStringToFile(const char* path, const String& value) {
-    File file = LittleFS.open(path, "w");
-    if (!file) {
-      Serial.printf("ERROR: Failed to open %s for writing\n", path);
+  static bool writeBoolToFile(const char* path, bool value) {
+    return writeStringToFile(path, value ? "true" : "false");
+  }
+
+  static bool writeStringToFile(const char* path, const char* value) {
+    if (!fileSystem->write(path, value, strlen(value))) {
+      Serial.printf("ERROR: Failed to write %s\n", path);
       return false;
     }
-
-    file.print(value);
-    file.close();
+    flashWrites++;
     return true;
   }
 };
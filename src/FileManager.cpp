@@ -1,13 +1,18 @@
 #include "FileManager.h"
 
+uint32_t FileManager::writeCount = 0;
+bool FileManager::verbose = false;
+
 FileManager::FileManager() {}
 
 String FileManager::readFile(fs::FS &fs, const char *path) {
-  Serial.printf("Reading file: %s\r\n", path);
+  if (verbose) {
+    Serial.printf("Reading file: %s\r\n", path);
+  }
 
   File file = fs.open(path);
   if (!file || file.isDirectory()) {
-    Serial.println(F("- failed to open file for reading"));
+    Serial.printf("- failed to open %s for reading\r\n", path);
     return String();
   }
 
@@ -20,16 +25,19 @@ String FileManager::readFile(fs::FS &fs, const char *path) {
 }
 
 void FileManager::writeFile(fs::FS &fs, const char *path, const char *message) {
-  Serial.printf("Writing file: %s\r\n", path);
+  if (verbose) {
+    Serial.printf("Writing file: %s\r\n", path);
+  }
 
   File file = fs.open(path, FILE_WRITE);
   if (!file) {
-    Serial.println(F("- failed to open file for writing"));
+    Serial.printf("- failed to open %s for writing\r\n", path);
     return;
   }
-  if (file.print(message)) {
+  writeCount++;
+  if (!file.print(message) && message[0] != '\0') {
+    Serial.printf("- write failed: %s\r\n", path);
+  } else if (verbose) {
     Serial.println(F("- file written"));
-  } else {
-    Serial.println(F("- write failed"));
   }
 }
\ No newline at end of file
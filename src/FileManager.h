@@ -13,6 +13,16 @@ class FileManager {
 
   // Запись в файл
   void writeFile(fs::FS &fs, const char *path, const char *message);
+
+  // Количество записей файлов (всеми экземплярами)
+  static uint32_t getWriteCount() { return writeCount; }
+
+  // Логировать каждое чтение/запись (ошибки выводятся всегда)
+  static void setVerbose(bool enabled) { verbose = enabled; }
+
+ private:
+  static uint32_t writeCount;
+  static bool verbose;
 };
 
 #endif
\ No newline at end of file
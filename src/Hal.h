@@ -0,0 +1,113 @@
+// Hal.h
+// Тонкие интерфейсы к железу: I2C, ШИМ, файлы, часы, сеть
+//
+// Реализации: HalEsp32.h (устройство) и HalHost.h (ПК, env:native).
+// Модули обработки зависят только от этих интерфейсов и собираются на ПК.
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define HAL_LOG(...) Serial.printf(__VA_ARGS__)
+#else
+#include <stdio.h>
+#ifdef HAL_LOG_QUIET
+// Пакетные прогоны утилит на ПК: тысячи фильтров без вывода
+#define HAL_LOG(...) ((void)0)
+#else
+#define HAL_LOG(...) printf(__VA_ARGS__)
+#endif
+#endif
+
+/**
+ * @brief Шина I2C (регистровый доступ)
+ */
+class HalI2c {
+ public:
+  virtual ~HalI2c() {}
+
+  // Устройство отвечает на адрес
+  virtual bool probe(uint8_t address) = 0;
+
+  virtual bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) = 0;
+
+  // Чтение length байт начиная с reg (автоинкремент - забота вызывающего)
+  virtual bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer,
+                             size_t length) = 0;
+};
+
+/**
+ * @brief Каналы ШИМ (светодиоды)
+ */
+class HalPwm {
+ public:
+  virtual ~HalPwm() {}
+
+  virtual bool attach(uint8_t channel, uint8_t pin, uint32_t frequency,
+                      uint8_t resolutionBits) = 0;
+  virtual void write(uint8_t channel, uint32_t duty) = 0;
+
+  // Аппаратный плавный переход; false - не поддерживается или ошибка,
+  // тогда вызывающий пишет скважность напрямую
+  virtual bool enableFade() = 0;
+  virtual bool fade(uint8_t channel, uint32_t duty, uint16_t timeMs) = 0;
+};
+
+/**
+ * @brief Файловая система настроек и записей
+ */
+class HalFileSystem {
+ public:
+  virtual ~HalFileSystem() {}
+
+  virtual bool exists(const char* path) = 0;
+
+  /**
+   * @brief Прочитать файл (не больше size - 1 байт, всегда с '\0')
+   * @return Прочитано байт или -1, если файл не открылся
+   */
+  virtual int read(const char* path, char* buffer, size_t size) = 0;
+
+  // Перезаписать файл целиком
+  virtual bool write(const char* path, const char* data, size_t length) = 0;
+
+  virtual bool remove(const char* path) = 0;
+
+  // Размер файла в байтах, -1 - файла нет
+  virtual long size(const char* path) = 0;
+
+  /**
+   * @brief Прочитать length байт с позиции offset (двоичные данные)
+   * @return Прочитано байт или -1, если файл не открылся
+   */
+  virtual int readAt(const char* path, uint32_t offset, uint8_t* buffer,
+                     size_t length) = 0;
+};
+
+/**
+ * @brief Монотонные часы
+ */
+class HalClock {
+ public:
+  virtual ~HalClock() {}
+
+  virtual uint32_t nowMs() = 0;
+  virtual uint32_t nowUs() = 0;
+};
+
+/**
+ * @brief Состояние сетевого подключения
+ */
+class HalNetwork {
+ public:
+  virtual ~HalNetwork() {}
+
+  virtual bool isConnected() const = 0;
+  virtual int32_t rssi() const = 0;  // дБм, 0 - нет данных
+};
+
+#endif  // HAL_H
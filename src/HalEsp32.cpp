@@ -0,0 +1,137 @@
+// HalEsp32.cpp
+#ifdef ARDUINO
+
+#include "HalEsp32.h"
+
+#include <WiFi.h>
+#include <driver/ledc.h>
+
+// ========== I2C ==========
+
+bool Esp32I2c::begin(uint8_t sdaPin, uint8_t sclPin, uint32_t frequency) {
+  if (!wire.begin(sdaPin, sclPin)) return false;
+  wire.setClock(frequency);
+  return true;
+}
+
+bool Esp32I2c::probe(uint8_t address) {
+  wire.beginTransmission(address);
+  return wire.endTransmission() == 0;
+}
+
+bool Esp32I2c::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+  wire.beginTransmission(address);
+  wire.write(reg);
+  wire.write(value);
+  return wire.endTransmission() == 0;
+}
+
+bool Esp32I2c::readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer,
+                             size_t length) {
+  wire.beginTransmission(address);
+  wire.write(reg);
+  if (wire.endTransmission(false) != 0) return false;  // Repeated start
+
+  if (wire.requestFrom(address, (uint8_t)length) != length) return false;
+  for (size_t i = 0; i < length; i++) {
+    buffer[i] = wire.read();
+  }
+  return true;
+}
+
+// ========== ШИМ ==========
+
+bool Esp32Pwm::attach(uint8_t channel, uint8_t pin, uint32_t frequency,
+                      uint8_t resolutionBits) {
+  if (ledcSetup(channel, frequency, resolutionBits) == 0) return false;
+  ledcAttachPin(pin, channel);
+  return true;
+}
+
+void Esp32Pwm::write(uint8_t channel, uint32_t duty) {
+  ledcWrite(channel, duty);
+}
+
+bool Esp32Pwm::enableFade() {
+  if (fadeInstalled) return true;
+
+  esp_err_t err = ledc_fade_func_install(0);
+  if (err != ESP_OK) {
+    Serial.printf("ERROR: ledc_fade_func_install failed (%d)\n", err);
+    return false;
+  }
+  fadeInstalled = true;
+  return true;
+}
+
+bool Esp32Pwm::fade(uint8_t channel, uint32_t duty, uint16_t timeMs) {
+  if (!fadeInstalled) return false;
+
+  // Каналы 0-7 Arduino LEDC = группа HIGH_SPEED, канал chan % 8
+  ledc_channel_t ledcChannel = (ledc_channel_t)(channel % 8);
+  return ledc_set_fade_with_time(LEDC_HIGH_SPEED_MODE, ledcChannel, duty,
+                                 timeMs) == ESP_OK &&
+         ledc_fade_start(LEDC_HIGH_SPEED_MODE, ledcChannel,
+                         LEDC_FADE_NO_WAIT) == ESP_OK;
+}
+
+// ========== Файлы ==========
+
+bool Esp32FileSystem::exists(const char* path) { return fs.exists(path); }
+
+int Esp32FileSystem::read(const char* path, char* buffer, size_t size) {
+  if (size == 0) return -1;
+
+  File file = fs.open(path, "r");
+  if (!file || file.isDirectory()) return -1;
+
+  int length = file.read((uint8_t*)buffer, size - 1);
+  file.close();
+  if (length < 0) length = 0;
+  buffer[length] = '\0';
+  return length;
+}
+
+bool Esp32FileSystem::write(const char* path, const char* data,
+                            size_t length) {
+  // create: недостающие каталоги (блоки записи лежат в /rec)
+  File file = fs.open(path, "w", true);
+  if (!file) return false;
+
+  size_t written = file.write((const uint8_t*)data, length);
+  file.close();
+  return written == length;
+}
+
+bool Esp32FileSystem::remove(const char* path) { return fs.remove(path); }
+
+long Esp32FileSystem::size(const char* path) {
+  File file = fs.open(path, "r");
+  if (!file || file.isDirectory()) return -1;
+
+  long length = (long)file.size();
+  file.close();
+  return length;
+}
+
+int Esp32FileSystem::readAt(const char* path, uint32_t offset, uint8_t* buffer,
+                            size_t length) {
+  File file = fs.open(path, "r");
+  if (!file || file.isDirectory()) return -1;
+
+  int count = 0;
+  if (file.seek(offset)) {
+    count = file.read(buffer, length);
+    if (count < 0) count = 0;
+  }
+  file.close();
+  return count;
+}
+
+// ========== Сеть ==========
+
+bool Esp32Network::isConnected() const { return WiFi.status() == WL_CONNECTED; }
+
+int32_t Esp32Network::rssi() const { return isConnected() ? WiFi.RSSI() : 0; }
+
+#endif  // ARDUINO
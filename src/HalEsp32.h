@@ -0,0 +1,73 @@
+// HalEsp32.h
+// Реализация Hal.h на ESP32: Wire, LEDC, LittleFS, millis(), WiFi
+
+#ifndef HAL_ESP32_H
+#define HAL_ESP32_H
+
+#ifdef ARDUINO
+
+#include <FS.h>
+#include <Wire.h>
+
+#include "Hal.h"
+
+class Esp32I2c : public HalI2c {
+ public:
+  explicit Esp32I2c(TwoWire& wire) : wire(wire) {}
+
+  bool begin(uint8_t sdaPin, uint8_t sclPin, uint32_t frequency);
+
+  bool probe(uint8_t address) override;
+  bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) override;
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer,
+                     size_t length) override;
+
+ private:
+  TwoWire& wire;
+};
+
+class Esp32Pwm : public HalPwm {
+ public:
+  Esp32Pwm() : fadeInstalled(false) {}
+
+  bool attach(uint8_t channel, uint8_t pin, uint32_t frequency,
+              uint8_t resolutionBits) override;
+  void write(uint8_t channel, uint32_t duty) override;
+  bool enableFade() override;
+  bool fade(uint8_t channel, uint32_t duty, uint16_t timeMs) override;
+
+ private:
+  bool fadeInstalled;
+};
+
+class Esp32FileSystem : public HalFileSystem {
+ public:
+  explicit Esp32FileSystem(fs::FS& fs) : fs(fs) {}
+
+  bool exists(const char* path) override;
+  int read(const char* path, char* buffer, size_t size) override;
+  bool write(const char* path, const char* data, size_t length) override;
+  bool remove(const char* path) override;
+  long size(const char* path) override;
+  int readAt(const char* path, uint32_t offset, uint8_t* buffer,
+             size_t length) override;
+
+ private:
+  fs::FS& fs;
+};
+
+class Esp32Clock : public HalClock {
+ public:
+  uint32_t nowMs() override { return millis(); }
+  uint32_t nowUs() override { return micros(); }
+};
+
+class Esp32Network : public HalNetwork {
+ public:
+  bool isConnected() const override;
+  int32_t rssi() const override;
+};
+
+#endif  // ARDUINO
+
+#endif  // HAL_ESP32_H
@@ -0,0 +1,98 @@
+// HalHost.cpp
+#ifndef ARDUINO
+
+#include "HalHost.h"
+
+#include <string.h>
+
+// ========== I2C ==========
+
+HostI2c::Device* HostI2c::find(uint8_t address) const {
+  std::map<uint8_t, Device*>::const_iterator it = devices.find(address);
+  return it == devices.end() ? nullptr : it->second;
+}
+
+bool HostI2c::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+  Device* device = find(address);
+  if (!device) return false;
+
+  writes++;
+  return device->writeRegister(reg, value);
+}
+
+bool HostI2c::readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer,
+                            size_t length) {
+  Device* device = find(address);
+  if (!device) return false;
+
+  reads++;
+  return device->readRegisters(reg, buffer, length);
+}
+
+// ========== ШИМ ==========
+
+HostPwm::HostPwm() : writes(0) { memset(duty, 0, sizeof(duty)); }
+
+bool HostPwm::attach(uint8_t channel, uint8_t, uint32_t, uint8_t) {
+  return channel < MAX_CHANNELS;
+}
+
+void HostPwm::write(uint8_t channel, uint32_t value) {
+  if (channel >= MAX_CHANNELS) return;
+  duty[channel] = value;
+  writes++;
+}
+
+bool HostPwm::fade(uint8_t channel, uint32_t value, uint16_t) {
+  write(channel, value);  // Переход мгновенный
+  return channel < MAX_CHANNELS;
+}
+
+uint32_t HostPwm::getDuty(uint8_t channel) const {
+  return channel < MAX_CHANNELS ? duty[channel] : 0;
+}
+
+// ========== Файлы ==========
+
+bool HostFileSystem::exists(const char* path) {
+  return files.find(path) != files.end();
+}
+
+int HostFileSystem::read(const char* path, char* buffer, size_t size) {
+  std::map<std::string, std::string>::const_iterator it = files.find(path);
+  if (it == files.end() || size == 0) return -1;
+
+  size_t length = it->second.size();
+  if (length > size - 1) length = size - 1;
+  memcpy(buffer, it->second.data(), length);
+  buffer[length] = '\0';
+  return (int)length;
+}
+
+bool HostFileSystem::write(const char* path, const char* data, size_t length) {
+  files[path].assign(data, length);
+  return true;
+}
+
+bool HostFileSystem::remove(const char* path) {
+  return files.erase(path) > 0;
+}
+
+long HostFileSystem::size(const char* path) {
+  std::map<std::string, std::string>::const_iterator it = files.find(path);
+  return it == files.end() ? -1 : (long)it->second.size();
+}
+
+int HostFileSystem::readAt(const char* path, uint32_t offset, uint8_t* buffer,
+                           size_t length) {
+  std::map<std::string, std::string>::const_iterator it = files.find(path);
+  if (it == files.end()) return -1;
+  if (offset >= it->second.size()) return 0;
+
+  size_t available = it->second.size() - offset;
+  if (length > available) length = available;
+  memcpy(buffer, it->second.data() + offset, length);
+  return (int)length;
+}
+
+#endif  // ARDUINO
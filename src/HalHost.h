@@ -0,0 +1,128 @@
+// HalHost.h
+// Реализация Hal.h для ПК (env:native): всё в памяти, время задаётся вручную
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#ifndef ARDUINO
+
+#include <map>
+#include <string>
+
+#include "Hal.h"
+
+/**
+ * @brief Шина I2C с программными устройствами
+ */
+class HostI2c : public HalI2c {
+ public:
+  // Модель устройства на шине
+  class Device {
+   public:
+    virtual ~Device() {}
+    virtual bool writeRegister(uint8_t reg, uint8_t value) = 0;
+    virtual bool readRegisters(uint8_t reg, uint8_t* buffer,
+                               size_t length) = 0;
+  };
+
+  HostI2c() : reads(0), writes(0) {}
+
+  // Устройство не принадлежит шине и должно жить дольше неё
+  void attach(uint8_t address, Device* device) { devices[address] = device; }
+  void detach(uint8_t address) { devices.erase(address); }
+
+  bool probe(uint8_t address) override { return find(address) != nullptr; }
+  bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) override;
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer,
+                     size_t length) override;
+
+  uint32_t getReadCount() const { return reads; }
+  uint32_t getWriteCount() const { return writes; }
+
+ private:
+  std::map<uint8_t, Device*> devices;
+  uint32_t reads, writes;
+
+  Device* find(uint8_t address) const;
+};
+
+/**
+ * @brief ШИМ: запоминает скважность каналов
+ */
+class HostPwm : public HalPwm {
+ public:
+  static const uint8_t MAX_CHANNELS = 16;
+
+  HostPwm();
+
+  bool attach(uint8_t channel, uint8_t pin, uint32_t frequency,
+              uint8_t resolutionBits) override;
+  void write(uint8_t channel, uint32_t duty) override;
+  bool enableFade() override { return true; }
+  bool fade(uint8_t channel, uint32_t duty, uint16_t timeMs) override;
+
+  uint32_t getDuty(uint8_t channel) const;
+  uint32_t getWriteCount() const { return writes; }
+
+ private:
+  uint32_t duty[MAX_CHANNELS];
+  uint32_t writes;
+};
+
+/**
+ * @brief Файловая система в памяти
+ */
+class HostFileSystem : public HalFileSystem {
+ public:
+  bool exists(const char* path) override;
+  int read(const char* path, char* buffer, size_t size) override;
+  bool write(const char* path, const char* data, size_t length) override;
+  bool remove(const char* path) override;
+  long size(const char* path) override;
+  int readAt(const char* path, uint32_t offset, uint8_t* buffer,
+             size_t length) override;
+
+ private:
+  std::map<std::string, std::string> files;
+};
+
+/**
+ * @brief Часы, которые двигает тест/бенчмарк
+ */
+class HostClock : public HalClock {
+ public:
+  HostClock() : us(0) {}
+
+  uint32_t nowMs() override { return (uint32_t)(us / 1000); }
+  uint32_t nowUs() override { return (uint32_t)us; }
+
+  void advanceUs(uint64_t deltaUs) { us += deltaUs; }
+  void advanceMs(uint32_t deltaMs) { us += (uint64_t)deltaMs * 1000; }
+
+ private:
+  uint64_t us;
+};
+
+/**
+ * @brief Сеть с задаваемым состоянием
+ */
+class HostNetwork : public HalNetwork {
+ public:
+  HostNetwork() : connected(false), signal(0) {}
+
+  bool isConnected() const override { return connected; }
+  int32_t rssi() const override { return connected ? signal : 0; }
+
+  void setConnected(bool value, int32_t rssiDbm = -60) {
+    connected = value;
+    signal = rssiDbm;
+  }
+
+ private:
+  bool connected;
+  int32_t signal;
+};
+
+#endif  // ARDUINO
+
+#endif  // HAL_HOST_H
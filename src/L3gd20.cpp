@@ -0,0 +1,62 @@
+// L3gd20.cpp
+#include "L3gd20.h"
+
+#include <math.h>
+
+namespace {
+
+// CTRL_REG1: ODR 95 Гц, полоса 12.5 Гц, PD = 1 (работа), Z/Y/X включены
+const uint8_t GYRO_POWER_ON = 0x0F;
+
+// CTRL_REG4: ±250 °/с, непрерывное обновление
+const uint8_t GYRO_RANGE_250DPS = 0x00;
+
+int16_t clampCounts(float counts) {
+  if (counts != counts) return 0;  // NaN
+  if (counts < -32768.0f) return -32768;
+  if (counts > 32767.0f) return 32767;
+  return (int16_t)lroundf(counts);
+}
+
+int16_t littleEndian(const uint8_t* p) { return (int16_t)(p[0] | (p[1] << 8)); }
+
+void putLittleEndian(uint8_t* p, int16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+}  // namespace
+
+bool L3gd20::begin() {
+  uint8_t id = 0;
+  if (!i2c.readRegisters(ADDRESS, REG_WHO_AM_I, &id, 1) ||
+      (id != ID_L3GD20 && id != ID_L3GD20H)) {
+    return false;
+  }
+  return i2c.writeRegister(ADDRESS, REG_CTRL_REG4, GYRO_RANGE_250DPS) &&
+         i2c.writeRegister(ADDRESS, REG_CTRL_REG1, GYRO_POWER_ON);
+}
+
+bool L3gd20::readGyro(float& x, float& y, float& z) {
+  uint8_t raw[6];
+  if (!i2c.readRegisters(ADDRESS, REG_OUT_X_L | AUTO_INCREMENT, raw,
+                         sizeof(raw))) {
+    return false;
+  }
+  decodeGyro(raw, x, y, z);
+  return true;
+}
+
+void L3gd20::decodeGyro(const uint8_t raw[6], float& x, float& y, float& z) {
+  const float scale = DPS_PER_LSB * RAD_PER_DEG;
+  x = littleEndian(raw + 0) * scale;
+  y = littleEndian(raw + 2) * scale;
+  z = littleEndian(raw + 4) * scale;
+}
+
+void L3gd20::encodeGyro(float x, float y, float z, uint8_t raw[6]) {
+  const float scale = DPS_PER_LSB * RAD_PER_DEG;
+  putLittleEndian(raw + 0, clampCounts(x / scale));
+  putLittleEndian(raw + 2, clampCounts(y / scale));
+  putLittleEndian(raw + 4, clampCounts(z / scale));
+}
@@ -0,0 +1,48 @@
+// L3gd20.h
+// Драйвер гироскопа L3GD20/L3GD20H поверх HalI2c
+
+#ifndef L3GD20_H
+#define L3GD20_H
+
+#include "Hal.h"
+
+/**
+ * @brief Регистровый драйвер L3GD20 (необязательный гироскоп)
+ *
+ * Стоит рядом с LSM303DLHC на платах 10-DOF. ±250 °/с, 8.75 m°/с на LSB,
+ * 95 Гц. Оси совпадают с акселерометром LSM303 при общей разводке.
+ * Кодирование в обратную сторону - для модели датчика на ПК.
+ */
+class L3gd20 {
+ public:
+  static const uint8_t ADDRESS = 0x6B;
+
+  static const uint8_t REG_WHO_AM_I = 0x0F;
+  static const uint8_t REG_CTRL_REG1 = 0x20;
+  static const uint8_t REG_CTRL_REG4 = 0x23;
+  static const uint8_t REG_OUT_X_L = 0x28;
+  static const uint8_t AUTO_INCREMENT = 0x80;
+
+  static const uint8_t ID_L3GD20 = 0xD4;
+  static const uint8_t ID_L3GD20H = 0xD7;
+
+  static constexpr float DPS_PER_LSB = 0.00875f;  // ±250 °/с
+  static constexpr float RAD_PER_DEG = 0.017453293f;
+
+  explicit L3gd20(HalI2c& i2c) : i2c(i2c) {}
+
+  /**
+   * @brief Проверить WHO_AM_I и включить (95 Гц, X/Y/Z, ±250 °/с)
+   */
+  bool begin();
+
+  bool readGyro(float& x, float& y, float& z);  // рад/с
+
+  static void decodeGyro(const uint8_t raw[6], float& x, float& y, float& z);
+  static void encodeGyro(float x, float y, float z, uint8_t raw[6]);
+
+ private:
+  HalI2c& i2c;
+};
+
+#endif  // L3GD20_H
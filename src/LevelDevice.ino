@@ -3,16 +3,26 @@
 
 #include <LittleFS.h>
 #include <WiFi.h>
+#include <Wire.h>
 
+#include "BatteryMonitor.h"
 #include "ConfigManager.h"
 #include "FileManager.h"
 #include "FileSystemManager.h"
+#include "HalEsp32.h"
 #include "LevelIndicator.h"
 #include "LevelWebServer.h"
+#include "LoopProfiler.h"
+#include "LoopScheduler.h"
 #include "NetworkManager.h"
+#include "PipelineBenchmark.h"
 #include "Pins.h"
+#include "PowerManager.h"
+#include "SampleRecorder.h"
 #include "Secrets.h"
 #include "SensorManager.h"
+#include "SensorSimulator.h"
+#include "UdpTelemetry.h"
 
 // ===== КОНФИГУРАЦИЯ =====
 const char* SSID_PATH = "/ssid.txt";
@@ -20,26 +30,83 @@ const char* PASS_PATH = "/pass.txt";
 const char* IP_PATH = "/ip.txt";
 const char* GATEWAY_PATH = "/gateway.txt";
 
+// Шина датчиков
+const unsigned long I2C_FREQUENCY = 400000;
+
 // Профиль фильтрации Калмана
 const auto FILTER_PROFILE = MultiChannelKalman::RESPONSIVE;
 
 // Частоты обновления
+// Индикатор обновляется от esp_timer, а не из loop(): зависший HTTP
+// запрос не замораживает светодиоды. Частота WebSocket - из ConfigManager.
 const unsigned long INDICATOR_UPDATE_MS = 30;   // 33 Hz для плавной индикации
-const unsigned long WEBSOCKET_UPDATE_MS = 200;  // 10 Hz
+const unsigned long SETTINGS_RELOAD_MS = 1000;  // Подхват настроек из кеша
+const unsigned long STATS_PRINT_MS = 60000;     // Статистика в Serial
+const unsigned long BATTERY_SAMPLE_MS = 2000;   // Замер аккумулятора
+const unsigned long POWER_CHECK_MS = 250;       // Выбор режима питания
+const uint16_t IDLE_BROADCAST_MS = 1000;        // WebSocket вне ACTIVE
+const unsigned long BENCHMARK_POLL_MS = 500;    // Команда 'b' в Serial
+const unsigned long LOG_STREAM_MS = 4;          // Порция выгрузки /log
+
+// Аппаратный fade светодиодов: плавность даёт LEDC, поэтому индикатор
+// обновляется раз в fade-время, а не каждые INDICATOR_UPDATE_MS
+const bool INDICATOR_FADE_ENABLED = true;
 
 // Максимум WebSocket клиентов
 const uint8_t MAX_WS_CLIENTS = 3;
 
+// Подключение к WiFi идёт в фоне; без IP за это время - точка доступа
+const uint32_t WIFI_CONNECT_TIMEOUT_MS = 10000;
+const unsigned long NETWORK_POLL_MS = 100;
+
+// ===== ЖЕЛЕЗО =====
+Esp32I2c i2cBus(Wire);
+Esp32Pwm ledPwm;
+Esp32FileSystem settingsFs(LittleFS);
+Esp32Clock systemClock;
+Esp32Network wifiLink;
+
 // ===== МЕНЕДЖЕРЫ =====
 FileSystemManager fsManager;
 FileManager fileManager;
 NetworkManager networkManager;
 
-SensorManager sensorManager(I2C_SDA_PIN, I2C_SCL_PIN);
-LevelWebServer webServer(sensorManager);
-LevelIndicator levelIndicator(LED_POSITIVE_1, LED_POSITIVE_2, LED_POSITIVE_3,
-                              LED_NEGATIVE_1, LED_NEGATIVE_2, LED_NEGATIVE_3,
-                              LED_NEUTRAL);
+#if SENSOR_SIMULATOR
+// Сценарий вместо LSM303 (+ L3GD20): драйверы и фильтры те же, данные
+// воспроизводимы
+SensorSimulator simulator(SIMULATOR_PROFILE);
+SimulatedLsm303 simulatedBus(simulator, systemClock, true);
+HalI2c& sensorBus = simulatedBus;
+#else
+HalI2c& sensorBus = i2cBus;
+#endif
+
+SensorManager sensorManager(sensorBus, systemClock);
+LevelWebServer webServer(sensorManager, wifiLink);
+LevelIndicator levelIndicator(ledPwm, systemClock, LED_POSITIVE_1,
+                              LED_POSITIVE_2, LED_POSITIVE_3, LED_NEGATIVE_1,
+                              LED_NEGATIVE_2, LED_NEGATIVE_3, LED_NEUTRAL);
+UdpTelemetry udpTelemetry;
+BatteryMonitor batteryMonitor(BATTERY_PIN, BATTERY_DIVIDER_RATIO);
+PowerManager powerManager;
+SampleRecorder recorder(settingsFs);
+#if PIPELINE_BENCHMARK
+PipelineBenchmark benchmark(sensorBus, webServer);
+#endif
+
+// ===== ПЛАНИРОВЩИК =====
+LoopScheduler scheduler;
+
+int8_t jobSensors = LoopScheduler::INVALID_JOB;
+int8_t jobHttp = LoopScheduler::INVALID_JOB;
+int8_t jobBroadcast = LoopScheduler::INVALID_JOB;
+int8_t jobSettings = LoopScheduler::INVALID_JOB;
+int8_t jobStats = LoopScheduler::INVALID_JOB;
+int8_t jobNetwork = LoopScheduler::INVALID_JOB;
+int8_t jobBattery = LoopScheduler::INVALID_JOB;
+int8_t jobPower = LoopScheduler::INVALID_JOB;
+int8_t jobBenchmark = LoopScheduler::INVALID_JOB;
+int8_t jobLogStream = LoopScheduler::INVALID_JOB;
 
 // ===== ОТЛАДКА =====
 bool DEBUG_MODE = false;
@@ -55,6 +122,21 @@ struct SystemStats {
   unsigned long lastStatsReset;
 } stats = {0};
 
+// Время загрузки (millis(), 0 = ещё не наступило)
+struct BootTimings {
+  uint32_t webServerMs;  // webServer.begin() выполнен
+  uint32_t networkUpMs;  // Получен IP или поднята точка доступа
+  bool reported;
+} bootTimings = {0};
+
+// HTTP доступен, когда есть и сервер, и сеть
+uint32_t httpReadyMs() {
+  if (bootTimings.webServerMs == 0 || bootTimings.networkUpMs == 0) {
+    return 0;
+  }
+  return max(bootTimings.webServerMs, bootTimings.networkUpMs);
+}
+
 // ===== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ =====
 
 void startAccessPoint() {
@@ -66,6 +148,11 @@ void startAccessPoint() {
   Serial.printf("AP SSID: %s\n", AP_SSID);
   Serial.printf("AP IP: %s\n", WiFi.softAPIP().toString().c_str());
   Serial.printf("Max clients: %d\n", MAX_WS_CLIENTS);
+
+  networkManager.markAccessPoint();
+  if (bootTimings.networkUpMs == 0) {
+    bootTimings.networkUpMs = millis();
+  }
 }
 
 void setupWiFi() {
@@ -82,13 +169,92 @@ void setupWiFi() {
     return;
   }
 
-  Serial.println("Attempting to connect to WiFi...");
-  if (networkManager.initWiFi(ssid, pass, ip, gateway)) {
-    Serial.println("=== Connected to WiFi (STA mode) ===");
-    Serial.printf("IP: %s\n", WiFi.localIP().toString().c_str());
-  } else {
-    Serial.println("Failed to connect, falling back to AP mode");
-    startAccessPoint();
+  // Не ждём: результат разбирает задача "network", при неудаче она же
+  // поднимает точку доступа
+  networkManager.setFallbackHandler(startAccessPoint);
+  networkManager.beginConnect(ssid, pass, ip, gateway,
+                              WIFI_CONNECT_TIMEOUT_MS);
+}
+
+void reportBootTimings() {
+  uint32_t firstLedMs = levelIndicator.getFirstRenderMs();
+  uint32_t httpMs = httpReadyMs();
+  if (bootTimings.reported || firstLedMs == 0 || httpMs == 0) {
+    return;
+  }
+
+  bootTimings.reported = true;
+  Serial.printf("Boot: first LED at %u ms, HTTP ready at %u ms (%s)\n",
+                firstLedMs, httpMs, networkManager.getStateName());
+  if (networkManager.getConnectTimeMs() > 0) {
+    Serial.printf("Boot: WiFi connected in %u ms\n",
+                  networkManager.getConnectTimeMs());
+  }
+}
+
+// Время fade по профилю фильтра: чем сильнее сглаживание, тем длиннее
+// переход, чтобы индикатор не "дёргался" быстрее самого фильтра
+uint16_t profileFadeTimeMs(MultiChannelKalman::FilterProfile profile) {
+  switch (profile) {
+    case MultiChannelKalman::AGGRESSIVE:
+      return 200;
+    case MultiChannelKalman::BALANCED:
+      return 120;
+#ifdef HAS_TUNED_PROFILE
+    case MultiChannelKalman::TUNED:
+      return TunedFilterProfile::FADE_TIME_MS;
+#endif
+    case MultiChannelKalman::RESPONSIVE:
+    default:
+      return 80;
+  }
+}
+
+unsigned long indicatorUpdateMs() {
+  if (!levelIndicator.isFadeEnabled()) {
+    return INDICATOR_UPDATE_MS;
+  }
+  return max(INDICATOR_UPDATE_MS, (unsigned long)levelIndicator.getFadeTime());
+}
+
+void startIndicatorRefresh() {
+  unsigned long periodMs = indicatorUpdateMs();
+
+  // Худший случай: сэмпл прочитан сразу после тика таймера
+  levelIndicator.setLatencyBound(
+      (sensorManager.getUpdateIntervalMs() + periodMs) * 1000UL);
+  levelIndicator.startAutoRefresh(sensorManager.getRollSnapshot(), periodMs);
+}
+
+// Период опроса меняется адаптивно (SensorManager) - подстраиваем задачу
+// и границу задержки индикатора
+void syncSensorRate() {
+  static uint16_t appliedMs = 0;
+  uint16_t intervalMs = sensorManager.getUpdateIntervalMs();
+  if (intervalMs == appliedMs) return;
+
+  appliedMs = intervalMs;
+  scheduler.setPeriod(jobSensors, intervalMs);
+  levelIndicator.setLatencyBound((intervalMs + indicatorUpdateMs()) * 1000UL);
+}
+
+void loadIndicatorFade() {
+  uint16_t fadeMs = ConfigManager::getFadeTimeMs();
+  if (fadeMs == 0) {
+    fadeMs = profileFadeTimeMs(FILTER_PROFILE);
+  }
+
+  if (levelIndicator.isFadeEnabled() == INDICATOR_FADE_ENABLED &&
+      levelIndicator.getFadeTime() == fadeMs) {
+    return;
+  }
+
+  levelIndicator.setFadeMode(INDICATOR_FADE_ENABLED, fadeMs);
+  stats.settingsReloads++;
+
+  // Период таймера зависит от fade
+  if (levelIndicator.isAutoRefreshing()) {
+    startIndicatorRefresh();
   }
 }
 
@@ -96,7 +262,14 @@ void loadLevelRange() {
   float rangeMin = ConfigManager::getLevelMin();
   float rangeMax = ConfigManager::getLevelMax();
 
+  float currentMin, currentMax;
+  levelIndicator.getRange(currentMin, currentMax);
+  if (currentMin == rangeMin && currentMax == rangeMax) {
+    return;
+  }
+
   levelIndicator.setRange(rangeMin, rangeMax);
+  stats.rangeReloads++;
 
   if (DEBUG_RANGE_RELOAD) {
     Serial.printf("[RANGE] Loaded from cache: %.1f° to %.1f°\n", rangeMin,
@@ -104,26 +277,350 @@ void loadLevelRange() {
   }
 }
 
+void loadHysteresis() {
+  float low = ConfigManager::getHysteresisLow();
+  float high = ConfigManager::getHysteresisHigh();
+
+  float currentLow, currentHigh;
+  levelIndicator.getHysteresis(currentLow, currentHigh);
+  if (currentLow == low && currentHigh == high) {
+    return;
+  }
+
+  levelIndicator.setHysteresis(low, high);
+  stats.settingsReloads++;
+}
+
+unsigned long broadcastIntervalMs() {
+  unsigned long intervalMs = ConfigManager::getWsIntervalMs();
+  if (powerManager.getMode() != PowerManager::MODE_ACTIVE) {
+    intervalMs = max(intervalMs, (unsigned long)IDLE_BROADCAST_MS);
+  }
+  return intervalMs;
+}
+
+// Применение режима питания: частоты задач, WiFi, индикатор
+void onPowerModeChange(PowerManager::Mode previous, PowerManager::Mode mode,
+                       bool lowLatencyRadio) {
+  if (mode != previous) {
+    sensorManager.setRestIntervalMs(PowerManager::restSampleIntervalMs(mode));
+    syncSensorRate();
+    scheduler.setPeriod(jobHttp, PowerManager::httpPollMs(mode));
+    scheduler.setPeriod(jobBroadcast, broadcastIntervalMs());
+  }
+
+  if (mode == PowerManager::MODE_LIGHT_SLEEP) {
+    // APB (и LEDC) во сне остановлен - гасим индикатор заранее
+    if (previous != mode) {
+      recorder.requestFlush();
+      levelIndicator.stopAutoRefresh();
+      levelIndicator.clear();
+      networkManager.shutdown();
+    }
+    return;
+  }
+
+  if (previous == PowerManager::MODE_LIGHT_SLEEP) {
+    setupWiFi();
+  }
+  WiFi.setSleep(!lowLatencyRadio);
+
+  // Новый период опроса меняет границу задержки индикатора
+  if (mode != previous || !levelIndicator.isAutoRefreshing()) {
+    startIndicatorRefresh();
+  }
+}
+
+void loadUdpTelemetry() {
+  udpTelemetry.configure((UdpTelemetry::Mode)ConfigManager::getUdpMode(),
+                         ConfigManager::getUdpPort());
+}
+
+// Метрики устройства для /metrics (дописываются LevelWebServer)
+void writeDeviceMetrics(MetricsWriter& metrics) {
+  metrics.counter("level_loop_iterations_total", "loop() iterations",
+                  (uint32_t)stats.loopCount);
+  metrics.counter("level_ws_rejected_total",
+                  "Broadcasts skipped because of too many clients",
+                  (uint32_t)stats.wsErrors);
+
+  uint32_t ledWrites, ledSkipped;
+  levelIndicator.getWriteStats(ledWrites, ledSkipped);
+  metrics.counter("level_led_writes_total", "LEDC duty writes", ledWrites);
+  metrics.counter("level_led_writes_skipped_total",
+                  "LEDC writes skipped (duty unchanged)", ledSkipped);
+  metrics.counter("level_indicator_zone_transitions_total",
+                  "Indicator zone changes",
+                  levelIndicator.getZoneTransitions());
+
+  // Задачи планировщика
+  static const char* const JOB_FAMILIES[][3] = {
+      {"level_job_runs_total", "counter", "Scheduler job executions"},
+      {"level_job_overruns_total", "counter", "Job runs over budget"},
+      {"level_job_missed_periods_total", "counter",
+       "Job periods skipped because of lateness"},
+      {"level_job_max_run_us", "gauge", "Longest job execution"},
+  };
+  char labels[32];
+  for (uint8_t f = 0; f < 4; f++) {
+    metrics.family(JOB_FAMILIES[f][0], JOB_FAMILIES[f][1],
+                   JOB_FAMILIES[f][2]);
+    for (uint8_t i = 0; i < scheduler.getJobCount(); i++) {
+      LoopScheduler::JobStats job;
+      scheduler.getJobStats(i, job);
+      snprintf(labels, sizeof(labels), "job=\"%s\"", job.name);
+
+      uint32_t value = f == 0   ? job.runs
+                       : f == 1 ? job.overruns
+                       : f == 2 ? job.missedPeriods
+                                : job.maxRunUs;
+      metrics.value(JOB_FAMILIES[f][0], value, labels);
+    }
+  }
+
+  metrics.counter("level_udp_frames_total", "UDP telemetry frames sent",
+                  udpTelemetry.getFramesSent());
+  metrics.counter("level_udp_send_errors_total",
+                  "UDP telemetry frames the stack refused",
+                  udpTelemetry.getSendErrors());
+
+  if (batteryMonitor.isValid()) {
+    metrics.gauge("level_battery_volts", "Filtered battery voltage",
+                  batteryMonitor.getVoltage());
+    metrics.gauge("level_battery_percent", "Battery charge estimate",
+                  batteryMonitor.getPercentage());
+  }
+
+  metrics.family("level_power_mode_seconds_total", "counter",
+                 "Time spent in each power mode");
+  for (uint8_t i = 0; i < PowerManager::MODE_COUNT; i++) {
+    PowerManager::Mode mode = (PowerManager::Mode)i;
+    snprintf(labels, sizeof(labels), "mode=\"%s\"",
+             PowerManager::modeName(mode));
+    metrics.value("level_power_mode_seconds_total",
+                  powerManager.getResidencyMs(mode) / 1000.0f, labels);
+  }
+  metrics.gauge("level_power_mode", "Current power mode (0 active, 1 idle, "
+                "2 light sleep)", (uint32_t)powerManager.getMode());
+  metrics.counter("level_power_light_sleeps_total", "Light sleep entries",
+                  powerManager.getLightSleepCount());
+  metrics.gauge("level_power_estimated_ma",
+                "Modelled average current over the last 10 s",
+                powerManager.getEstimatedCurrentMa());
+  metrics.gauge("level_power_consumed_mah",
+                "Modelled charge used since boot",
+                powerManager.getConsumedMah());
+  metrics.gauge("level_motion_level", "Accel deviation from its mean (m/s^2)",
+                sensorManager.getMotionLevel());
+
+  metrics.gauge("level_recorder_interval_ms",
+                "Recording period (0 = recording off)",
+                (uint32_t)recorder.getIntervalMs());
+  metrics.counter("level_recorder_samples_total", "Samples recorded",
+                  recorder.getSamples());
+  metrics.counter("level_recorder_dropped_total",
+                  "Samples dropped while the previous block was being written",
+                  recorder.getDroppedSamples());
+  metrics.counter("level_recorder_blocks_written_total",
+                  "4 KB blocks written to flash", recorder.getBlocksWritten());
+  metrics.counter("level_recorder_write_errors_total",
+                  "Failed block writes", recorder.getWriteErrors());
+
+  metrics.gauge("level_boot_first_led_ms",
+                "Time from boot to the first valid LED output",
+                levelIndicator.getFirstRenderMs());
+  metrics.gauge("level_boot_http_ready_ms",
+                "Time from boot to HTTP server reachable", httpReadyMs());
+  metrics.gauge("level_wifi_connect_ms",
+                "Time to obtain an IP in station mode",
+                networkManager.getConnectTimeMs());
+
+  LevelIndicator::LatencyStats latency = levelIndicator.getLatencyStats();
+  metrics.gauge("level_indicator_latency_us",
+                "Last sample-to-LED latency", latency.lastUs);
+  metrics.gauge("level_indicator_latency_max_us",
+                "Worst sample-to-LED latency", latency.maxUs);
+  metrics.counter("level_indicator_latency_over_bound_total",
+                  "Samples that reached the LEDs later than the bound",
+                  latency.overBound);
+}
+
 void printSystemInfo() {
   Serial.println("\n=== SYSTEM INFO ===");
   Serial.printf("Free heap: %u bytes\n", ESP.getFreeHeap());
   Serial.printf("WiFi SSID: %s\n", WiFi.SSID().c_str());
   Serial.printf("IP Address: %s\n", WiFi.localIP().toString().c_str());
+  Serial.printf("WiFi state: %s\n", networkManager.getStateName());
   Serial.printf("WebSocket clients: %d\n", webServer.getClientCount());
+  Serial.printf("Boot: first LED %u ms, HTTP ready %u ms\n",
+                levelIndicator.getFirstRenderMs(), httpReadyMs());
 
   float rangeMin, rangeMax;
   levelIndicator.getRange(rangeMin, rangeMax);
   Serial.printf("Current range: %.1f° to %.1f°\n", rangeMin, rangeMax);
 
+  uint32_t ledWrites, ledSkipped;
+  levelIndicator.getWriteStats(ledWrites, ledSkipped);
+  Serial.printf("LED writes: %u (skipped %u)\n", ledWrites, ledSkipped);
+  Serial.printf("Zone transitions: %u\n", levelIndicator.getZoneTransitions());
+
+  LevelIndicator::LatencyStats latency = levelIndicator.getLatencyStats();
+  Serial.printf("LED latency: last=%u us, mean=%u us, max=%u us\n",
+                latency.lastUs, latency.meanUs, latency.maxUs);
+  Serial.printf("LED latency over %u us: %u of %u\n", latency.boundUs,
+                latency.overBound, latency.samples);
+
+  Serial.printf("Battery: %.2f V (%.0f%%, %s)\n", batteryMonitor.getVoltage(),
+                batteryMonitor.getPercentage(), batteryMonitor.getStatus());
+
+  Serial.printf("Power: %s, ~%.1f mA, %.2f mAh used, slept %u ms (%u times)\n",
+                PowerManager::modeName(powerManager.getMode()),
+                powerManager.getEstimatedCurrentMa(),
+                powerManager.getConsumedMah(), powerManager.getLightSleepMs(),
+                powerManager.getLightSleepCount());
+
   SensorData data = sensorManager.getCachedData();
   Serial.printf("Current angle: %.2f°\n", data.roll);
 
   Serial.printf("WS messages sent: %lu\n", stats.wsMessagesSent);
   Serial.printf("WS errors: %lu\n", stats.wsErrors);
   Serial.printf("Range reloads: %lu\n", stats.rangeReloads);
+  Serial.printf("UDP telemetry: %s, %u frames, %u errors\n",
+                UdpTelemetry::modeName(udpTelemetry.getMode()),
+                udpTelemetry.getFramesSent(), udpTelemetry.getSendErrors());
+
+  scheduler.printStats();
+
+#if LOOP_PROFILING
+  if (LoopProfiler::isEnabled()) {
+    LoopProfiler::printSummary();
+  }
+#endif
   Serial.println("===================\n");
 }
 
+// ===== ЗАДАЧИ ПЛАНИРОВЩИКА =====
+
+void runHttpJob() {
+  PROFILE_STAGE(STAGE_HANDLE_CLIENTS);
+  webServer.handleClients();
+}
+
+// Выгрузка записи: одна порция (блок или ~2.8 КБ CSV) без ожидания TCP,
+// остальные задачи идут между порциями
+void runLogStreamJob() { webServer.serviceLogStream(); }
+
+void runSensorJob() {
+  // Индикатор читает результат сам, по таймеру
+  PROFILE_STAGE(STAGE_SENSOR_UPDATE);
+  sensorManager.sample();
+  syncSensorRate();
+
+  SensorData data = sensorManager.getCachedData();
+
+  // Запись - после стабилизации фильтров. Здесь только кодирование в RAM,
+  // во flash пишет задача регистратора
+  if (sensorManager.isWarmedUp()) {
+    recorder.record(data.timestamp, data, sensorManager.getRawData());
+  }
+
+  // UDP - каждый сэмпл, независимо от числа слушателей
+  if (udpTelemetry.isEnabled()) {
+    udpTelemetry.send(data, sensorManager.getLastSampleMicros(),
+                      ConfigManager::getAxisSwap());
+  }
+}
+
+void runBroadcastJob() {
+  uint8_t clientCount = webServer.getClientCount();
+  if (clientCount > 0 && clientCount <= MAX_WS_CLIENTS) {
+    PROFILE_STAGE(STAGE_BROADCAST);
+    webServer.broadcastSensorData();
+    stats.wsMessagesSent++;
+  } else if (clientCount > MAX_WS_CLIENTS) {
+    stats.wsErrors++;
+    if (DEBUG_MODE) {
+      Serial.printf("Too many clients: %d\n", clientCount);
+    }
+  }
+}
+
+void runNetworkJob() {
+  networkManager.update();
+
+  if (bootTimings.networkUpMs == 0 &&
+      networkManager.getState() == NetworkManager::STATE_CONNECTED) {
+    bootTimings.networkUpMs = millis();
+  }
+  reportBootTimings();
+}
+
+void runPowerJob() {
+  powerManager.setSleepAfterMs(ConfigManager::getSleepAfterS() * 1000UL);
+  // Идущая выгрузка /log держит WiFi, как подключённый клиент
+  uint8_t clients =
+      webServer.getClientCount() + (webServer.isLogStreaming() ? 1 : 0);
+  powerManager.update(sensorManager.getMotionLevel(), clients,
+                      udpTelemetry.isEnabled());
+}
+
+// 16 чтений ADC, без ожидания: HTTP отдаёт результат из кеша
+void runBatteryJob() { batteryMonitor.sample(); }
+
+// Подхват настроек, изменённых через веб
+void runSettingsJob() {
+  loadLevelRange();
+  loadHysteresis();
+  loadIndicatorFade();
+  loadUdpTelemetry();
+  recorder.setIntervalMs(ConfigManager::getRecordIntervalMs());
+  scheduler.setPeriod(jobBroadcast, broadcastIntervalMs());
+}
+
+#if PIPELINE_BENCHMARK
+// Первый прогон - после стабилизации фильтров, дальше по 'b' в Serial
+// (например, после подключения браузера, чтобы broadcast был настоящим)
+void runBenchmarkJob() {
+  static bool done = false;
+  if (!sensorManager.isWarmedUp()) return;
+
+  bool requested = false;
+  while (Serial.available() > 0) {
+    if (Serial.read() == 'b') requested = true;
+  }
+  if (done && !requested) return;
+
+  benchmark.run(PIPELINE_BENCHMARK_ITERATIONS, FILTER_PROFILE);
+  done = true;
+}
+#endif
+
+void setupScheduler() {
+  // Приоритет решает только при одинаковом сроке; бюджеты - ориентиры
+  // для поиска задачи, которая задерживает остальные
+  jobSensors = scheduler.addJob("sensors", sensorManager.getUpdateIntervalMs(),
+                                4, 3000, runSensorJob);
+  jobHttp = scheduler.addJob(
+      "http", PowerManager::httpPollMs(powerManager.getMode()), 3, 5000,
+      runHttpJob);
+  jobBroadcast = scheduler.addJob("broadcast", broadcastIntervalMs(), 2, 8000,
+                                  runBroadcastJob);
+  jobNetwork =
+      scheduler.addJob("network", NETWORK_POLL_MS, 1, 2000, runNetworkJob);
+  jobBattery = scheduler.addJob("battery", BATTERY_SAMPLE_MS, 0, 1500,
+                                runBatteryJob);
+  jobPower = scheduler.addJob("power", POWER_CHECK_MS, 1, 1000, runPowerJob);
+  jobSettings =
+      scheduler.addJob("settings", SETTINGS_RELOAD_MS, 1, 2000, runSettingsJob);
+  jobStats = scheduler.addJob("stats", STATS_PRINT_MS, 0, 0, printSystemInfo);
+  jobLogStream =
+      scheduler.addJob("log", LOG_STREAM_MS, 0, 3000, runLogStreamJob);
+#if PIPELINE_BENCHMARK
+  jobBenchmark = scheduler.addJob("benchmark", BENCHMARK_POLL_MS, 0, 0,
+                                  runBenchmarkJob);
+#endif
+}
+
 // ===== ARDUINO SETUP =====
 void setup() {
   Serial.begin(115200);
@@ -138,17 +635,36 @@ void setup() {
     Serial.println("FATAL: LittleFS init failed!");
     while (1) delay(1000);
   }
+  FileManager::setVerbose(DEBUG_MODE);
 
   // 2. Конфигурация
-  ConfigManager::initialize();
+  ConfigManager::initialize(settingsFs);
   ConfigManager::printConfig();
 
+  // Регистратор: файл-кольцо создаётся при первом запуске
+  if (recorder.begin() && recorder.startWriterTask()) {
+    recorder.setIntervalMs(ConfigManager::getRecordIntervalMs());
+  }
+
   // 3. Датчики
+#if SENSOR_SIMULATOR
+  Serial.printf("Sensor simulator: %s profile\n",
+                SensorSimulator::profileName(SIMULATOR_PROFILE));
+#else
+  if (!i2cBus.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FREQUENCY)) {
+    Serial.println("FATAL: I2C init failed!");
+    while (1) delay(1000);
+  }
+  Serial.printf("I2C initialized (SDA: %d, SCL: %d, %lu kHz)\n", I2C_SDA_PIN,
+                I2C_SCL_PIN, I2C_FREQUENCY / 1000);
+#endif
+
   Serial.printf("Initializing sensors with %s profile...\n",
                 FILTER_PROFILE == MultiChannelKalman::AGGRESSIVE ? "AGGRESSIVE"
-                : FILTER_PROFILE == MultiChannelKalman::BALANCED
-                    ? "BALANCED"
-                    : "RESPONSIVE");
+                : FILTER_PROFILE == MultiChannelKalman::BALANCED ? "BALANCED"
+                : FILTER_PROFILE == MultiChannelKalman::RESPONSIVE
+                    ? "RESPONSIVE"
+                    : "TUNED");
 
   if (!sensorManager.begin(FILTER_PROFILE)) {
     Serial.println("FATAL: Sensor init failed!");
@@ -157,78 +673,54 @@ void setup() {
 
   sensorManager.setDebugMode(DEBUG_MODE);
 
-  // 4. Индикатор
+  // 4. Индикатор: загорается сам, как только фильтры стабилизируются
   levelIndicator.begin();
   loadLevelRange();
+  loadHysteresis();
+  loadIndicatorFade();
+  startIndicatorRefresh();
 
-  // 5. WiFi
+  // 5. WiFi (в фоне)
   setupWiFi();
 
-  // 6. Веб-сервер
+  // 6. Аккумулятор: дальше замеры в фоне, веб-сервер отдаёт кеш
+  batteryMonitor.begin();
+
+  // 7. Веб-сервер: сокет слушает сразу, запросы пойдут после получения IP
+  webServer.setMetricsHook(writeDeviceMetrics);
+  webServer.setBatteryMonitor(&batteryMonitor);
+  webServer.setPowerManager(&powerManager);
+  webServer.setSampleRecorder(&recorder);
   webServer.begin();
+  bootTimings.webServerMs = millis();
+  loadUdpTelemetry();
 
   Serial.println("\n=== System Ready ===");
-  Serial.printf("Indicator update: %d Hz\n", 1000 / INDICATOR_UPDATE_MS);
-  Serial.printf("WebSocket update: %d Hz\n", 1000 / WEBSOCKET_UPDATE_MS);
+  Serial.printf("Indicator update: %lu Hz (fade %s)\n",
+                1000 / indicatorUpdateMs(),
+                levelIndicator.isFadeEnabled() ? "ON" : "OFF");
+  Serial.printf("WebSocket update: %d Hz\n",
+                1000 / ConfigManager::getWsIntervalMs());
   Serial.printf("Max WS clients: %d\n", MAX_WS_CLIENTS);
 
-  // Стабилизация
-  Serial.println("Stabilizing filters...");
-  for (int i = 0; i < 20; i++) {
-    sensorManager.update();
-    delay(50);
-  }
-  Serial.println("Ready!\n");
-
+  // Стабилизация фильтров идёт в задаче "sensors": первые сэмплы
+  // не публикуются индикатору (SensorManager::isWarmedUp)
+  powerManager.setModeHandler(onPowerModeChange);
+  powerManager.setSleepAfterMs(ConfigManager::getSleepAfterS() * 1000UL);
+  setupScheduler();
+  Serial.printf("Setup done in %lu ms\n\n", millis());
   stats.lastStatsReset = millis();
 }
 
 // ===== ARDUINO LOOP =====
 void loop() {
-  stats.loopCount++;
-  unsigned long now = millis();
+  {
+    PROFILE_STAGE(STAGE_LOOP);
+    stats.loopCount++;
 
-  // Обработка Web сервера
-  webServer.handleClients();
-
-  // 1. Обновление датчиков (ВСЕГДА)
-  sensorManager.update();
-
-  // 2. Светодиодная индикация (33 Hz - без изменений)
-  static unsigned long lastIndicatorUpdate = 0;
-  if (now - lastIndicatorUpdate >= INDICATOR_UPDATE_MS) {
-    float roll = sensorManager.getRoll();
-    levelIndicator.update(roll);
-    lastIndicatorUpdate = now;
-  }
-
-  // 3. WebSocket (5 Hz - УМЕНЬШЕНО!)
-  static unsigned long lastBroadcast = 0;
-  if (now - lastBroadcast >= WEBSOCKET_UPDATE_MS) {
-    uint8_t clientCount = webServer.getClientCount();
-    if (clientCount > 0 && clientCount <= MAX_WS_CLIENTS) {
-      webServer.broadcastSensorData();
-      stats.wsMessagesSent++;
-    } else if (clientCount > MAX_WS_CLIENTS) {
-      stats.wsErrors++;
-      if (DEBUG_MODE) {
-        Serial.printf("Too many clients: %d\n", clientCount);
-      }
-    }
-    lastBroadcast = now;
+    scheduler.run();
   }
 
-  // 4. Очистка соединений (каждые 10 секунд вместо 5)
-  static unsigned long lastCleanup = 0;
-  if (now - lastCleanup >= 10000) {
-    webServer.handleClients();
-    lastCleanup = now;
-  }
-
-  // 5. Статистика (каждые 60 секунд)
-  static unsigned long lastInfoPrint = 0;
-  if (now - lastInfoPrint >= 60000) {
-    printSystemInfo();
-    lastInfoPrint = now;
-  }
-}
\ No newline at end of file
+  // Простой до ближайшей задачи: vTaskDelay или light sleep
+  powerManager.waitForNextJob(scheduler.msUntilNextDeadline());
+}
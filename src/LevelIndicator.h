@@ -4,19 +4,49 @@
 #ifndef LEVEL_INDICATOR_H
 #define LEVEL_INDICATOR_H
 
-#include <Arduino.h>
+#include "AngleSnapshot.h"
+#include "Hal.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
 
 class LevelIndicator {
  public:
+  // Зоны индикации
+  enum Zone : uint8_t {
+    ZONE_UNKNOWN,  // До первого update()
+    ZONE_BELOW,    // Ниже rangeMin - синий градиент
+    ZONE_INSIDE,   // Внутри диапазона - зелёный
+    ZONE_ABOVE     // Выше rangeMax - красный градиент
+  };
+
+  static constexpr float MAX_HYSTERESIS = 5.0f;  // Градусы
+
+  // Задержка "измерение датчика -> запись в LEDC" (микросекунды)
+  struct LatencyStats {
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint32_t meanUs;
+    uint32_t boundUs;    // Допустимая граница
+    uint32_t samples;    // Сколько сэмплов доведено до светодиодов
+    uint32_t overBound;  // Сколько из них превысили границу
+  };
+
   /**
    * @brief Конструктор
+   * @param pwm Каналы ШИМ светодиодов
+   * @param clock Часы (окончание fade, время первого вывода)
    * @param positive1-3 Пины для положительного наклона (зелёные)
    * @param negative1-3 Пины для отрицательного наклона (красные) 
    * @param neutral Пин для нейтрального положения (синий)
    */
-  LevelIndicator(uint8_t positive1, uint8_t positive2, uint8_t positive3,
-                 uint8_t negative1, uint8_t negative2, uint8_t negative3,
-                 uint8_t neutral);
+  LevelIndicator(HalPwm& pwm, HalClock& clock, uint8_t positive1,
+                 uint8_t positive2, uint8_t positive3, uint8_t negative1,
+                 uint8_t negative2, uint8_t negative3, uint8_t neutral);
+  ~LevelIndicator();
 
   /**
    * @brief Инициализация пинов
@@ -29,6 +59,42 @@ class LevelIndicator {
    */
   void update(float angle);
 
+#ifdef ARDUINO
+  /**
+   * @brief Запустить обновление от esp_timer, независимо от loop()
+   * Таймер с периодом periodMs читает последний угол из source без
+   * блокировок. Повторный вызов меняет период.
+   *
+   * @param source Снимок угла (обычно SensorManager::getRollSnapshot())
+   * @param periodMs Период обновления (мс)
+   */
+  bool startAutoRefresh(const AngleSnapshot& source, uint32_t periodMs);
+
+  /**
+   * @brief Остановить обновление от таймера
+   */
+  void stopAutoRefresh();
+#endif
+
+  bool isAutoRefreshing() const { return refreshSource != nullptr; }
+  uint32_t getRefreshPeriodMs() const { return refreshPeriodMs; }
+
+  /**
+   * @brief Граница задержки измерение -> светодиод для статистики
+   * @param boundUs Превышение считается в LatencyStats::overBound
+   */
+  void setLatencyBound(uint32_t boundUs) { latencyBoundUs = boundUs; }
+
+  /**
+   * @brief Статистика задержки (только в режиме таймера)
+   */
+  LatencyStats getLatencyStats() const;
+
+  /**
+   * @brief Время (мс) первого вывода реального угла на светодиоды (0 - нет)
+   */
+  uint32_t getFirstRenderMs() const { return firstRenderMs; }
+
   /**
    * @brief Установить рабочий диапазон (min, max)
    * Внутри диапазона: зелёные светодиоды (градиент)
@@ -39,6 +105,31 @@ class LevelIndicator {
    */
   void setRange(float min, float max);
 
+  /**
+   * @brief Установить гистерезис вокруг границ диапазона
+   * Зона меняется, только когда угол выходит за границу дальше, чем на
+   * полуширину полосы: выход из диапазона при angle < rangeMin - lowerBand,
+   * возврат при angle >= rangeMin + lowerBand (аналогично для rangeMax).
+   *
+   * @param lowerBand Полуширина полосы вокруг rangeMin (градусы)
+   * @param upperBand Полуширина полосы вокруг rangeMax (градусы)
+   */
+  void setHysteresis(float lowerBand, float upperBand);
+
+  /**
+   * @brief Получить текущий гистерезис
+   */
+  void getHysteresis(float& lowerBand, float& upperBand) const {
+    lowerBand = hysteresisLower;
+    upperBand = hysteresisUpper;
+  }
+
+  /**
+   * @brief Текущая зона и число переходов между зонами
+   */
+  Zone getZone() const { return zone; }
+  uint32_t getZoneTransitions() const { return zoneTransitions; }
+
   /**
    * @brief Установить пороги срабатывания для градиента
    * @param low Первый уровень (по умолчанию 33% от диапазона)
@@ -53,6 +144,19 @@ class LevelIndicator {
   void setBrightness(uint8_t lowBrightness, uint8_t mediumBrightness,
                      uint8_t highBrightness);
 
+  /**
+   * @brief Режим аппаратного плавного перехода (LEDC fade)
+   * Яркость плавно меняется аппаратно за fadeTimeMs, поэтому update()
+   * можно вызывать реже без ступенек на светодиодах.
+   *
+   * @param enabled true - переходы через LEDC fade, false - мгновенно
+   * @param fadeTimeMs Длительность перехода (мс)
+   */
+  void setFadeMode(bool enabled, uint16_t fadeTimeMs);
+
+  bool isFadeEnabled() const { return fadeEnabled; }
+  uint16_t getFadeTime() const { return fadeTimeMs; }
+
   /**
    * @brief Получить текущий диапазон
    */
@@ -62,11 +166,24 @@ class LevelIndicator {
   }
 
   /**
-   * @brief Выключить все светодиоды
+   * @brief Выключить все светодиоды сразу, прервав идущие переходы fade
    */
   void clear();
 
+  /**
+   * @brief Статистика записей в LEDC
+   * @param written Реально выполненные записи в ШИМ
+   * @param skipped Пропущенные (скважность не изменилась)
+   */
+  void getWriteStats(uint32_t& written, uint32_t& skipped) const {
+    written = ledWrites;
+    skipped = ledWritesSkipped;
+  }
+
  private:
+  HalPwm& pwm;
+  HalClock& clock;
+
   // Пины светодиодов
   uint8_t pinPositive1, pinPositive2, pinPositive3;  // Положительный (зелёные)
   uint8_t pinNegative1, pinNegative2, pinNegative3;  // Отрицательный (красные)
@@ -76,6 +193,34 @@ class LevelIndicator {
   float rangeMin;  // По умолчанию -45°
   float rangeMax;  // По умолчанию +45°
 
+  // Гистерезис вокруг границ (полуширина полосы, градусы)
+  float hysteresisLower;
+  float hysteresisUpper;
+
+  // Автомат зон
+  Zone zone;
+  uint32_t zoneTransitions;
+
+#ifdef ARDUINO
+  // Защита настроек: update() может идти из задачи esp_timer
+  SemaphoreHandle_t mutex;
+
+  // Обновление от таймера
+  esp_timer_handle_t refreshTimer;
+#endif
+  const AngleSnapshot* refreshSource;
+  uint32_t refreshPeriodMs;
+  uint32_t lastAppliedSampleMicros;
+  volatile uint32_t firstRenderMs;
+
+  // Задержка измерение -> светодиод
+  uint32_t latencyBoundUs;
+  uint32_t latencyLastUs;
+  uint32_t latencyMaxUs;
+  uint64_t latencySumUs;
+  uint32_t latencySamples;
+  uint32_t latencyOverBound;
+
   // Пороги срабатывания (в процентах от диапазона)
   float thresholdLow;     // 33% диапазона
   float thresholdMedium;  // 66% диапазона
@@ -95,13 +240,47 @@ class LevelIndicator {
   static const uint8_t PWM_CHANNEL_NEG3 = 6;
   static const uint8_t PWM_CHANNEL_NEUTRAL = 7;
 
+  static const uint8_t PWM_CHANNEL_COUNT = 7;  // Каналы 1..7
+
   static const uint32_t PWM_FREQ = 5000;    // 5 kHz
   static const uint8_t PWM_RESOLUTION = 8;  // 8 бит (0-255)
 
+  // Последняя записанная скважность по каналам (-1 = неизвестна)
+  int16_t lastDuty[PWM_CHANNEL_COUNT];
+
+  // Аппаратный fade
+  bool fadeEnabled;
+  uint16_t fadeTimeMs;
+  uint32_t fadeEndMs[PWM_CHANNEL_COUNT];  // Окончание текущего fade
+
+  // Счётчики записей в LEDC
+  uint32_t ledWrites;
+  uint32_t ledWritesSkipped;
+
+  // Таблица градиента: расстояние за границей диапазона -> яркость 3 LED.
+  // Не зависит от rangeMin/rangeMax, поэтому пересчитывается только
+  // при изменении порогов или яркости.
+  static const uint16_t GRADIENT_LUT_SIZE = 256;
+  static constexpr float GRADIENT_MAX_DISTANCE = 90.0f;  // 90° = 100%
+  static constexpr float GRADIENT_LUT_SCALE =
+      (GRADIENT_LUT_SIZE - 1) / GRADIENT_MAX_DISTANCE;
+  uint8_t gradientLut[GRADIENT_LUT_SIZE][3];
+  uint16_t gradientFirstVisible;  // Первая строка, где первый LED не 0
+
   // Вспомогательные функции
   void setupPWM();
   void setLED(uint8_t channel, uint8_t brightness);
-  
+  void render(float angle);
+  bool lock();
+  void unlock();
+#ifdef ARDUINO
+  void refreshFromSnapshot();
+  static void onRefreshTimer(void* arg);
+#endif
+  Zone nextZone(float angle) const;
+  void rebuildGradientLut();
+  const uint8_t* lookupGradient(float distance) const;
+
   // Расчёт градиента внутри/вне диапазона
   void calculateGradient(float angle, float rangeSize, 
                         uint8_t& level1, uint8_t& level2, uint8_t& level3);
@@ -4,14 +4,23 @@
 // Статический указатель для callback
 LevelWebServer* LevelWebServer::instance = nullptr;
 
-LevelWebServer::LevelWebServer(SensorManager& sensorMgr)
+LevelWebServer::LevelWebServer(SensorManager& sensorMgr,
+                               const HalNetwork& network)
     : httpServer(80),
       wsServer(81),  // WebSocket на порту 81
       sensorManager(sensorMgr),
+      network(network),
       wsDebugEnabled(true),
       lastBroadcastTime(0),
       broadcastCount(0),
-      wsClientCount(0) {
+      wsClientCount(0),
+      wsFramesSent(0),
+      wsBytesSent(0),
+      wsFramesDropped(0),
+      metricsHook(nullptr),
+      batteryMonitor(nullptr),
+      powerManager(nullptr),
+      recorder(nullptr) {
   instance = this;
 }
 
@@ -20,6 +29,11 @@ void LevelWebServer::begin() {
 
   // Запускаем HTTP сервер
   setupRoutes();
+
+  // Докачка /log
+  static const char* headerKeys[] = {"Range"};
+  httpServer.collectHeaders(headerKeys, 1);
+
   httpServer.begin();
   Serial.println("HTTP Server started on port 80");
 
@@ -61,7 +75,12 @@ void LevelWebServer::webSocketEvent(uint8_t num, WStype_t type,
 
       // Отправляем начальные данные
       String json = instance->getSensorDataJson();
-      instance->wsServer.sendTXT(num, json);
+      if (instance->wsServer.sendTXT(num, json)) {
+        instance->wsFramesSent++;
+        instance->wsBytesSent += json.length();
+      } else {
+        instance->wsFramesDropped++;
+      }
       Serial.printf("[WS]   Sent initial data to #%u (%d bytes)\n", num,
                     json.length());
       break;
@@ -102,7 +121,7 @@ void LevelWebServer::broadcastSensorData() {
   unsigned long now = millis();
 
   // Проверка минимального интервала
-  if (now - lastBroadcastTime < BROADCAST_INTERVAL_MS) {
+  if (now - lastBroadcastTime < MIN_BROADCAST_INTERVAL_MS) {
     return;
   }
 
@@ -120,6 +139,7 @@ void LevelWebServer::broadcastSensorData() {
   if (freeHeap < 10000) {
     Serial.printf("[WS] ⚠ Low memory (%u bytes), skipping broadcast\n",
                   freeHeap);
+    wsFramesDropped += wsClientCount;
     return;
   }
 
@@ -133,7 +153,12 @@ void LevelWebServer::broadcastSensorData() {
 
   // Отправляем всем клиентам
   // broadcastTXT автоматически пропускает отключённых клиентов
-  wsServer.broadcastTXT(json);
+  if (wsServer.broadcastTXT(json)) {
+    wsFramesSent += wsClientCount;
+    wsBytesSent += jsonSize * wsClientCount;
+  } else {
+    wsFramesDropped += wsClientCount;
+  }
   broadcastCount++;
   lastBroadcastTime = now;
 
@@ -166,14 +191,18 @@ void LevelWebServer::handleClients() {
 }
 
 String LevelWebServer::getSensorDataJson() {
-  StaticJsonDocument<256> doc;
-
   SensorData data = sensorManager.getCachedData();
 
   if (!data.valid) {
     Serial.println("[WS] ⚠ WARNING: Sensor data not valid!");
   }
 
+  return sensorDataToJson(data);
+}
+
+String LevelWebServer::sensorDataToJson(const SensorData& data) {
+  StaticJsonDocument<256> doc;
+
   float roll = data.roll;
   float pitch = data.pitch;
 
@@ -191,10 +220,14 @@ String LevelWebServer::getSensorDataJson() {
   accel["y"] = serialized(String(data.accel_y, 2));
   accel["z"] = serialized(String(data.accel_z, 2));
 
-  JsonObject mag = doc["magnetometer"].to<JsonObject>();
-  mag["x"] = serialized(String(data.mag_x, 1));
-  mag["y"] = serialized(String(data.mag_y, 1));
-  mag["z"] = serialized(String(data.mag_z, 1));
+  // Магнитометр не читается, пока курс выключен
+  if (sensorManager.isHeadingEnabled()) {
+    JsonObject mag = doc["magnetometer"].to<JsonObject>();
+    mag["x"] = serialized(String(data.mag_x, 1));
+    mag["y"] = serialized(String(data.mag_y, 1));
+    mag["z"] = serialized(String(data.mag_z, 1));
+    doc["heading"] = serialized(String(data.heading, 1));
+  }
 
   doc["roll"] = serialized(String(roll, 2));
   doc["pitch"] = serialized(String(pitch, 2));
@@ -205,6 +238,330 @@ String LevelWebServer::getSensorDataJson() {
   return output;
 }
 
+void LevelWebServer::sendMetricsChunk(void* context, const char* data,
+                                      size_t length) {
+  static_cast<LevelWebServer*>(context)->httpServer.sendContent(data, length);
+}
+
+void LevelWebServer::streamMetrics() {
+  // Длина заранее неизвестна: HTTP/1.1 chunked, конец - пустой кусок
+  httpServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer.send(200, "text/plain; version=0.0.4", "");
+
+  MetricsWriter metrics(metricsBuffer, METRICS_CHUNK_SIZE, sendMetricsChunk,
+                        this);
+
+  metrics.gauge("level_uptime_seconds", "Time since boot",
+                (uint32_t)(millis() / 1000));
+
+  // Датчики
+  SensorStats sensor = sensorManager.getStats();
+  metrics.counter("level_sensor_samples_total", "Processed sensor samples",
+                  sensor.samples);
+  metrics.gauge("level_sensor_sample_rate_hz",
+                "Achieved sample rate over the last second",
+                sensor.sampleRateHz);
+  metrics.counter("level_sensor_deadline_misses_total",
+                  "Sensor sampling periods missed", sensor.deadlineMisses);
+  metrics.gauge("level_sensor_interval_ms", "Current sensor sampling period",
+                (uint32_t)sensorManager.getUpdateIntervalMs());
+  metrics.gauge("level_sensor_accel_odr_hz", "Accelerometer output data rate",
+                (uint32_t)sensorManager.getAccelOdrHz());
+  metrics.counter("level_sensor_rate_switches_total",
+                  "Switches between motion and rest sampling rates",
+                  sensor.rateSwitches);
+
+  metrics.family("level_i2c_errors_total", "counter",
+                 "Failed sensor reads over I2C");
+  metrics.value("level_i2c_errors_total", sensor.accelErrors,
+                "sensor=\"accel\"");
+  metrics.value("level_i2c_errors_total", sensor.magErrors, "sensor=\"mag\"");
+  metrics.value("level_i2c_errors_total", sensor.gyroErrors,
+                "sensor=\"gyro\"");
+
+  const OutlierRejector& outliers = sensorManager.getOutlierRejector();
+  char channelLabel[32];
+  metrics.family("level_outliers_total", "counter",
+                 "Samples replaced by outlier rejection");
+  for (uint8_t ch = 0; ch < outliers.getChannelCount(); ch++) {
+    snprintf(channelLabel, sizeof(channelLabel), "channel=\"%s\"",
+             SensorPipeline::channelName(ch));
+    metrics.value("level_outliers_total", outliers.getRejected(ch),
+                  channelLabel);
+  }
+
+  // WebSocket
+  metrics.gauge("level_ws_clients", "Connected WebSocket clients",
+                (uint32_t)wsClientCount);
+  metrics.counter("level_ws_frames_sent_total",
+                  "WebSocket frames sent (per client)", wsFramesSent);
+  metrics.counter("level_ws_bytes_sent_total",
+                  "WebSocket payload bytes sent (per client)", wsBytesSent);
+  metrics.counter("level_ws_frames_dropped_total",
+                  "WebSocket frames not delivered", wsFramesDropped);
+
+  // Выгрузка записи
+  metrics.counter("level_log_downloads_total", "Completed /log downloads",
+                  logStreamer.getStreamsCompleted());
+  metrics.counter("level_log_downloads_aborted_total",
+                  "/log downloads closed before the end",
+                  logStreamer.getStreamsAborted());
+  metrics.counter("level_log_bytes_sent_total", "/log body bytes sent",
+                  logStreamer.getBytesSent());
+
+  // Flash
+  metrics.counter("level_flash_writes_total", "Settings file writes",
+                  ConfigManager::getFlashWrites() +
+                      FileManager::getWriteCount());
+
+  // Память
+  metrics.gauge("level_heap_free_bytes", "Free heap",
+                (uint32_t)ESP.getFreeHeap());
+  metrics.gauge("level_heap_min_free_bytes", "Lowest free heap since boot",
+                (uint32_t)ESP.getMinFreeHeap());
+  metrics.gauge("level_heap_largest_block_bytes", "Largest allocatable block",
+                (uint32_t)ESP.getMaxAllocHeap());
+
+  // Wi-Fi (только в режиме STA)
+  if (network.isConnected()) {
+    metrics.gauge("level_wifi_rssi_dbm", "Wi-Fi signal strength",
+                  network.rssi());
+  }
+
+  // Длительность этапов loop()
+  if (LoopProfiler::isEnabled()) {
+    static const float QUANTILES[] = {0.5f, 0.9f, 0.99f};
+    char labels[64];
+
+    metrics.family("level_stage_duration_us", "summary",
+                   "Loop stage duration in microseconds");
+    for (uint8_t i = 0; i < LoopProfiler::STAGE_COUNT; i++) {
+      LoopProfiler::Stage stage = (LoopProfiler::Stage)i;
+      LoopProfiler::StageStats stats;
+      LoopProfiler::getStats(stage, stats);
+
+      for (float q : QUANTILES) {
+        snprintf(labels, sizeof(labels), "stage=\"%s\",quantile=\"%g\"",
+                 LoopProfiler::stageName(stage), q);
+        metrics.value("level_stage_duration_us",
+                      LoopProfiler::quantileUs(stage, q), labels);
+      }
+
+      snprintf(labels, sizeof(labels), "stage=\"%s\"",
+               LoopProfiler::stageName(stage));
+      metrics.value("level_stage_duration_us_sum",
+                    (float)stats.meanUs * stats.count, labels);
+      metrics.value("level_stage_duration_us_count", stats.count, labels);
+    }
+  }
+
+  if (metricsHook) {
+    metricsHook(metrics);
+  }
+
+  metrics.flush();
+  httpServer.sendContent("");
+
+  if (metrics.overflowed()) {
+    Serial.println("[METRICS] ⚠ Line longer than the chunk buffer, output cut");
+  }
+}
+
+void LevelWebServer::sendParamError(const char* name, ParseError error) {
+  char body[128];
+  int length;
+  if (error == PARSE_MISSING) {
+    length = snprintf(body, sizeof(body),
+                      "{\"error\":\"Missing parameter\",\"param\":\"%s\"}",
+                      name);
+  } else {
+    length = snprintf(
+        body, sizeof(body),
+        "{\"error\":\"Invalid parameter\",\"param\":\"%s\",\"reason\":\"%s\"}",
+        name, ParamParser::errorName(error));
+  }
+  if (length < 0 || (size_t)length >= sizeof(body)) {
+    length = strlen(body);
+  }
+
+  Serial.printf("[HTTP] Parameter '%s': %s\n", name,
+                ParamParser::errorName(error));
+  sendCORSHeaders();
+  httpServer.send_P(400, "application/json", body, length);
+}
+
+bool LevelWebServer::readFloatParam(const char* name, float& out) {
+  ParseError error = ParamParser::parseFloat(httpServer.param(name), out);
+  if (error != PARSE_OK) {
+    sendParamError(name, error);
+    return false;
+  }
+  return true;
+}
+
+bool LevelWebServer::readFloatParam(const char* name, float min, float max,
+                                    float& out) {
+  ParseError error =
+      ParamParser::parseFloat(httpServer.param(name), min, max, out);
+  if (error != PARSE_OK) {
+    sendParamError(name, error);
+    return false;
+  }
+  return true;
+}
+
+bool LevelWebServer::readIntParam(const char* name, long min, long max,
+                                  long& out) {
+  ParseError error =
+      ParamParser::parseInt(httpServer.param(name), min, max, out);
+  if (error != PARSE_OK) {
+    sendParamError(name, error);
+    return false;
+  }
+  return true;
+}
+
+bool LevelWebServer::readBoolParam(const char* name, bool& out) {
+  ParseError error = ParamParser::parseBool(httpServer.param(name), out);
+  if (error != PARSE_OK) {
+    sendParamError(name, error);
+    return false;
+  }
+  return true;
+}
+
+void LevelWebServer::handleLogDownload() {
+  Serial.println(F("GET /log"));
+
+  if (!recorder || logStreamer.isActive()) {
+    // Буфер блока один: вторая выгрузка ждёт первую
+    sendCORSHeaders();
+    if (recorder) httpServer.sendHeader("Retry-After", "5");
+    httpServer.send(503, "application/json",
+                    recorder ? "{\"error\":\"Log download in progress\"}"
+                             : "{\"error\":\"Recorder not available\"}");
+    return;
+  }
+
+  LogStreamer::Format format = LogStreamer::FORMAT_BINARY;
+  ParamView formatParam = httpServer.param("format");
+  if (formatParam.isNull() || formatParam.equalsIgnoreCase("bin")) {
+    format = LogStreamer::FORMAT_BINARY;
+  } else if (formatParam.equalsIgnoreCase("csv")) {
+    format = LogStreamer::FORMAT_CSV;
+  } else {
+    sendParamError("format", PARSE_MALFORMED);
+    return;
+  }
+
+  long fromSequence = 0;
+  if (!httpServer.param("from_seq").isNull() &&
+      !readIntParam("from_seq", 0, LONG_MAX, fromSequence)) {
+    return;
+  }
+
+  logStreamer.scan(*recorder, (uint32_t)fromSequence);
+  uint32_t total = logStreamer.getTotalBytes();
+
+  // CSV: размер заранее неизвестен, докачка - по from_seq (целыми блоками)
+  if (format == LogStreamer::FORMAT_CSV) {
+    if (sendLogHeaders(format, false, 0, 0)) {
+      logStreamer.start(httpServer.client(), format);
+    }
+    return;
+  }
+
+  // Двоичный: ?offset=N или заголовок Range
+  uint32_t first = 0;
+  uint32_t last = total > 0 ? total - 1 : 0;
+  ParseError rangeError;
+
+  if (!httpServer.param("offset").isNull()) {
+    long offset;
+    if (!readIntParam("offset", 0, LONG_MAX, offset)) return;
+    rangeError = (uint32_t)offset < total ? PARSE_OK : PARSE_OUT_OF_RANGE;
+    first = (uint32_t)offset;
+  } else {
+    rangeError = ParamParser::parseByteRange(httpServer.header("Range"), total,
+                                             first, last);
+  }
+
+  if (rangeError == PARSE_OUT_OF_RANGE) {
+    char contentRange[32];
+    snprintf(contentRange, sizeof(contentRange), "bytes */%lu",
+             (unsigned long)total);
+    sendCORSHeaders();
+    httpServer.sendHeader("Content-Range", contentRange);
+    httpServer.send(416, "application/json",
+                    "{\"error\":\"Range not satisfiable\"}");
+    return;
+  }
+  // Испорченный или составной Range игнорируется: отдаётся весь файл
+  bool partial = rangeError == PARSE_OK;
+  if (!partial) {
+    first = 0;
+    last = total > 0 ? total - 1 : 0;
+  }
+
+  if (sendLogHeaders(format, partial, first, last) && total > 0) {
+    logStreamer.start(httpServer.client(), format, first, last);
+  }
+}
+
+bool LevelWebServer::sendLogHeaders(LogStreamer::Format format, bool partial,
+                                    uint32_t first, uint32_t last) {
+  bool csv = format == LogStreamer::FORMAT_CSV;
+  uint32_t total = logStreamer.getTotalBytes();
+  uint32_t length = total > 0 ? last - first + 1 : 0;
+
+  char headers[512];
+  int n = snprintf(headers, sizeof(headers),
+                   "HTTP/1.1 %s\r\n"
+                   "Content-Type: %s\r\n"
+                   "Content-Disposition: attachment; filename=\"%s\"\r\n",
+                   partial ? "206 Partial Content" : "200 OK",
+                   csv ? "text/csv" : "application/octet-stream",
+                   csv ? "level.csv" : "level.rec");
+
+  if (csv) {
+    n += snprintf(headers + n, sizeof(headers) - n,
+                  "Transfer-Encoding: chunked\r\n");
+  } else {
+    n += snprintf(headers + n, sizeof(headers) - n,
+                  "Content-Length: %lu\r\nAccept-Ranges: bytes\r\n",
+                  (unsigned long)length);
+    if (partial) {
+      n += snprintf(headers + n, sizeof(headers) - n,
+                    "Content-Range: bytes %lu-%lu/%lu\r\n",
+                    (unsigned long)first, (unsigned long)last,
+                    (unsigned long)total);
+    }
+  }
+
+  // Номер первого блока: докачка с тем же from_seq даёт те же смещения,
+  // пока этот блок не перезаписан
+  n += snprintf(headers + n, sizeof(headers) - n,
+                "X-Log-First-Sequence: %lu\r\n"
+                "X-Log-Last-Sequence: %lu\r\n"
+                "Access-Control-Allow-Origin: *\r\n"
+                "Access-Control-Expose-Headers: Content-Range, "
+                "Content-Disposition, X-Log-First-Sequence, "
+                "X-Log-Last-Sequence\r\n"
+                "Connection: close\r\n\r\n",
+                (unsigned long)logStreamer.getFirstSequence(),
+                (unsigned long)logStreamer.getLastSequence());
+
+  if (n <= 0 || (size_t)n >= sizeof(headers)) {
+    Serial.println(F("[LOG] ⚠ Header buffer too small"));
+    return false;
+  }
+
+  Serial.printf("[LOG] %s: %u blocks, bytes %lu-%lu\n", csv ? "CSV" : "Binary",
+                logStreamer.getBlockCount(), (unsigned long)first,
+                (unsigned long)last);
+  return httpServer.client().write((const uint8_t*)headers, n) == (size_t)n;
+}
+
 void LevelWebServer::setupRoutes() {
   // ========== ГЛАВНАЯ СТРАНИЦА ==========
 
@@ -262,35 +619,87 @@ void LevelWebServer::setupRoutes() {
     httpServer.send(200, "application/json", output);
   });
 
+  // ========== PROMETHEUS METRICS ==========
+
+  httpServer.on("/metrics", HTTP_GET, [this]() { streamMetrics(); });
+
+  // ========== LOOP TIMING ==========
+
+  httpServer.on("/stats/loop", HTTP_GET, [this]() {
+    // Сначала все параметры: при ошибке статистика не тронута
+    bool reset = !httpServer.param("reset").isNull();
+    bool changeEnabled = !httpServer.param("enable").isNull();
+    bool enable = LoopProfiler::isEnabled();
+    if (changeEnabled && !readBoolParam("enable", enable)) return;
+
+    StaticJsonDocument<3072> doc;
+    doc["enabled"] = LoopProfiler::isEnabled();
+    doc["cpu_mhz"] = getCpuFrequencyMhz();
+
+    JsonObject stages = doc["stages"].to<JsonObject>();
+    for (uint8_t i = 0; i < LoopProfiler::STAGE_COUNT; i++) {
+      LoopProfiler::Stage stage = (LoopProfiler::Stage)i;
+      LoopProfiler::StageStats stats;
+      LoopProfiler::getStats(stage, stats);
+
+      JsonObject entry = stages[LoopProfiler::stageName(stage)].to<JsonObject>();
+      entry["count"] = stats.count;
+      entry["min_us"] = stats.minUs;
+      entry["mean_us"] = stats.meanUs;
+      entry["max_us"] = stats.maxUs;
+
+      // Гистограмма: [верхняя граница корзины (мкс), количество]
+      JsonArray histogram = entry["histogram"].to<JsonArray>();
+      for (uint8_t b = 0; b < LoopProfiler::HISTOGRAM_BUCKETS; b++) {
+        if (stats.histogram[b] > 0) {
+          JsonArray bucket = histogram.add<JsonArray>();
+          bucket.add(LoopProfiler::bucketUpperUs(b));
+          bucket.add(stats.histogram[b]);
+        }
+      }
+    }
+
+    // Ответ - статистика до сброса
+    if (reset) LoopProfiler::reset();
+    if (changeEnabled) LoopProfiler::setEnabled(enable);
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
   // ========== WIFI SETTINGS ==========
 
   httpServer.on("/set_wifi", HTTP_GET, [this]() {
     Serial.println(F("GET /set_wifi"));
 
-    if (httpServer.hasArg("ssid") && httpServer.hasArg("pass") &&
-        httpServer.hasArg("ip") && httpServer.hasArg("gateway")) {
-      String ssid = httpServer.arg("ssid");
-      String pass = httpServer.arg("pass");
-      String ip = httpServer.arg("ip");
-      String gateway = httpServer.arg("gateway");
+    static const char* const NAMES[] = {"ssid", "pass", "ip", "gateway"};
+    static const char* const PATHS[] = {"/ssid.txt", "/pass.txt", "/ip.txt",
+                                        "/gateway.txt"};
 
-      fileManager.writeFile(LittleFS, "/ssid.txt", ssid.c_str());
-      fileManager.writeFile(LittleFS, "/pass.txt", pass.c_str());
-      fileManager.writeFile(LittleFS, "/ip.txt", ip.c_str());
-      fileManager.writeFile(LittleFS, "/gateway.txt", gateway.c_str());
+    // Строки пишем прямо из буфера запроса
+    ParamView values[4];
+    for (uint8_t i = 0; i < 4; i++) {
+      values[i] = httpServer.param(NAMES[i]);
+      if (values[i].isNull()) {
+        sendParamError(NAMES[i], PARSE_MISSING);
+        return;
+      }
+    }
 
-      Serial.println(F("WiFi credentials saved"));
+    for (uint8_t i = 0; i < 4; i++) {
+      fileManager.writeFile(LittleFS, PATHS[i], values[i].data);
+    }
 
-      sendCORSHeaders();
-      httpServer.send(200, "application/json", "{\"message\":\"success\"}");
+    Serial.println(F("WiFi credentials saved"));
 
-      delay(1000);
-      ESP.restart();
-    } else {
-      sendCORSHeaders();
-      httpServer.send(400, "application/json",
-                      "{\"error\":\"Missing parameters\"}");
-    }
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", "{\"message\":\"success\"}");
+
+    delay(1000);
+    ESP.restart();
   });
 
   httpServer.on("/clear_credentials", HTTP_GET, [this]() {
@@ -314,35 +723,30 @@ void LevelWebServer::setupRoutes() {
   httpServer.on("/set_level_range", HTTP_GET, [this]() {
     Serial.println(F("GET /set_level_range"));
 
-    if (httpServer.hasArg("min") && httpServer.hasArg("max")) {
-      float minAngle = httpServer.arg("min").toFloat();
-      float maxAngle = httpServer.arg("max").toFloat();
+    float minAngle, maxAngle;
+    if (!readFloatParam("min", minAngle) || !readFloatParam("max", maxAngle)) {
+      return;
+    }
 
-      if (!ConfigManager::setLevelRange(minAngle, maxAngle)) {
-        sendCORSHeaders();
-        httpServer.send(400, "application/json",
-                        "{\"error\":\"Invalid range\"}");
-        return;
-      }
+    if (!ConfigManager::setLevelRange(minAngle, maxAngle)) {
+      sendCORSHeaders();
+      httpServer.send(400, "application/json",
+                      "{\"error\":\"Invalid range\"}");
+      return;
+    }
 
-      Serial.printf("Level range updated: %.1f° to %.1f°\n", minAngle,
-                    maxAngle);
+    Serial.printf("Level range updated: %.1f° to %.1f°\n", minAngle, maxAngle);
 
-      StaticJsonDocument<128> doc;
-      doc["message"] = "success";
-      doc["min"] = minAngle;
-      doc["max"] = maxAngle;
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["min"] = minAngle;
+    doc["max"] = maxAngle;
 
-      String output;
-      serializeJson(doc, output);
+    String output;
+    serializeJson(doc, output);
 
-      sendCORSHeaders();
-      httpServer.send(200, "application/json", output);
-    } else {
-      sendCORSHeaders();
-      httpServer.send(400, "application/json",
-                      "{\"error\":\"Missing parameters\"}");
-    }
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
   });
 
   httpServer.on("/get_level_range", HTTP_GET, [this]() {
@@ -364,32 +768,27 @@ void LevelWebServer::setupRoutes() {
   httpServer.on("/set_zero_offset", HTTP_GET, [this]() {
     Serial.println(F("GET /set_zero_offset"));
 
-    if (httpServer.hasArg("offset")) {
-      float offset = httpServer.arg("offset").toFloat();
+    float offset;
+    if (!readFloatParam("offset", offset)) return;
 
-      if (!ConfigManager::setZeroOffset(offset)) {
-        sendCORSHeaders();
-        httpServer.send(400, "application/json",
-                        "{\"error\":\"Invalid offset\"}");
-        return;
-      }
+    if (!ConfigManager::setZeroOffset(offset)) {
+      sendCORSHeaders();
+      httpServer.send(400, "application/json",
+                      "{\"error\":\"Invalid offset\"}");
+      return;
+    }
 
-      Serial.printf("Zero offset updated: %.2f°\n", offset);
+    Serial.printf("Zero offset updated: %.2f°\n", offset);
 
-      StaticJsonDocument<128> doc;
-      doc["message"] = "success";
-      doc["offset"] = offset;
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["offset"] = offset;
 
-      String output;
-      serializeJson(doc, output);
+    String output;
+    serializeJson(doc, output);
 
-      sendCORSHeaders();
-      httpServer.send(200, "application/json", output);
-    } else {
-      sendCORSHeaders();
-      httpServer.send(400, "application/json",
-                      "{\"error\":\"Missing parameter\"}");
-    }
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
   });
 
   httpServer.on("/calibrate_zero", HTTP_GET, [this]() {
@@ -428,51 +827,177 @@ void LevelWebServer::setupRoutes() {
     httpServer.send(200, "application/json", output);
   });
 
-  // ========== AXIS SWAP ==========
+  // ========== ACCEL CALIBRATION ==========
+  // Шесть положений: /accel_cal/capture?position=x_up ... z_down (каждое
+  // ~2 с неподвижно, ход - /accel_cal/status), затем /accel_cal/solve
 
-  httpServer.on("/set_axis_swap", HTTP_GET, [this]() {
-    Serial.println(F("GET /set_axis_swap"));
+  httpServer.on("/accel_cal/capture", HTTP_GET, [this]() {
+    Serial.println(F("GET /accel_cal/capture"));
+
+    ParamView value = httpServer.param("position");
+    if (value.isNull()) {
+      sendParamError("position", PARSE_MISSING);
+      return;
+    }
+
+    int position = 0;
+    while (position < AccelCalibration::POSITION_COUNT &&
+           !value.equalsIgnoreCase(AccelCalibration::positionName(
+               (AccelCalibration::Position)position))) {
+      position++;
+    }
+    if (position == AccelCalibration::POSITION_COUNT) {
+      sendParamError("position", PARSE_MALFORMED);
+      return;
+    }
+
+    sensorManager.startAccelCapture((AccelCalibration::Position)position);
 
-    if (httpServer.hasArg("swap")) {
-      String swapStr = httpServer.arg("swap");
-      swapStr.toLowerCase();
-      bool swap = (swapStr == "true" || swapStr == "1" || swapStr == "yes");
+    StaticJsonDocument<128> doc;
+    doc["message"] = "capturing";
+    doc["position"] =
+        AccelCalibration::positionName((AccelCalibration::Position)position);
+    doc["duration_ms"] = AccelCalibration::CAPTURE_MS;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
 
-      ConfigManager::setAxisSwap(swap);
+  httpServer.on("/accel_cal/status", HTTP_GET, [this]() {
+    Serial.println(F("GET /accel_cal/status"));
+
+    const AccelCalibration& cal = sensorManager.getAccelCalibration();
+
+    StaticJsonDocument<768> doc;
+    doc["status"] = AccelCalibration::statusName(cal.getStatus());
+    doc["position"] = AccelCalibration::positionName(cal.getPosition());
+    doc["progress"] = serialized(String(cal.getProgress(millis()), 2));
+    doc["restarts"] = cal.getRestarts();
+    doc["captured"] = cal.getCapturedCount();
+
+    // Средние показания снятых положений (м/с²)
+    JsonObject positions = doc["positions"].to<JsonObject>();
+    for (int p = 0; p < AccelCalibration::POSITION_COUNT; p++) {
+      AccelCalibration::Position position = (AccelCalibration::Position)p;
+      if (!cal.hasPosition(position)) continue;
+      JsonArray mean =
+          positions[AccelCalibration::positionName(position)].to<JsonArray>();
+      for (int axis = 0; axis < 3; axis++) {
+        mean.add(serialized(String(cal.getMean(position)[axis], 3)));
+      }
+    }
+
+    const AccelCorrection& c = ConfigManager::getAccelCorrection();
+    JsonObject applied = doc["applied"].to<JsonObject>();
+    JsonArray bias = applied["bias"].to<JsonArray>();
+    JsonArray scale = applied["scale"].to<JsonArray>();
+    for (int axis = 0; axis < 3; axis++) {
+      bias.add(serialized(String(c.bias[axis], 4)));
+      scale.add(serialized(String(c.scale[axis], 5)));
+    }
 
-      Serial.printf("Axis swap %s\n", swap ? "ENABLED" : "DISABLED");
+    String output;
+    serializeJson(doc, output);
 
-      StaticJsonDocument<128> doc;
-      doc["message"] = "success";
-      doc["swap"] = swap;
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
 
-      String output;
-      serializeJson(doc, output);
+  httpServer.on("/accel_cal/solve", HTTP_GET, [this]() {
+    Serial.println(F("GET /accel_cal/solve"));
 
+    AccelCorrection correction;
+    AccelCalibration::SolveResult result =
+        sensorManager.getAccelCalibration().solve(correction);
+    if (result != AccelCalibration::SOLVE_OK) {
       sendCORSHeaders();
-      httpServer.send(200, "application/json", output);
-    } else {
+      httpServer.send(409, "application/json",
+                      result == AccelCalibration::SOLVE_INCOMPLETE
+                          ? "{\"error\":\"Not all positions captured\"}"
+                          : "{\"error\":\"Calibration out of range\"}");
+      return;
+    }
+
+    if (!ConfigManager::setAccelCorrection(correction)) {
       sendCORSHeaders();
-      httpServer.send(400, "application/json",
-                      "{\"error\":\"Missing parameter\"}");
+      httpServer.send(500, "application/json",
+                      "{\"error\":\"Failed to save calibration\"}");
+      return;
+    }
+    sensorManager.setAccelCorrection(correction);
+    sensorManager.resetAccelCalibration();
+
+    Serial.printf("Accel calibrated: bias %.3f/%.3f/%.3f, "
+                  "scale %.4f/%.4f/%.4f\n",
+                  correction.bias[0], correction.bias[1], correction.bias[2],
+                  correction.scale[0], correction.scale[1],
+                  correction.scale[2]);
+
+    StaticJsonDocument<256> doc;
+    doc["message"] = "success";
+    JsonArray bias = doc["bias"].to<JsonArray>();
+    JsonArray scale = doc["scale"].to<JsonArray>();
+    for (int axis = 0; axis < 3; axis++) {
+      bias.add(serialized(String(correction.bias[axis], 4)));
+      scale.add(serialized(String(correction.scale[axis], 5)));
     }
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
   });
 
-  httpServer.on("/toggle_axis_swap", HTTP_GET, [this]() {
-    Serial.println(F("GET /toggle_axis_swap"));
+  // Бросить снятые положения (сохранённая поправка остаётся)
+  httpServer.on("/accel_cal/reset", HTTP_GET, [this]() {
+    Serial.println(F("GET /accel_cal/reset"));
 
-    bool currentSwap = ConfigManager::getAxisSwap();
-    bool newSwap = !currentSwap;
+    sensorManager.resetAccelCalibration();
 
-    ConfigManager::setAxisSwap(newSwap);
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", "{\"message\":\"success\"}");
+  });
 
-    Serial.printf("Axis swap toggled: %s → %s\n", currentSwap ? "ON" : "OFF",
-                  newSwap ? "ON" : "OFF");
+  // Вернуть номинальный масштаб датчика
+  httpServer.on("/accel_cal/clear", HTTP_GET, [this]() {
+    Serial.println(F("GET /accel_cal/clear"));
+
+    AccelCorrection identity = AccelCorrection::identity();
+    ConfigManager::setAccelCorrection(identity);
+    sensorManager.setAccelCorrection(identity);
+    Serial.println("Accel calibration cleared");
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", "{\"message\":\"success\"}");
+  });
+
+  // ========== HEADING / MAG CALIBRATION ==========
+  // Курс: /set_heading?enabled=1. Калибровка: /mag_cal/start, вращать
+  // устройство во все стороны (ход - /mag_cal/status), /mag_cal/solve
+
+  httpServer.on("/set_heading", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_heading"));
+
+    bool enabled;
+    if (!readBoolParam("enabled", enabled)) return;
+
+    if (enabled && !sensorManager.isMagAvailable()) {
+      sendCORSHeaders();
+      httpServer.send(409, "application/json",
+                      "{\"error\":\"Magnetometer not available\"}");
+      return;
+    }
+
+    ConfigManager::setHeadingEnabled(enabled);
+    sensorManager.setHeadingEnabled(enabled);
 
     StaticJsonDocument<128> doc;
     doc["message"] = "success";
-    doc["swap"] = newSwap;
-    doc["previous"] = currentSwap;
+    doc["enabled"] = enabled;
 
     String output;
     serializeJson(doc, output);
@@ -481,11 +1006,17 @@ void LevelWebServer::setupRoutes() {
     httpServer.send(200, "application/json", output);
   });
 
-  httpServer.on("/get_axis_swap", HTTP_GET, [this]() {
-    Serial.println(F("GET /get_axis_swap"));
+  httpServer.on("/get_heading", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_heading"));
 
     StaticJsonDocument<128> doc;
-    doc["swap"] = ConfigManager::getAxisSwap();
+    doc["enabled"] = sensorManager.isHeadingEnabled();
+    doc["available"] = sensorManager.isMagAvailable();
+    doc["calibrated"] = !ConfigManager::getMagCorrection().isIdentity();
+    if (sensorManager.isHeadingEnabled()) {
+      doc["heading"] =
+          serialized(String(sensorManager.getCachedData().heading, 1));
+    }
 
     String output;
     serializeJson(doc, output);
@@ -494,38 +1025,87 @@ void LevelWebServer::setupRoutes() {
     httpServer.send(200, "application/json", output);
   });
 
-  // ========== BATTERY ==========
-
-  httpServer.on("/battery", HTTP_GET, [this]() {
-    Serial.println(F("GET /battery"));
+  httpServer.on("/mag_cal/start", HTTP_GET, [this]() {
+    Serial.println(F("GET /mag_cal/start"));
 
-    const int BATTERY_PIN = 35;
-    int adcValue = analogRead(BATTERY_PIN);
-    float voltage = (adcValue / 4095.0f) * 3.3f * 2.0f;
-    float percentage = ((voltage - 3.0f) / (4.2f - 3.0f)) * 100.0f;
-    if (percentage < 0.0f) percentage = 0.0f;
-    if (percentage > 100.0f) percentage = 100.0f;
-
-    String status = "unknown";
-    if (percentage >= 99.0f) {
-      status = "full";
-    } else if (voltage > 4.1f) {
-      status = "charging";
-    } else {
-      status = "discharging";
+    if (!sensorManager.startMagCalibration()) {
+      sendCORSHeaders();
+      httpServer.send(409, "application/json",
+                      "{\"error\":\"Magnetometer not available\"}");
+      return;
     }
 
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", "{\"message\":\"collecting\"}");
+  });
+
+  httpServer.on("/mag_cal/status", HTTP_GET, [this]() {
+    Serial.println(F("GET /mag_cal/status"));
+
+    const MagCalibration& cal = sensorManager.getMagCalibration();
+
     StaticJsonDocument<256> doc;
-    doc["voltage"] = serialized(String(voltage, 2));
-    doc["percentage"] = (int)percentage;
-    doc["status"] = status;
-    doc["raw_adc"] = adcValue;
+    doc["collecting"] = cal.isCollecting();
+    doc["samples"] = cal.getSampleCount();
+    doc["min_samples"] = MagCalibration::MIN_SAMPLES;
+    doc["min_span_ut"] = MagCalibration::MIN_SPAN_UT;
+
+    // Размах по осям: какую ось ещё повернуть
+    JsonArray span = doc["span_ut"].to<JsonArray>();
+    for (int axis = 0; axis < 3; axis++) {
+      span.add(serialized(String(cal.getSpan(axis), 1)));
+    }
 
-    if (percentage < 20.0f) {
-      doc["warning"] = "Low battery";
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/mag_cal/solve", HTTP_GET, [this]() {
+    Serial.println(F("GET /mag_cal/solve"));
+
+    MagCorrection correction;
+    float field = 0.0f, fitError = 0.0f;
+    MagCalibration::SolveResult result =
+        sensorManager.getMagCalibration().solve(correction, field, fitError);
+    if (result != MagCalibration::SOLVE_OK) {
+      // Сбор продолжается: можно довращать и повторить
+      char body[96];
+      snprintf(body, sizeof(body),
+               "{\"error\":\"Calibration failed\",\"result\":\"%s\"}",
+               MagCalibration::resultName(result));
+      sendCORSHeaders();
+      httpServer.send(409, "application/json", body);
+      return;
     }
-    if (percentage < 10.0f) {
-      doc["critical"] = true;
+
+    if (!ConfigManager::setMagCorrection(correction)) {
+      sendCORSHeaders();
+      httpServer.send(500, "application/json",
+                      "{\"error\":\"Failed to save calibration\"}");
+      return;
+    }
+    sensorManager.setMagCorrection(correction);
+    sensorManager.stopMagCalibration();
+
+    Serial.printf("Mag calibrated: offset %.1f/%.1f/%.1f uT, field %.1f uT\n",
+                  correction.offset[0], correction.offset[1],
+                  correction.offset[2], field);
+
+    StaticJsonDocument<512> doc;
+    doc["message"] = "success";
+    doc["field_ut"] = serialized(String(field, 1));
+    doc["fit_error"] = serialized(String(fitError, 4));
+    JsonArray offset = doc["offset"].to<JsonArray>();
+    JsonArray matrix = doc["matrix"].to<JsonArray>();
+    for (int i = 0; i < 3; i++) {
+      offset.add(serialized(String(correction.offset[i], 2)));
+      JsonArray row = matrix.add<JsonArray>();
+      for (int j = 0; j < 3; j++) {
+        row.add(serialized(String(correction.matrix[i][j], 4)));
+      }
     }
 
     String output;
@@ -533,37 +1113,603 @@ void LevelWebServer::setupRoutes() {
 
     sendCORSHeaders();
     httpServer.send(200, "application/json", output);
+  });
 
-    if (percentage < 20.0f) {
-      Serial.printf("WARNING: Low battery! %.1f%% (%.2fV)\n", percentage,
-                    voltage);
-    }
+  httpServer.on("/mag_cal/stop", HTTP_GET, [this]() {
+    Serial.println(F("GET /mag_cal/stop"));
+
+    sensorManager.stopMagCalibration();
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", "{\"message\":\"success\"}");
   });
 
-  // ========== SETTINGS ==========
+  httpServer.on("/mag_cal/clear", HTTP_GET, [this]() {
+    Serial.println(F("GET /mag_cal/clear"));
 
-  httpServer.on("/settings", HTTP_GET, [this]() {
-    Serial.println(F("GET /settings"));
+    MagCorrection identity = MagCorrection::identity();
+    ConfigManager::setMagCorrection(identity);
+    sensorManager.setMagCorrection(identity);
+    Serial.println("Mag calibration cleared");
 
-    StaticJsonDocument<512> doc;
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", "{\"message\":\"success\"}");
+  });
 
-    JsonObject range = doc["level_range"].to<JsonObject>();
-    range["min"] = ConfigManager::getLevelMin();
-    range["max"] = ConfigManager::getLevelMax();
+  // ========== ORIENTATION ENGINE ==========
+  // /set_orientation?engine=accel|complementary|mahony (последние два -
+  // только с гироскопом L3GD20)
 
-    doc["zero_offset"] = ConfigManager::getZeroOffset();
-    doc["axis_swap"] = ConfigManager::getAxisSwap();
+  httpServer.on("/set_orientation", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_orientation"));
+
+    ParamView value = httpServer.param("engine");
+    if (value.isNull()) {
+      sendParamError("engine", PARSE_MISSING);
+      return;
+    }
+
+    int engine = 0;
+    while (engine < OrientationEngine::TYPE_COUNT &&
+           !value.equalsIgnoreCase(
+               OrientationEngine::typeName((OrientationEngine::Type)engine))) {
+      engine++;
+    }
+    if (engine == OrientationEngine::TYPE_COUNT) {
+      sendParamError("engine", PARSE_MALFORMED);
+      return;
+    }
+
+    OrientationEngine::Type type = (OrientationEngine::Type)engine;
+    if (type != OrientationEngine::ACCEL && !sensorManager.isGyroAvailable()) {
+      sendCORSHeaders();
+      httpServer.send(409, "application/json",
+                      "{\"error\":\"Gyroscope not available\"}");
+      return;
+    }
 
-    const int BATTERY_PIN = 35;
-    int adcValue = analogRead(BATTERY_PIN);
-    float voltage = (adcValue / 4095.0f) * 3.3f * 2.0f;
-    float percentage = ((voltage - 3.0f) / 1.2f) * 100.0f;
-    if (percentage < 0.0f) percentage = 0.0f;
-    if (percentage > 100.0f) percentage = 100.0f;
+    ConfigManager::setOrientationEngine(type);
+    sensorManager.setOrientationEngine(type);
 
-    JsonObject battery = doc["battery"].to<JsonObject>();
-    battery["voltage"] = serialized(String(voltage, 2));
-    battery["percentage"] = (int)percentage;
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["engine"] = OrientationEngine::typeName(type);
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_orientation", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_orientation"));
+
+    StaticJsonDocument<128> doc;
+    doc["engine"] =
+        OrientationEngine::typeName(sensorManager.getOrientationEngine());
+    doc["gyro_available"] = sensorManager.isGyroAvailable();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== OUTLIER REJECTION ==========
+  // /set_outlier?mode=off|hampel|innovation
+
+  httpServer.on("/set_outlier", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_outlier"));
+
+    ParamView value = httpServer.param("mode");
+    if (value.isNull()) {
+      sendParamError("mode", PARSE_MISSING);
+      return;
+    }
+
+    int mode = 0;
+    while (mode < OutlierRejector::MODE_COUNT &&
+           !value.equalsIgnoreCase(
+               OutlierRejector::modeName((OutlierRejector::Mode)mode))) {
+      mode++;
+    }
+    if (mode == OutlierRejector::MODE_COUNT) {
+      sendParamError("mode", PARSE_MALFORMED);
+      return;
+    }
+
+    OutlierRejector::Mode outlierMode = (OutlierRejector::Mode)mode;
+    ConfigManager::setOutlierMode(outlierMode);
+    sensorManager.setOutlierMode(outlierMode);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["mode"] = OutlierRejector::modeName(outlierMode);
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // Счётчики с загрузки, по каналам фильтра
+  httpServer.on("/get_outlier", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_outlier"));
+
+    const OutlierRejector& outliers = sensorManager.getOutlierRejector();
+    StaticJsonDocument<256> doc;
+    doc["mode"] = OutlierRejector::modeName(outliers.getMode());
+    doc["total"] = outliers.getTotalRejected();
+    JsonObject rejected = doc["rejected"].to<JsonObject>();
+    for (uint8_t ch = 0; ch < outliers.getChannelCount(); ch++) {
+      rejected[SensorPipeline::channelName(ch)] = outliers.getRejected(ch);
+    }
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== AXIS SWAP ==========
+
+  httpServer.on("/set_axis_swap", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_axis_swap"));
+
+    bool swap;
+    if (!readBoolParam("swap", swap)) return;
+
+    ConfigManager::setAxisSwap(swap);
+
+    Serial.printf("Axis swap %s\n", swap ? "ENABLED" : "DISABLED");
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["swap"] = swap;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/toggle_axis_swap", HTTP_GET, [this]() {
+    Serial.println(F("GET /toggle_axis_swap"));
+
+    bool currentSwap = ConfigManager::getAxisSwap();
+    bool newSwap = !currentSwap;
+
+    ConfigManager::setAxisSwap(newSwap);
+
+    Serial.printf("Axis swap toggled: %s → %s\n", currentSwap ? "ON" : "OFF",
+                  newSwap ? "ON" : "OFF");
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["swap"] = newSwap;
+    doc["previous"] = currentSwap;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_axis_swap", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_axis_swap"));
+
+    StaticJsonDocument<128> doc;
+    doc["swap"] = ConfigManager::getAxisSwap();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== WEBSOCKET INTERVAL ==========
+
+  httpServer.on("/set_ws_interval", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_ws_interval"));
+
+    long intervalMs;
+    if (!readIntParam("ms", ConfigManager::MIN_WS_INTERVAL_MS,
+                      ConfigManager::MAX_WS_INTERVAL_MS, intervalMs)) {
+      return;
+    }
+
+    if (!ConfigManager::setWsIntervalMs((uint16_t)intervalMs)) {
+      sendCORSHeaders();
+      httpServer.send(400, "application/json",
+                      "{\"error\":\"Invalid interval\"}");
+      return;
+    }
+
+    Serial.printf("WS interval updated: %ld ms\n", intervalMs);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["interval_ms"] = intervalMs;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_ws_interval", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_ws_interval"));
+
+    StaticJsonDocument<128> doc;
+    doc["interval_ms"] = ConfigManager::getWsIntervalMs();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== UDP TELEMETRY ==========
+
+  httpServer.on("/set_udp", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_udp"));
+
+    long mode;
+    long port = ConfigManager::getUdpPort();
+    if (!readIntParam("mode", 0, ConfigManager::MAX_UDP_MODE, mode)) return;
+    if (!httpServer.param("port").isNull() &&
+        !readIntParam("port", ConfigManager::MIN_UDP_PORT, UINT16_MAX, port)) {
+      return;
+    }
+
+    if (!ConfigManager::setUdpTelemetry((uint8_t)mode, (uint16_t)port)) {
+      sendCORSHeaders();
+      httpServer.send(400, "application/json",
+                      "{\"error\":\"Invalid UDP settings\"}");
+      return;
+    }
+
+    Serial.printf("UDP telemetry updated: mode %ld, port %ld\n", mode, port);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["mode"] = mode;
+    doc["port"] = port;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_udp", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_udp"));
+
+    StaticJsonDocument<128> doc;
+    doc["mode"] = ConfigManager::getUdpMode();
+    doc["port"] = ConfigManager::getUdpPort();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== POWER ==========
+
+  httpServer.on("/set_power", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_power"));
+
+    long sleepAfterS;
+    if (!readIntParam("sleep_s", 0, UINT16_MAX, sleepAfterS)) return;
+
+    ConfigManager::setSleepAfterS((uint16_t)sleepAfterS);
+    Serial.printf("Light sleep after: %ld s\n", sleepAfterS);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["sleep_s"] = sleepAfterS;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_power", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_power"));
+
+    StaticJsonDocument<512> doc;
+    doc["sleep_s"] = ConfigManager::getSleepAfterS();
+
+    if (powerManager) {
+      doc["mode"] = PowerManager::modeName(powerManager->getMode());
+      doc["low_latency_radio"] = powerManager->isLowLatencyRadio();
+      doc["estimated_ma"] = powerManager->getEstimatedCurrentMa();
+      doc["consumed_mah"] = powerManager->getConsumedMah();
+      doc["light_sleep_ms"] = powerManager->getLightSleepMs();
+      doc["light_sleeps"] = powerManager->getLightSleepCount();
+
+      JsonObject residency = doc["residency_ms"].to<JsonObject>();
+      for (uint8_t i = 0; i < PowerManager::MODE_COUNT; i++) {
+        PowerManager::Mode mode = (PowerManager::Mode)i;
+        residency[PowerManager::modeName(mode)] =
+            powerManager->getResidencyMs(mode);
+      }
+    }
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== HYSTERESIS ==========
+
+  httpServer.on("/set_hysteresis", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_hysteresis"));
+
+    float low, high;
+    if (!readFloatParam("low", 0.0f, ConfigManager::MAX_HYSTERESIS, low) ||
+        !readFloatParam("high", 0.0f, ConfigManager::MAX_HYSTERESIS, high)) {
+      return;
+    }
+
+    if (!ConfigManager::setHysteresis(low, high)) {
+      sendCORSHeaders();
+      httpServer.send(400, "application/json",
+                      "{\"error\":\"Invalid hysteresis\"}");
+      return;
+    }
+
+    Serial.printf("Hysteresis updated: ±%.2f° / ±%.2f°\n", low, high);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["low"] = low;
+    doc["high"] = high;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_hysteresis", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_hysteresis"));
+
+    StaticJsonDocument<128> doc;
+    doc["low"] = ConfigManager::getHysteresisLow();
+    doc["high"] = ConfigManager::getHysteresisHigh();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== LED FADE ==========
+
+  httpServer.on("/set_indicator_fade", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_indicator_fade"));
+
+    long fadeMs;
+    if (!readIntParam("ms", 0, ConfigManager::MAX_FADE_TIME_MS, fadeMs)) {
+      return;
+    }
+
+    if (!ConfigManager::setFadeTimeMs((uint16_t)fadeMs)) {
+      sendCORSHeaders();
+      httpServer.send(400, "application/json",
+                      "{\"error\":\"Invalid fade time\"}");
+      return;
+    }
+
+    Serial.printf("LED fade time updated: %ld ms\n", fadeMs);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["fade_ms"] = fadeMs;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_indicator_fade", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_indicator_fade"));
+
+    StaticJsonDocument<128> doc;
+    doc["fade_ms"] = ConfigManager::getFadeTimeMs();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== BATTERY ==========
+
+  httpServer.on("/battery", HTTP_GET, [this]() {
+    Serial.println(F("GET /battery"));
+
+    // Замеры делает задача планировщика, здесь - только кеш
+    if (!batteryMonitor || !batteryMonitor->isValid()) {
+      sendCORSHeaders();
+      httpServer.send(503, "application/json",
+                      "{\"error\":\"Battery monitor not ready\"}");
+      return;
+    }
+
+    StaticJsonDocument<256> doc;
+    doc["voltage"] = serialized(String(batteryMonitor->getVoltage(), 2));
+    doc["percentage"] = (int)batteryMonitor->getPercentage();
+    doc["status"] = batteryMonitor->getStatus();
+    doc["raw_adc"] = batteryMonitor->getRawAdc();
+    doc["samples"] = batteryMonitor->getSampleCount();
+
+    if (batteryMonitor->isLow()) {
+      doc["warning"] = "Low battery";
+    }
+    if (batteryMonitor->isCritical()) {
+      doc["critical"] = true;
+    }
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== RECORDER ==========
+
+  httpServer.on("/set_record", HTTP_GET, [this]() {
+    Serial.println(F("GET /set_record"));
+
+    long intervalMs;
+    if (!readIntParam("interval_ms", 0, ConfigManager::MAX_RECORD_INTERVAL_MS,
+                      intervalMs)) {
+      return;
+    }
+    if (intervalMs != 0 &&
+        intervalMs < ConfigManager::MIN_RECORD_INTERVAL_MS) {
+      sendParamError("interval_ms", PARSE_OUT_OF_RANGE);
+      return;
+    }
+
+    ConfigManager::setRecordIntervalMs((uint16_t)intervalMs);
+    if (recorder) recorder->setIntervalMs((uint16_t)intervalMs);
+    Serial.printf("Record interval: %ld ms\n", intervalMs);
+
+    StaticJsonDocument<128> doc;
+    doc["message"] = "success";
+    doc["interval_ms"] = intervalMs;
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/get_record", HTTP_GET, [this]() {
+    Serial.println(F("GET /get_record"));
+
+    StaticJsonDocument<256> doc;
+    doc["interval_ms"] = ConfigManager::getRecordIntervalMs();
+
+    if (recorder) {
+      doc["enabled"] = recorder->isEnabled();
+      doc["blocks"] = recorder->getBlockCount();
+      doc["block_size"] = RecordFormat::BLOCK_SIZE;
+      doc["sequence"] = recorder->getSequence();
+      doc["samples"] = recorder->getSamples();
+      doc["dropped"] = recorder->getDroppedSamples();
+      doc["blocks_written"] = recorder->getBlocksWritten();
+      doc["write_errors"] = recorder->getWriteErrors();
+    }
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  // ========== LOG ==========
+
+  // Заголовок /log заранее: сколько блоков и какие номера. Заодно просит
+  // регистратор сбросить незаполненный блок - он войдёт в следующую выгрузку
+  httpServer.on("/log/info", HTTP_GET, [this]() {
+    Serial.println(F("GET /log/info"));
+
+    if (!recorder || logStreamer.isActive()) {
+      sendCORSHeaders();
+      httpServer.send(503, "application/json",
+                      recorder ? "{\"error\":\"Log download in progress\"}"
+                               : "{\"error\":\"Recorder not available\"}");
+      return;
+    }
+
+    recorder->requestFlush();
+    logStreamer.scan(*recorder);
+
+    StaticJsonDocument<256> doc;
+    doc["format_version"] = RecordFormat::VERSION;
+    doc["block_size"] = RecordFormat::BLOCK_SIZE;
+    doc["blocks"] = logStreamer.getBlockCount();
+    doc["bytes"] = logStreamer.getTotalBytes();
+    doc["samples"] = logStreamer.getSampleCount();
+    doc["first_sequence"] = logStreamer.getFirstSequence();
+    doc["last_sequence"] = logStreamer.getLastSequence();
+
+    String output;
+    serializeJson(doc, output);
+
+    sendCORSHeaders();
+    httpServer.send(200, "application/json", output);
+  });
+
+  httpServer.on("/log", HTTP_GET, [this]() { handleLogDownload(); });
+
+  // ========== SETTINGS ==========
+
+  httpServer.on("/settings", HTTP_GET, [this]() {
+    Serial.println(F("GET /settings"));
+
+    StaticJsonDocument<512> doc;
+
+    JsonObject range = doc["level_range"].to<JsonObject>();
+    range["min"] = ConfigManager::getLevelMin();
+    range["max"] = ConfigManager::getLevelMax();
+
+    doc["zero_offset"] = ConfigManager::getZeroOffset();
+    doc["axis_swap"] = ConfigManager::getAxisSwap();
+    doc["accel_calibrated"] = !ConfigManager::getAccelCorrection().isIdentity();
+    doc["heading_enabled"] = ConfigManager::getHeadingEnabled();
+    doc["mag_calibrated"] = !ConfigManager::getMagCorrection().isIdentity();
+    doc["orientation_engine"] =
+        OrientationEngine::typeName(ConfigManager::getOrientationEngine());
+    doc["outlier_mode"] =
+        OutlierRejector::modeName(ConfigManager::getOutlierMode());
+    doc["fade_ms"] = ConfigManager::getFadeTimeMs();
+    doc["ws_interval_ms"] = ConfigManager::getWsIntervalMs();
+
+    doc["sleep_after_s"] = ConfigManager::getSleepAfterS();
+    doc["record_interval_ms"] = ConfigManager::getRecordIntervalMs();
+
+    JsonObject udp = doc["udp"].to<JsonObject>();
+    udp["mode"] = ConfigManager::getUdpMode();
+    udp["port"] = ConfigManager::getUdpPort();
+
+    JsonObject hysteresis = doc["hysteresis"].to<JsonObject>();
+    hysteresis["low"] = ConfigManager::getHysteresisLow();
+    hysteresis["high"] = ConfigManager::getHysteresisHigh();
+
+    if (batteryMonitor && batteryMonitor->isValid()) {
+      JsonObject battery = doc["battery"].to<JsonObject>();
+      battery["voltage"] = serialized(String(batteryMonitor->getVoltage(), 2));
+      battery["percentage"] = (int)batteryMonitor->getPercentage();
+    }
 
     String output;
     serializeJson(doc, output);
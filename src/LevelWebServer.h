@@ -5,16 +5,26 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
-#include <WebServer.h>
 #include <WebSocketsServer.h>
 
+#include "BatteryMonitor.h"
 #include "ConfigManager.h"
 #include "FileManager.h"
+#include "Hal.h"
+#include "LogStreamer.h"
+#include "LoopProfiler.h"
+#include "MetricsWriter.h"
+#include "ParamWebServer.h"
+#include "PowerManager.h"
+#include "SampleRecorder.h"
 #include "SensorManager.h"
 
 class LevelWebServer {
  public:
-  LevelWebServer(SensorManager& sensorMgr);
+  // Дополнительные метрики от владельца (индикатор, статистика loop)
+  typedef void (*MetricsHook)(MetricsWriter& metrics);
+
+  LevelWebServer(SensorManager& sensorMgr, const HalNetwork& network);
 
   /**
    * @brief Запуск серверов (HTTP + WebSocket)
@@ -41,11 +51,42 @@ class LevelWebServer {
    */
   void setDebugMode(bool enabled) { wsDebugEnabled = enabled; }
 
+  /**
+   * @brief Подключить функцию, дописывающую свои метрики в /metrics
+   */
+  void setMetricsHook(MetricsHook hook) { metricsHook = hook; }
+
+  /**
+   * @brief Источник данных для /battery и /settings
+   */
+  void setBatteryMonitor(const BatteryMonitor* monitor) {
+    batteryMonitor = monitor;
+  }
+
+  /**
+   * @brief Источник данных для /get_power
+   */
+  void setPowerManager(const PowerManager* manager) { powerManager = manager; }
+
+  /**
+   * @brief Регистратор для /set_record и /get_record
+   */
+  void setSampleRecorder(SampleRecorder* recorder) { this->recorder = recorder; }
+
+  /**
+   * @brief Следующая порция выгрузки /log (отдельная задача планировщика)
+   */
+  void serviceLogStream() { logStreamer.poll(); }
+  bool isLogStreaming() const { return logStreamer.isActive(); }
+
  private:
-  WebServer httpServer;
+  friend class PipelineBenchmark;  // Замер sensorDataToJson и broadcastTXT
+
+  ParamWebServer httpServer;
   WebSocketsServer wsServer;
 
   SensorManager& sensorManager;
+  const HalNetwork& network;
   FileManager fileManager;
 
   // WebSocket статистика
@@ -53,9 +94,24 @@ class LevelWebServer {
   unsigned long lastBroadcastTime;
   unsigned long broadcastCount;
   uint8_t wsClientCount;
+  uint32_t wsFramesSent;     // Кадров отправлено (по клиентам)
+  uint32_t wsBytesSent;      // Байт отправлено (по клиентам)
+  uint32_t wsFramesDropped;  // Кадров не отправлено
+
+  // Окно ответа /metrics: ответ уходит частями по мере заполнения
+  // (chunked), без выделения памяти на каждый запрос
+  static const size_t METRICS_CHUNK_SIZE = 1024;
+  char metricsBuffer[METRICS_CHUNK_SIZE];
+  MetricsHook metricsHook;
+
+  const BatteryMonitor* batteryMonitor;
+  const PowerManager* powerManager;
+  SampleRecorder* recorder;
+  LogStreamer logStreamer;  // Одна выгрузка /log за раз
 
-  // Минимальный интервал между broadcast (мс)
-  static const uint32_t BROADCAST_INTERVAL_MS = 200;  // 5 Hz
+  // Минимальный интервал между broadcast (мс). Рабочую частоту задаёт
+  // планировщик в loop() из ConfigManager::getWsIntervalMs()
+  static const uint32_t MIN_BROADCAST_INTERVAL_MS = 50;  // 20 Hz
 
   // WebSocket обработчик событий
   static void webSocketEvent(uint8_t num, WStype_t type, uint8_t* payload,
@@ -68,8 +124,25 @@ class LevelWebServer {
   // CORS helper
   void sendCORSHeaders();
 
+  // Разбор параметров запроса: при ошибке сразу отвечают 400
+  // (с именем параметра и причиной) и возвращают false
+  bool readFloatParam(const char* name, float& out);
+  bool readFloatParam(const char* name, float min, float max, float& out);
+  bool readIntParam(const char* name, long min, long max, long& out);
+  bool readBoolParam(const char* name, bool& out);
+  void sendParamError(const char* name, ParseError error);
+
+  // GET /log: заголовки пишутся сами, тело отдаёт serviceLogStream()
+  void handleLogDownload();
+  bool sendLogHeaders(LogStreamer::Format format, bool partial,
+                      uint32_t first, uint32_t last);
+
   // Вспомогательные функции
   String getSensorDataJson();
+  String sensorDataToJson(const SensorData& data);
+  void streamMetrics();
+  static void sendMetricsChunk(void* context, const char* data,
+                               size_t length);
 };
 
 #endif  // LEVEL_WEB_SERVER_H
\ No newline at end of file
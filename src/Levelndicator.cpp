@@ -1,11 +1,18 @@
 // LevelIndicator.cpp
 #include "LevelIndicator.h"
 
-LevelIndicator::LevelIndicator(uint8_t positive1, uint8_t positive2,
+#ifdef ARDUINO
+#include "LoopProfiler.h"
+#endif
+
+LevelIndicator::LevelIndicator(HalPwm& pwm, HalClock& clock,
+                               uint8_t positive1, uint8_t positive2,
                                uint8_t positive3, uint8_t negative1,
                                uint8_t negative2, uint8_t negative3,
                                uint8_t neutral)
-    : pinPositive1(positive1),
+    : pwm(pwm),
+      clock(clock),
+      pinPositive1(positive1),
       pinPositive2(positive2),
       pinPositive3(positive3),
       pinNegative1(negative1),
@@ -14,89 +21,343 @@ LevelIndicator::LevelIndicator(uint8_t positive1, uint8_t positive2,
       pinNeutral(neutral),
       rangeMin(-45.0f),
       rangeMax(45.0f),
+      hysteresisLower(0.0f),
+      hysteresisUpper(0.0f),
+      zone(ZONE_UNKNOWN),
+      zoneTransitions(0),
+#ifdef ARDUINO
+      mutex(nullptr),
+      refreshTimer(nullptr),
+#endif
+      refreshSource(nullptr),
+      refreshPeriodMs(0),
+      lastAppliedSampleMicros(0),
+      firstRenderMs(0),
+      latencyBoundUs(0),
+      latencyLastUs(0),
+      latencyMaxUs(0),
+      latencySumUs(0),
+      latencySamples(0),
+      latencyOverBound(0),
       thresholdLow(0.33f),
       thresholdMedium(0.66f),
       thresholdHigh(1.0f),
       brightnessLow(85),
       brightnessMedium(170),
-      brightnessHigh(255) {}
+      brightnessHigh(255),
+      fadeEnabled(false),
+      fadeTimeMs(0),
+      ledWrites(0),
+      ledWritesSkipped(0) {
+  for (uint8_t i = 0; i < PWM_CHANNEL_COUNT; i++) {
+    lastDuty[i] = -1;
+    fadeEndMs[i] = 0;
+  }
+  rebuildGradientLut();
+
+#ifdef ARDUINO
+  mutex = xSemaphoreCreateMutex();
+  if (mutex == NULL) {
+    HAL_LOG("ERROR: Failed to create indicator mutex!\n");
+  }
+#endif
+}
+
+LevelIndicator::~LevelIndicator() {
+#ifdef ARDUINO
+  stopAutoRefresh();
+  if (refreshTimer) {
+    esp_timer_delete(refreshTimer);
+  }
+  if (mutex) {
+    vSemaphoreDelete(mutex);
+  }
+#endif
+}
+
+#ifdef ARDUINO
+bool LevelIndicator::lock() {
+  return mutex && xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE;
+}
+
+void LevelIndicator::unlock() { xSemaphoreGive(mutex); }
+#else
+// На ПК (env:native) таймера нет, всё идёт из одного потока
+bool LevelIndicator::lock() { return true; }
+
+void LevelIndicator::unlock() {}
+#endif
 
 void LevelIndicator::begin() {
-  Serial.println("=== Initializing LevelIndicator ===");
+  HAL_LOG("=== Initializing LevelIndicator ===\n");
   setupPWM();
   clear();
-  Serial.printf("Positive LEDs (RED): %d, %d, %d\n", pinPositive1, pinPositive2,
-                pinPositive3);
-  Serial.printf("Negative LEDs (BLUE): %d, %d, %d\n", pinNegative1,
-                pinNegative2, pinNegative3);
-  Serial.printf("Neutral LED (GREEN): %d\n", pinNeutral);
-  Serial.printf("Range: %.1f° to %.1f°\n", rangeMin, rangeMax);
-  Serial.println("=== LevelIndicator ready ===");
+  HAL_LOG("Positive LEDs (RED): %d, %d, %d\n", pinPositive1, pinPositive2,
+          pinPositive3);
+  HAL_LOG("Negative LEDs (BLUE): %d, %d, %d\n", pinNegative1,
+          pinNegative2, pinNegative3);
+  HAL_LOG("Neutral LED (GREEN): %d\n", pinNeutral);
+  HAL_LOG("Range: %.1f° to %.1f°\n", rangeMin, rangeMax);
+  HAL_LOG("=== LevelIndicator ready ===\n");
 }
 
 void LevelIndicator::setupPWM() {
-  ledcSetup(PWM_CHANNEL_POS1, PWM_FREQ, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_POS2, PWM_FREQ, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_POS3, PWM_FREQ, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_NEG1, PWM_FREQ, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_NEG2, PWM_FREQ, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_NEG3, PWM_FREQ, PWM_RESOLUTION);
-  ledcSetup(PWM_CHANNEL_NEUTRAL, PWM_FREQ, PWM_RESOLUTION);
-
-  ledcAttachPin(pinPositive1, PWM_CHANNEL_POS1);
-  ledcAttachPin(pinPositive2, PWM_CHANNEL_POS2);
-  ledcAttachPin(pinPositive3, PWM_CHANNEL_POS3);
-  ledcAttachPin(pinNegative1, PWM_CHANNEL_NEG1);
-  ledcAttachPin(pinNegative2, PWM_CHANNEL_NEG2);
-  ledcAttachPin(pinNegative3, PWM_CHANNEL_NEG3);
-  ledcAttachPin(pinNeutral, PWM_CHANNEL_NEUTRAL);
+  pwm.attach(PWM_CHANNEL_POS1, pinPositive1, PWM_FREQ, PWM_RESOLUTION);
+  pwm.attach(PWM_CHANNEL_POS2, pinPositive2, PWM_FREQ, PWM_RESOLUTION);
+  pwm.attach(PWM_CHANNEL_POS3, pinPositive3, PWM_FREQ, PWM_RESOLUTION);
+  pwm.attach(PWM_CHANNEL_NEG1, pinNegative1, PWM_FREQ, PWM_RESOLUTION);
+  pwm.attach(PWM_CHANNEL_NEG2, pinNegative2, PWM_FREQ, PWM_RESOLUTION);
+  pwm.attach(PWM_CHANNEL_NEG3, pinNegative3, PWM_FREQ, PWM_RESOLUTION);
+  pwm.attach(PWM_CHANNEL_NEUTRAL, pinNeutral, PWM_FREQ, PWM_RESOLUTION);
+}
+
+void LevelIndicator::setFadeMode(bool enabled, uint16_t fadeTime) {
+  if (!lock()) {
+    HAL_LOG("ERROR: Indicator busy, fade mode not changed\n");
+    return;
+  }
+  fadeEnabled = enabled && fadeTime > 0;
+  fadeTimeMs = fadeTime;
+  if (fadeEnabled && !pwm.enableFade()) {
+    fadeEnabled = false;
+  }
+  unlock();
+  HAL_LOG("LED fade %s (%u ms)\n", fadeEnabled ? "ON" : "OFF",
+          fadeTimeMs);
 }
 
 void LevelIndicator::setLED(uint8_t channel, uint8_t brightness) {
-  ledcWrite(channel, brightness);
+  // Пишем в LEDC только при изменении скважности
+  uint8_t index = channel - PWM_CHANNEL_POS1;
+  int16_t& last = lastDuty[index];
+  if (last == brightness) {
+    ledWritesSkipped++;
+    return;
+  }
+
+  if (fadeEnabled) {
+    // Новый fade нельзя запустить, пока идёт предыдущий: драйвер
+    // заблокирует вызов до его окончания. Цель применится в следующем
+    // update(), lastDuty не трогаем.
+    uint32_t now = clock.nowMs();
+    if ((int32_t)(now - fadeEndMs[index]) < 0) {
+      return;
+    }
+
+    if (pwm.fade(channel, brightness, fadeTimeMs)) {
+      fadeEndMs[index] = now + fadeTimeMs;
+    } else {
+      pwm.write(channel, brightness);
+    }
+  } else {
+    pwm.write(channel, brightness);
+  }
+
+  last = brightness;
+  ledWrites++;
 }
 
 void LevelIndicator::setRange(float min, float max) {
   if (min >= max) {
-    Serial.println("ERROR: Invalid range (min >= max)");
+    HAL_LOG("ERROR: Invalid range (min >= max)\n");
+    return;
+  }
+  if (!lock()) {
+    HAL_LOG("ERROR: Indicator busy, range not changed\n");
     return;
   }
   rangeMin = min;
   rangeMax = max;
-  Serial.printf("Level range updated: %.1f° to %.1f°\n", min, max);
+  unlock();
+  HAL_LOG("Level range updated: %.1f° to %.1f°\n", min, max);
+}
+
+void LevelIndicator::setHysteresis(float lowerBand, float upperBand) {
+  if (lowerBand < 0.0f || upperBand < 0.0f || lowerBand > MAX_HYSTERESIS ||
+      upperBand > MAX_HYSTERESIS) {
+    HAL_LOG("ERROR: Invalid hysteresis\n");
+    return;
+  }
+  if (!lock()) {
+    HAL_LOG("ERROR: Indicator busy, hysteresis not changed\n");
+    return;
+  }
+  hysteresisLower = lowerBand;
+  hysteresisUpper = upperBand;
+  unlock();
+  HAL_LOG("Hysteresis updated: ±%.2f° / ±%.2f°\n", lowerBand,
+          upperBand);
+}
+
+LevelIndicator::Zone LevelIndicator::nextZone(float angle) const {
+  // Жёсткие пороги выхода за диапазон
+  bool farBelow = angle < rangeMin - hysteresisLower;
+  bool farAbove = angle > rangeMax + hysteresisUpper;
+
+  switch (zone) {
+    case ZONE_INSIDE:
+      if (farBelow) return ZONE_BELOW;
+      if (farAbove) return ZONE_ABOVE;
+      return ZONE_INSIDE;
+
+    case ZONE_BELOW:
+      if (farAbove) return ZONE_ABOVE;
+      if (angle >= rangeMin + hysteresisLower) return ZONE_INSIDE;
+      return ZONE_BELOW;
+
+    case ZONE_ABOVE:
+      if (farBelow) return ZONE_BELOW;
+      if (angle <= rangeMax - hysteresisUpper) return ZONE_INSIDE;
+      return ZONE_ABOVE;
+
+    case ZONE_UNKNOWN:
+    default:
+      // Первое измерение - без гистерезиса
+      if (angle < rangeMin) return ZONE_BELOW;
+      if (angle > rangeMax) return ZONE_ABOVE;
+      return ZONE_INSIDE;
+  }
 }
 
 void LevelIndicator::update(float angle) {
+  if (!lock()) return;
+  render(angle);
+  unlock();
+}
+
+#ifdef ARDUINO
+bool LevelIndicator::startAutoRefresh(const AngleSnapshot& source,
+                                      uint32_t periodMs) {
+  if (periodMs == 0) {
+    HAL_LOG("ERROR: Invalid refresh period\n");
+    return false;
+  }
+
+  if (!refreshTimer) {
+    esp_timer_create_args_t args = {};
+    args.callback = &LevelIndicator::onRefreshTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "led_refresh";
+
+    esp_err_t err = esp_timer_create(&args, &refreshTimer);
+    if (err != ESP_OK) {
+      HAL_LOG("ERROR: esp_timer_create failed (%d)\n", err);
+      refreshTimer = nullptr;
+      return false;
+    }
+  } else {
+    esp_timer_stop(refreshTimer);  // Смена периода
+  }
+
+  refreshSource = &source;
+  refreshPeriodMs = periodMs;
+
+  esp_err_t err = esp_timer_start_periodic(refreshTimer, periodMs * 1000ULL);
+  if (err != ESP_OK) {
+    HAL_LOG("ERROR: esp_timer_start_periodic failed (%d)\n", err);
+    refreshSource = nullptr;
+    return false;
+  }
+
+  HAL_LOG("Indicator auto refresh: every %u ms (latency bound %u us)\n",
+          periodMs, latencyBoundUs);
+  return true;
+}
+
+void LevelIndicator::stopAutoRefresh() {
+  if (refreshTimer) {
+    esp_timer_stop(refreshTimer);
+  }
+  refreshSource = nullptr;
+}
+
+void LevelIndicator::onRefreshTimer(void* arg) {
+  static_cast<LevelIndicator*>(arg)->refreshFromSnapshot();
+}
+
+void LevelIndicator::refreshFromSnapshot() {
+  const AngleSnapshot* source = refreshSource;
+  if (!source) return;
+
+  float angle;
+  uint32_t sampleMicros;
+  if (!source->read(angle, sampleMicros)) return;
+
+  // Тот же сэмпл даёт ту же картинку; с fade повторяем, чтобы догнать
+  // цели, отложенные до окончания предыдущего перехода
+  bool newSample = sampleMicros != lastAppliedSampleMicros;
+  if (!newSample && !fadeEnabled) return;
+
+  // Не ждём: если настройки меняются прямо сейчас - следующий тик
+  if (!mutex || xSemaphoreTake(mutex, 0) != pdTRUE) return;
+  {
+    PROFILE_STAGE(STAGE_INDICATOR);
+    render(angle);
+  }
+  unlock();
+
+  if (newSample) {
+    uint32_t latency = clock.nowUs() - sampleMicros;
+    lastAppliedSampleMicros = sampleMicros;
+    if (firstRenderMs == 0) {
+      firstRenderMs = clock.nowMs();
+    }
+
+    latencyLastUs = latency;
+    if (latency > latencyMaxUs) latencyMaxUs = latency;
+    latencySumUs += latency;
+    latencySamples++;
+    if (latencyBoundUs > 0 && latency > latencyBoundUs) {
+      latencyOverBound++;
+    }
+  }
+}
+#endif  // ARDUINO
+
+LevelIndicator::LatencyStats LevelIndicator::getLatencyStats() const {
+  LatencyStats result;
+  result.lastUs = latencyLastUs;
+  result.maxUs = latencyMaxUs;
+  result.samples = latencySamples;
+  result.meanUs =
+      latencySamples > 0 ? (uint32_t)(latencySumUs / latencySamples) : 0;
+  result.boundUs = latencyBoundUs;
+  result.overBound = latencyOverBound;
+  return result;
+}
+
+void LevelIndicator::render(float angle) {
+  Zone newZone = nextZone(angle);
+  if (newZone != zone) {
+    if (zone != ZONE_UNKNOWN) {
+      zoneTransitions++;
+    }
+    zone = newZone;
+  }
+
   // ========================================
   // ЗОНА 1: НИЖЕ rangeMin - СИНИЙ градиент
   // ========================================
-  if (angle < rangeMin) {
+  if (zone == ZONE_BELOW) {
     // Выключаем красные и зелёный
     setLED(PWM_CHANNEL_POS1, 0);
     setLED(PWM_CHANNEL_POS2, 0);
     setLED(PWM_CHANNEL_POS3, 0);
     setLED(PWM_CHANNEL_NEUTRAL, 0);
 
-    // Расстояние ниже минимума
-    float distanceBelow = rangeMin - angle;
-
-    // Нормализация (90° = 100%)
-    float maxDistance = 90.0f;
-    float percent = min(distanceBelow / maxDistance, 1.0f);
-
-    // Вычисляем градиент для СИНИХ
-    uint8_t level1 = 0, level2 = 0, level3 = 0;
-    calculateGradient(percent, 1.0f, level1, level2, level3);
+    // Градиент для СИНИХ по расстоянию ниже минимума
+    const uint8_t* levels = lookupGradient(rangeMin - angle);
 
     // СИНИЕ светодиоды (NEGATIVE)
-    setLED(PWM_CHANNEL_NEG1, level1);
-    setLED(PWM_CHANNEL_NEG2, level2);
-    setLED(PWM_CHANNEL_NEG3, level3);
+    setLED(PWM_CHANNEL_NEG1, levels[0]);
+    setLED(PWM_CHANNEL_NEG2, levels[1]);
+    setLED(PWM_CHANNEL_NEG3, levels[2]);
   }
   // ========================================
   // ЗОНА 2: ВНУТРИ rangeMin...rangeMax - ЗЕЛЁНЫЙ на полную
   // ========================================
-  else if (angle >= rangeMin && angle <= rangeMax) {
+  else if (zone == ZONE_INSIDE) {
     // Выключаем все кроме зелёного
     setLED(PWM_CHANNEL_POS1, 0);
     setLED(PWM_CHANNEL_POS2, 0);
@@ -111,29 +372,51 @@ void LevelIndicator::update(float angle) {
   // ========================================
   // ЗОНА 3: ВЫШЕ rangeMax - КРАСНЫЙ градиент
   // ========================================
-  else {  // angle > rangeMax
+  else {  // ZONE_ABOVE
     // Выключаем синие и зелёный
     setLED(PWM_CHANNEL_NEG1, 0);
     setLED(PWM_CHANNEL_NEG2, 0);
     setLED(PWM_CHANNEL_NEG3, 0);
     setLED(PWM_CHANNEL_NEUTRAL, 0);
 
-    // Расстояние выше максимума
-    float distanceAbove = angle - rangeMax;
+    // Градиент для КРАСНЫХ по расстоянию выше максимума
+    const uint8_t* levels = lookupGradient(angle - rangeMax);
+
+    // КРАСНЫЕ светодиоды (POSITIVE)
+    setLED(PWM_CHANNEL_POS1, levels[0]);
+    setLED(PWM_CHANNEL_POS2, levels[1]);
+    setLED(PWM_CHANNEL_POS3, levels[2]);
+  }
+}
 
-    // Нормализация (90° = 100%)
-    float maxDistance = 90.0f;
-    float percent = min(distanceAbove / maxDistance, 1.0f);
+void LevelIndicator::rebuildGradientLut() {
+  // Пересчёт таблицы: индекс i соответствует расстоянию
+  // i / GRADIENT_LUT_SCALE градусов за границей диапазона
+  for (uint16_t i = 0; i < GRADIENT_LUT_SIZE; i++) {
+    float percent = (float)i / (GRADIENT_LUT_SIZE - 1);
+    calculateGradient(percent, 1.0f, gradientLut[i][0], gradientLut[i][1],
+                      gradientLut[i][2]);
+  }
 
-    // Вычисляем градиент для КРАСНЫХ
-    uint8_t level1 = 0, level2 = 0, level3 = 0;
-    calculateGradient(percent, 1.0f, level1, level2, level3);
+  gradientFirstVisible = 0;
+  while (gradientFirstVisible < GRADIENT_LUT_SIZE - 1 &&
+         gradientLut[gradientFirstVisible][0] == 0) {
+    gradientFirstVisible++;
+  }
+}
 
-    // КРАСНЫЕ светодиоды (POSITIVE)
-    setLED(PWM_CHANNEL_POS1, level1);
-    setLED(PWM_CHANNEL_POS2, level2);
-    setLED(PWM_CHANNEL_POS3, level3);
+const uint8_t* LevelIndicator::lookupGradient(float distance) const {
+  // Квантование расстояния: одно умножение вместо делений
+  float index = distance * GRADIENT_LUT_SCALE + 0.5f;
+  if (index >= GRADIENT_LUT_SIZE - 1) {
+    return gradientLut[GRADIENT_LUT_SIZE - 1];
+  }
+  // Зона вне диапазона держится и в полосе гистерезиса (distance <= 0),
+  // и у самой границы: там горит первая видимая ступень, а не ничего
+  if (index < gradientFirstVisible) {
+    return gradientLut[gradientFirstVisible];
   }
+  return gradientLut[(uint16_t)index];
 }
 
 void LevelIndicator::calculateGradient(float percent, float maxRange,
@@ -158,6 +441,7 @@ void LevelIndicator::calculateGradient(float percent, float maxRange,
     // 66-100%: первые два полные, третий нарастает
     float localPercent =
         (percent - thresholdMedium) / (thresholdHigh - thresholdMedium);
+    if (localPercent > 1.0f) localPercent = 1.0f;  // thresholdHigh < 100%
     level1 = brightnessLow;
     level2 = brightnessMedium;
     level3 = brightnessHigh * localPercent;
@@ -166,31 +450,54 @@ void LevelIndicator::calculateGradient(float percent, float maxRange,
 
 void LevelIndicator::setThresholds(float low, float medium, float high) {
   if (low >= medium || medium >= high || high > 1.0f) {
-    Serial.println("ERROR: Invalid thresholds");
+    HAL_LOG("ERROR: Invalid thresholds\n");
+    return;
+  }
+  if (!lock()) {
+    HAL_LOG("ERROR: Indicator busy, thresholds not changed\n");
     return;
   }
   thresholdLow = low;
   thresholdMedium = medium;
   thresholdHigh = high;
-  Serial.printf("Thresholds updated: %.2f, %.2f, %.2f\n", low, medium, high);
+  rebuildGradientLut();
+  unlock();
+  HAL_LOG("Thresholds updated: %.2f, %.2f, %.2f\n", low, medium, high);
 }
 
 void LevelIndicator::setBrightness(uint8_t lowBrightness,
                                    uint8_t mediumBrightness,
                                    uint8_t highBrightness) {
+  if (!lock()) {
+    HAL_LOG("ERROR: Indicator busy, brightness not changed\n");
+    return;
+  }
   brightnessLow = lowBrightness;
   brightnessMedium = mediumBrightness;
   brightnessHigh = highBrightness;
-  Serial.printf("Brightness updated: %d, %d, %d\n", lowBrightness,
-                mediumBrightness, highBrightness);
+  rebuildGradientLut();
+  unlock();
+  HAL_LOG("Brightness updated: %d, %d, %d\n", lowBrightness,
+          mediumBrightness, highBrightness);
 }
 
 void LevelIndicator::clear() {
-  setLED(PWM_CHANNEL_POS1, 0);
-  setLED(PWM_CHANNEL_POS2, 0);
-  setLED(PWM_CHANNEL_POS3, 0);
-  setLED(PWM_CHANNEL_NEG1, 0);
-  setLED(PWM_CHANNEL_NEG2, 0);
-  setLED(PWM_CHANNEL_NEG3, 0);
-  setLED(PWM_CHANNEL_NEUTRAL, 0);
+  if (!lock()) return;
+  // Мимо fade: setLED() пропустил бы канал с идущим переходом, а перед
+  // сном update() уже не будет. Запись скважности в драйвере дожидается
+  // конца идущего перехода и ставит 0.
+  uint32_t now = clock.nowMs();
+  for (uint8_t index = 0; index < PWM_CHANNEL_COUNT; index++) {
+    bool fading = fadeEnabled && (int32_t)(now - fadeEndMs[index]) < 0;
+    if (lastDuty[index] == 0 && !fading) {
+      ledWritesSkipped++;
+      continue;
+    }
+
+    pwm.write(PWM_CHANNEL_POS1 + index, 0);
+    lastDuty[index] = 0;
+    fadeEndMs[index] = now;
+    ledWrites++;
+  }
+  unlock();
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+// LogStreamer.cpp
+#include "LogStreamer.h"
+
+#include <errno.h>
+#include <lwip/sockets.h>
+
+namespace {
+
+// Префикс порции chunked: 4 hex-цифры размера (ведущие нули допустимы)
+const uint8_t CHUNK_PREFIX = 6;
+const char LAST_CHUNK[] = "0\r\n\r\n";
+
+}  // namespace
+
+LogStreamer::LogStreamer()
+    : recorder(nullptr),
+      count(0),
+      sampleCount(0),
+      format(FORMAT_BINARY),
+      active(false),
+      position(0),
+      lastByte(0),
+      blockIndex(0),
+      blockOpen(false),
+      headerSent(false),
+      finalChunkSent(false),
+      loadedIndex(-1),
+      pending(nullptr),
+      pendingLength(0),
+      lastProgressMs(0),
+      streamsCompleted(0),
+      streamsAborted(0),
+      bytesSent(0) {}
+
+uint16_t LogStreamer::scan(const SampleRecorder& recorder,
+                           uint32_t fromSequence) {
+  this->recorder = &recorder;
+  count = 0;
+  sampleCount = 0;
+  loadedIndex = -1;
+
+  HalFileSystem& fs = recorder.getFileSystem();
+  uint8_t raw[RecordFormat::HEADER_SIZE];
+  char blockPath[SampleRecorder::BLOCK_PATH_SIZE];
+  for (uint16_t slot = 0; slot < recorder.getBlockCount(); slot++) {
+    RecordBlockHeader header;
+    recorder.getBlockPath(slot, blockPath);
+    if (fs.readAt(blockPath, 0, raw, sizeof(raw)) != (int)sizeof(raw) ||
+        !RecordFormat::parseHeader(raw, header) ||
+        header.sequence < fromSequence) {
+      continue;
+    }
+
+    // Не помещается - вытесняем самый старый
+    if (count == MAX_BLOCKS) {
+      if (header.sequence <= sequences[0]) continue;
+      memmove(slots, slots + 1, (count - 1) * sizeof(slots[0]));
+      memmove(sequences, sequences + 1, (count - 1) * sizeof(sequences[0]));
+      count--;
+    }
+
+    // Вставка по возрастанию номера
+    uint16_t i = count;
+    while (i > 0 && sequences[i - 1] > header.sequence) {
+      slots[i] = slots[i - 1];
+      sequences[i] = sequences[i - 1];
+      i--;
+    }
+    slots[i] = slot;
+    sequences[i] = header.sequence;
+    count++;
+    sampleCount += header.sampleCount;
+  }
+  return count;
+}
+
+bool LogStreamer::start(const WiFiClient& client, Format format,
+                        uint32_t first, uint32_t last) {
+  if (active || !recorder) return false;
+  if (format == FORMAT_BINARY && (count == 0 || last < first ||
+                                  last >= getTotalBytes())) {
+    return false;
+  }
+
+  this->client = client;
+  this->format = format;
+  position = first;
+  lastByte = last;
+  blockIndex = 0;
+  blockOpen = false;
+  headerSent = false;
+  finalChunkSent = false;
+  pending = nullptr;
+  pendingLength = 0;
+  lastProgressMs = millis();
+  active = true;
+  return true;
+}
+
+void LogStreamer::stop() {
+  if (active) finish(false);
+}
+
+void LogStreamer::poll() {
+  if (!active) return;
+
+  if (!client.connected()) {
+    finish(false);
+    return;
+  }
+
+  if (pendingLength == 0) {
+    bool more = format == FORMAT_BINARY ? fillBinary() : fillCsv();
+    if (!more) {
+      if (active) finish(true);
+      return;
+    }
+  }
+
+  // Без ожидания: WiFiClient::write() ждал бы место в буфере TCP до секунды
+  int sent = send(client.fd(), pending, pendingLength, MSG_DONTWAIT);
+  uint32_t now = millis();
+  if (sent > 0) {
+    pending += sent;
+    pendingLength -= sent;
+    bytesSent += sent;
+    lastProgressMs = now;
+    return;
+  }
+
+  if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    finish(false);
+  } else if (now - lastProgressMs > STALL_TIMEOUT_MS) {
+    finish(false);
+  }
+}
+
+bool LogStreamer::loadBlock(uint16_t index) {
+  if (loadedIndex == index) return true;
+
+  loadedIndex = -1;
+  char blockPath[SampleRecorder::BLOCK_PATH_SIZE];
+  recorder->getBlockPath(slots[index], blockPath);
+  if (recorder->getFileSystem().readAt(blockPath, 0, block, sizeof(block)) !=
+      (int)sizeof(block)) {
+    return false;
+  }
+  loadedIndex = index;
+  return true;
+}
+
+bool LogStreamer::fillBinary() {
+  if (position > lastByte) return false;
+
+  uint16_t index = position / RecordFormat::BLOCK_SIZE;
+  uint16_t offset = position % RecordFormat::BLOCK_SIZE;
+  if (!loadBlock(index)) {
+    // Обрыв вместо подмены данных: клиент докачает с Range
+    finish(false);
+    return false;
+  }
+
+  uint32_t length = RecordFormat::BLOCK_SIZE - offset;
+  if (length > lastByte - position + 1) length = lastByte - position + 1;
+
+  pending = block + offset;
+  pendingLength = length;
+  position += length;
+  return true;
+}
+
+bool LogStreamer::fillCsv() {
+  char* out = chunkBuffer + CHUNK_PREFIX;
+  size_t length = 0;
+
+  if (!headerSent) {
+    length = strlen(RecordFormat::CSV_HEADER);
+    memcpy(out, RecordFormat::CSV_HEADER, length);
+    headerSent = true;
+  }
+
+  while (CSV_CHUNK_BYTES - length >= RecordFormat::MAX_CSV_ROW) {
+    if (!blockOpen) {
+      if (blockIndex >= count) break;
+
+      // Нечитаемый, испорченный или уже перезаписанный блок пропускается
+      if (!loadBlock(blockIndex) || !decoder.begin(block) ||
+          decoder.getHeader().sequence != sequences[blockIndex]) {
+        blockIndex++;
+        continue;
+      }
+      blockOpen = true;
+    }
+
+    RecordSample sample;
+    if (!decoder.next(sample)) {
+      blockOpen = false;
+      blockIndex++;
+      continue;
+    }
+    length += RecordFormat::formatCsvRow(sample, sequences[blockIndex],
+                                         out + length,
+                                         CSV_CHUNK_BYTES - length);
+  }
+
+  if (length == 0) {
+    if (finalChunkSent) return false;
+    pending = reinterpret_cast<const uint8_t*>(LAST_CHUNK);
+    pendingLength = sizeof(LAST_CHUNK) - 1;
+    finalChunkSent = true;
+    return true;
+  }
+
+  char prefix[CHUNK_PREFIX + 1];
+  snprintf(prefix, sizeof(prefix), "%04X\r\n", (unsigned)length);
+  memcpy(chunkBuffer, prefix, CHUNK_PREFIX);
+  out[length++] = '\r';
+  out[length++] = '\n';
+
+  pending = reinterpret_cast<const uint8_t*>(chunkBuffer);
+  pendingLength = CHUNK_PREFIX + length;
+  return true;
+}
+
+void LogStreamer::finish(bool completed) {
+  client.stop();
+  active = false;
+  pendingLength = 0;
+
+  if (completed) {
+    streamsCompleted++;
+    Serial.printf("[LOG] Download complete (%s)\n",
+                  format == FORMAT_BINARY ? "binary" : "csv");
+  } else {
+    streamsAborted++;
+    Serial.println(F("[LOG] Download aborted"));
+  }
+}
@@ -0,0 +1,125 @@
+// LogStreamer.h
+// Выгрузка записи SampleRecorder по HTTP порциями из планировщика
+
+#ifndef LOG_STREAMER_H
+#define LOG_STREAMER_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#include "Hal.h"
+#include "RecordFormat.h"
+#include "SampleRecorder.h"
+
+/**
+ * @brief Потоковая отдача кольца записи
+ *
+ * WebServer синхронный: ответ, отправленный целиком из обработчика,
+ * на секунды занял бы loop(). Обработчик только фиксирует порядок блоков
+ * (snapshot) и отправляет заголовки, дальше poll() из отдельной задачи
+ * планировщика читает с flash по одному блоку и отдаёт его неблокирующим
+ * send(): если буфер TCP полон, poll() сразу возвращается.
+ *
+ * В RAM только один блок и порция CSV. Форматы:
+ *  - BINARY - блоки как есть, от старого к новому (размер известен:
+ *    Content-Length, поддерживается Range);
+ *  - CSV - блоки разворачиваются в строки на лету (chunked).
+ * Пока идёт выгрузка, кольцо продолжает писаться: перезаписанный блок
+ * в BINARY уходит с новым номером, в CSV пропускается.
+ */
+class LogStreamer {
+ public:
+  enum Format : uint8_t { FORMAT_BINARY, FORMAT_CSV };
+
+  // Больше блоков в snapshot не помещается (1 МБ записи)
+  static const uint16_t MAX_BLOCKS = 256;
+
+  // Порция CSV: два сегмента TCP
+  static const uint16_t CSV_CHUNK_BYTES = 2 * 1436;
+
+  // Клиент не забирает данные - соединение закрывается
+  static const uint32_t STALL_TIMEOUT_MS = 30000;
+
+  LogStreamer();
+
+  /**
+   * @brief Снять порядок блоков кольца (читаются только заголовки)
+   * @param fromSequence Пропустить блоки с меньшим номером
+   * @return Число блоков
+   */
+  uint16_t scan(const SampleRecorder& recorder, uint32_t fromSequence = 0);
+
+  // Результат scan()
+  uint16_t getBlockCount() const { return count; }
+  uint32_t getTotalBytes() const {
+    return (uint32_t)count * RecordFormat::BLOCK_SIZE;
+  }
+  uint32_t getSampleCount() const { return sampleCount; }
+  uint32_t getFirstSequence() const { return count ? sequences[0] : 0; }
+  uint32_t getLastSequence() const {
+    return count ? sequences[count - 1] : 0;
+  }
+
+  /**
+   * @brief Начать отдачу (заголовки HTTP уже отправлены)
+   * @param first, last Байты BINARY включительно; для CSV не используются
+   */
+  bool start(const WiFiClient& client, Format format, uint32_t first = 0,
+             uint32_t last = 0);
+
+  /**
+   * @brief Отправить следующую порцию (задача планировщика)
+   */
+  void poll();
+
+  void stop();
+  bool isActive() const { return active; }
+
+  // Статистика
+  uint32_t getStreamsCompleted() const { return streamsCompleted; }
+  uint32_t getStreamsAborted() const { return streamsAborted; }
+  uint32_t getBytesSent() const { return bytesSent; }
+
+ private:
+  const SampleRecorder* recorder;
+
+  // Snapshot: слоты по возрастанию номера блока
+  uint16_t slots[MAX_BLOCKS];
+  uint32_t sequences[MAX_BLOCKS];
+  uint16_t count;
+  uint32_t sampleCount;
+
+  WiFiClient client;
+  Format format;
+  bool active;
+
+  // BINARY: текущая позиция и последний байт потока
+  uint32_t position;
+  uint32_t lastByte;
+
+  // CSV: индекс блока в snapshot и декодер текущего блока
+  uint16_t blockIndex;
+  bool blockOpen;
+  RecordBlockDecoder decoder;
+  bool headerSent;
+  bool finalChunkSent;
+
+  // Текущий блок; отдаётся прямо из него (BINARY) или из chunkBuffer (CSV)
+  uint8_t block[RecordFormat::BLOCK_SIZE];
+  int32_t loadedIndex;
+  char chunkBuffer[CSV_CHUNK_BYTES + 8];
+  const uint8_t* pending;
+  size_t pendingLength;
+  uint32_t lastProgressMs;
+
+  uint32_t streamsCompleted;
+  uint32_t streamsAborted;
+  uint32_t bytesSent;
+
+  bool loadBlock(uint16_t index);
+  bool fillBinary();
+  bool fillCsv();
+  void finish(bool completed);
+};
+
+#endif  // LOG_STREAMER_H
@@ -0,0 +1,118 @@
+// LoopProfiler.cpp
+#include "LoopProfiler.h"
+
+bool LoopProfiler::enabled = true;
+LoopProfiler::StageData LoopProfiler::stages[LoopProfiler::STAGE_COUNT];
+portMUX_TYPE LoopProfiler::stagesLock = portMUX_INITIALIZER_UNLOCKED;
+
+void LoopProfiler::record(Stage stage, uint32_t cycles) {
+  if (stage >= STAGE_COUNT) return;
+
+  // Номер корзины = число значащих бит
+  uint8_t bucket = cycles == 0 ? 0 : 32 - __builtin_clz(cycles);
+  if (bucket >= HISTOGRAM_BUCKETS) bucket = HISTOGRAM_BUCKETS - 1;
+
+  portENTER_CRITICAL(&stagesLock);
+  StageData& data = stages[stage];
+  if (data.count == 0 || cycles < data.minCycles) data.minCycles = cycles;
+  if (cycles > data.maxCycles) data.maxCycles = cycles;
+  data.sumCycles += cycles;
+  data.count++;
+  data.histogram[bucket]++;
+  portEXIT_CRITICAL(&stagesLock);
+}
+
+void LoopProfiler::snapshot(Stage stage, StageData& out) {
+  portENTER_CRITICAL(&stagesLock);
+  out = stages[stage];
+  portEXIT_CRITICAL(&stagesLock);
+}
+
+uint32_t LoopProfiler::cyclesToUs(uint64_t cycles) {
+  return (uint32_t)(cycles / getCpuFrequencyMhz());
+}
+
+void LoopProfiler::getStats(Stage stage, StageStats& out) {
+  memset(&out, 0, sizeof(out));
+  if (stage >= STAGE_COUNT) return;
+
+  StageData data;
+  snapshot(stage, data);
+  out.count = data.count;
+  out.minUs = cyclesToUs(data.minCycles);
+  out.maxUs = cyclesToUs(data.maxCycles);
+  out.meanUs = data.count > 0 ? cyclesToUs(data.sumCycles / data.count) : 0;
+  memcpy(out.histogram, data.histogram, sizeof(out.histogram));
+}
+
+uint32_t LoopProfiler::bucketUpperUs(uint8_t bucket) {
+  if (bucket >= HISTOGRAM_BUCKETS) bucket = HISTOGRAM_BUCKETS - 1;
+  return cyclesToUs(1ULL << bucket);
+}
+
+uint32_t LoopProfiler::quantileUs(Stage stage, float q) {
+  if (stage >= STAGE_COUNT) return 0;
+
+  StageData data;
+  snapshot(stage, data);
+  if (data.count == 0) return 0;
+
+  // Ранг искомого значения (1..count)
+  uint32_t rank = (uint32_t)(q * data.count + 0.5f);
+  if (rank < 1) rank = 1;
+  if (rank > data.count) rank = data.count;
+
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+    seen += data.histogram[b];
+    if (seen >= rank) {
+      // Граница корзины не может быть больше реального максимума
+      uint32_t upper = bucketUpperUs(b);
+      uint32_t maxUs = cyclesToUs(data.maxCycles);
+      return upper < maxUs ? upper : maxUs;
+    }
+  }
+  return cyclesToUs(data.maxCycles);
+}
+
+const char* LoopProfiler::stageName(Stage stage) {
+  switch (stage) {
+    case STAGE_LOOP:
+      return "loop";
+    case STAGE_HANDLE_CLIENTS:
+      return "handle_clients";
+    case STAGE_SENSOR_UPDATE:
+      return "sensor_update";
+    case STAGE_INDICATOR:
+      return "indicator";
+    case STAGE_BROADCAST:
+      return "broadcast";
+    default:
+      return "unknown";
+  }
+}
+
+void LoopProfiler::reset() {
+  portENTER_CRITICAL(&stagesLock);
+  memset(stages, 0, sizeof(stages));
+  portEXIT_CRITICAL(&stagesLock);
+}
+
+void LoopProfiler::printSummary() {
+  Serial.printf("=== Loop timing (us, %s) ===\n", enabled ? "ON" : "OFF");
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    StageStats stats;
+    getStats((Stage)i, stats);
+
+    Serial.printf("%-15s n=%u min=%u mean=%u max=%u |", stageName((Stage)i),
+                  stats.count, stats.minUs, stats.meanUs, stats.maxUs);
+
+    // Только непустые корзины: "<=верхняя граница:количество"
+    for (uint8_t b = 0; b < HISTOGRAM_BUCKETS; b++) {
+      if (stats.histogram[b] > 0) {
+        Serial.printf(" <=%u:%u", bucketUpperUs(b), stats.histogram[b]);
+      }
+    }
+    Serial.println();
+  }
+}
@@ -0,0 +1,132 @@
+// LoopProfiler.h
+// Замер длительности этапов loop() по счётчику тактов CPU
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <Arduino.h>
+
+// LOOP_PROFILING=0 в build_flags полностью убирает замеры из кода
+#ifndef LOOP_PROFILING
+#define LOOP_PROFILING 1
+#endif
+
+class LoopProfiler {
+ public:
+  // Этапы, которые замеряем
+  enum Stage : uint8_t {
+    STAGE_LOOP,            // Весь loop() целиком
+    STAGE_HANDLE_CLIENTS,  // LevelWebServer::handleClients()
+    STAGE_SENSOR_UPDATE,   // SensorManager::update()
+    STAGE_INDICATOR,       // LevelIndicator (таймер)
+    STAGE_BROADCAST,       // LevelWebServer::broadcastSensorData()
+    STAGE_COUNT
+  };
+
+  // Гистограмма: корзина k содержит длительности [2^(k-1), 2^k) тактов
+  static const uint8_t HISTOGRAM_BUCKETS = 32;
+
+  struct StageStats {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t meanUs;
+    uint32_t maxUs;
+    uint32_t histogram[HISTOGRAM_BUCKETS];
+  };
+
+  /**
+   * @brief RAII-замер: от конструктора до деструктора
+   */
+  class Scope {
+   public:
+    explicit Scope(Stage stage)
+        : stage(stage),
+          active(enabled),
+          start(active ? ESP.getCycleCount() : 0) {}
+    ~Scope() {
+      if (active) {
+        record(stage, ESP.getCycleCount() - start);
+      }
+    }
+
+   private:
+    Stage stage;
+    bool active;  // Замер включён на входе - иначе start не снят
+    uint32_t start;
+  };
+
+  /**
+   * @brief Включить/выключить замеры во время работы
+   */
+  static void setEnabled(bool value) { enabled = value; }
+  static bool isEnabled() { return enabled; }
+
+  /**
+   * @brief Записать длительность этапа (такты CPU)
+   */
+  static void record(Stage stage, uint32_t cycles);
+
+  /**
+   * @brief Получить статистику этапа в микросекундах
+   */
+  static void getStats(Stage stage, StageStats& out);
+
+  /**
+   * @brief Верхняя граница корзины гистограммы (мкс)
+   */
+  static uint32_t bucketUpperUs(uint8_t bucket);
+
+  /**
+   * @brief Оценка квантиля по гистограмме (верхняя граница корзины, мкс)
+   * @param q Квантиль 0.0 - 1.0
+   */
+  static uint32_t quantileUs(Stage stage, float q);
+
+  /**
+   * @brief Имя этапа для вывода
+   */
+  static const char* stageName(Stage stage);
+
+  /**
+   * @brief Сбросить всю статистику (из любой задачи)
+   */
+  static void reset();
+
+  /**
+   * @brief Компактный вывод в Serial (одна строка на этап)
+   */
+  static void printSummary();
+
+ private:
+  struct StageData {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t sumCycles;
+    uint32_t histogram[HISTOGRAM_BUCKETS];
+  };
+
+  static bool enabled;
+  static StageData stages[STAGE_COUNT];
+
+  // record() идёт и из loop(), и из задачи esp_timer (индикатор, другое
+  // ядро), reset() - из HTTP-обработчика
+  static portMUX_TYPE stagesLock;
+
+  // Согласованная копия статистики этапа
+  static void snapshot(Stage stage, StageData& out);
+  static uint32_t cyclesToUs(uint64_t cycles);
+};
+
+#define LOOP_PROFILER_CONCAT_(a, b) a##b
+#define LOOP_PROFILER_CONCAT(a, b) LOOP_PROFILER_CONCAT_(a, b)
+
+#if LOOP_PROFILING
+#define PROFILE_STAGE(stage)                                       \
+  LoopProfiler::Scope LOOP_PROFILER_CONCAT(profileScope, __LINE__)( \
+      LoopProfiler::stage)
+#else
+#define PROFILE_STAGE(stage)
+#endif
+
+#endif  // LOOP_PROFILER_H
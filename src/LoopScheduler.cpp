@@ -0,0 +1,173 @@
+// LoopScheduler.cpp
+#include "LoopScheduler.h"
+
+LoopScheduler::LoopScheduler() : jobCount(0) {}
+
+int8_t LoopScheduler::addJob(const char* name, uint32_t periodMs,
+                             uint8_t priority, uint32_t budgetUs,
+                             JobFunction function) {
+  if (jobCount >= MAX_JOBS || !function) {
+    Serial.printf("ERROR: Cannot add job '%s'\n", name);
+    return INVALID_JOB;
+  }
+
+  Job& job = jobs[jobCount];
+  job.function = function;
+  job.nextDeadline = millis() + periodMs;  // Первый запуск - через период
+
+  memset(&job.stats, 0, sizeof(job.stats));
+  job.stats.name = name;
+  job.stats.periodMs = periodMs;
+  job.stats.priority = priority;
+  job.stats.budgetUs = budgetUs;
+  job.stats.enabled = true;
+
+  Serial.printf("Job '%s': period=%u ms, priority=%u, budget=%u us\n", name,
+                periodMs, priority, budgetUs);
+  return jobCount++;
+}
+
+bool LoopScheduler::setPeriod(int8_t id, uint32_t periodMs) {
+  if (!isValid(id)) return false;
+
+  Job& job = jobs[id];
+  if (job.stats.periodMs == periodMs) return true;
+
+  job.stats.periodMs = periodMs;
+  job.nextDeadline = millis() + periodMs;
+  return true;
+}
+
+bool LoopScheduler::setEnabled(int8_t id, bool enabled) {
+  if (!isValid(id)) return false;
+
+  Job& job = jobs[id];
+  if (enabled && !job.stats.enabled) {
+    job.nextDeadline = millis();
+  }
+  job.stats.enabled = enabled;
+  return true;
+}
+
+int8_t LoopScheduler::pickNextJob(unsigned long now, uint16_t skipMask) const {
+  int8_t best = INVALID_JOB;
+
+  for (uint8_t i = 0; i < jobCount; i++) {
+    const Job& job = jobs[i];
+    if (!job.stats.enabled || (skipMask & (1u << i))) continue;
+    if ((long)(now - job.nextDeadline) < 0) continue;  // Ещё не пора
+
+    if (best == INVALID_JOB) {
+      best = i;
+      continue;
+    }
+
+    const Job& current = jobs[best];
+    long diff = (long)(job.nextDeadline - current.nextDeadline);
+    if (diff < 0 ||
+        (diff == 0 && job.stats.priority > current.stats.priority)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void LoopScheduler::runJob(Job& job, unsigned long now) {
+  JobStats& stats = job.stats;
+
+  if (stats.periodMs > 0) {
+    uint32_t lateness = now - job.nextDeadline;
+    if (lateness > stats.maxLatenessMs) stats.maxLatenessMs = lateness;
+  }
+
+  uint32_t start = micros();
+  job.function();
+  uint32_t elapsed = micros() - start;
+
+  stats.runs++;
+  stats.lastRunUs = elapsed;
+  stats.totalRunUs += elapsed;
+  if (elapsed > stats.maxRunUs) stats.maxRunUs = elapsed;
+  if (stats.budgetUs > 0 && elapsed > stats.budgetUs) stats.overruns++;
+
+  // Следующий срок - от предыдущего, чтобы период не "уплывал".
+  // Если отстали больше чем на период - пропускаем догоняющие запуски.
+  if (stats.periodMs == 0) {
+    // Срок - конец выполнения: готовые периодические задачи идут раньше
+    job.nextDeadline = millis();
+  } else {
+    job.nextDeadline += stats.periodMs;
+    unsigned long after = millis();
+    if ((long)(after - job.nextDeadline) > 0) {
+      stats.missedPeriods += (after - job.nextDeadline) / stats.periodMs + 1;
+      job.nextDeadline = after + stats.periodMs;
+    }
+  }
+}
+
+uint8_t LoopScheduler::run() {
+  uint8_t executed = 0;
+  unsigned long now = millis();
+
+  // Каждая задача - не больше одного раза за проход, иначе задача с
+  // нулевым периодом заняла бы весь проход
+  uint16_t ranMask = 0;
+
+  int8_t id;
+  while ((id = pickNextJob(now, ranMask)) != INVALID_JOB) {
+    runJob(jobs[id], now);
+    ranMask |= 1u << id;
+    executed++;
+    now = millis();
+  }
+
+  return executed;
+}
+
+uint32_t LoopScheduler::msUntilNextDeadline() const {
+  unsigned long now = millis();
+  uint32_t soonest = UINT32_MAX;
+
+  for (uint8_t i = 0; i < jobCount; i++) {
+    const Job& job = jobs[i];
+    if (!job.stats.enabled) continue;
+
+    long remaining = (long)(job.nextDeadline - now);
+    if (remaining <= 0) return 0;
+    if ((uint32_t)remaining < soonest) soonest = remaining;
+  }
+  return soonest;
+}
+
+bool LoopScheduler::getJobStats(int8_t id, JobStats& out) const {
+  if (!isValid(id)) return false;
+  out = jobs[id].stats;
+  return true;
+}
+
+void LoopScheduler::resetStats() {
+  for (uint8_t i = 0; i < jobCount; i++) {
+    JobStats& stats = jobs[i].stats;
+    stats.runs = 0;
+    stats.overruns = 0;
+    stats.missedPeriods = 0;
+    stats.lastRunUs = 0;
+    stats.maxRunUs = 0;
+    stats.maxLatenessMs = 0;
+    stats.totalRunUs = 0;
+  }
+}
+
+void LoopScheduler::printStats() const {
+  Serial.println("=== Scheduler jobs ===");
+  for (uint8_t i = 0; i < jobCount; i++) {
+    const JobStats& stats = jobs[i].stats;
+    uint32_t meanUs = stats.runs > 0 ? stats.totalRunUs / stats.runs : 0;
+    Serial.printf(
+        "%-10s %5u ms p%u runs=%u mean=%u us max=%u us budget=%u us "
+        "overruns=%u missed=%u late<=%u ms%s\n",
+        stats.name, stats.periodMs, stats.priority, stats.runs, meanUs,
+        stats.maxRunUs, stats.budgetUs, stats.overruns, stats.missedPeriods,
+        stats.maxLatenessMs, stats.enabled ? "" : " (off)");
+  }
+}
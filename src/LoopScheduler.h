@@ -0,0 +1,105 @@
+// LoopScheduler.h
+// Кооперативный планировщик периодических задач loop() (EDF)
+
+#ifndef LOOP_SCHEDULER_H
+#define LOOP_SCHEDULER_H
+
+#include <Arduino.h>
+
+#include <functional>
+
+/**
+ * @brief Планировщик задач с периодом, приоритетом и бюджетом времени
+ *
+ * Из готовых к запуску задач первой выполняется та, у которой раньше
+ * срок (earliest deadline first); при равных сроках - с большим
+ * приоритетом. Задачи не вытесняются: каждая должна укладываться в свой
+ * бюджет, превышения считаются.
+ */
+class LoopScheduler {
+ public:
+  typedef std::function<void()> JobFunction;
+
+  static const uint8_t MAX_JOBS = 12;
+  static const int8_t INVALID_JOB = -1;
+
+  // Статистика задачи
+  struct JobStats {
+    const char* name;
+    uint32_t periodMs;
+    uint8_t priority;
+    uint32_t budgetUs;
+    bool enabled;
+    uint32_t runs;
+    uint32_t overruns;       // Выполнение дольше бюджета
+    uint32_t missedPeriods;  // Отставание больше периода (пропуск запуска)
+    uint32_t lastRunUs;
+    uint32_t maxRunUs;
+    uint32_t maxLatenessMs;  // Максимальное опоздание старта
+    uint64_t totalRunUs;     // Суммарное время выполнения
+  };
+
+  LoopScheduler();
+
+  /**
+   * @brief Зарегистрировать задачу (первый запуск - через periodMs)
+   * @param name Имя (строка должна жить всё время работы)
+   * @param periodMs Период (0 = на каждом проходе run())
+   * @param priority Приоритет при равных сроках (больше = важнее)
+   * @param budgetUs Допустимое время выполнения (0 = без контроля)
+   * @param function Тело задачи
+   * @return Идентификатор задачи или INVALID_JOB
+   */
+  int8_t addJob(const char* name, uint32_t periodMs, uint8_t priority,
+                uint32_t budgetUs, JobFunction function);
+
+  /**
+   * @brief Изменить период задачи (следующий срок - от текущего момента)
+   */
+  bool setPeriod(int8_t id, uint32_t periodMs);
+
+  /**
+   * @brief Включить/выключить задачу
+   */
+  bool setEnabled(int8_t id, bool enabled);
+
+  /**
+   * @brief Выполнить все задачи, срок которых наступил
+   * @return Количество выполненных задач
+   */
+  uint8_t run();
+
+  /**
+   * @brief Сколько мс до ближайшего срока (0 = есть готовые задачи)
+   */
+  uint32_t msUntilNextDeadline() const;
+
+  uint8_t getJobCount() const { return jobCount; }
+  bool getJobStats(int8_t id, JobStats& out) const;
+
+  /**
+   * @brief Сбросить статистику всех задач
+   */
+  void resetStats();
+
+  /**
+   * @brief Вывести статистику задач в Serial
+   */
+  void printStats() const;
+
+ private:
+  struct Job {
+    JobFunction function;
+    unsigned long nextDeadline;  // millis()
+    JobStats stats;
+  };
+
+  Job jobs[MAX_JOBS];
+  uint8_t jobCount;
+
+  bool isValid(int8_t id) const { return id >= 0 && id < jobCount; }
+  int8_t pickNextJob(unsigned long now, uint16_t skipMask) const;
+  void runJob(Job& job, unsigned long now);
+};
+
+#endif  // LOOP_SCHEDULER_H
@@ -0,0 +1,131 @@
+// Lsm303.cpp
+#include "Lsm303.h"
+
+#include <math.h>
+
+namespace {
+
+// CTRL_REG1_A: ODR[7:4], LPen = 0 (нормальный режим), Z/Y/X включены
+const uint8_t ACCEL_AXES_ENABLE = 0x07;
+const uint8_t ACCEL_ODR_100HZ = 5;
+
+// CRB_REG_M: усиление ±1.3 Гс; MR_REG_M: непрерывное измерение
+const uint8_t MAG_GAIN_1_3 = 0x20;
+const uint8_t MAG_CONTINUOUS = 0x00;
+
+// Коды ODR 1..7
+const uint8_t ODR_CODES = 7;
+const uint16_t ODR_HZ[ODR_CODES] = {1, 10, 25, 50, 100, 200, 400};
+
+int16_t clampCounts(float counts, int16_t min, int16_t max) {
+  if (counts != counts) return 0;  // NaN
+  if (counts < min) return min;
+  if (counts > max) return max;
+  return (int16_t)lroundf(counts);
+}
+
+int16_t littleEndian(const uint8_t* p) { return (int16_t)(p[0] | (p[1] << 8)); }
+
+int16_t bigEndian(const uint8_t* p) { return (int16_t)((p[0] << 8) | p[1]); }
+
+void putLittleEndian(uint8_t* p, int16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+void putBigEndian(uint8_t* p, int16_t v) {
+  p[0] = (uint8_t)((uint16_t)v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+}  // namespace
+
+bool Lsm303::beginAccel() {
+  if (!writeAccelOdr(ACCEL_ODR_100HZ)) return false;
+
+  // Регистр читается обратно - датчик на месте и это LSM303
+  uint8_t value = 0;
+  if (!i2c.readRegisters(ACCEL_ADDRESS, REG_CTRL_REG1_A, &value, 1)) {
+    return false;
+  }
+  return value == ((ACCEL_ODR_100HZ << 4) | ACCEL_AXES_ENABLE);
+}
+
+bool Lsm303::beginMag() {
+  return i2c.writeRegister(MAG_ADDRESS, REG_MR_REG_M, MAG_CONTINUOUS) &&
+         i2c.writeRegister(MAG_ADDRESS, REG_CRB_REG_M, MAG_GAIN_1_3);
+}
+
+uint8_t Lsm303::accelOdrCode(uint16_t intervalMs) {
+  for (uint8_t i = 0; i < ODR_CODES; i++) {
+    if ((uint32_t)ODR_HZ[i] * intervalMs >= 2000) return i + 1;
+  }
+  return ODR_CODES;  // 400 Гц, если период совсем короткий
+}
+
+uint16_t Lsm303::accelOdrHzForCode(uint8_t code) {
+  if (code == 0 || code > ODR_CODES) return 0;
+  return ODR_HZ[code - 1];
+}
+
+uint16_t Lsm303::setAccelOdrForInterval(uint16_t intervalMs) {
+  if (!writeAccelOdr(accelOdrCode(intervalMs))) return 0;
+  return accelOdrHz;
+}
+
+bool Lsm303::writeAccelOdr(uint8_t code) {
+  if (!i2c.writeRegister(ACCEL_ADDRESS, REG_CTRL_REG1_A,
+                         (uint8_t)((code << 4) | ACCEL_AXES_ENABLE))) {
+    return false;
+  }
+  accelOdrHz = accelOdrHzForCode(code);
+  return true;
+}
+
+bool Lsm303::readAccel(float& x, float& y, float& z) {
+  uint8_t raw[6];
+  if (!i2c.readRegisters(ACCEL_ADDRESS, REG_OUT_X_L_A | AUTO_INCREMENT, raw,
+                         sizeof(raw))) {
+    return false;
+  }
+  decodeAccel(raw, x, y, z);
+  return true;
+}
+
+bool Lsm303::readMag(float& x, float& y, float& z) {
+  uint8_t raw[6];
+  if (!i2c.readRegisters(MAG_ADDRESS, REG_OUT_X_H_M, raw, sizeof(raw))) {
+    return false;
+  }
+  decodeMag(raw, x, y, z);
+  return true;
+}
+
+void Lsm303::decodeAccel(const uint8_t raw[6], float& x, float& y, float& z) {
+  const float scale = ACCEL_G_PER_LSB * GRAVITY;
+  x = (littleEndian(raw + 0) >> 4) * scale;
+  y = (littleEndian(raw + 2) >> 4) * scale;
+  z = (littleEndian(raw + 4) >> 4) * scale;
+}
+
+void Lsm303::encodeAccel(float x, float y, float z, uint8_t raw[6]) {
+  const float scale = ACCEL_G_PER_LSB * GRAVITY;
+  // 12 бит со знаком, выравнивание влево
+  putLittleEndian(raw + 0, clampCounts(x / scale, -2048, 2047) * 16);
+  putLittleEndian(raw + 2, clampCounts(y / scale, -2048, 2047) * 16);
+  putLittleEndian(raw + 4, clampCounts(z / scale, -2048, 2047) * 16);
+}
+
+void Lsm303::decodeMag(const uint8_t raw[6], float& x, float& y, float& z) {
+  x = bigEndian(raw + 0) / MAG_LSB_PER_GAUSS_XY * MICROTESLA_PER_GAUSS;
+  z = bigEndian(raw + 2) / MAG_LSB_PER_GAUSS_Z * MICROTESLA_PER_GAUSS;
+  y = bigEndian(raw + 4) / MAG_LSB_PER_GAUSS_XY * MICROTESLA_PER_GAUSS;
+}
+
+void Lsm303::encodeMag(float x, float y, float z, uint8_t raw[6]) {
+  const float xy = MAG_LSB_PER_GAUSS_XY / MICROTESLA_PER_GAUSS;
+  const float zs = MAG_LSB_PER_GAUSS_Z / MICROTESLA_PER_GAUSS;
+  putBigEndian(raw + 0, clampCounts(x * xy, -2048, 2047));
+  putBigEndian(raw + 2, clampCounts(z * zs, -2048, 2047));
+  putBigEndian(raw + 4, clampCounts(y * xy, -2048, 2047));
+}
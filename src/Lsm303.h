@@ -0,0 +1,77 @@
+// Lsm303.h
+// Драйвер LSM303DLHC (акселерометр + магнитометр) поверх HalI2c
+
+#ifndef LSM303_H
+#define LSM303_H
+
+#include "Hal.h"
+
+/**
+ * @brief Регистровый драйвер LSM303DLHC
+ *
+ * Масштабы как у Adafruit_LSM303_U: акселерометр ±2 g, 1 mg/LSB
+ * (12 бит, выравнивание влево); магнитометр ±1.3 Гс, 1100/980 LSB/Гс.
+ * Кодирование в обратную сторону - для модели датчика на ПК.
+ */
+class Lsm303 {
+ public:
+  static const uint8_t ACCEL_ADDRESS = 0x19;
+  static const uint8_t MAG_ADDRESS = 0x1E;
+
+  // Акселерометр
+  static const uint8_t REG_CTRL_REG1_A = 0x20;
+  static const uint8_t REG_OUT_X_L_A = 0x28;
+  static const uint8_t AUTO_INCREMENT = 0x80;  // Бит автоинкремента адреса
+
+  // Магнитометр
+  static const uint8_t REG_CRA_REG_M = 0x00;
+  static const uint8_t REG_CRB_REG_M = 0x01;
+  static const uint8_t REG_MR_REG_M = 0x02;
+  static const uint8_t REG_OUT_X_H_M = 0x03;  // X, Z, Y; старший байт первым
+
+  static constexpr float GRAVITY = 9.80665f;        // м/с² на 1 g
+  static constexpr float ACCEL_G_PER_LSB = 0.001f;  // ±2 g, после >> 4
+  static constexpr float MAG_LSB_PER_GAUSS_XY = 1100.0f;
+  static constexpr float MAG_LSB_PER_GAUSS_Z = 980.0f;
+  static constexpr float MICROTESLA_PER_GAUSS = 100.0f;
+
+  explicit Lsm303(HalI2c& i2c) : i2c(i2c), accelOdrHz(0) {}
+
+  /**
+   * @brief Включить акселерометр (100 Гц, X/Y/Z) и проверить ответ
+   */
+  bool beginAccel();
+
+  /**
+   * @brief Включить магнитометр (непрерывный режим, ±1.3 Гс)
+   */
+  bool beginMag();
+
+  /**
+   * @brief Частота данных акселерометра под период опроса
+   * Минимальный ODR, дающий два свежих отсчёта на период.
+   * @return Выбранная частота (Гц) или 0 при ошибке I2C
+   */
+  uint16_t setAccelOdrForInterval(uint16_t intervalMs);
+  uint16_t getAccelOdrHz() const { return accelOdrHz; }
+
+  bool readAccel(float& x, float& y, float& z);  // м/с²
+  bool readMag(float& x, float& y, float& z);    // мкТл
+
+  // Код ODR (CTRL_REG1_A[7:4]) для периода и его частота
+  static uint8_t accelOdrCode(uint16_t intervalMs);
+  static uint16_t accelOdrHzForCode(uint8_t code);
+
+  static void decodeAccel(const uint8_t raw[6], float& x, float& y, float& z);
+  static void encodeAccel(float x, float y, float z, uint8_t raw[6]);
+  static void decodeMag(const uint8_t raw[6], float& x, float& y, float& z);
+  static void encodeMag(float x, float y, float z, uint8_t raw[6]);
+
+ private:
+  HalI2c& i2c;
+  uint16_t accelOdrHz;
+
+  bool writeAccelOdr(uint8_t code);
+};
+
+#endif  // LSM303_H
@@ -0,0 +1,254 @@
+// MagCalibration.cpp
+#include "MagCalibration.h"
+
+#include <math.h>
+
+namespace {
+
+// Ниже - система считается вырожденной
+const double MIN_PIVOT = 1e-12;
+
+// Решение A x = b методом Гаусса с выбором главного элемента (A портится)
+bool solveLinear(double* a, double* b, double* x, int n) {
+  for (int col = 0; col < n; col++) {
+    int pivot = col;
+    for (int row = col + 1; row < n; row++) {
+      if (fabs(a[row * n + col]) > fabs(a[pivot * n + col])) pivot = row;
+    }
+    if (fabs(a[pivot * n + col]) < MIN_PIVOT) return false;
+
+    if (pivot != col) {
+      for (int k = 0; k < n; k++) {
+        double t = a[col * n + k];
+        a[col * n + k] = a[pivot * n + k];
+        a[pivot * n + k] = t;
+      }
+      double t = b[col];
+      b[col] = b[pivot];
+      b[pivot] = t;
+    }
+
+    for (int row = col + 1; row < n; row++) {
+      double f = a[row * n + col] / a[col * n + col];
+      for (int k = col; k < n; k++) a[row * n + k] -= f * a[col * n + k];
+      b[row] -= f * b[col];
+    }
+  }
+
+  for (int row = n - 1; row >= 0; row--) {
+    double s = b[row];
+    for (int k = row + 1; k < n; k++) s -= a[row * n + k] * x[k];
+    x[row] = s / a[row * n + row];
+  }
+  return true;
+}
+
+// Собственные числа и векторы (столбцы v) симметричной 3x3 методом Якоби
+void eigenSymmetric(double a[3][3], double values[3], double v[3][3]) {
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) v[i][j] = i == j ? 1.0 : 0.0;
+  }
+
+  for (int sweep = 0; sweep < 50; sweep++) {
+    double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    if (off < 1e-24) break;
+
+    for (int p = 0; p < 2; p++) {
+      for (int q = p + 1; q < 3; q++) {
+        if (fabs(a[p][q]) < 1e-30) continue;
+
+        double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        double t = (theta >= 0 ? 1.0 : -1.0) /
+                   (fabs(theta) + sqrt(theta * theta + 1.0));
+        double c = 1.0 / sqrt(t * t + 1.0);
+        double s = t * c;
+
+        for (int k = 0; k < 3; k++) {
+          double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 3; k++) {
+          double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < 3; k++) {
+          double vkp = v[k][p], vkq = v[k][q];
+          v[k][p] = c * vkp - s * vkq;
+          v[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < 3; i++) values[i] = a[i][i];
+}
+
+}  // namespace
+
+MagCalibration::MagCalibration() : collecting(false) { clear(); }
+
+void MagCalibration::start() {
+  clear();
+  collecting = true;
+}
+
+void MagCalibration::clear() {
+  count = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    last[axis] = 0.0f;
+    minValue[axis] = INFINITY;
+    maxValue[axis] = -INFINITY;
+  }
+  for (int i = 0; i < TERMS; i++) {
+    rhs[i] = 0.0;
+    for (int j = 0; j < TERMS; j++) normal[i][j] = 0.0;
+  }
+}
+
+bool MagCalibration::addSample(float x, float y, float z) {
+  if (!collecting) return false;
+
+  float dx = x - last[0], dy = y - last[1], dz = z - last[2];
+  if (count > 0 && dx * dx + dy * dy + dz * dz < MIN_STEP_UT * MIN_STEP_UT) {
+    return false;
+  }
+  last[0] = x;
+  last[1] = y;
+  last[2] = z;
+
+  const float value[3] = {x, y, z};
+  for (int axis = 0; axis < 3; axis++) {
+    if (value[axis] < minValue[axis]) minValue[axis] = value[axis];
+    if (value[axis] > maxValue[axis]) maxValue[axis] = value[axis];
+  }
+
+  double nx = x / NORMALIZE_UT, ny = y / NORMALIZE_UT, nz = z / NORMALIZE_UT;
+  const double u[TERMS] = {nx * nx,     ny * ny,     nz * nz,
+                           2 * nx * ny, 2 * nx * nz, 2 * ny * nz,
+                           2 * nx,      2 * ny,      2 * nz};
+
+  // Матрица симметрична: копится верхний треугольник
+  for (int i = 0; i < TERMS; i++) {
+    rhs[i] += u[i];
+    for (int j = i; j < TERMS; j++) normal[i][j] += u[i] * u[j];
+  }
+  count++;
+  return true;
+}
+
+float MagCalibration::getSpan(int axis) const {
+  return count ? maxValue[axis] - minValue[axis] : 0.0f;
+}
+
+MagCalibration::SolveResult MagCalibration::solve(MagCorrection& out,
+                                                  float& fieldUt,
+                                                  float& fitError) const {
+  if (count < MIN_SAMPLES) return SOLVE_INCOMPLETE;
+  for (int axis = 0; axis < 3; axis++) {
+    if (getSpan(axis) < MIN_SPAN_UT) return SOLVE_INCOMPLETE;
+  }
+
+  double a[TERMS * TERMS], b[TERMS], theta[TERMS];
+  for (int i = 0; i < TERMS; i++) {
+    b[i] = rhs[i];
+    for (int j = 0; j < TERMS; j++) {
+      a[i * TERMS + j] = i <= j ? normal[i][j] : normal[j][i];
+    }
+  }
+  if (!solveLinear(a, b, theta, TERMS)) return SOLVE_DEGENERATE;
+
+  // Невязка sum((uᵀθ - 1)²) = θᵀNθ - 2θᵀs + n
+  double residual = (double)count;
+  for (int i = 0; i < TERMS; i++) {
+    residual -= 2.0 * theta[i] * rhs[i];
+    for (int j = 0; j < TERMS; j++) {
+      residual += theta[i] * theta[j] * (i <= j ? normal[i][j] : normal[j][i]);
+    }
+  }
+  fitError = (float)sqrt(residual > 0.0 ? residual / count : 0.0);
+
+  // Центр: A c = -v
+  double quadric[3][3] = {{theta[0], theta[3], theta[4]},
+                          {theta[3], theta[1], theta[5]},
+                          {theta[4], theta[5], theta[2]}};
+  double m[9], center[3], minusV[3] = {-theta[6], -theta[7], -theta[8]};
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) m[i * 3 + j] = quadric[i][j];
+  }
+  if (!solveLinear(m, minusV, center, 3)) return SOLVE_DEGENERATE;
+
+  // (x - c)ᵀ A (x - c) = 1 - vᵀc: приводим к единичной правой части
+  double k = 1.0 - (theta[6] * center[0] + theta[7] * center[1] +
+                    theta[8] * center[2]);
+  if (k <= 0.0) return SOLVE_DEGENERATE;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) quadric[i][j] /= k;
+  }
+
+  double values[3], vectors[3][3];
+  eigenSymmetric(quadric, values, vectors);
+  if (values[0] <= 0.0 || values[1] <= 0.0 || values[2] <= 0.0) {
+    return SOLVE_DEGENERATE;
+  }
+
+  // Полуоси эллипсоида (мкТл) и радиус сферы того же объёма
+  double radius[3], minRadius = INFINITY, maxRadius = 0.0;
+  for (int i = 0; i < 3; i++) {
+    radius[i] = NORMALIZE_UT / sqrt(values[i]);
+    if (radius[i] < minRadius) minRadius = radius[i];
+    if (radius[i] > maxRadius) maxRadius = radius[i];
+  }
+  double field = cbrt(radius[0] * radius[1] * radius[2]);
+
+  // matrix = field * sqrt(A) (A в мкТл): полуось i сжимается до field
+  MagCorrection c;
+  for (int i = 0; i < 3; i++) {
+    c.offset[i] = (float)(center[i] * NORMALIZE_UT);
+    for (int j = 0; j < 3; j++) {
+      double sum = 0.0;
+      for (int e = 0; e < 3; e++) {
+        sum += vectors[i][e] * (field / radius[e]) * vectors[j][e];
+      }
+      c.matrix[i][j] = (float)sum;
+    }
+  }
+
+  fieldUt = (float)field;
+  if (field < MIN_FIELD_UT || field > MAX_FIELD_UT ||
+      maxRadius / minRadius > MAX_AXIS_RATIO || !isValid(c)) {
+    return SOLVE_OUT_OF_RANGE;
+  }
+  out = c;
+  return SOLVE_OK;
+}
+
+bool MagCalibration::isValid(const MagCorrection& c) {
+  for (int i = 0; i < 3; i++) {
+    // !(a <= b) заодно отсекает NaN
+    if (!(fabsf(c.offset[i]) <= MAX_OFFSET_UT)) return false;
+    for (int j = 0; j < 3; j++) {
+      float value = c.matrix[i][j];
+      bool ok = i == j ? value >= MIN_MATRIX_DIAGONAL &&
+                             value <= MAX_MATRIX_DIAGONAL
+                       : fabsf(value) <= MAX_MATRIX_CROSS;
+      if (!ok) return false;
+    }
+  }
+  return true;
+}
+
+const char* MagCalibration::resultName(SolveResult result) {
+  switch (result) {
+    case SOLVE_OK:
+      return "ok";
+    case SOLVE_INCOMPLETE:
+      return "incomplete";
+    case SOLVE_DEGENERATE:
+      return "degenerate";
+    case SOLVE_OUT_OF_RANGE:
+      return "out_of_range";
+  }
+  return "unknown";
+}
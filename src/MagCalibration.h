@@ -0,0 +1,128 @@
+// MagCalibration.h
+// Калибровка магнитометра: hard-iron смещение и soft-iron искажение
+
+#ifndef MAG_CALIBRATION_H
+#define MAG_CALIBRATION_H
+
+#include <stdint.h>
+
+/**
+ * @brief Поправка магнитометра: m = matrix * (raw - offset)
+ *
+ * offset - hard-iron (постоянное поле платы), matrix - soft-iron
+ * (эллипсоид показаний в сферу радиусом среднего поля).
+ */
+struct MagCorrection {
+  float offset[3];     // мкТл
+  float matrix[3][3];  // Симметричная
+
+  static MagCorrection identity() {
+    MagCorrection c = {{0.0f, 0.0f, 0.0f},
+                       {{1.0f, 0.0f, 0.0f},
+                        {0.0f, 1.0f, 0.0f},
+                        {0.0f, 0.0f, 1.0f}}};
+    return c;
+  }
+
+  bool isIdentity() const {
+    for (int i = 0; i < 3; i++) {
+      if (offset[i] != 0.0f) return false;
+      for (int j = 0; j < 3; j++) {
+        if (matrix[i][j] != (i == j ? 1.0f : 0.0f)) return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief Подгонка эллипсоида по показаниям при вращении устройства
+ *
+ * Показания исправного магнитометра при вращении лежат на сфере; железо
+ * платы сдвигает её (hard-iron) и вытягивает в эллипсоид (soft-iron).
+ * Подгоняется общий эллипсоид
+ *   a x² + b y² + c z² + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+ * методом наименьших квадратов. Сэмплы не хранятся - копятся только
+ * нормальные уравнения (9x9), поэтому сбор может идти сколько угодно.
+ * Почти повторяющиеся показания (устройство не вращают) пропускаются,
+ * чтобы покой не перевешивал остальные направления.
+ */
+class MagCalibration {
+ public:
+  enum SolveResult : uint8_t {
+    SOLVE_OK,
+    SOLVE_INCOMPLETE,   // Мало сэмплов или вращали не по всем осям
+    SOLVE_DEGENERATE,   // Система вырождена или не эллипсоид
+    SOLVE_OUT_OF_RANGE  // Поле или искажение вне допустимого
+  };
+
+  static const uint16_t MIN_SAMPLES = 150;
+
+  // Сэмпл берётся, если отличается от предыдущего хотя бы на столько
+  static constexpr float MIN_STEP_UT = 2.0f;
+
+  // Размах по каждой оси: поле Земли 25..65 мкТл, полный оборот - вдвое
+  static constexpr float MIN_SPAN_UT = 30.0f;
+
+  // Радиус сферы и отношение осей эллипсоида (LSM303DLHC: ±130 мкТл)
+  static constexpr float MIN_FIELD_UT = 10.0f;
+  static constexpr float MAX_FIELD_UT = 130.0f;
+  static constexpr float MAX_AXIS_RATIO = 1.5f;
+  static constexpr float MAX_OFFSET_UT = 130.0f;
+
+  // Диагональ и вне диагонали matrix у правдоподобной поправки
+  static constexpr float MIN_MATRIX_DIAGONAL = 0.5f;
+  static constexpr float MAX_MATRIX_DIAGONAL = 2.0f;
+  static constexpr float MAX_MATRIX_CROSS = 0.5f;
+
+  MagCalibration();
+
+  void start();
+  void stop() { collecting = false; }
+  bool isCollecting() const { return collecting; }
+
+  /**
+   * @brief Сырое показание (мкТл)
+   * @return true - сэмпл принят в подгонку
+   */
+  bool addSample(float x, float y, float z);
+
+  uint32_t getSampleCount() const { return count; }
+
+  // Размах показаний по оси (мкТл) - видно, какую ось ещё повернуть
+  float getSpan(int axis) const;
+
+  /**
+   * @brief Поправка по накопленным сэмплам
+   * @param fieldUt Радиус сферы после поправки (среднее поле)
+   * @param fitError СКО невязки уравнения эллипсоида (безразмерная)
+   */
+  SolveResult solve(MagCorrection& out, float& fieldUt,
+                    float& fitError) const;
+
+  /**
+   * @brief Поправка в допустимых пределах (в т.ч. прочитанная из файла)
+   */
+  static bool isValid(const MagCorrection& correction);
+
+  static const char* resultName(SolveResult result);
+
+ private:
+  static const uint8_t TERMS = 9;
+
+  // Показания делятся на масштаб поля: члены x² и x одного порядка
+  static constexpr float NORMALIZE_UT = 50.0f;
+
+  bool collecting;
+  uint32_t count;
+  float last[3];
+  float minValue[3], maxValue[3];
+
+  // Нормальные уравнения: sum(u uᵀ), sum(u), где u - члены уравнения
+  double normal[TERMS][TERMS];
+  double rhs[TERMS];
+
+  void clear();
+};
+
+#endif  // MAG_CALIBRATION_H
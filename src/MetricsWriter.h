@@ -0,0 +1,156 @@
+// MetricsWriter.h
+// Формирование метрик в текстовом формате Prometheus через фиксированный буфер
+
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Запись метрик Prometheus без выделения памяти
+ *
+ * Пишет строки в переданный буфер. С приёмником (sink) буфер - только
+ * окно: перед строкой, которая не влезает, накопленное отдаётся в sink,
+ * и размер ответа буфером не ограничен. Без приёмника или если одна
+ * строка больше буфера дальнейшие строки отбрасываются целиком,
+ * overflowed() возвращает true. Вывод всегда кончается полной строкой.
+ */
+class MetricsWriter {
+ public:
+  // Приёмник готовых строк (например, WebServer::sendContent)
+  typedef void (*Sink)(void* context, const char* data, size_t length);
+
+  MetricsWriter(char* buffer, size_t capacity, Sink sink = nullptr,
+                void* context = nullptr)
+      : buffer(buffer),
+        capacity(capacity),
+        sink(sink),
+        context(context),
+        used(0),
+        flushed(0),
+        overflow(false) {
+    if (capacity > 0) buffer[0] = '\0';
+  }
+
+  /**
+   * @brief Заголовок семейства метрик (# HELP и # TYPE)
+   * @param type "counter", "gauge" или "summary"
+   */
+  void family(const char* name, const char* type, const char* help) {
+    append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  }
+
+  /**
+   * @brief Значение метрики
+   * @param labels Метки без фигурных скобок (key="value",...) или nullptr
+   */
+  void value(const char* name, uint32_t v, const char* labels = nullptr) {
+    if (labels) {
+      append("%s{%s} %u\n", name, labels, (unsigned)v);
+    } else {
+      append("%s %u\n", name, (unsigned)v);
+    }
+  }
+
+  void value(const char* name, int32_t v, const char* labels = nullptr) {
+    if (labels) {
+      append("%s{%s} %d\n", name, labels, (int)v);
+    } else {
+      append("%s %d\n", name, (int)v);
+    }
+  }
+
+  void value(const char* name, float v, const char* labels = nullptr) {
+    if (labels) {
+      append("%s{%s} %.3f\n", name, labels, v);
+    } else {
+      append("%s %.3f\n", name, v);
+    }
+  }
+
+  /**
+   * @brief Семейство из одного значения
+   */
+  void counter(const char* name, const char* help, uint32_t v) {
+    family(name, "counter", help);
+    value(name, v);
+  }
+
+  void gauge(const char* name, const char* help, uint32_t v) {
+    family(name, "gauge", help);
+    value(name, v);
+  }
+
+  void gauge(const char* name, const char* help, int32_t v) {
+    family(name, "gauge", help);
+    value(name, v);
+  }
+
+  void gauge(const char* name, const char* help, float v) {
+    family(name, "gauge", help);
+    value(name, v);
+  }
+
+  /**
+   * @brief Отдать накопленные строки в sink (в конце ответа)
+   */
+  void flush() {
+    if (!sink || used == 0) return;
+    sink(context, buffer, used);
+    flushed += used;
+    used = 0;
+    buffer[0] = '\0';
+  }
+
+  // Ещё не отданное в sink
+  const char* data() const { return buffer; }
+  size_t length() const { return used; }
+
+  // Всего записано, вместе с отданным в sink
+  size_t totalLength() const { return flushed + used; }
+  bool overflowed() const { return overflow; }
+
+ private:
+  char* buffer;
+  size_t capacity;
+  Sink sink;
+  void* context;
+  size_t used;
+  size_t flushed;
+  bool overflow;
+
+  void append(const char* format, ...) {
+    if (overflow) return;
+
+    va_list args;
+    va_start(args, format);
+    bool fits = tryAppend(format, args);
+    va_end(args);
+    if (fits) return;
+
+    if (sink && used > 0) {
+      flush();  // Освобождаем окно и пишем строку заново
+      va_start(args, format);
+      fits = tryAppend(format, args);
+      va_end(args);
+      if (fits) return;
+    }
+    overflow = true;
+  }
+
+  bool tryAppend(const char* format, va_list args) {
+    int written = vsnprintf(buffer + used, capacity - used, format, args);
+    if (written < 0 || (size_t)written >= capacity - used) {
+      // Не влезло: откатываем обрезанную строку
+      buffer[used] = '\0';
+      return false;
+    }
+    used += written;
+    return true;
+  }
+};
+
+#endif  // METRICS_WRITER_H
@@ -1,29 +1,131 @@
 #include "NetworkManager.h"
 
-NetworkManager::NetworkManager() {}
+NetworkManager* NetworkManager::instance = nullptr;
+
+NetworkManager::NetworkManager()
+    : state(STATE_IDLE),
+      fallback(nullptr),
+      connectStartMs(0),
+      connectTimeoutMs(0),
+      connectTimeMs(0),
+      connectedSinceBegin(false),
+      gotIpEvent(false),
+      disconnectedEvent(false),
+      lastDisconnectReason(0) {
+  instance = this;
+}
+
+void NetworkManager::onWiFiEvent(arduino_event_id_t event,
+                                 arduino_event_info_t info) {
+  if (!instance) return;
+
+  // Контекст задачи событий Wi-Fi: только выставляем флаги
+  switch (event) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      instance->gotIpEvent = true;
+      break;
+
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      instance->lastDisconnectReason = info.wifi_sta_disconnected.reason;
+      instance->disconnectedEvent = true;
+      break;
+
+    default:
+      break;
+  }
+}
+
+void NetworkManager::beginConnect(const String& ssid, const String& pass,
+                                  const String& ip, const String& gateway,
+                                  uint32_t timeoutMs) {
+  static bool handlerRegistered = false;
+  if (!handlerRegistered) {
+    WiFi.onEvent(onWiFiEvent);
+    handlerRegistered = true;
+  }
+
+  gotIpEvent = false;
+  disconnectedEvent = false;
+  connectedSinceBegin = false;
 
-bool NetworkManager::initWiFi(String ssid, String pass, String ip,
-                              String gateway) {
   WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
   WiFi.config(ipAddress(ip), ipAddress(gateway), IPAddress(255, 255, 255, 0));
   WiFi.begin(ssid.c_str(), pass.c_str());
 
-  Serial.print(F("Connecting to WiFi"));
-  int retries = 0;
-  while (WiFi.status() != WL_CONNECTED && retries < 20) {
-    delay(500);
-    Serial.print(F("."));
-    retries++;
+  state = STATE_CONNECTING;
+  connectStartMs = millis();
+  connectTimeoutMs = timeoutMs;
+
+  Serial.printf("Connecting to WiFi '%s' in background (timeout %u ms)\n",
+                ssid.c_str(), timeoutMs);
+}
+
+void NetworkManager::shutdown() {
+  state = STATE_IDLE;
+  WiFi.setAutoReconnect(false);
+  WiFi.mode(WIFI_OFF);
+  gotIpEvent = false;
+  disconnectedEvent = false;
+  Serial.println(F("WiFi off"));
+}
+
+void NetworkManager::markAccessPoint() {
+  state = STATE_ACCESS_POINT;
+  WiFi.setAutoReconnect(false);
+}
+
+void NetworkManager::update() {
+  if (disconnectedEvent) {
+    disconnectedEvent = false;
+    if (state == STATE_CONNECTED) {
+      // Связь потеряна: драйвер переподключается сам, AP не поднимаем
+      Serial.printf("WiFi connection lost (reason %u), reconnecting...\n",
+                    lastDisconnectReason);
+      state = STATE_CONNECTING;
+    }
   }
-  Serial.println();
 
-  if (WiFi.status() == WL_CONNECTED) {
+  // Статус проверяем на случай пропущенного события (статический IP)
+  bool gotIp = gotIpEvent;
+  gotIpEvent = false;
+  if (state == STATE_CONNECTING && (gotIp || WiFi.status() == WL_CONNECTED)) {
+    state = STATE_CONNECTED;
+    if (!connectedSinceBegin) {
+      connectTimeMs = millis() - connectStartMs;
+      connectedSinceBegin = true;
+    }
     Serial.print(F("Connected to WiFi. IP Address: "));
     Serial.println(WiFi.localIP());
-    return true;
-  } else {
-    Serial.println(F("Failed to connect to WiFi"));
-    return false;
+  }
+
+  // Подключение после beginConnect() (в том числе после сна) не удалось
+  // за отведённое время - точка доступа. После успешного подключения
+  // обрывы не переводят в AP.
+  if (state == STATE_CONNECTING && !connectedSinceBegin &&
+      millis() - connectStartMs >= connectTimeoutMs) {
+    Serial.printf("Failed to connect to WiFi (last reason %u)\n",
+                  lastDisconnectReason);
+    WiFi.disconnect(true);
+    markAccessPoint();
+    if (fallback) {
+      fallback();
+    }
+  }
+}
+
+const char* NetworkManager::getStateName() const {
+  switch (state) {
+    case STATE_IDLE:
+      return "idle";
+    case STATE_CONNECTING:
+      return "connecting";
+    case STATE_CONNECTED:
+      return "connected";
+    case STATE_ACCESS_POINT:
+      return "access_point";
+    default:
+      return "unknown";
   }
 }
 
@@ -31,4 +133,4 @@ IPAddress NetworkManager::ipAddress(String ip) {
   IPAddress ipAddr;
   ipAddr.fromString(ip);
   return ipAddr;
-}
\ No newline at end of file
+}
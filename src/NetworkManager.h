@@ -6,13 +6,73 @@
 
 class NetworkManager {
  public:
+  // Состояние подключения
+  enum State : uint8_t {
+    STATE_IDLE,          // Подключение не запускалось
+    STATE_CONNECTING,    // Ждём IP от точки доступа
+    STATE_CONNECTED,     // STA подключен
+    STATE_ACCESS_POINT   // Переключились в режим точки доступа
+  };
+
+  // Вызывается из update(), когда подключиться не удалось
+  typedef void (*FallbackHandler)();
+
   NetworkManager();
 
-  bool initWiFi(String ssid, String pass, String ip, String gateway);
+  /**
+   * @brief Запустить подключение к Wi-Fi без ожидания
+   * Результат приходит через события Wi-Fi, переходы выполняет update().
+   *
+   * @param timeoutMs Сколько ждать IP до перехода на fallback
+   */
+  void beginConnect(const String& ssid, const String& pass, const String& ip,
+                    const String& gateway, uint32_t timeoutMs = 10000);
+
+  /**
+   * @brief Обработать события и таймаут (вызывать периодически из loop)
+   */
+  void update();
+
+  /**
+   * @brief Функция перехода в режим точки доступа при неудаче
+   */
+  void setFallbackHandler(FallbackHandler handler) { fallback = handler; }
+
+  /**
+   * @brief Выключить WiFi (сон); повторное подключение - beginConnect()
+   */
+  void shutdown();
+
+  /**
+   * @brief Отметить, что работаем точкой доступа (fallback вызван снаружи)
+   */
+  void markAccessPoint();
+
+  State getState() const { return state; }
+  const char* getStateName() const;
+
+  /**
+   * @brief Время от beginConnect() до получения IP (0 = не подключались)
+   */
+  uint32_t getConnectTimeMs() const { return connectTimeMs; }
+
   IPAddress ipAddress(String ip);
 
  private:
-  // Здесь могут быть приватные переменные или методы, если потребуется
+  State state;
+  FallbackHandler fallback;
+  unsigned long connectStartMs;
+  uint32_t connectTimeoutMs;
+  uint32_t connectTimeMs;
+  bool connectedSinceBegin;  // IP получен после последнего beginConnect()
+
+  // Флаги от обработчика событий (задача Wi-Fi), разбираются в update()
+  volatile bool gotIpEvent;
+  volatile bool disconnectedEvent;
+  volatile uint8_t lastDisconnectReason;
+
+  static NetworkManager* instance;  // Для доступа из обработчика событий
+  static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info);
 };
 
-#endif
\ No newline at end of file
+#endif
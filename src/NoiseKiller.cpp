@@ -3,7 +3,10 @@
 
 // Конструктор с профилем
 MultiChannelKalman::MultiChannelKalman(size_t channels, FilterProfile profile)
-    : channelCount(channels), filters(nullptr), lastValues(nullptr) {
+    : filters(nullptr),
+      channelCount(channels),
+      lastValues(nullptr),
+      processNoiseScale(1.0f) {
   float q, r, p;
   getProfileParameters(profile, q, r, p);
 
@@ -13,54 +16,53 @@ MultiChannelKalman::MultiChannelKalman(size_t channels, FilterProfile profile)
 
   initFilters(q, r, p);
 
-  Serial.printf(
-      "MultiChannelKalman: %d channels, profile parameters q=%.3f r=%.3f "
+  HAL_LOG(
+      "MultiChannelKalman: %u channels, profile parameters q=%.3f r=%.3f "
       "p=%.3f\n",
-      channels, q, r, p);
+      (unsigned)channels, q, r, p);
 }
 
 // Конструктор с ручными параметрами
 MultiChannelKalman::MultiChannelKalman(size_t channels, float q, float r,
                                        float p)
-    : channelCount(channels),
+    : filters(nullptr),
+      channelCount(channels),
+      lastValues(nullptr),
       currentQ(q),
       currentR(r),
       currentP(p),
-      filters(nullptr),
-      lastValues(nullptr) {
+      processNoiseScale(1.0f) {
   initFilters(q, r, p);
 
-  Serial.printf(
-      "MultiChannelKalman: %d channels, manual parameters q=%.3f r=%.3f "
+  HAL_LOG(
+      "MultiChannelKalman: %u channels, manual parameters q=%.3f r=%.3f "
       "p=%.3f\n",
-      channels, q, r, p);
+      (unsigned)channels, q, r, p);
 }
 
 MultiChannelKalman::~MultiChannelKalman() {
-  if (filters) {
-    for (size_t i = 0; i < channelCount; i++) {
-      if (filters[i]) {
-        delete filters[i];
-      }
-    }
-    delete[] filters;
-  }
-
-  if (lastValues) {
-    delete[] lastValues;
-  }
+  delete[] filters;
+  delete[] lastValues;
 }
 
 void MultiChannelKalman::initFilters(float q, float r, float p) {
-  filters = new SimpleKalmanFilter*[channelCount];
+  filters = new KalmanChannel[channelCount];
   lastValues = new float[channelCount];
 
   for (size_t i = 0; i < channelCount; i++) {
-    filters[i] = new SimpleKalmanFilter(q, r, p);
+    initChannel(i, q, r, p);
     lastValues[i] = 0.0f;
   }
 }
 
+// Порядок SimpleKalmanFilter(mea_e, est_e, q) сохранён: (q, r, p) профиля
+// идут в него как есть, шум процесса модели - третий аргумент, в него и
+// идёт масштаб
+void MultiChannelKalman::initChannel(size_t channel, float q, float r, float p,
+                                     float initial) {
+  filters[channel].init(q, r, p * processNoiseScale, initial);
+}
+
 void MultiChannelKalman::getProfileParameters(FilterProfile profile, float& q,
                                               float& r, float& p) {
   switch (profile) {
@@ -73,7 +75,8 @@ void MultiChannelKalman::getProfileParameters(FilterProfile profile, float& q,
       break;
 
     case BALANCED:
-      // Баланс - хорошо для большинства случаев
+    default:
+      // Баланс - хорошо для большинства случаев (и неизвестный профиль)
       q = 0.1f;   // Средний шум процесса
       r = 0.1f;   // Средний шум измерения
       p = 0.01f;  // Низкая начальная ошибка
@@ -86,15 +89,24 @@ void MultiChannelKalman::getProfileParameters(FilterProfile profile, float& q,
       r = 0.05f;  // Низкий шум измерения = меньше фильтрации
       p = 0.01f;
       break;
+
+#ifdef HAS_TUNED_PROFILE
+    case TUNED:
+      // Минимум шум/задержка на записях устройства (tools/tuner)
+      q = TunedFilterProfile::Q;
+      r = TunedFilterProfile::R;
+      p = TunedFilterProfile::P;
+      break;
+#endif
   }
 }
 
 float MultiChannelKalman::update(size_t channel, float measurement) {
-  if (channel >= channelCount || !filters[channel]) {
+  if (channel >= channelCount) {
     return measurement;
   }
 
-  lastValues[channel] = filters[channel]->updateEstimate(measurement);
+  lastValues[channel] = filters[channel].update(measurement);
   return lastValues[channel];
 }
 
@@ -103,7 +115,7 @@ void MultiChannelKalman::setProfile(FilterProfile profile) {
   getProfileParameters(profile, q, r, p);
   setParameters(q, r, p);
 
-  Serial.printf("Filter profile changed: q=%.3f r=%.3f p=%.3f\n", q, r, p);
+  HAL_LOG("Filter profile changed: q=%.3f r=%.3f p=%.3f\n", q, r, p);
 }
 
 void MultiChannelKalman::setParameters(float q, float r, float p) {
@@ -112,18 +124,23 @@ void MultiChannelKalman::setParameters(float q, float r, float p) {
   currentP = p;
 
   for (size_t i = 0; i < channelCount; i++) {
-    if (filters[i]) {
-      delete filters[i];
-      filters[i] = new SimpleKalmanFilter(q, r, p);
-    }
+    initChannel(i, q, r, p);
   }
 }
 
 void MultiChannelKalman::setChannelParameters(size_t channel, float q, float r,
                                               float p) {
-  if (channel < channelCount && filters[channel]) {
-    delete filters[channel];
-    filters[channel] = new SimpleKalmanFilter(q, r, p);
+  if (channel < channelCount) {
+    initChannel(channel, q, r, p);
+  }
+}
+
+void MultiChannelKalman::setProcessNoiseScale(float scale) {
+  if (scale <= 0.0f || scale == processNoiseScale) return;
+
+  processNoiseScale = scale;
+  for (size_t i = 0; i < channelCount; i++) {
+    filters[i].processNoise = currentP * scale;
   }
 }
 
@@ -135,9 +152,8 @@ float MultiChannelKalman::getValue(size_t channel) const {
 }
 
 void MultiChannelKalman::reset(size_t channel, float initial_value) {
-  if (channel < channelCount && filters[channel]) {
-    delete filters[channel];
-    filters[channel] = new SimpleKalmanFilter(currentQ, currentR, currentP);
+  if (channel < channelCount) {
+    initChannel(channel, currentQ, currentR, currentP, initial_value);
     lastValues[channel] = initial_value;
   }
 }
@@ -146,16 +162,16 @@ void MultiChannelKalman::resetAll(float initial_value) {
   for (size_t i = 0; i < channelCount; i++) {
     reset(i, initial_value);
   }
-  Serial.println("All Kalman filters reset");
+  HAL_LOG("All Kalman filters reset\n");
 }
 
 void MultiChannelKalman::printInfo() const {
-  Serial.println("=== Kalman Filter Info ===");
-  Serial.printf("Channels: %d\n", channelCount);
-  Serial.printf("Parameters: q=%.3f, r=%.3f, p=%.3f\n", currentQ, currentR,
-                currentP);
-  Serial.println("Channel values:");
+  HAL_LOG("=== Kalman Filter Info ===\n");
+  HAL_LOG("Channels: %u\n", (unsigned)channelCount);
+  HAL_LOG("Parameters: q=%.3f, r=%.3f, p=%.3f (process noise x%.2f)\n",
+          currentQ, currentR, currentP, processNoiseScale);
+  HAL_LOG("Channel values:\n");
   for (size_t i = 0; i < channelCount; i++) {
-    Serial.printf("  Ch%d: %.3f\n", i, lastValues[i]);
+    HAL_LOG("  Ch%u: %.3f\n", (unsigned)i, lastValues[i]);
   }
-}
\ No newline at end of file
+}
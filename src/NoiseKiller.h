@@ -4,8 +4,48 @@
 #ifndef NOISE_KILLER_H
 #define NOISE_KILLER_H
 
-#include <Arduino.h>
-#include <SimpleKalmanFilter.h>
+#include <math.h>
+
+#include "Hal.h"
+
+// Профиль TUNED есть, только если tools/tuner записал TunedFilterProfile.h:
+// заголовок пишется, лишь когда подбор заметно лучше профилей ниже
+#if defined(__has_include)
+#if __has_include("TunedFilterProfile.h")
+#include "TunedFilterProfile.h"
+#define HAS_TUNED_PROFILE 1
+#endif
+#endif
+
+/**
+ * @brief Скалярный фильтр Калмана одного канала
+ *
+ * Та же модель, что в библиотеке SimpleKalmanFilter (mea_e, est_e, q):
+ * ошибка оценки растёт на |изменение оценки| * q. Своя реализация - без
+ * зависимости от Arduino, чтобы фильтр собирался и на ПК.
+ */
+struct KalmanChannel {
+  float measurementError;
+  float estimateError;
+  float processNoise;
+  float estimate;
+
+  void init(float mea_e, float est_e, float q, float initial = 0.0f) {
+    measurementError = mea_e;
+    estimateError = est_e;
+    processNoise = q;
+    estimate = initial;
+  }
+
+  float update(float measurement) {
+    float gain = estimateError / (estimateError + measurementError);
+    float previous = estimate;
+    estimate = previous + gain * (measurement - previous);
+    estimateError = (1.0f - gain) * estimateError +
+                    fabsf(previous - estimate) * processNoise;
+    return estimate;
+  }
+};
 
 /**
  * @brief Многоканальный фильтр Калмана для датчиков
@@ -20,7 +60,10 @@ class MultiChannelKalman {
   enum FilterProfile {
     AGGRESSIVE,  // Сильная фильтрация, медленный отклик (q=0.01, r=0.5)
     BALANCED,    // Баланс между шумом и откликом (q=0.1, r=0.1)
-    RESPONSIVE   // Быстрый отклик, больше шума (q=0.5, r=0.05)
+    RESPONSIVE,  // Быстрый отклик, больше шума (q=0.5, r=0.05)
+#ifdef HAS_TUNED_PROFILE
+    TUNED,  // Подобран tools/tuner по записям (TunedFilterProfile.h)
+#endif
   };
 
   /**
@@ -64,6 +107,15 @@ class MultiChannelKalman {
    */
   void setChannelParameters(size_t channel, float q, float r, float p);
 
+  /**
+   * @brief Масштаб шума процесса под период опроса
+   * Шум процесса за шаг растёт пропорционально dt, поэтому при опросе в
+   * scale раз реже отклик во времени остаётся примерно тем же.
+   * Оценки каналов сохраняются; базой служит общий p (setParameters).
+   */
+  void setProcessNoiseScale(float scale);
+  float getProcessNoiseScale() const { return processNoiseScale; }
+
   /**
    * @brief Получить последнее отфильтрованное значение
    */
@@ -85,21 +137,28 @@ class MultiChannelKalman {
   size_t getChannelCount() const { return channelCount; }
 
   /**
-   * @brief Вывести информацию о фильтре в Serial
+   * @brief Вывести информацию о фильтре в лог
    */
   void printInfo() const;
 
+  /**
+   * @brief Параметры (q, r, p) предустановленного профиля
+   */
+  static void getProfileParameters(FilterProfile profile, float& q, float& r,
+                                   float& p);
+
  private:
-  SimpleKalmanFilter** filters;
+  KalmanChannel* filters;
   size_t channelCount;
   float* lastValues;
 
   // Текущие параметры фильтров
   float currentQ, currentR, currentP;
+  float processNoiseScale;
 
   void initFilters(float q, float r, float p);
-  void getProfileParameters(FilterProfile profile, float& q, float& r,
-                            float& p);
+  void initChannel(size_t channel, float q, float r, float p,
+                   float initial = 0.0f);
 };
 
 #endif  // NOISE_KILLER_H
\ No newline at end of file
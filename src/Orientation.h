@@ -0,0 +1,85 @@
+// Orientation.h
+// Углы наклона по вектору ускорения и пользовательские поправки
+
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+#include <math.h>
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+/**
+ * @brief Крен (градусы, -180..180)
+ */
+inline float computeRoll(float ax, float ay, float az) {
+  if (fabsf(az) < 0.01f && fabsf(ay) < 0.01f) {
+    return 0.0f;
+  }
+
+  float roll = atan2(ay, az) * 180.0f / PI;
+
+  while (roll > 180.0f) roll -= 360.0f;
+  while (roll < -180.0f) roll += 360.0f;
+
+  return roll;
+}
+
+/**
+ * @brief Тангаж (градусы, -90..90)
+ */
+inline float computePitch(float ax, float ay, float az) {
+  float pitch = atan2(-ax, sqrt(ay * ay + az * az)) * 180.0f / PI;
+
+  if (pitch > 90.0f) pitch = 90.0f;
+  if (pitch < -90.0f) pitch = -90.0f;
+
+  return pitch;
+}
+
+/**
+ * @brief Курс с компенсацией наклона (градусы, 0..360)
+ * Вектор поля поворачивается в горизонталь по вектору ускорения (крен,
+ * затем тангаж - как computeRoll()/computePitch()), без тригонометрии
+ * кроме одного atan2. 0° - поле вдоль +X, рост - к +Y (как trueHeading
+ * SensorSimulator).
+ */
+inline float computeHeading(float ax, float ay, float az, float mx, float my,
+                            float mz) {
+  float yz = sqrtf(ay * ay + az * az);
+  float norm = sqrtf(ax * ax + yz * yz);
+  if (norm < 0.01f) return 0.0f;
+
+  // sin/cos крена и тангажа из компонент ускорения
+  float sr = 0.0f, cr = 1.0f;
+  if (yz > 0.01f) {
+    sr = ay / yz;
+    cr = az / yz;
+  }
+  float sp = -ax / norm;
+  float cp = yz / norm;
+
+  float horizontalX = cp * mx + sp * (sr * my + cr * mz);
+  float horizontalY = cr * my - sr * mz;
+
+  float heading = atan2f(horizontalY, horizontalX) * 180.0f / PI;
+  if (heading < 0.0f) heading += 360.0f;
+  return heading;
+}
+
+/**
+ * @brief Поправка нуля (к roll) и перестановка осей
+ */
+inline void applyZeroAndSwap(float& roll, float& pitch, float zeroOffset,
+                             bool axisSwap) {
+  roll += zeroOffset;
+
+  if (axisSwap) {
+    float temp = roll;
+    roll = pitch;
+    pitch = temp;
+  }
+}
+
+#endif  // ORIENTATION_H
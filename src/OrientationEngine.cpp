@@ -0,0 +1,214 @@
+// OrientationEngine.cpp
+#include "OrientationEngine.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+const char* const TYPE_NAMES[OrientationEngine::TYPE_COUNT] = {
+    "accel", "complementary", "mahony"};
+
+// Интеграл ошибки e (поправка смещения нуля гироскопа) с ограничением
+void integrate(float integral[3], const float e[3], float gain, float dt,
+               float limit) {
+  for (int axis = 0; axis < 3; axis++) {
+    integral[axis] += gain * e[axis] * dt;
+    if (integral[axis] > limit) integral[axis] = limit;
+    if (integral[axis] < -limit) integral[axis] = -limit;
+  }
+}
+
+void normalize(float v[3]) {
+  float norm = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (norm < 1e-6f) return;
+  v[0] /= norm;
+  v[1] /= norm;
+  v[2] /= norm;
+}
+
+}  // namespace
+
+// ========== OrientationEngine ==========
+
+const char* OrientationEngine::typeName(Type type) {
+  return type < TYPE_COUNT ? TYPE_NAMES[type] : "unknown";
+}
+
+bool OrientationEngine::typeFromName(const char* name, Type& out) {
+  for (uint8_t i = 0; i < TYPE_COUNT; i++) {
+    if (strcmp(name, TYPE_NAMES[i]) == 0) {
+      out = (Type)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool OrientationEngine::gravityDirection(const float accel[3], float out[3]) {
+  float norm = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] +
+                     accel[2] * accel[2]);
+  if (fabsf(norm - GRAVITY) > MAX_GRAVITY_ERROR * GRAVITY) return false;
+
+  out[0] = accel[0] / norm;
+  out[1] = accel[1] / norm;
+  out[2] = accel[2] / norm;
+  return true;
+}
+
+// ========== AccelOrientation ==========
+
+AccelOrientation::AccelOrientation() : gravity{0.0f, 0.0f, GRAVITY} {}
+
+void AccelOrientation::update(const OrientationInput& input) {
+  gravity[0] = input.filtered[0];
+  gravity[1] = input.filtered[1];
+  gravity[2] = input.filtered[2];
+}
+
+void AccelOrientation::getGravity(float out[3]) const {
+  out[0] = gravity[0];
+  out[1] = gravity[1];
+  out[2] = gravity[2];
+}
+
+// ========== ComplementaryOrientation ==========
+
+ComplementaryOrientation::ComplementaryOrientation() { reset(); }
+
+void ComplementaryOrientation::reset() {
+  started = false;
+  runS = 0.0f;
+  gravity[0] = gravity[1] = 0.0f;
+  gravity[2] = 1.0f;
+  integral[0] = integral[1] = integral[2] = 0.0f;
+}
+
+void ComplementaryOrientation::update(const OrientationInput& input) {
+  if (!started) {
+    // Старт с ускорения как есть: за SETTLE_S оно усредняется со следующими
+    gravity[0] = input.accel[0];
+    gravity[1] = input.accel[1];
+    gravity[2] = input.accel[2];
+    normalize(gravity);
+    started = true;
+    return;
+  }
+
+  float dt = input.dt;
+  float gx = gravity[0], gy = gravity[1], gz = gravity[2];
+  runS += dt;
+  bool settling = runS < SETTLE_S;
+
+  float measured[3];
+  bool corrected = gravityDirection(input.accel, measured);
+  if (corrected && !settling) {
+    // Ось поворота от оценки к измерению: ω += e тянет g к измерению
+    float e[3] = {measured[1] * gz - measured[2] * gy,
+                  measured[2] * gx - measured[0] * gz,
+                  measured[0] * gy - measured[1] * gx};
+    integrate(integral, e, KI, dt, MAX_INTEGRAL);
+  }
+
+  // Вектор, неподвижный в мире, в осях датчика вращается против ω
+  float w[3];
+  for (int axis = 0; axis < 3; axis++) {
+    w[axis] = input.gyro[axis] + integral[axis];
+  }
+  gravity[0] += (gy * w[2] - gz * w[1]) * dt;
+  gravity[1] += (gz * w[0] - gx * w[2]) * dt;
+  gravity[2] += (gx * w[1] - gy * w[0]) * dt;
+
+  if (corrected) {
+    float alpha = dt / ((settling ? runS : TIME_CONSTANT_S) + dt);
+    for (int axis = 0; axis < 3; axis++) {
+      gravity[axis] += alpha * (measured[axis] - gravity[axis]);
+    }
+  }
+  normalize(gravity);
+}
+
+void ComplementaryOrientation::getGravity(float out[3]) const {
+  out[0] = gravity[0];
+  out[1] = gravity[1];
+  out[2] = gravity[2];
+}
+
+// ========== MahonyOrientation ==========
+
+MahonyOrientation::MahonyOrientation() { reset(); }
+
+void MahonyOrientation::reset() {
+  started = false;
+  runS = 0.0f;
+  q0 = 1.0f;
+  q1 = q2 = q3 = 0.0f;
+  integral[0] = integral[1] = integral[2] = 0.0f;
+}
+
+void MahonyOrientation::update(const OrientationInput& input) {
+  const float* a = input.accel;
+
+  if (!started) {
+    // Кватернион по крену и тангажу ускорения, курс 0
+    float roll = atan2f(a[1], a[2]);
+    float pitch = atan2f(-a[0], sqrtf(a[1] * a[1] + a[2] * a[2]));
+    float cr = cosf(0.5f * roll), sr = sinf(0.5f * roll);
+    float cp = cosf(0.5f * pitch), sp = sinf(0.5f * pitch);
+    q0 = cr * cp;
+    q1 = sr * cp;
+    q2 = cr * sp;
+    q3 = -sr * sp;
+    started = true;
+    return;
+  }
+
+  float gx = input.gyro[0], gy = input.gyro[1], gz = input.gyro[2];
+  float dt = input.dt;
+  runS += dt;
+  bool settling = runS < SETTLE_S;
+
+  float measured[3];
+  if (gravityDirection(a, measured)) {
+    // Оценка "вверх" в осях датчика - третья строка матрицы поворота
+    float vx = 2.0f * (q1 * q3 - q0 * q2);
+    float vy = 2.0f * (q0 * q1 + q2 * q3);
+    float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+    float e[3] = {measured[1] * vz - measured[2] * vy,
+                  measured[2] * vx - measured[0] * vz,
+                  measured[0] * vy - measured[1] * vx};
+    if (!settling) integrate(integral, e, KI, dt, MAX_INTEGRAL);
+    float kp = settling ? 1.0f / runS : KP;
+    gx += kp * e[0];
+    gy += kp * e[1];
+    gz += kp * e[2];
+  }
+  gx += integral[0];
+  gy += integral[1];
+  gz += integral[2];
+
+  // q' = q + 0.5 q (0, ω) dt
+  float h = 0.5f * dt;
+  float a0 = q0, a1 = q1, a2 = q2, a3 = q3;
+  q0 += (-a1 * gx - a2 * gy - a3 * gz) * h;
+  q1 += (a0 * gx + a2 * gz - a3 * gy) * h;
+  q2 += (a0 * gy - a1 * gz + a3 * gx) * h;
+  q3 += (a0 * gz + a1 * gy - a2 * gx) * h;
+
+  float norm = sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  if (norm < 1e-6f) {
+    reset();
+    return;
+  }
+  q0 /= norm;
+  q1 /= norm;
+  q2 /= norm;
+  q3 /= norm;
+}
+
+void MahonyOrientation::getGravity(float out[3]) const {
+  out[0] = 2.0f * (q1 * q3 - q0 * q2);
+  out[1] = 2.0f * (q0 * q1 + q2 * q3);
+  out[2] = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+}
@@ -0,0 +1,152 @@
+// OrientationEngine.h
+// Оценка направления силы тяжести: только акселерометр или слияние с
+// гироскопом (комплементарный фильтр, кватернионный фильтр Махони)
+
+#ifndef ORIENTATION_ENGINE_H
+#define ORIENTATION_ENGINE_H
+
+#include <stdint.h>
+
+// ORIENTATION_ENGINE в build_flags - движок по умолчанию (до настройки
+// из файла), например -DORIENTATION_ENGINE=OrientationEngine::COMPLEMENTARY
+#ifndef ORIENTATION_ENGINE
+#define ORIENTATION_ENGINE OrientationEngine::ACCEL
+#endif
+
+/**
+ * @brief Вход движка на одном сэмпле
+ */
+struct OrientationInput {
+  float accel[3];     // После поправки, без фильтра Калмана (м/с²)
+  float filtered[3];  // После фильтра Калмана (м/с²)
+  float gyro[3];      // Без смещения нуля (рад/с)
+  float dt;           // С прошлого сэмпла (с)
+};
+
+/**
+ * @brief Движок ориентации
+ *
+ * Выдаёт вектор "вверх" в осях датчика (как показание акселерометра в
+ * покое) - по нему считаются крен, тангаж и компенсация наклона курса.
+ * Углы из одного акселерометра приходится сильно сглаживать Калманом,
+ * отсюда задержка при наклоне. Гироскоп даёт поворот без задержки, а
+ * акселерометр лишь медленно убирает его дрейф.
+ */
+class OrientationEngine {
+ public:
+  enum Type : uint8_t {
+    ACCEL,          // Ускорение после фильтра Калмана (как раньше)
+    COMPLEMENTARY,  // Гироскоп + медленная подтяжка к ускорению
+    MAHONY,         // Кватернион, PI-обратная связь по ускорению
+    TYPE_COUNT
+  };
+
+  static constexpr float GRAVITY = 9.80665f;  // м/с², как Lsm303::GRAVITY
+
+  // Подтяжка к ускорению только при |a| в пределах g ± доля (без ударов)
+  static constexpr float MAX_GRAVITY_ERROR = 0.2f;
+
+  // Первые секунды после старта движки с гироскопом тянутся к среднему
+  // ускорения с начала, без интеграла смещения: иначе первый сэмпл в
+  // вибрации задаёт ошибку, которую интеграл потом долго отдаёт
+  static constexpr float SETTLE_S = 1.0f;
+
+  virtual ~OrientationEngine() {}
+
+  virtual Type getType() const = 0;
+  virtual bool needsGyro() const { return true; }
+
+  virtual void update(const OrientationInput& input) = 0;
+
+  /**
+   * @brief Вектор "вверх" последнего сэмпла (длина не нормирована)
+   */
+  virtual void getGravity(float out[3]) const = 0;
+
+  /**
+   * @brief Следующий сэмпл задаёт начальное состояние
+   */
+  virtual void reset() = 0;
+
+  static const char* typeName(Type type);
+  static bool typeFromName(const char* name, Type& out);
+
+ protected:
+  // Единичный вектор ускорения, если оно похоже на силу тяжести
+  static bool gravityDirection(const float accel[3], float out[3]);
+};
+
+/**
+ * @brief Только акселерометр: углы по отфильтрованному ускорению
+ */
+class AccelOrientation : public OrientationEngine {
+ public:
+  AccelOrientation();
+
+  Type getType() const override { return ACCEL; }
+  bool needsGyro() const override { return false; }
+  void update(const OrientationInput& input) override;
+  void getGravity(float out[3]) const override;
+  void reset() override {}
+
+ private:
+  float gravity[3];
+};
+
+/**
+ * @brief Комплементарный фильтр на векторе силы тяжести
+ *
+ * Вектор поворачивается по гироскопу (g' = g + g x ω dt) и на каждом
+ * сэмпле подтягивается к направлению ускорения с постоянной времени
+ * TIME_CONSTANT_S: быстрые наклоны - от гироскопа, дрейф убирает
+ * акселерометр. Остаток смещения нуля копится интегралом (KI) от
+ * рассогласования, иначе он давал бы постоянную ошибку ω·TIME_CONSTANT.
+ */
+class ComplementaryOrientation : public OrientationEngine {
+ public:
+  static constexpr float TIME_CONSTANT_S = 1.0f;
+  static constexpr float KI = 0.05f;           // 1/с²
+  static constexpr float MAX_INTEGRAL = 0.1f;  // рад/с
+
+  ComplementaryOrientation();
+
+  Type getType() const override { return COMPLEMENTARY; }
+  void update(const OrientationInput& input) override;
+  void getGravity(float out[3]) const override;
+  void reset() override;
+
+ private:
+  bool started;
+  float runS;        // С начала (до SETTLE_S - быстрый старт)
+  float gravity[3];  // Единичный
+  float integral[3];
+};
+
+/**
+ * @brief Кватернионный фильтр Махони (только IMU, без магнитометра)
+ *
+ * Ошибка - векторное произведение измеренного и оценённого направлений
+ * "вверх"; пропорциональная часть (KP) поправляет угловую скорость,
+ * интегральная (KI) копит остаток смещения нуля гироскопа.
+ */
+class MahonyOrientation : public OrientationEngine {
+ public:
+  static constexpr float KP = 1.0f;            // 1/с: подтяжка ~1 с
+  static constexpr float KI = 0.05f;           // 1/с²
+  static constexpr float MAX_INTEGRAL = 0.1f;  // рад/с
+
+  MahonyOrientation();
+
+  Type getType() const override { return MAHONY; }
+  void update(const OrientationInput& input) override;
+  void getGravity(float out[3]) const override;
+  void reset() override;
+
+ private:
+  bool started;
+  float runS;            // С начала (до SETTLE_S - быстрый старт)
+  float q0, q1, q2, q3;  // Датчик -> мир
+  float integral[3];
+};
+
+#endif  // ORIENTATION_ENGINE_H
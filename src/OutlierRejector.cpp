@@ -0,0 +1,150 @@
+// OutlierRejector.cpp
+#include "OutlierRejector.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+// СКО нормального шума по MAD и по среднему модулю отклонения
+const float MAD_TO_SIGMA = 1.4826f;
+const float MEAN_ABS_TO_SIGMA = 1.2533f;
+
+const char* const MODE_NAMES[OutlierRejector::MODE_COUNT] = {
+    "off", "hampel", "innovation"};
+
+// Вставками: окно из нескольких элементов, время постоянно
+void sortSmall(float* values, uint8_t count) {
+  for (uint8_t i = 1; i < count; i++) {
+    float value = values[i];
+    uint8_t j = i;
+    while (j > 0 && values[j - 1] > value) {
+      values[j] = values[j - 1];
+      j--;
+    }
+    values[j] = value;
+  }
+}
+
+}  // namespace
+
+OutlierRejector::OutlierRejector(uint8_t channels)
+    : mode(OFF),
+      channelCount(channels < MAX_CHANNELS ? channels : MAX_CHANNELS) {
+  for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+    state[i].floor = 0.0f;
+    state[i].rejected = 0;
+    resetChannel(i);
+  }
+}
+
+void OutlierRejector::setMode(Mode m) {
+  if (m >= MODE_COUNT) m = OFF;
+  if (m == mode) return;
+  mode = m;
+  reset();
+}
+
+void OutlierRejector::setNoiseFloor(uint8_t channel, float sigma) {
+  if (channel < channelCount) state[channel].floor = sigma;
+}
+
+void OutlierRejector::resetChannel(uint8_t channel) {
+  if (channel >= MAX_CHANNELS) return;
+
+  Channel& c = state[channel];
+  memset(c.window, 0, sizeof(c.window));
+  c.count = 0;
+  c.next = 0;
+  c.meanAbs = 0.0f;
+  c.consecutive = 0;
+}
+
+void OutlierRejector::reset() {
+  for (uint8_t i = 0; i < channelCount; i++) resetChannel(i);
+}
+
+float OutlierRejector::apply(uint8_t channel, float value, float estimate) {
+  if (channel >= channelCount) return value;
+
+  switch (mode) {
+    case HAMPEL:
+      return hampel(state[channel], value);
+    case INNOVATION:
+      return innovation(state[channel], value, estimate);
+    default:
+      return value;
+  }
+}
+
+float OutlierRejector::hampel(Channel& c, float value) {
+  c.window[c.next] = value;
+  c.next = (c.next + 1) % WINDOW;
+  if (c.count < WINDOW) c.count++;
+  if (c.count < WINDOW) return value;
+
+  float sorted[WINDOW];
+  memcpy(sorted, c.window, sizeof(sorted));
+  sortSmall(sorted, WINDOW);
+  float median = sorted[WINDOW / 2];
+
+  for (uint8_t i = 0; i < WINDOW; i++) {
+    sorted[i] = fabsf(c.window[i] - median);
+  }
+  sortSmall(sorted, WINDOW);
+  float sigma = MAD_TO_SIGMA * sorted[WINDOW / 2];
+  if (sigma < c.floor) sigma = c.floor;
+
+  if (fabsf(value - median) <= THRESHOLD * sigma) return value;
+  c.rejected++;
+  return median;
+}
+
+float OutlierRejector::innovation(Channel& c, float value, float estimate) {
+  float error = fabsf(value - estimate);
+
+  // Оценка фильтра ещё сходится к данным: масштаб копится, но не
+  // проверяется (после прогрева он завышен и сходится сверху)
+  if (c.count < WARMUP_SAMPLES) {
+    c.count++;
+    c.meanAbs += SCALE_ALPHA * (error - c.meanAbs);
+    return value;
+  }
+
+  float sigma = MEAN_ABS_TO_SIGMA * c.meanAbs;
+  if (sigma < c.floor) sigma = c.floor;
+
+  if (error > THRESHOLD * sigma) {
+    // Много подряд - это не выброс, а движение: принимаем до возврата
+    if (c.consecutive < MAX_REJECTED) {
+      c.consecutive++;
+      c.rejected++;
+      return estimate;
+    }
+  } else {
+    c.consecutive = 0;
+  }
+
+  c.meanAbs += SCALE_ALPHA * (error - c.meanAbs);
+  return value;
+}
+
+uint32_t OutlierRejector::getTotalRejected() const {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < channelCount; i++) total += state[i].rejected;
+  return total;
+}
+
+const char* OutlierRejector::modeName(Mode m) {
+  return m < MODE_COUNT ? MODE_NAMES[m] : "unknown";
+}
+
+bool OutlierRejector::modeFromName(const char* name, Mode& out) {
+  for (uint8_t i = 0; i < MODE_COUNT; i++) {
+    if (strcmp(name, MODE_NAMES[i]) == 0) {
+      out = (Mode)i;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,96 @@
+// OutlierRejector.h
+// Отбраковка одиночных выбросов (удары, наводки) перед фильтром Калмана
+
+#ifndef OUTLIER_REJECTOR_H
+#define OUTLIER_REJECTOR_H
+
+#include <stdint.h>
+
+/**
+ * @brief Предфильтр выбросов по каналам
+ *
+ * Одиночный всплеск (удар инструментом) фильтр Калмана принимает как
+ * измерение и потом много сэмплов от него отходит. Предфильтр заменяет
+ * такой сэмпл правдоподобным значением:
+ *  - HAMPEL: медиана окна WINDOW последних сэмплов; выброс - дальше
+ *    THRESHOLD оценок СКО по MAD (медиана |x - медиана|) от медианы.
+ *    Без задержки на одиночном всплеске, ступенька проходит через
+ *    WINDOW / 2 сэмплов.
+ *  - INNOVATION: сравнение с текущей оценкой Калмана; масштаб - EMA
+ *    |измерение - оценка|. После MAX_REJECTED выбросов подряд сэмплы
+ *    принимаются, пока не вернутся в порог: настоящий наклон не
+ *    застревает.
+ * Окно и порог фиксированы - O(1) на сэмпл, без кучи.
+ */
+class OutlierRejector {
+ public:
+  enum Mode : uint8_t {
+    OFF,
+    HAMPEL,
+    INNOVATION,
+    MODE_COUNT
+  };
+
+  static const uint8_t MAX_CHANNELS = 6;
+  static const uint8_t WINDOW = 5;          // Нечётное
+  static constexpr float THRESHOLD = 4.0f;  // В оценках СКО
+  static const uint8_t MAX_REJECTED = 5;    // Подряд (INNOVATION)
+
+  // INNOVATION: первые сэмплы фильтр только сходится - не проверяются;
+  // шаг EMA масштаба (~20 сэмплов)
+  static const uint8_t WARMUP_SAMPLES = 25;
+  static constexpr float SCALE_ALPHA = 0.05f;
+
+  explicit OutlierRejector(uint8_t channels = MAX_CHANNELS);
+
+  void setMode(Mode mode);
+  Mode getMode() const { return mode; }
+
+  /**
+   * @brief Наименьшая оценка СКО канала (шум датчика)
+   * Без неё на квантованных или стоящих данных порог схлопывается в ноль.
+   */
+  void setNoiseFloor(uint8_t channel, float sigma);
+
+  /**
+   * @brief Сэмпл канала
+   * @param estimate Текущая оценка фильтра (для INNOVATION)
+   * @return Сэмпл или замена, если он выброс
+   */
+  float apply(uint8_t channel, float value, float estimate);
+
+  /**
+   * @brief Следующий сэмпл канала начинает окно заново (счётчик цел)
+   */
+  void resetChannel(uint8_t channel);
+  void reset();
+
+  uint8_t getChannelCount() const { return channelCount; }
+  uint32_t getRejected(uint8_t channel) const {
+    return channel < channelCount ? state[channel].rejected : 0;
+  }
+  uint32_t getTotalRejected() const;
+
+  static const char* modeName(Mode mode);
+  static bool modeFromName(const char* name, Mode& out);
+
+ private:
+  struct Channel {
+    float window[WINDOW];
+    uint8_t count;  // Заполнено окно / сэмплов прогрева
+    uint8_t next;   // Куда писать следующий
+    float meanAbs;  // EMA |инновации|
+    uint8_t consecutive;
+    float floor;
+    uint32_t rejected;
+  };
+
+  Mode mode;
+  uint8_t channelCount;
+  Channel state[MAX_CHANNELS];
+
+  float hampel(Channel& c, float value);
+  float innovation(Channel& c, float value, float estimate);
+};
+
+#endif  // OUTLIER_REJECTOR_H
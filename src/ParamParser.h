@@ -0,0 +1,263 @@
+// ParamParser.h
+// Строгий разбор параметров запроса без выделения памяти
+
+#ifndef PARAM_PARSER_H
+#define PARAM_PARSER_H
+
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Ссылка на значение параметра (без копирования)
+ *
+ * Указывает в буфер, которым владеет сервер; действительна только
+ * во время обработки запроса.
+ */
+struct ParamView {
+  const char* data;
+  size_t length;
+
+  ParamView() : data(nullptr), length(0) {}
+  ParamView(const char* data, size_t length) : data(data), length(length) {}
+  explicit ParamView(const char* text)
+      : data(text), length(text ? strlen(text) : 0) {}
+
+  bool isNull() const { return data == nullptr; }
+  bool isEmpty() const { return length == 0; }
+
+  // Сравнение без учёта регистра (ASCII)
+  bool equalsIgnoreCase(const char* text) const {
+    size_t n = strlen(text);
+    if (n != length) return false;
+    for (size_t i = 0; i < n; i++) {
+      char a = data[i], b = text[i];
+      if (a >= 'A' && a <= 'Z') a += 'a' - 'A';
+      if (b >= 'A' && b <= 'Z') b += 'a' - 'A';
+      if (a != b) return false;
+    }
+    return true;
+  }
+};
+
+// Результат разбора
+enum ParseError : uint8_t {
+  PARSE_OK,
+  PARSE_MISSING,       // Параметра нет в запросе
+  PARSE_EMPTY,         // Параметр есть, значение пустое
+  PARSE_MALFORMED,     // Не число / не bool / мусор после значения
+  PARSE_OUT_OF_RANGE   // Число корректное, но вне допустимых пределов
+};
+
+class ParamParser {
+ public:
+  // Длиннее этого число не бывает (знак, 20 цифр, точка, экспонента)
+  static const size_t MAX_NUMBER_LENGTH = 31;
+
+  static const char* errorName(ParseError error) {
+    switch (error) {
+      case PARSE_OK:
+        return "ok";
+      case PARSE_MISSING:
+        return "missing";
+      case PARSE_EMPTY:
+        return "empty";
+      case PARSE_MALFORMED:
+        return "malformed";
+      case PARSE_OUT_OF_RANGE:
+        return "out of range";
+      default:
+        return "unknown";
+    }
+  }
+
+  /**
+   * @brief Десятичное число с плавающей точкой
+   *
+   * Формат: [+-] цифры [. цифры] [e|E [+-] цифры], хотя бы одна цифра в
+   * мантиссе. Пробелы, nan, inf, hex и любой хвост - ошибка (в отличие от
+   * String::toFloat(), который возвращает 0.0).
+   */
+  static ParseError parseFloat(const ParamView& value, float& out) {
+    ParseError error = checkPresent(value);
+    if (error != PARSE_OK) return error;
+    if (value.length > MAX_NUMBER_LENGTH) return PARSE_MALFORMED;
+
+    const char* p = value.data;
+    const char* end = p + value.length;
+
+    if (*p == '+' || *p == '-') p++;
+    size_t mantissaDigits = skipDigits(p, end);
+    if (p < end && *p == '.') {
+      p++;
+      mantissaDigits += skipDigits(p, end);
+    }
+    if (mantissaDigits == 0) return PARSE_MALFORMED;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+      p++;
+      if (p < end && (*p == '+' || *p == '-')) p++;
+      if (skipDigits(p, end) == 0) return PARSE_MALFORMED;
+    }
+    if (p != end) return PARSE_MALFORMED;
+
+    // Формат проверен - strtof получает только допустимые символы
+    char buffer[MAX_NUMBER_LENGTH + 1];
+    memcpy(buffer, value.data, value.length);
+    buffer[value.length] = '\0';
+
+    float result = strtof(buffer, nullptr);
+    if (!isfinite(result)) return PARSE_OUT_OF_RANGE;
+
+    out = result;
+    return PARSE_OK;
+  }
+
+  /**
+   * @brief Число с плавающей точкой в пределах [min, max]
+   */
+  static ParseError parseFloat(const ParamView& value, float min, float max,
+                               float& out) {
+    float result;
+    ParseError error = parseFloat(value, result);
+    if (error != PARSE_OK) return error;
+    if (result < min || result > max) return PARSE_OUT_OF_RANGE;
+
+    out = result;
+    return PARSE_OK;
+  }
+
+  /**
+   * @brief Целое десятичное число [+-]цифры в пределах [min, max]
+   */
+  static ParseError parseInt(const ParamView& value, long min, long max,
+                             long& out) {
+    ParseError error = checkPresent(value);
+    if (error != PARSE_OK) return error;
+    if (value.length > MAX_NUMBER_LENGTH) return PARSE_MALFORMED;
+
+    const char* p = value.data;
+    const char* end = p + value.length;
+
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+      negative = *p == '-';
+      p++;
+    }
+    if (p == end) return PARSE_MALFORMED;
+
+    // Накопление в unsigned с контролем переполнения
+    unsigned long magnitude = 0;
+    bool overflow = false;
+    for (; p < end; p++) {
+      if (*p < '0' || *p > '9') return PARSE_MALFORMED;
+      unsigned long digit = *p - '0';
+      if (magnitude > (ULONG_MAX - digit) / 10) {
+        overflow = true;  // Дочитываем, чтобы отличить мусор от переполнения
+        continue;
+      }
+      magnitude = magnitude * 10 + digit;
+    }
+
+    const unsigned long limit =
+        negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    if (overflow || magnitude > limit) return PARSE_OUT_OF_RANGE;
+
+    long result = negative ? (long)(0 - magnitude) : (long)magnitude;
+    if (result < min || result > max) return PARSE_OUT_OF_RANGE;
+
+    out = result;
+    return PARSE_OK;
+  }
+
+  /**
+   * @brief Логическое значение: 1/0, true/false, yes/no, on/off
+   */
+  static ParseError parseBool(const ParamView& value, bool& out) {
+    ParseError error = checkPresent(value);
+    if (error != PARSE_OK) return error;
+
+    if (value.equalsIgnoreCase("1") || value.equalsIgnoreCase("true") ||
+        value.equalsIgnoreCase("yes") || value.equalsIgnoreCase("on")) {
+      out = true;
+      return PARSE_OK;
+    }
+    if (value.equalsIgnoreCase("0") || value.equalsIgnoreCase("false") ||
+        value.equalsIgnoreCase("no") || value.equalsIgnoreCase("off")) {
+      out = false;
+      return PARSE_OK;
+    }
+    return PARSE_MALFORMED;
+  }
+
+  /**
+   * @brief Заголовок Range: "bytes=a-b", "bytes=a-" или "bytes=-n"
+   *
+   * Только один диапазон. Конец за пределами size обрезается.
+   * @param size Полный размер ответа
+   * @param first, last Границы включительно (0..size-1)
+   * @return PARSE_OUT_OF_RANGE - диапазон не пересекается с [0, size)
+   */
+  static ParseError parseByteRange(const ParamView& value, uint32_t size,
+                                   uint32_t& first, uint32_t& last) {
+    ParseError error = checkPresent(value);
+    if (error != PARSE_OK) return error;
+
+    static const char PREFIX[] = "bytes=";
+    const size_t prefixLength = sizeof(PREFIX) - 1;
+    if (value.length <= prefixLength ||
+        !ParamView(value.data, prefixLength).equalsIgnoreCase(PREFIX)) {
+      return PARSE_MALFORMED;
+    }
+
+    const char* start = value.data + prefixLength;
+    const char* end = value.data + value.length;
+    const char* dash =
+        static_cast<const char*>(memchr(start, '-', end - start));
+    if (!dash) return PARSE_MALFORMED;
+
+    ParamView from(start, dash - start);
+    ParamView to(dash + 1, end - dash - 1);
+    long a = 0, b = 0;
+    if (!from.isEmpty() && parseInt(from, 0, LONG_MAX, a) != PARSE_OK) {
+      return PARSE_MALFORMED;  // Сюда же "a-b,c-d" и отрицательные
+    }
+    if (!to.isEmpty() && parseInt(to, 0, LONG_MAX, b) != PARSE_OK) {
+      return PARSE_MALFORMED;
+    }
+
+    if (from.isEmpty()) {
+      // Последние b байт
+      if (to.isEmpty()) return PARSE_MALFORMED;
+      if (b == 0 || size == 0) return PARSE_OUT_OF_RANGE;
+      first = (uint32_t)b >= size ? 0 : size - (uint32_t)b;
+      last = size - 1;
+      return PARSE_OK;
+    }
+
+    if ((unsigned long)a >= size) return PARSE_OUT_OF_RANGE;
+    if (!to.isEmpty() && b < a) return PARSE_MALFORMED;
+
+    first = (uint32_t)a;
+    last = (to.isEmpty() || (unsigned long)b >= size) ? size - 1 : (uint32_t)b;
+    return PARSE_OK;
+  }
+
+ private:
+  static ParseError checkPresent(const ParamView& value) {
+    if (value.isNull()) return PARSE_MISSING;
+    if (value.isEmpty()) return PARSE_EMPTY;
+    return PARSE_OK;
+  }
+
+  static size_t skipDigits(const char*& p, const char* end) {
+    const char* start = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    return p - start;
+  }
+};
+
+#endif  // PARAM_PARSER_H
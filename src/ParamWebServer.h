@@ -0,0 +1,51 @@
+// ParamWebServer.h
+// WebServer с доступом к аргументам запроса без копирования в String
+
+#ifndef PARAM_WEB_SERVER_H
+#define PARAM_WEB_SERVER_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#include "ParamParser.h"
+
+/**
+ * @brief WebServer::arg() возвращает копию String на каждый вызов;
+ * param() отдаёт ссылку на уже разобранное (URL-decoded) значение
+ */
+class ParamWebServer : public WebServer {
+ public:
+  explicit ParamWebServer(int port = 80) : WebServer(port) {}
+
+  /**
+   * @brief Значение аргумента (isNull() - аргумента нет)
+   * Строка нуль-терминирована, действительна до конца обработчика
+   */
+  ParamView param(const char* name) const {
+    for (int i = 0; i < _currentArgCount; i++) {
+      const String& key = _currentArgs[i].key;
+      if (strcmp(key.c_str(), name) == 0) {
+        const String& value = _currentArgs[i].value;
+        return ParamView(value.c_str(), value.length());
+      }
+    }
+    return ParamView();
+  }
+
+  /**
+   * @brief Заголовок запроса (isNull() - нет или не собирается)
+   * Доступны только имена из collectHeaders()
+   */
+  ParamView header(const char* name) const {
+    for (int i = 0; i < _headerKeysCount; i++) {
+      const String& key = _currentHeaders[i].key;
+      if (strcasecmp(key.c_str(), name) == 0) {
+        const String& value = _currentHeaders[i].value;
+        return ParamView(value.c_str(), value.length());
+      }
+    }
+    return ParamView();
+  }
+};
+
+#endif  // PARAM_WEB_SERVER_H
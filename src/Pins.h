@@ -22,4 +22,8 @@
 // Нейтральное положение
 #define LED_NEUTRAL 17  // Горит при наклоне ±5°
 
+// ===== ПИТАНИЕ =====
+#define BATTERY_PIN 35             // ADC1_CH7, через делитель
+#define BATTERY_DIVIDER_RATIO 2.0f  // Делитель 1:1 (100k/100k)
+
 #endif  // PINS_H
\ No newline at end of file
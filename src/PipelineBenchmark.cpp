@@ -0,0 +1,211 @@
+// PipelineBenchmark.cpp
+#include "PipelineBenchmark.h"
+
+#if PIPELINE_BENCHMARK
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdlib.h>
+
+#include "ConfigManager.h"
+
+namespace {
+
+// Такты каждого прогона текущего этапа (статически: не трогаем кучу)
+uint32_t cycleSamples[PipelineBenchmark::MAX_ITERATIONS];
+
+// Выделения памяти в задаче, где идёт замер
+volatile TaskHandle_t countedTask = nullptr;
+volatile uint32_t allocationCount = 0;
+volatile uint32_t allocatedBytes = 0;
+
+inline void countAllocation(size_t size) {
+  if (countedTask && xTaskGetCurrentTaskHandle() == countedTask) {
+    allocationCount++;
+    allocatedBytes += size;
+  }
+}
+
+int compareCycles(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+const char* profileName(MultiChannelKalman::FilterProfile profile) {
+  switch (profile) {
+    case MultiChannelKalman::AGGRESSIVE:
+      return "AGGRESSIVE";
+    case MultiChannelKalman::BALANCED:
+      return "BALANCED";
+#ifdef HAS_TUNED_PROFILE
+    case MultiChannelKalman::TUNED:
+      return "TUNED";
+#endif
+    default:
+      return "RESPONSIVE";
+  }
+}
+
+}  // namespace
+
+// Обёртки -Wl,--wrap: все вызовы malloc/calloc/realloc в прошивке идут сюда
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  countAllocation(size);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  countAllocation(count * size);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  countAllocation(size);  // Рост String - тоже выделение
+  return __real_realloc(ptr, size);
+}
+}
+
+PipelineBenchmark::PipelineBenchmark(HalI2c& i2c, LevelWebServer& server)
+    : lsm303(i2c), server(server), raw(), filtered() {
+  memset(results, 0, sizeof(results));
+}
+
+void PipelineBenchmark::runStage(Stage stage) {
+  switch (stage) {
+    case STAGE_READ_RAW:
+      lsm303.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+      lsm303.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+      raw.timestamp = millis();
+      break;
+
+    case STAGE_KALMAN:
+      pipeline.filter(raw, filtered);
+      break;
+
+    case STAGE_ORIENTATION:
+      pipeline.orient(filtered);
+      break;
+
+    case STAGE_SETTINGS: {
+      SensorData data = filtered;  // Поправка не должна накапливаться
+      pipeline.applySettings(data);
+      break;
+    }
+
+    case STAGE_JSON:
+      json = server.sensorDataToJson(filtered);  // Свой отсчёт, не кеш
+      break;
+
+    case STAGE_BROADCAST:
+      server.wsServer.broadcastTXT(json);
+      break;
+
+    case STAGE_PIPELINE:
+      for (uint8_t s = STAGE_READ_RAW; s < STAGE_PIPELINE; s++) {
+        runStage((Stage)s);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void PipelineBenchmark::measure(Stage stage, uint16_t iterations) {
+  runStage(stage);  // Прогрев: кэш flash, первые выделения String
+
+  allocationCount = 0;
+  allocatedBytes = 0;
+  countedTask = xTaskGetCurrentTaskHandle();
+
+  for (uint16_t i = 0; i < iterations; i++) {
+    uint32_t start = ESP.getCycleCount();
+    runStage(stage);
+    cycleSamples[i] = ESP.getCycleCount() - start;
+  }
+
+  countedTask = nullptr;
+
+  uint64_t sum = 0;
+  for (uint16_t i = 0; i < iterations; i++) sum += cycleSamples[i];
+  qsort(cycleSamples, iterations, sizeof(cycleSamples[0]), compareCycles);
+
+  StageResult& result = results[stage];
+  result.count = iterations;
+  result.minCycles = cycleSamples[0];
+  result.medianCycles = cycleSamples[iterations / 2];
+  result.p99Cycles = cycleSamples[(uint32_t)(iterations - 1) * 99 / 100];
+  result.maxCycles = cycleSamples[iterations - 1];
+  result.meanCycles = (uint32_t)(sum / iterations);
+  result.allocationsPerRun = (float)allocationCount / iterations;
+  result.bytesPerRun = (float)allocatedBytes / iterations;
+}
+
+bool PipelineBenchmark::run(uint16_t iterations,
+                            MultiChannelKalman::FilterProfile profile) {
+  if (iterations == 0) return false;
+  if (iterations > MAX_ITERATIONS) iterations = MAX_ITERATIONS;
+
+  pipeline.setProfile(profile);
+  pipeline.setUserSettings(ConfigManager::getZeroOffset(),
+                           ConfigManager::getAxisSwap());
+
+  uint32_t cpuMhz = getCpuFrequencyMhz();
+  Serial.printf(
+      "{\"type\":\"bench_start\",\"iterations\":%u,\"cpu_mhz\":%u,"
+      "\"profile\":\"%s\",\"ws_clients\":%u,\"free_heap\":%u}\n",
+      iterations, cpuMhz, profileName(profile), server.getClientCount(),
+      ESP.getFreeHeap());
+
+  unsigned long startMs = millis();
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    measure((Stage)s, iterations);
+    printResult((Stage)s);
+  }
+
+  Serial.printf("{\"type\":\"bench_end\",\"duration_ms\":%lu}\n",
+                millis() - startMs);
+  return true;
+}
+
+void PipelineBenchmark::printResult(Stage stage) const {
+  const StageResult& r = results[stage];
+  float cyclesPerUs = (float)getCpuFrequencyMhz();
+
+  Serial.printf(
+      "{\"type\":\"stage\",\"stage\":\"%s\",\"n\":%u,\"min\":%u,"
+      "\"median\":%u,\"p99\":%u,\"max\":%u,\"mean\":%u,"
+      "\"median_us\":%.2f,\"p99_us\":%.2f,\"allocs\":%.2f,\"bytes\":%.1f}\n",
+      stageName(stage), r.count, r.minCycles, r.medianCycles, r.p99Cycles,
+      r.maxCycles, r.meanCycles, r.medianCycles / cyclesPerUs,
+      r.p99Cycles / cyclesPerUs, r.allocationsPerRun, r.bytesPerRun);
+}
+
+const char* PipelineBenchmark::stageName(Stage stage) {
+  switch (stage) {
+    case STAGE_READ_RAW:
+      return "read_raw";
+    case STAGE_KALMAN:
+      return "kalman";
+    case STAGE_ORIENTATION:
+      return "orientation";
+    case STAGE_SETTINGS:
+      return "settings";
+    case STAGE_JSON:
+      return "json";
+    case STAGE_BROADCAST:
+      return "broadcast";
+    case STAGE_PIPELINE:
+      return "pipeline";
+    default:
+      return "unknown";
+  }
+}
+
+#endif  // PIPELINE_BENCHMARK
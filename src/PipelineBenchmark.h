@@ -0,0 +1,93 @@
+// PipelineBenchmark.h
+// Бенчмарк горячего пути датчик -> WebSocket по счётчику тактов CPU
+
+#ifndef PIPELINE_BENCHMARK_H
+#define PIPELINE_BENCHMARK_H
+
+// PIPELINE_BENCHMARK=1 в build_flags (env:esp32dev_bench) включает бенчмарк;
+// подсчёт выделений памяти требует -Wl,--wrap=malloc,--wrap=calloc,
+// --wrap=realloc в той же сборке
+#ifndef PIPELINE_BENCHMARK
+#define PIPELINE_BENCHMARK 0
+#endif
+
+#ifndef PIPELINE_BENCHMARK_ITERATIONS
+#define PIPELINE_BENCHMARK_ITERATIONS 1000
+#endif
+
+#if PIPELINE_BENCHMARK
+
+#include <Arduino.h>
+
+#include "Hal.h"
+#include "LevelWebServer.h"
+#include "Lsm303.h"
+#include "SensorPipeline.h"
+
+/**
+ * @brief Прогон каждого этапа и всей цепочки N раз
+ *
+ * Этапы те же, что в работе: чтение LSM303 по I2C, фильтр Калмана, углы,
+ * offset/swap, JSON и broadcastTXT. Драйвер и цепочка свои (на той же
+ * шине), состояние SensorManager не меняется. Результат - строки JSON в
+ * Serial: медиана, p99, минимум, максимум в тактах и выделения памяти на
+ * итерацию. Выделения считаются только в задаче, где идёт замер.
+ */
+class PipelineBenchmark {
+ public:
+  enum Stage : uint8_t {
+    STAGE_READ_RAW,     // Lsm303::readAccel + readMag
+    STAGE_KALMAN,       // SensorPipeline::filter
+    STAGE_ORIENTATION,  // SensorPipeline::orient
+    STAGE_SETTINGS,     // SensorPipeline::applySettings
+    STAGE_JSON,         // LevelWebServer::sensorDataToJson
+    STAGE_BROADCAST,    // WebSocketsServer::broadcastTXT
+    STAGE_PIPELINE,     // Всё подряд
+    STAGE_COUNT
+  };
+
+  static const uint16_t MAX_ITERATIONS = 2000;
+
+  struct StageResult {
+    uint16_t count;
+    uint32_t minCycles;
+    uint32_t medianCycles;
+    uint32_t p99Cycles;
+    uint32_t maxCycles;
+    uint32_t meanCycles;
+    float allocationsPerRun;
+    float bytesPerRun;
+  };
+
+  PipelineBenchmark(HalI2c& i2c, LevelWebServer& server);
+
+  /**
+   * @brief Прогнать все этапы и вывести отчёт в Serial
+   * @param iterations Прогонов на этап (не больше MAX_ITERATIONS)
+   */
+  bool run(uint16_t iterations, MultiChannelKalman::FilterProfile profile);
+
+  const StageResult& getResult(Stage stage) const { return results[stage]; }
+
+  static const char* stageName(Stage stage);
+
+ private:
+  Lsm303 lsm303;
+  LevelWebServer& server;
+  SensorPipeline pipeline;
+
+  // Данные между этапами
+  SensorDataRaw raw;
+  SensorData filtered;
+  String json;
+
+  StageResult results[STAGE_COUNT];
+
+  void runStage(Stage stage);
+  void measure(Stage stage, uint16_t iterations);
+  void printResult(Stage stage) const;
+};
+
+#endif  // PIPELINE_BENCHMARK
+
+#endif  // PIPELINE_BENCHMARK_H
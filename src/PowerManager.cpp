@@ -0,0 +1,163 @@
+// PowerManager.cpp
+#include "PowerManager.h"
+
+#include <esp_sleep.h>
+
+PowerManager::PowerManager()
+    : mode(MODE_ACTIVE),
+      lowLatencyRadio(false),
+      modeHandler(nullptr),
+      sleepAfterMs(0),
+      lastActivityMs(0),
+      modeSinceMs(0),
+      lastAccountUs(0),
+      totalCharge(0),
+      windowCharge(0),
+      windowStartUs(0),
+      windowCurrentMa(0.0f),
+      sleptUs(0),
+      lightSleeps(0) {
+  memset(residencyMs, 0, sizeof(residencyMs));
+}
+
+void PowerManager::update(float motionLevel, uint8_t clientCount,
+                          bool streaming) {
+  unsigned long now = millis();
+
+  if (motionLevel > MOTION_THRESHOLD || clientCount > 0 || streaming) {
+    lastActivityMs = now;
+  }
+
+  unsigned long restMs = now - lastActivityMs;
+  Mode next = MODE_ACTIVE;
+  if (sleepAfterMs > 0 && restMs >= sleepAfterMs) {
+    next = MODE_LIGHT_SLEEP;
+  } else if (restMs >= IDLE_AFTER_MS) {
+    next = MODE_IDLE;
+  }
+
+  // Без power save только пока кто-то ждёт данные по WebSocket
+  switchTo(next, clientCount > 0);
+}
+
+void PowerManager::switchTo(Mode next, bool lowLatency) {
+  if (next == mode && lowLatency == lowLatencyRadio) return;
+
+  Mode previous = mode;
+  if (next != mode) {
+    unsigned long now = millis();
+    residencyMs[mode] += now - modeSinceMs;
+    modeSinceMs = now;
+    mode = next;
+    Serial.printf("Power mode: %s -> %s\n", modeName(previous),
+                  modeName(next));
+  }
+  lowLatencyRadio = lowLatency;
+
+  if (modeHandler) {
+    modeHandler(previous, mode, lowLatencyRadio);
+  }
+}
+
+uint32_t PowerManager::radioCurrentUa() const {
+  if (mode == MODE_LIGHT_SLEEP) return 0;  // WiFi выключен
+  return lowLatencyRadio ? RADIO_AWAKE_UA : RADIO_MODEM_SLEEP_UA;
+}
+
+void PowerManager::account(uint32_t durationUs, uint32_t currentUa) {
+  uint64_t charge = (uint64_t)durationUs * currentUa;
+  totalCharge += charge;
+  windowCharge += charge;
+
+  uint32_t now = micros();
+  uint32_t windowUs = now - windowStartUs;
+  if (windowUs >= ESTIMATE_WINDOW_MS * 1000UL) {
+    windowCurrentMa = (float)windowCharge / windowUs / 1000.0f;
+    windowCharge = 0;
+    windowStartUs = now;
+  }
+}
+
+void PowerManager::waitForNextJob(uint32_t msUntilDeadline) {
+  uint32_t start = micros();
+  uint32_t radioUa = radioCurrentUa();
+
+  // Всё с прошлого ожидания - работа задач
+  if (lastAccountUs != 0) {
+    account(start - lastAccountUs, CPU_RUN_UA + radioUa);
+  }
+
+  if (msUntilDeadline == 0) {
+    lastAccountUs = start;
+    return;
+  }
+  if (msUntilDeadline > MAX_WAIT_MS) msUntilDeadline = MAX_WAIT_MS;
+
+  if (mode == MODE_LIGHT_SLEEP && msUntilDeadline >= MIN_LIGHT_SLEEP_MS) {
+    Serial.flush();  // UART во сне не работает
+    esp_sleep_enable_timer_wakeup((uint64_t)msUntilDeadline * 1000ULL);
+    esp_light_sleep_start();
+
+    // micros() идёт и во сне (esp_timer корректируется при пробуждении)
+    uint32_t slept = micros() - start;
+    sleptUs += slept;
+    lightSleeps++;
+    account(slept, LIGHT_SLEEP_UA);
+  } else {
+    vTaskDelay(pdMS_TO_TICKS(msUntilDeadline));
+    account(micros() - start, CPU_WAIT_UA + radioUa);
+  }
+
+  lastAccountUs = micros();
+}
+
+uint32_t PowerManager::getResidencyMs(Mode which) const {
+  if (which >= MODE_COUNT) return 0;
+
+  uint32_t total = residencyMs[which];
+  if (which == mode) {
+    total += millis() - modeSinceMs;
+  }
+  return total;
+}
+
+float PowerManager::getConsumedMah() const {
+  // 1 мАч = 1000 мкА * 3.6e9 мкс
+  return (float)(totalCharge / 1000000ULL) / 3600000.0f;
+}
+
+const char* PowerManager::modeName(Mode mode) {
+  switch (mode) {
+    case MODE_ACTIVE:
+      return "active";
+    case MODE_IDLE:
+      return "idle";
+    case MODE_LIGHT_SLEEP:
+      return "light_sleep";
+    default:
+      return "unknown";
+  }
+}
+
+uint16_t PowerManager::restSampleIntervalMs(Mode mode) {
+  switch (mode) {
+    case MODE_LIGHT_SLEEP:
+      return 200;
+    case MODE_ACTIVE:
+    case MODE_IDLE:
+    default:
+      return 100;  // 10 Гц хватает, чтобы заметить движение
+  }
+}
+
+uint16_t PowerManager::httpPollMs(Mode mode) {
+  switch (mode) {
+    case MODE_IDLE:
+      return 20;
+    case MODE_LIGHT_SLEEP:
+      return 200;  // WiFi выключен
+    case MODE_ACTIVE:
+    default:
+      return 2;
+  }
+}
@@ -0,0 +1,125 @@
+// PowerManager.h
+// Режимы питания: активный, ожидание и light sleep между сэмплами
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Выбор режима питания по движению и наличию клиентов
+ *
+ * ACTIVE      - есть движение или клиенты: полная частота опроса.
+ * IDLE        - покой дольше IDLE_AFTER_MS и нет клиентов: опрос реже,
+ *               WiFi в modem sleep.
+ * LIGHT_SLEEP - покой дольше sleepAfterMs: WiFi и индикатор выключены,
+ *               между задачами CPU в light sleep. Движение будит.
+ *
+ * Режим только выбирается здесь; применяет его (частоты, WiFi,
+ * индикатор) обработчик владельца. Потребление - оценка по модели
+ * (константы *_UA), а не измерение.
+ */
+class PowerManager {
+ public:
+  enum Mode : uint8_t { MODE_ACTIVE, MODE_IDLE, MODE_LIGHT_SLEEP, MODE_COUNT };
+
+  // Вызывается при смене режима или требования к задержке WiFi
+  typedef void (*ModeHandler)(Mode previous, Mode current,
+                              bool lowLatencyRadio);
+
+  static constexpr float MOTION_THRESHOLD = 0.05f;  // м/с² (~0.3° наклона)
+  static const uint32_t IDLE_AFTER_MS = 10000;
+  static const uint32_t MIN_LIGHT_SLEEP_MS = 5;  // Короче - не окупается
+  static const uint32_t MAX_WAIT_MS = 100;
+
+  // Модель потребления (мкА)
+  static const uint32_t CPU_RUN_UA = 30000;     // 240 МГц, вычисления
+  static const uint32_t CPU_WAIT_UA = 5000;     // Ожидание задачи (waiti)
+  static const uint32_t RADIO_AWAKE_UA = 80000;  // WiFi без power save
+  static const uint32_t RADIO_MODEM_SLEEP_UA = 20000;  // Среднее с DTIM
+  static const uint32_t LIGHT_SLEEP_UA = 800;
+
+  // Окно усреднения оценки тока
+  static const uint32_t ESTIMATE_WINDOW_MS = 10000;
+
+  PowerManager();
+
+  void setModeHandler(ModeHandler handler) { modeHandler = handler; }
+
+  /**
+   * @brief Через сколько мс покоя уходить в light sleep (0 = никогда)
+   */
+  void setSleepAfterMs(uint32_t ms) { sleepAfterMs = ms; }
+  uint32_t getSleepAfterMs() const { return sleepAfterMs; }
+
+  /**
+   * @brief Пересчитать режим (вызывать периодически)
+   * @param motionLevel SensorManager::getMotionLevel()
+   * @param clientCount Подключённые WebSocket клиенты
+   * @param streaming Есть потребители без подключения (UDP телеметрия)
+   */
+  void update(float motionLevel, uint8_t clientCount, bool streaming);
+
+  /**
+   * @brief Ждать до следующей задачи планировщика
+   * В LIGHT_SLEEP - light sleep с пробуждением по таймеру, иначе
+   * vTaskDelay (CPU простаивает вместо опроса millis()).
+   */
+  void waitForNextJob(uint32_t msUntilDeadline);
+
+  Mode getMode() const { return mode; }
+  bool isLowLatencyRadio() const { return lowLatencyRadio; }
+  static const char* modeName(Mode mode);
+
+  /**
+   * @brief Время в режиме с момента старта, включая текущий (мс)
+   */
+  uint32_t getResidencyMs(Mode mode) const;
+
+  uint32_t getLightSleepMs() const { return (uint32_t)(sleptUs / 1000); }
+  uint32_t getLightSleepCount() const { return lightSleeps; }
+
+  /**
+   * @brief Средний ток за последнее окно ESTIMATE_WINDOW_MS (мА)
+   */
+  float getEstimatedCurrentMa() const { return windowCurrentMa; }
+
+  /**
+   * @brief Оценка израсходованного заряда с момента старта (мАч)
+   */
+  float getConsumedMah() const;
+
+  /**
+   * @brief Частоты задач для режима
+   * restSampleIntervalMs - период опроса датчиков в покое; при движении
+   * SensorManager сам переходит на быстрый опрос.
+   */
+  static uint16_t restSampleIntervalMs(Mode mode);
+  static uint16_t httpPollMs(Mode mode);
+
+ private:
+  Mode mode;
+  bool lowLatencyRadio;
+  ModeHandler modeHandler;
+  uint32_t sleepAfterMs;
+  unsigned long lastActivityMs;
+
+  // Время в режимах
+  unsigned long modeSinceMs;
+  uint32_t residencyMs[MODE_COUNT];
+
+  // Учёт заряда (мкА * мкс)
+  uint32_t lastAccountUs;
+  uint64_t totalCharge;
+  uint64_t windowCharge;
+  uint32_t windowStartUs;
+  float windowCurrentMa;
+  uint64_t sleptUs;
+  uint32_t lightSleeps;
+
+  void switchTo(Mode next, bool lowLatency);
+  uint32_t radioCurrentUa() const;
+  void account(uint32_t durationUs, uint32_t currentUa);
+};
+
+#endif  // POWER_MANAGER_H
@@ -0,0 +1,360 @@
+// RecordFormat.cpp
+#include "RecordFormat.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "Lsm303.h"
+
+namespace {
+
+// CRC-32 по тетрадам: 64 байта таблицы вместо 1 КБ
+const uint32_t CRC_NIBBLE_TABLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+uint16_t getU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+// Поля сэмпла по порядку кодирования
+void fieldsOf(const RecordSample& s, int16_t out[RecordFormat::FIELD_COUNT]) {
+  out[0] = s.roll;
+  out[1] = s.pitch;
+  out[2] = s.accel[0];
+  out[3] = s.accel[1];
+  out[4] = s.accel[2];
+  out[5] = s.mag[0];
+  out[6] = s.mag[1];
+  out[7] = s.mag[2];
+}
+
+void setFields(RecordSample& s, const int16_t in[RecordFormat::FIELD_COUNT]) {
+  s.roll = in[0];
+  s.pitch = in[1];
+  s.accel[0] = in[2];
+  s.accel[1] = in[3];
+  s.accel[2] = in[4];
+  s.mag[0] = in[5];
+  s.mag[1] = in[6];
+  s.mag[2] = in[7];
+}
+
+size_t putVarint(uint8_t* p, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// false - обрыв данных или слишком длинное число
+bool getVarint(const uint8_t* p, uint16_t end, uint16_t& pos, uint32_t& v) {
+  v = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (pos >= end) return false;
+    uint8_t byte = p[pos++];
+    v |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+int16_t toFixed(float value, float scale) {
+  float scaled = value * scale;
+  if (scaled != scaled) return 0;  // NaN
+  if (scaled > INT16_MAX) return INT16_MAX;
+  if (scaled < INT16_MIN) return INT16_MIN;
+  return (int16_t)lroundf(scaled);
+}
+
+// Целое с фиксированной точкой: -1234, 2 знака -> "-12.34"
+char* putFixed(char* p, int32_t value, uint8_t decimals) {
+  char digits[12];
+  uint8_t n = 0;
+  uint32_t magnitude = value < 0 ? (uint32_t)(-(int64_t)value) : value;
+  do {
+    digits[n++] = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0 || n <= decimals);
+
+  if (value < 0) *p++ = '-';
+  while (n > 0) {
+    if (n == decimals) *p++ = '.';
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+// Обратно: "-12.34", 2 знака -> -1234 (ровно decimals знаков не требуется)
+bool getFixed(const char*& p, uint8_t decimals, int32_t& out) {
+  bool negative = *p == '-';
+  if (negative) p++;
+
+  int64_t value = 0;
+  uint8_t digits = 0;
+  int8_t fraction = -1;
+  for (; *p && *p != ',' && *p != '\n' && *p != '\r'; p++) {
+    if (*p == '.' && fraction < 0) {
+      fraction = 0;
+      continue;
+    }
+    if (*p < '0' || *p > '9' || digits > 10) return false;
+    if (fraction >= 0) {
+      if (fraction == decimals) continue;  // Лишние знаки отбрасываются
+      fraction++;
+    }
+    value = value * 10 + (*p - '0');
+    digits++;
+  }
+  if (digits == 0) return false;
+  for (int8_t i = fraction < 0 ? 0 : fraction; i < decimals; i++) {
+    value *= 10;
+  }
+
+  out = (int32_t)(negative ? -value : value);
+  if (*p == ',') p++;
+  return true;
+}
+
+}  // namespace
+
+// ========== RecordFormat ==========
+
+uint32_t RecordFormat::crc32(const uint8_t* data, size_t length, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ CRC_NIBBLE_TABLE[crc & 0x0F];
+    crc = (crc >> 4) ^ CRC_NIBBLE_TABLE[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+bool RecordFormat::parseHeader(const uint8_t* block, RecordBlockHeader& out) {
+  if (getU32(block) != MAGIC) return false;
+
+  out.version = block[4];
+  out.payloadBytes = getU16(block + 6);
+  out.sequence = getU32(block + 8);
+  out.startMs = getU32(block + 12);
+  out.sampleCount = getU16(block + 16);
+  out.intervalMs = getU16(block + 18);
+  out.crc = getU32(block + 20);
+
+  return out.version == VERSION && out.payloadBytes <= PAYLOAD_SIZE;
+}
+
+bool RecordFormat::verifyBlock(const uint8_t* block, RecordBlockHeader& out) {
+  if (!parseHeader(block, out)) return false;
+
+  uint32_t crc = crc32(block, HEADER_SIZE - 4);
+  crc = crc32(block + HEADER_SIZE, out.payloadBytes, crc);
+  return crc == out.crc;
+}
+
+void RecordFormat::makeSample(uint32_t timeMs, float roll, float pitch,
+                              const SensorDataRaw& raw, RecordSample& out) {
+  const float mgPerMs2 = 1000.0f / Lsm303::GRAVITY;
+
+  out.timeMs = timeMs;
+  out.roll = toFixed(roll, ANGLE_SCALE);
+  out.pitch = toFixed(pitch, ANGLE_SCALE);
+  out.accel[0] = toFixed(raw.accel_x, mgPerMs2);
+  out.accel[1] = toFixed(raw.accel_y, mgPerMs2);
+  out.accel[2] = toFixed(raw.accel_z, mgPerMs2);
+  out.mag[0] = toFixed(raw.mag_x, MAG_SCALE);
+  out.mag[1] = toFixed(raw.mag_y, MAG_SCALE);
+  out.mag[2] = toFixed(raw.mag_z, MAG_SCALE);
+}
+
+void RecordFormat::toRaw(const RecordSample& sample, SensorDataRaw& out) {
+  const float ms2PerMg = Lsm303::GRAVITY / 1000.0f;
+
+  out.accel_x = sample.accel[0] * ms2PerMg;
+  out.accel_y = sample.accel[1] * ms2PerMg;
+  out.accel_z = sample.accel[2] * ms2PerMg;
+  out.mag_x = sample.mag[0] / MAG_SCALE;
+  out.mag_y = sample.mag[1] / MAG_SCALE;
+  out.mag_z = sample.mag[2] / MAG_SCALE;
+  out.gyro_x = out.gyro_y = out.gyro_z = 0.0f;  // Гироскоп не пишется
+  out.timestamp = sample.timeMs;
+}
+
+size_t RecordFormat::formatCsvRow(const RecordSample& sample,
+                                  uint32_t sequence, char* out, size_t size) {
+  if (size < MAX_CSV_ROW) return 0;
+
+  char* p = out;
+  p = putFixed(p, (int32_t)sequence, 0);
+  *p++ = ',';
+  p = putFixed(p, (int32_t)sample.timeMs, 0);
+  *p++ = ',';
+  p = putFixed(p, sample.roll, 2);
+  *p++ = ',';
+  p = putFixed(p, sample.pitch, 2);
+  for (uint8_t i = 0; i < 3; i++) {
+    *p++ = ',';
+    p = putFixed(p, sample.accel[i], 3);  // mg -> g
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    *p++ = ',';
+    p = putFixed(p, sample.mag[i], 1);  // 0.1 мкТл -> мкТл
+  }
+  *p++ = '\n';
+  return p - out;
+}
+
+bool RecordFormat::parseCsvRow(const char* line, uint32_t& sequence,
+                               RecordSample& out) {
+  const uint8_t decimals[10] = {0, 0, 2, 2, 3, 3, 3, 1, 1, 1};
+  int32_t values[10];
+
+  const char* p = line;
+  for (uint8_t i = 0; i < 10; i++) {
+    if (!getFixed(p, decimals[i], values[i])) return false;
+    if (i >= 2 && (values[i] < INT16_MIN || values[i] > INT16_MAX)) {
+      return false;
+    }
+  }
+
+  sequence = (uint32_t)values[0];
+  out.timeMs = (uint32_t)values[1];
+  out.roll = (int16_t)values[2];
+  out.pitch = (int16_t)values[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    out.accel[i] = (int16_t)values[4 + i];
+    out.mag[i] = (int16_t)values[7 + i];
+  }
+  return true;
+}
+
+// ========== Кодирование ==========
+
+RecordBlockEncoder::RecordBlockEncoder()
+    : block(nullptr),
+      sequence(0),
+      startMs(0),
+      intervalMs(0),
+      sampleCount(0),
+      payloadBytes(0),
+      previous() {}
+
+void RecordBlockEncoder::begin(uint8_t* block, uint32_t sequence,
+                               uint16_t intervalMs) {
+  this->block = block;
+  this->sequence = sequence;
+  this->intervalMs = intervalMs;
+  startMs = 0;
+  sampleCount = 0;
+  payloadBytes = 0;
+  previous = RecordSample();
+  memset(block, 0, RecordFormat::BLOCK_SIZE);
+}
+
+bool RecordBlockEncoder::append(const RecordSample& sample) {
+  if (!block || sampleCount == UINT16_MAX ||
+      payloadBytes + RecordFormat::MAX_SAMPLE_BYTES >
+          RecordFormat::PAYLOAD_SIZE) {
+    return false;
+  }
+
+  if (sampleCount == 0) {
+    startMs = sample.timeMs;
+    previous.timeMs = sample.timeMs;
+  }
+
+  uint8_t* p = block + RecordFormat::HEADER_SIZE + payloadBytes;
+  size_t n = putVarint(p, sample.timeMs - previous.timeMs);
+
+  int16_t current[RecordFormat::FIELD_COUNT];
+  int16_t last[RecordFormat::FIELD_COUNT];
+  fieldsOf(sample, current);
+  fieldsOf(previous, last);
+  for (uint8_t i = 0; i < RecordFormat::FIELD_COUNT; i++) {
+    n += putVarint(p + n, zigzag((int32_t)current[i] - last[i]));
+  }
+
+  payloadBytes += n;
+  sampleCount++;
+  previous = sample;
+  return true;
+}
+
+void RecordBlockEncoder::finish() {
+  if (!block) return;
+
+  putU32(block, RecordFormat::MAGIC);
+  block[4] = RecordFormat::VERSION;
+  block[5] = 0;
+  putU16(block + 6, payloadBytes);
+  putU32(block + 8, sequence);
+  putU32(block + 12, startMs);
+  putU16(block + 16, sampleCount);
+  putU16(block + 18, intervalMs);
+
+  uint32_t crc = RecordFormat::crc32(block, RecordFormat::HEADER_SIZE - 4);
+  crc = RecordFormat::crc32(block + RecordFormat::HEADER_SIZE, payloadBytes,
+                            crc);
+  putU32(block + 20, crc);
+}
+
+// ========== Декодирование ==========
+
+RecordBlockDecoder::RecordBlockDecoder()
+    : block(nullptr), header(), position(0), decoded(0), previous() {}
+
+bool RecordBlockDecoder::begin(const uint8_t* block) {
+  this->block = nullptr;
+  if (!RecordFormat::verifyBlock(block, header)) return false;
+
+  this->block = block;
+  position = RecordFormat::HEADER_SIZE;
+  decoded = 0;
+  previous = RecordSample();
+  previous.timeMs = header.startMs;
+  return true;
+}
+
+bool RecordBlockDecoder::next(RecordSample& out) {
+  if (!block || decoded >= header.sampleCount) return false;
+
+  uint16_t end = RecordFormat::HEADER_SIZE + header.payloadBytes;
+  uint32_t value;
+  if (!getVarint(block, end, position, value)) return false;
+  out.timeMs = previous.timeMs + value;
+
+  int16_t fields[RecordFormat::FIELD_COUNT];
+  fieldsOf(previous, fields);
+  for (uint8_t i = 0; i < RecordFormat::FIELD_COUNT; i++) {
+    if (!getVarint(block, end, position, value)) return false;
+    fields[i] = (int16_t)(fields[i] + unzigzag(value));
+  }
+  setFields(out, fields);
+
+  previous = out;
+  decoded++;
+  return true;
+}
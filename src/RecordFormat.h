@@ -0,0 +1,176 @@
+// RecordFormat.h
+// Двоичный формат записи сэмплов: блоки по 4096 байт с заголовком и CRC
+//
+// Общий для прошивки (SampleRecorder, выгрузка /log) и утилит на ПК.
+//
+// Файл записи - кольцо из одинаковых блоков. Блок:
+//   0  u32 magic 'LVLR'       12 u32 startMs (время первого сэмпла)
+//   4  u8  version            16 u16 sampleCount
+//   5  u8  reserved           18 u16 intervalMs (период записи)
+//   6  u16 payloadBytes       20 u32 CRC-32 (байты 0..19 + полезные данные)
+//   8  u32 sequence (номер блока, растёт; самый старый - наименьший)
+// Далее сэмплы; числа little-endian. Сэмпл: varint(dt от предыдущего, мс),
+// затем zigzag-varint разностей 8 полей int16 от предыдущего сэмпла.
+// В начале блока предыдущий сэмпл нулевой - блок декодируется отдельно.
+// В покое разности малы: ~9-12 байт на сэмпл вместо 20.
+
+#ifndef RECORD_FORMAT_H
+#define RECORD_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SensorTypes.h"
+
+/**
+ * @brief Сэмпл записи в фиксированной точке
+ */
+struct RecordSample {
+  uint32_t timeMs;
+  int16_t roll, pitch;  // 0.01° (с offset и swap, как на индикаторе)
+  int16_t accel[3];     // Сырое ускорение, mg (1 LSB LSM303 при ±2 g)
+  int16_t mag[3];       // Сырое поле, 0.1 мкТл
+};
+
+/**
+ * @brief Заголовок блока
+ */
+struct RecordBlockHeader {
+  uint8_t version;
+  uint16_t payloadBytes;
+  uint32_t sequence;
+  uint32_t startMs;
+  uint16_t sampleCount;
+  uint16_t intervalMs;
+  uint32_t crc;
+};
+
+class RecordFormat {
+ public:
+  static const uint32_t MAGIC = 0x524C564C;  // "LVLR"
+  static const uint8_t VERSION = 1;
+
+  // Блок = страница стирания flash и блок LittleFS на ESP32
+  static const uint16_t BLOCK_SIZE = 4096;
+  static const uint8_t HEADER_SIZE = 24;
+  static const uint16_t PAYLOAD_SIZE = BLOCK_SIZE - HEADER_SIZE;
+
+  static const uint8_t FIELD_COUNT = 8;
+  // Худший случай: varint u32 + 8 x zigzag-varint 17 бит
+  static const uint8_t MAX_SAMPLE_BYTES = 5 + FIELD_COUNT * 3;
+
+  static constexpr float ANGLE_SCALE = 100.0f;  // LSB на градус
+  static constexpr float MAG_SCALE = 10.0f;     // LSB на мкТл
+
+  // CSV выгрузки: значения как в блоке, без округления (ускорение в g)
+  static constexpr const char* CSV_HEADER =
+      "sequence,time_ms,roll_deg,pitch_deg,accel_x_g,accel_y_g,accel_z_g,"
+      "mag_x_ut,mag_y_ut,mag_z_ut\n";
+  static const uint8_t MAX_CSV_ROW = 96;
+
+  /**
+   * @brief Заголовок из начала блока (без проверки CRC)
+   * @return false - не блок записи (чистый или чужой)
+   */
+  static bool parseHeader(const uint8_t* block, RecordBlockHeader& out);
+
+  /**
+   * @brief Заголовок и CRC всего блока
+   */
+  static bool verifyBlock(const uint8_t* block, RecordBlockHeader& out);
+
+  /**
+   * @brief CRC-32 (IEEE 802.3), можно считать по частям
+   */
+  static uint32_t crc32(const uint8_t* data, size_t length,
+                        uint32_t crc = 0);
+
+  // Перевод в фиксированную точку и обратно
+  static void makeSample(uint32_t timeMs, float roll, float pitch,
+                         const SensorDataRaw& raw, RecordSample& out);
+  static void toRaw(const RecordSample& sample, SensorDataRaw& out);
+  static float angleDegrees(int16_t value) { return value / ANGLE_SCALE; }
+
+  /**
+   * @brief Строка CSV (с '\n') без printf с плавающей точкой
+   * @return Длина строки или 0, если не поместилась в size
+   */
+  static size_t formatCsvRow(const RecordSample& sample, uint32_t sequence,
+                             char* out, size_t size);
+
+  /**
+   * @brief Разбор строки CSV выгрузки (для утилит на ПК)
+   * @return false - заголовок или испорченная строка
+   */
+  static bool parseCsvRow(const char* line, uint32_t& sequence,
+                          RecordSample& out);
+};
+
+/**
+ * @brief Кодирование сэмплов в блок (буфер BLOCK_SIZE байт)
+ */
+class RecordBlockEncoder {
+ public:
+  RecordBlockEncoder();
+
+  /**
+   * @brief Начать новый блок (буфер очищается)
+   */
+  void begin(uint8_t* block, uint32_t sequence, uint16_t intervalMs);
+
+  /**
+   * @brief Добавить сэмпл
+   * @return false - блок заполнен, сэмпл не добавлен
+   */
+  bool append(const RecordSample& sample);
+
+  /**
+   * @brief Записать заголовок и CRC. Можно вызывать повторно:
+   * после finish() блок дописывается дальше.
+   */
+  void finish();
+
+  bool isEmpty() const { return sampleCount == 0; }
+  uint16_t getSampleCount() const { return sampleCount; }
+  uint16_t getPayloadBytes() const { return payloadBytes; }
+  uint32_t getSequence() const { return sequence; }
+
+ private:
+  uint8_t* block;
+  uint32_t sequence;
+  uint32_t startMs;
+  uint16_t intervalMs;
+  uint16_t sampleCount;
+  uint16_t payloadBytes;
+  RecordSample previous;
+};
+
+/**
+ * @brief Чтение сэмплов из проверенного блока
+ */
+class RecordBlockDecoder {
+ public:
+  RecordBlockDecoder();
+
+  /**
+   * @brief Проверить блок (magic, версия, CRC) и встать на первый сэмпл
+   */
+  bool begin(const uint8_t* block);
+
+  /**
+   * @brief Следующий сэмпл
+   * @return false - сэмплы кончились или данные испорчены
+   */
+  bool next(RecordSample& out);
+
+  const RecordBlockHeader& getHeader() const { return header; }
+
+ private:
+  const uint8_t* block;
+  RecordBlockHeader header;
+  uint16_t position;
+  uint16_t decoded;
+  RecordSample previous;
+};
+
+#endif  // RECORD_FORMAT_H
@@ -0,0 +1,177 @@
+// SampleRecorder.cpp
+#include "SampleRecorder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+SampleRecorder::SampleRecorder(HalFileSystem& fs, const char* directory,
+                               uint16_t blockCount)
+    : fs(fs),
+      directory(directory),
+      blockCount(blockCount < 2                 ? 2
+                 : blockCount > MAX_BLOCK_COUNT ? MAX_BLOCK_COUNT
+                                                : blockCount),
+      ready(false),
+      intervalMs(0),
+      headSlot(0),
+      lastFlushMs(0),
+      lastRecordMs(0),
+      hasRecorded(false),
+      writeSlot(0),
+      writePendingFlag(false),
+      flushRequested(false),
+      samples(0),
+      droppedSamples(0),
+      blocksWritten(0),
+      writeErrors(0)
+#ifdef ARDUINO
+      ,
+      writerTask(nullptr)
+#endif
+{
+}
+
+bool SampleRecorder::begin() {
+  // 256 КБ старого кольца одним файлом - место под новые блоки
+  if (fs.exists(LEGACY_PATH)) fs.remove(LEGACY_PATH);
+
+  findHead();
+  ready = true;
+  HAL_LOG("Recorder: %s, %u blocks, next #%u in slot %u\n", directory,
+          blockCount, (unsigned)encoder.getSequence(), headSlot);
+  return true;
+}
+
+void SampleRecorder::getBlockPath(uint16_t slot, char* out) const {
+  snprintf(out, BLOCK_PATH_SIZE, "%s/%03u.bin", directory, (unsigned)slot);
+}
+
+void SampleRecorder::findHead() {
+  // Продолжаем после блока с наибольшим номером; слоты без файла пусты
+  uint32_t lastSequence = 0;
+  int32_t lastSlot = -1;
+  char blockPath[BLOCK_PATH_SIZE];
+  for (uint16_t slot = 0; slot < blockCount; slot++) {
+    RecordBlockHeader header;
+    getBlockPath(slot, blockPath);
+    if (fs.readAt(blockPath, 0, activeBlock, RecordFormat::HEADER_SIZE) ==
+            RecordFormat::HEADER_SIZE &&
+        RecordFormat::parseHeader(activeBlock, header) &&
+        header.sequence > lastSequence) {
+      lastSequence = header.sequence;
+      lastSlot = slot;
+    }
+  }
+
+  headSlot = lastSlot < 0 ? 0 : (uint16_t)((lastSlot + 1) % blockCount);
+  encoder.begin(activeBlock, lastSequence + 1, intervalMs);
+}
+
+void SampleRecorder::setIntervalMs(uint16_t intervalMs) {
+  if (intervalMs == this->intervalMs) return;
+
+  // Выключили запись - накопленное не должно пропасть
+  if (intervalMs == 0 && !encoder.isEmpty()) requestFlush();
+  this->intervalMs = intervalMs;
+  hasRecorded = false;
+}
+
+bool SampleRecorder::record(uint32_t nowMs, const SensorData& data,
+                            const SensorDataRaw& raw) {
+  if (!ready) return false;
+
+  if (flushRequested) {
+    if (encoder.isEmpty() || submit(nowMs, false)) flushRequested = false;
+  }
+  if (intervalMs == 0) return false;
+
+  // Сэмплы датчика идут с дрожанием - допуск 1/8 периода
+  if (hasRecorded && nowMs - lastRecordMs + intervalMs / 8 < intervalMs) {
+    return false;
+  }
+
+  RecordSample sample;
+  RecordFormat::makeSample(nowMs, data.roll, data.pitch, raw, sample);
+  if (!encoder.append(sample)) {
+    // Блок заполнен: новый можно начать, только если прошлый уже записан
+    if (!submit(nowMs, true) || !encoder.append(sample)) {
+      droppedSamples++;
+      return false;
+    }
+  }
+  if (encoder.getSampleCount() == 1) lastFlushMs = nowMs;
+
+  lastRecordMs = nowMs;
+  hasRecorded = true;
+  samples++;
+
+  // Незаполненный блок - во flash раз в PARTIAL_FLUSH_MS (не терять при
+  // выключении питания больше этого)
+  if (nowMs - lastFlushMs >= PARTIAL_FLUSH_MS) submit(nowMs, false);
+  return true;
+}
+
+bool SampleRecorder::submit(uint32_t nowMs, bool full) {
+  if (writePendingFlag.load()) return false;  // Задача записи занята
+
+  encoder.finish();
+  memcpy(writeBlock, activeBlock, sizeof(writeBlock));
+  writeSlot = headSlot;
+  lastFlushMs = nowMs;
+  writePendingFlag.store(true);
+
+  if (full) {
+    headSlot = (headSlot + 1) % blockCount;
+    encoder.begin(activeBlock, encoder.getSequence() + 1, intervalMs);
+  }
+
+#ifdef ARDUINO
+  if (writerTask) xTaskNotifyGive(writerTask);
+#endif
+  return true;
+}
+
+bool SampleRecorder::writePending() {
+  if (!writePendingFlag.load()) return false;
+
+  // Файл слота заново целиком: старый блок LittleFS освобождается
+  char blockPath[BLOCK_PATH_SIZE];
+  getBlockPath(writeSlot, blockPath);
+  bool ok = fs.write(blockPath, (const char*)writeBlock, sizeof(writeBlock));
+  if (ok) {
+    blocksWritten++;
+  } else {
+    writeErrors++;
+  }
+
+  writePendingFlag.store(false);
+  return ok;
+}
+
+#ifdef ARDUINO
+
+void SampleRecorder::writerLoop(void* arg) {
+  SampleRecorder* recorder = static_cast<SampleRecorder*>(arg);
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    recorder->writePending();
+  }
+}
+
+bool SampleRecorder::startWriterTask() {
+  if (writerTask) return true;
+
+  // Отдельная задача: record() не ждёт LittleFS (поиск места, метаданные).
+  // Стирание и программирование SPI flash всё равно отключают кэш обоих
+  // ядер, и loop() на ядре 1 на это время тоже встаёт (стирание сектора
+  // 4 КБ - десятки мс); ядро 0 - просто чтобы не делить ядро с loop()
+  if (xTaskCreatePinnedToCore(writerLoop, "recorder", 4096, this, 1,
+                              &writerTask, 0) != pdPASS) {
+    writerTask = nullptr;
+    HAL_LOG("ERROR: Recorder writer task not started\n");
+    return false;
+  }
+  return true;
+}
+
+#endif  // ARDUINO
@@ -0,0 +1,148 @@
+// SampleRecorder.h
+// Запись сэмплов во flash: кольцо блоков RecordFormat, блок - файл LittleFS
+
+#ifndef SAMPLE_RECORDER_H
+#define SAMPLE_RECORDER_H
+
+#include <atomic>
+
+#include "Hal.h"
+#include "RecordFormat.h"
+#include "SensorTypes.h"
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+/**
+ * @brief Регистратор сэмплов
+ *
+ * Каждый слот кольца - отдельный файл в каталоге записи (000.bin, ...),
+ * и блок всегда пишется новым файлом целиком. Правка по месту внутри
+ * большого файла в LittleFS переписывает изменённый блок и все блоки
+ * файла после него (список блоков CTZ) - в среднем в десятки раз больше
+ * данных. Новый файл из 4 КБ - одно стирание и программирование блока
+ * flash плюс метаданные. Пишется один раз на заполненный блок (~450 сэмплов в
+ * покое) и не чаще раза в PARTIAL_FLUSH_MS для незаполненного.
+ *
+ * record() из цикла датчиков только кодирует сэмпл в RAM. Готовый блок
+ * копируется во второй буфер, пишет его отдельная задача (writePending()),
+ * так что опрос не ждёт LittleFS. Если запись ещё идёт, а блок уже
+ * заполнен, сэмплы отбрасываются и считаются.
+ */
+class SampleRecorder {
+ public:
+  static constexpr const char* DEFAULT_DIRECTORY = "/rec";
+
+  // Кольцо прежних версий одним файлом - удаляется в begin()
+  static constexpr const char* LEGACY_PATH = "/record.bin";
+
+  // 256 КБ: ~8 ч при записи раз в секунду, ~48 мин при 10 Гц
+  static const uint16_t DEFAULT_BLOCK_COUNT = 64;
+
+  // Не больше 999 слотов (имя файла - три цифры)
+  static const uint16_t MAX_BLOCK_COUNT = 999;
+  static const size_t BLOCK_PATH_SIZE = 40;
+
+  // Незаполненный блок сбрасывается во flash не реже этого
+  static const uint32_t PARTIAL_FLUSH_MS = 60000;
+
+  SampleRecorder(HalFileSystem& fs, const char* directory = DEFAULT_DIRECTORY,
+                 uint16_t blockCount = DEFAULT_BLOCK_COUNT);
+
+  /**
+   * @brief Найти конец кольца по заголовкам блоков
+   */
+  bool begin();
+
+  /**
+   * @brief Период записи (мс), 0 - запись выключена
+   */
+  void setIntervalMs(uint16_t intervalMs);
+  uint16_t getIntervalMs() const { return intervalMs; }
+  bool isEnabled() const { return ready && intervalMs > 0; }
+
+  /**
+   * @brief Записать сэмпл, если прошёл период (цикл датчиков)
+   * @param data Обработанные углы (с offset и swap)
+   * @param raw Сырые показания того же сэмпла
+   * @return true - сэмпл записан в буфер
+   */
+  bool record(uint32_t nowMs, const SensorData& data, const SensorDataRaw& raw);
+
+  /**
+   * @brief Сбросить незаполненный блок при следующей возможности
+   * (перед выгрузкой, сном)
+   */
+  void requestFlush() { flushRequested = true; }
+
+  /**
+   * @brief Записать готовый блок во flash (задача записи)
+   * @return true - блок был и записан
+   */
+  bool writePending();
+
+#ifdef ARDUINO
+  /**
+   * @brief Задача записи на ядре 0 (ждёт уведомления от record())
+   */
+  bool startWriterTask();
+#endif
+
+  // Устройство кольца (для выгрузки)
+  HalFileSystem& getFileSystem() const { return fs; }
+  uint16_t getBlockCount() const { return blockCount; }
+
+  /**
+   * @brief Путь файла слота (out не короче BLOCK_PATH_SIZE)
+   */
+  void getBlockPath(uint16_t slot, char* out) const;
+
+  // Слот текущего (ещё пишущегося) блока и его номер
+  uint16_t getHeadSlot() const { return headSlot; }
+  uint32_t getSequence() const { return encoder.getSequence(); }
+
+  // Статистика
+  uint32_t getSamples() const { return samples; }
+  uint32_t getDroppedSamples() const { return droppedSamples; }
+  uint32_t getBlocksWritten() const { return blocksWritten; }
+  uint32_t getWriteErrors() const { return writeErrors; }
+
+ private:
+  HalFileSystem& fs;
+  const char* directory;
+  uint16_t blockCount;
+  bool ready;
+  uint16_t intervalMs;
+
+  // Блок, который наполняет record()
+  uint8_t activeBlock[RecordFormat::BLOCK_SIZE];
+  RecordBlockEncoder encoder;
+  uint16_t headSlot;
+  uint32_t lastFlushMs;  // Открытие блока или последний частичный сброс
+  uint32_t lastRecordMs;
+  bool hasRecorded;
+
+  // Копия для задачи записи
+  uint8_t writeBlock[RecordFormat::BLOCK_SIZE];
+  uint16_t writeSlot;
+  std::atomic<bool> writePendingFlag;
+  std::atomic<bool> flushRequested;
+
+  // Статистика
+  uint32_t samples;
+  uint32_t droppedSamples;
+  uint32_t blocksWritten;
+  uint32_t writeErrors;
+
+#ifdef ARDUINO
+  TaskHandle_t writerTask;
+  static void writerLoop(void* arg);
+#endif
+
+  void findHead();
+  bool submit(uint32_t nowMs, bool full);
+};
+
+#endif  // SAMPLE_RECORDER_H
@@ -1,23 +1,29 @@
 // SensorManager.cpp
 #include "SensorManager.h"
 
-#include <Wire.h>
-
 #include "ConfigManager.h"
-
-SensorManager::SensorManager(uint8_t sda_pin, uint8_t scl_pin)
-    : accel(12345),
-      mag(12346),
-      sdaPin(sda_pin),
-      sclPin(scl_pin),
+#include "Orientation.h"
+
+SensorManager::SensorManager(HalI2c& i2c, HalClock& clock)
+    : i2c(i2c),
+      clock(clock),
+      lsm303(i2c),
+      gyro(i2c),
+      gyroAvailable(false),
+      magAvailable(false),
+      lastSampleMicros(0),
       initialized(false),
       debugMode(false),
       lastUpdate(0),
+      updateIntervalMs(UPDATE_INTERVAL_MS),
+      adaptiveRate(true),
+      fastRate(true),
+      restIntervalMs(REST_INTERVAL_MS),
+      lastMotionMs(0),
       updateCount(0),
       lastStatsTime(0),
-      kalmanFilter(nullptr),
-      zeroOffset(0.0f),
-      axisSwap(false) {
+      rateWindowStart(0),
+      rateWindowSamples(0) {
   mutex = xSemaphoreCreateMutex();
   if (mutex == NULL) {
     Serial.println("ERROR: Failed to create mutex!");
@@ -25,13 +31,11 @@ SensorManager::SensorManager(uint8_t sda_pin, uint8_t scl_pin)
 
   filteredCache = {0};
   rawCache = {0};
+  sensorStats = {0};
   filteredCache.valid = false;
 }
 
 SensorManager::~SensorManager() {
-  if (kalmanFilter) {
-    delete kalmanFilter;
-  }
   if (mutex) {
     vSemaphoreDelete(mutex);
   }
@@ -40,17 +44,11 @@ SensorManager::~SensorManager() {
 bool SensorManager::begin(MultiChannelKalman::FilterProfile filterProfile) {
   Serial.println("=== Initializing SensorManager ===");
 
-  // Инициализируем I2C
-  Wire.begin(sdaPin, sclPin);
-  Wire.setClock(400000);
-  Serial.printf("I2C initialized (SDA: %d, SCL: %d, 400kHz)\n", sdaPin, sclPin);
-
   // Сканируем шину
   Serial.println("Scanning I2C bus...");
   int nDevices = 0;
-  for (byte addr = 1; addr < 127; addr++) {
-    Wire.beginTransmission(addr);
-    if (Wire.endTransmission() == 0) {
+  for (uint8_t addr = 1; addr < 127; addr++) {
+    if (i2c.probe(addr)) {
       Serial.printf("  Device found at 0x%02X\n", addr);
       nDevices++;
     }
@@ -64,10 +62,14 @@ bool SensorManager::begin(MultiChannelKalman::FilterProfile filterProfile) {
     return false;
   }
 
-  // Создаём фильтр Калмана
-  kalmanFilter = new MultiChannelKalman(6, filterProfile);
+  // Фильтр Калмана
+  pipeline.setProfile(filterProfile);
   Serial.println("Kalman filter initialized");
 
+  // ODR и фильтр под начальный (быстрый) период
+  applySampleInterval(updateIntervalMs);
+  lastMotionMs = clock.nowMs();
+
   // Загружаем настройки из файлов
   loadSettings();
 
@@ -77,65 +79,101 @@ bool SensorManager::begin(MultiChannelKalman::FilterProfile filterProfile) {
 }
 
 bool SensorManager::initSensors() {
-  if (!accel.begin()) {
+  if (!lsm303.beginAccel()) {
     Serial.println("ERROR: LSM303 accelerometer not found!");
     return false;
   }
-  Serial.println("Accelerometer initialized");
+  Serial.println("Accelerometer initialized (±2 g, 1 mg/LSB)");
 
-  if (!mag.begin()) {
+  magAvailable = lsm303.beginMag();
+  if (!magAvailable) {
     Serial.println("WARNING: LSM303 magnetometer not found!");
   } else {
-    Serial.println("Magnetometer initialized");
+    Serial.println("Magnetometer initialized (±1.3 Gs)");
   }
 
-  sensor_t sensor;
-  accel.getSensor(&sensor);
-  Serial.println("=== Accelerometer Info ===");
-  Serial.printf("  Name: %s\n", sensor.name);
-  Serial.printf("  Range: ±%.1f m/s²\n", sensor.max_value);
-  Serial.printf("  Resolution: %.3f m/s²\n", sensor.resolution);
-
-  mag.getSensor(&sensor);
-  Serial.println("=== Magnetometer Info ===");
-  Serial.printf("  Name: %s\n", sensor.name);
-  Serial.printf("  Range: ±%.1f µT\n", sensor.max_value);
-  Serial.printf("  Resolution: %.3f µT\n", sensor.resolution);
+  // Гироскоп необязателен: без него углы только по акселерометру
+  gyroAvailable = gyro.begin();
+  if (gyroAvailable) {
+    Serial.println("Gyroscope L3GD20 initialized (±250 dps)");
+  } else {
+    Serial.println("No L3GD20 gyroscope, accel-only orientation");
+  }
 
   return true;
 }
 
-// SensorManager.cpp
 void SensorManager::loadSettings() {
   // Загружаем из кеша ConfigManager (без чтения файлов!)
-  zeroOffset = ConfigManager::getZeroOffset();
-  axisSwap = ConfigManager::getAxisSwap();
+  pipeline.setUserSettings(ConfigManager::getZeroOffset(),
+                           ConfigManager::getAxisSwap());
+  pipeline.setAccelCorrection(ConfigManager::getAccelCorrection());
+  pipeline.setMagCorrection(ConfigManager::getMagCorrection());
+  setHeadingEnabled(ConfigManager::getHeadingEnabled());
+  setOrientationEngine(ConfigManager::getOrientationEngine());
+  setOutlierMode(ConfigManager::getOutlierMode());
 }
 
 void SensorManager::update() {
   if (!initialized) return;
 
-  unsigned long now = millis();
-  if (now - lastUpdate < UPDATE_INTERVAL_MS) {
+  if (clock.nowMs() - lastUpdate < updateIntervalMs) {
     return;
   }
+
+  sample();
+}
+
+void SensorManager::sample() {
+  if (!initialized) return;
+
+  unsigned long now = clock.nowMs();
+  unsigned long elapsed = now - lastUpdate;
+
+  // Опоздали больше чем на период - пропущенные слоты
+  if (lastUpdate != 0 && elapsed >= 2 * updateIntervalMs) {
+    sensorStats.deadlineMisses += elapsed / updateIntervalMs - 1;
+  }
   lastUpdate = now;
   updateCount++;
+  sensorStats.samples++;
+
+  // Фактическая частота за окно 1 с
+  rateWindowSamples++;
+  if (now - rateWindowStart >= 1000) {
+    sensorStats.sampleRateHz =
+        rateWindowSamples * 1000.0f / (now - rateWindowStart);
+    rateWindowStart = now;
+    rateWindowSamples = 0;
+  }
 
-  // Читаем сырые данные
-  readRawData();
-
-  // Применяем фильтр Калмана
-  applyKalmanFilter();
+  // Читаем сырые данные (при ошибке акселерометра - прошлые значения)
+  bool accelRead = readRawData();
+
+  // Фильтр Калмана, ориентация, offset/swap
+  SensorData data;
+  pipeline.process(rawCache, data);
+
+  // Калибровка копит сырое ускорение, без поправки и фильтра
+  if (accelRead && accelCalibration.isCapturing() &&
+      accelCalibration.addSample(rawCache.accel_x, rawCache.accel_y,
+                                 rawCache.accel_z, pipeline.getMotionLevel(),
+                                 now)) {
+    Serial.printf("Accel calibration %s: %s\n",
+                  AccelCalibration::positionName(
+                      accelCalibration.getPosition()),
+                  AccelCalibration::statusName(accelCalibration.getStatus()));
+  }
 
-  // Вычисляем ориентацию
-  calculateOrientation();
+  if (magCalibration.isCollecting()) {
+    magCalibration.addSample(rawCache.mag_x, rawCache.mag_y, rawCache.mag_z);
+  }
 
-  // Применяем пользовательские настройки (offset, swap)
-  applyUserSettings();
+  // Частота следующих сэмплов по уровню движения
+  updateSampleRate(now);
 
   // Обновляем кэш
-  updateCache();
+  updateCache(data);
 
   // Отладочный вывод
   if (debugMode && (now - lastStatsTime >= 1000)) {
@@ -144,123 +182,111 @@ void SensorManager::update() {
   }
 }
 
-void SensorManager::readRawData() {
-  sensors_event_t accelEvent, magEvent;
+bool SensorManager::readRawData() {
+  lastSampleMicros = clock.nowUs();
+  if (!lsm303.readAccel(rawCache.accel_x, rawCache.accel_y,
+                        rawCache.accel_z)) {
+    sensorStats.accelErrors++;
+    Serial.println("WARNING: Failed to read accelerometer");
+    return false;
+  }
 
-  if (accel.getEvent(&accelEvent)) {
-    rawCache.accel_x = accelEvent.acceleration.x;
-    rawCache.accel_y = accelEvent.acceleration.y;
-    rawCache.accel_z = accelEvent.acceleration.z;
+  // Без курса и калибровки магнитометр не нужен - транзакция I2C экономится
+  if (pipeline.isMagEnabled() || magCalibration.isCollecting()) {
+    if (!lsm303.readMag(rawCache.mag_x, rawCache.mag_y, rawCache.mag_z)) {
+      sensorStats.magErrors++;
+    }
   } else {
-    Serial.println("WARNING: Failed to read accelerometer");
-    return;
+    rawCache.mag_x = rawCache.mag_y = rawCache.mag_z = 0.0f;
   }
 
-  if (mag.getEvent(&magEvent)) {
-    rawCache.mag_x = magEvent.magnetic.x;
-    rawCache.mag_y = magEvent.magnetic.y;
-    rawCache.mag_z = magEvent.magnetic.z;
+  if (pipeline.needsGyro()) {
+    if (!gyro.readGyro(rawCache.gyro_x, rawCache.gyro_y, rawCache.gyro_z)) {
+      sensorStats.gyroErrors++;
+    }
+  } else {
+    rawCache.gyro_x = rawCache.gyro_y = rawCache.gyro_z = 0.0f;
   }
 
-  rawCache.timestamp = millis();
+  rawCache.timestamp = clock.nowMs();
+  return true;
 }
 
-void SensorManager::applyKalmanFilter() {
-  if (!kalmanFilter) return;
-
-  float filtered_ax = kalmanFilter->update(CH_ACCEL_X, rawCache.accel_x);
-  float filtered_ay = kalmanFilter->update(CH_ACCEL_Y, rawCache.accel_y);
-  float filtered_az = kalmanFilter->update(CH_ACCEL_Z, rawCache.accel_z);
+void SensorManager::setAdaptiveRate(bool enabled) {
+  adaptiveRate = enabled;
+  lastMotionMs = clock.nowMs();
+  if (!enabled && !fastRate) {
+    fastRate = true;
+    applySampleInterval(UPDATE_INTERVAL_MS);
+  }
+}
 
-  float filtered_mx = kalmanFilter->update(CH_MAG_X, rawCache.mag_x);
-  float filtered_my = kalmanFilter->update(CH_MAG_Y, rawCache.mag_y);
-  float filtered_mz = kalmanFilter->update(CH_MAG_Z, rawCache.mag_z);
+void SensorManager::setRestIntervalMs(uint16_t intervalMs) {
+  if (intervalMs < UPDATE_INTERVAL_MS || intervalMs == restIntervalMs) return;
 
-  if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-    filteredCache.accel_x = filtered_ax;
-    filteredCache.accel_y = filtered_ay;
-    filteredCache.accel_z = filtered_az;
-    filteredCache.mag_x = filtered_mx;
-    filteredCache.mag_y = filtered_my;
-    filteredCache.mag_z = filtered_mz;
-    filteredCache.timestamp = millis();
-    filteredCache.valid = true;
-    xSemaphoreGive(mutex);
+  restIntervalMs = intervalMs;
+  if (!fastRate) {
+    applySampleInterval(restIntervalMs);
   }
 }
 
-void SensorManager::calculateOrientation() {
-  if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-    // Вычисляем базовые углы (без настроек)
-    filteredCache.roll = computeRoll(
-        filteredCache.accel_x, filteredCache.accel_y, filteredCache.accel_z);
+void SensorManager::updateSampleRate(unsigned long now) {
+  if (pipeline.getMotionLevel() > RATE_MOTION_THRESHOLD) {
+    lastMotionMs = now;
+  }
 
-    filteredCache.pitch = computePitch(
-        filteredCache.accel_x, filteredCache.accel_y, filteredCache.accel_z);
+  bool fast = !adaptiveRate || now - lastMotionMs < REST_HOLD_MS;
+  if (fast == fastRate) return;
 
-    xSemaphoreGive(mutex);
-  }
+  fastRate = fast;
+  sensorStats.rateSwitches++;
+  applySampleInterval(fast ? UPDATE_INTERVAL_MS : restIntervalMs);
 }
 
-void SensorManager::applyUserSettings() {
-  if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-    float roll = filteredCache.roll;
-    float pitch = filteredCache.pitch;
+void SensorManager::applySampleInterval(uint16_t intervalMs) {
+  updateIntervalMs = intervalMs;
+  lastUpdate = 0;  // Переход не считается пропуском
 
-    // 1. Применяем offset (добавляем к roll)
-    roll += zeroOffset;
+  // Одинаковый отклик во времени при любом периоде
+  pipeline.setSampleIntervalMs(intervalMs);
 
-    // 2. Применяем swap (меняем местами)
-    if (axisSwap) {
-      float temp = roll;
-      roll = pitch;
-      pitch = temp;
-    }
+  if (lsm303.setAccelOdrForInterval(intervalMs) == 0) {
+    sensorStats.accelErrors++;
+    Serial.println("WARNING: Failed to set accelerometer ODR");
+  }
 
-    // Сохраняем обработанные значения
-    filteredCache.roll = roll;
-    filteredCache.pitch = pitch;
+  if (debugMode) {
+    Serial.printf("Sample rate: %u ms, accel ODR %u Hz\n", intervalMs,
+                  lsm303.getAccelOdrHz());
+  }
+}
 
+void SensorManager::updateCache(const SensorData& data) {
+  if (xSemaphoreTake(mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+    filteredCache = data;
+    filteredCache.timestamp = clock.nowMs();
     xSemaphoreGive(mutex);
+
+    // Для индикатора, работающего от таймера. Пока фильтры не
+    // стабилизировались, индикатор не показывает переходный процесс.
+    if (isWarmedUp()) {
+      rollSnapshot.publish(data.roll, lastSampleMicros);
+    }
   }
 }
 
-void SensorManager::applyOffset(float& angle) { angle += zeroOffset; }
+void SensorManager::applyOffset(float& angle) {
+  angle += pipeline.getZeroOffset();
+}
 
 void SensorManager::applySwap(float& roll, float& pitch) {
-  if (axisSwap) {
+  if (pipeline.getAxisSwap()) {
     float temp = roll;
     roll = pitch;
     pitch = temp;
   }
 }
 
-void SensorManager::updateCache() {
-  // Кэш уже обновлён в предыдущих функциях
-}
-
-float SensorManager::computeRoll(float ax, float ay, float az) {
-  if (abs(az) < 0.01f && abs(ay) < 0.01f) {
-    return 0.0f;
-  }
-
-  float roll = atan2(ay, az) * 180.0f / PI;
-
-  while (roll > 180.0f) roll -= 360.0f;
-  while (roll < -180.0f) roll += 360.0f;
-
-  return roll;
-}
-
-float SensorManager::computePitch(float ax, float ay, float az) {
-  float pitch = atan2(-ax, sqrt(ay * ay + az * az)) * 180.0f / PI;
-
-  if (pitch > 90.0f) pitch = 90.0f;
-  if (pitch < -90.0f) pitch = -90.0f;
-
-  return pitch;
-}
-
 SensorData SensorManager::getCachedData() {
   SensorData data = {0};
 
@@ -299,19 +325,58 @@ float SensorManager::getPitch() {
   return pitch;
 }
 
+void SensorManager::setAccelCorrection(const AccelCorrection& correction) {
+  pipeline.setAccelCorrection(correction);
+}
+
+void SensorManager::setHeadingEnabled(bool enabled) {
+  pipeline.setMagEnabled(enabled && magAvailable);
+  Serial.printf("Heading %s\n", pipeline.isMagEnabled() ? "ON" : "OFF");
+}
+
+void SensorManager::setMagCorrection(const MagCorrection& correction) {
+  pipeline.setMagCorrection(correction);
+}
+
+bool SensorManager::startMagCalibration() {
+  if (!magAvailable) return false;
+  magCalibration.start();
+  Serial.println("Mag calibration: collecting, rotate the device");
+  return true;
+}
+
+void SensorManager::startAccelCapture(AccelCalibration::Position position) {
+  accelCalibration.start(position, clock.nowMs());
+  Serial.printf("Accel calibration: capturing %s\n",
+                AccelCalibration::positionName(position));
+}
+
+void SensorManager::setOrientationEngine(OrientationEngine::Type type) {
+  if (type >= OrientationEngine::TYPE_COUNT) type = OrientationEngine::ACCEL;
+  if (type != OrientationEngine::ACCEL && !gyroAvailable) {
+    Serial.printf("WARNING: %s orientation needs a gyroscope\n",
+                  OrientationEngine::typeName(type));
+    type = OrientationEngine::ACCEL;
+  }
+  pipeline.setOrientationEngine(type);
+  Serial.printf("Orientation engine: %s\n", OrientationEngine::typeName(type));
+}
+
+void SensorManager::setOutlierMode(OutlierRejector::Mode mode) {
+  pipeline.setOutlierMode(mode);
+  Serial.printf("Outlier rejection: %s\n",
+                OutlierRejector::modeName(pipeline.getOutlierMode()));
+}
+
 void SensorManager::setFilterProfile(
     MultiChannelKalman::FilterProfile profile) {
-  if (kalmanFilter) {
-    kalmanFilter->setProfile(profile);
-    Serial.println("Filter profile updated");
-  }
+  pipeline.setProfile(profile);
+  Serial.println("Filter profile updated");
 }
 
 void SensorManager::resetFilters() {
-  if (kalmanFilter) {
-    kalmanFilter->resetAll();
-    Serial.println("All filters reset");
-  }
+  pipeline.reset();
+  Serial.println("All filters reset");
 }
 
 void SensorManager::printFilterStats() {
@@ -320,13 +385,15 @@ void SensorManager::printFilterStats() {
 
   Serial.println("=== Sensor Statistics ===");
   Serial.printf("Update rate: %lu Hz\n", updateCount);
-  Serial.printf("Settings: offset=%.2f°, swap=%s\n", zeroOffset,
-                axisSwap ? "ON" : "OFF");
+  Serial.printf("Settings: offset=%.2f°, swap=%s\n", pipeline.getZeroOffset(),
+                pipeline.getAxisSwap() ? "ON" : "OFF");
   Serial.printf("Raw Roll: %.2f°, Pitch: %.2f°\n",
                 computeRoll(raw.accel_x, raw.accel_y, raw.accel_z),
                 computePitch(raw.accel_x, raw.accel_y, raw.accel_z));
   Serial.printf("Final Roll: %.2f°, Pitch: %.2f°\n", filtered.roll,
                 filtered.pitch);
+  Serial.printf("Outliers rejected: %lu\n",
+                (unsigned long)getOutlierRejector().getTotalRejected());
 
   updateCount = 0;
-}
\ No newline at end of file
+}
@@ -4,36 +4,26 @@
 #ifndef SENSOR_MANAGER_H
 #define SENSOR_MANAGER_H
 
-#include <Adafruit_LSM303_U.h>
-#include <Adafruit_Sensor.h>
 #include <Arduino.h>
-#include <LittleFS.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
-#include "NoiseKiller.h"
-
-// Структура для сырых данных датчиков
-struct SensorDataRaw {
-  float accel_x, accel_y, accel_z;
-  float mag_x, mag_y, mag_z;
-  unsigned long timestamp;
-};
-
-// Структура для обработанных данных
-struct SensorData {
-  float accel_x, accel_y, accel_z;
-  float mag_x, mag_y, mag_z;
-  unsigned long timestamp;
-
-  float roll;   // Крен (с учётом offset и swap)
-  float pitch;  // Тангаж (с учётом offset и swap)
-  bool valid;
-};
+#include "AccelCalibration.h"
+#include "AngleSnapshot.h"
+#include "Hal.h"
+#include "L3gd20.h"
+#include "Lsm303.h"
+#include "MagCalibration.h"
+#include "SensorPipeline.h"
+#include "SensorTypes.h"
 
 class SensorManager {
  public:
-  SensorManager(uint8_t sda_pin, uint8_t scl_pin);
+  /**
+   * @param i2c Шина с LSM303 и, если есть, L3GD20 (уже инициализирована)
+   * @param clock Источник времени сэмплов
+   */
+  SensorManager(HalI2c& i2c, HalClock& clock);
   ~SensorManager();
 
   /**
@@ -48,6 +38,13 @@ class SensorManager {
    */
   void update();
 
+  /**
+   * @brief Обработать один сэмпл без проверки интервала
+   * Для вызова из планировщика, который сам выдерживает период
+   * getUpdateIntervalMs()
+   */
+  void sample();
+
   /**
    * @brief Получить обработанные данные (с offset и swap)
    */
@@ -68,6 +65,58 @@ class SensorManager {
    */
   float getPitch();
 
+  /**
+   * @brief Lock-free снимок последнего roll (с offset и swap)
+   * Для чтения из таймера/другой задачи без захвата mutex
+   */
+  const AngleSnapshot& getRollSnapshot() const { return rollSnapshot; }
+
+  /**
+   * @brief micros() чтения датчиков для последнего сэмпла
+   */
+  uint32_t getLastSampleMicros() const { return lastSampleMicros; }
+
+  /**
+   * @brief Фильтры стабилизировались (снимок roll уже публикуется)
+   */
+  bool isWarmedUp() const { return sensorStats.samples >= WARMUP_SAMPLES; }
+
+  /**
+   * @brief Период опроса датчиков (мс)
+   */
+  uint16_t getUpdateIntervalMs() const { return updateIntervalMs; }
+
+  /**
+   * @brief Адаптивная частота опроса
+   * При движении - UPDATE_INTERVAL_MS, после REST_HOLD_MS покоя - период
+   * покоя. Вместе с периодом меняются ODR акселерометра, шум процесса
+   * фильтра Калмана и постоянная детектора движения.
+   */
+  void setAdaptiveRate(bool enabled);
+  bool isAdaptiveRate() const { return adaptiveRate; }
+  bool isFastRate() const { return fastRate; }
+
+  /**
+   * @brief Период опроса в покое (задаёт режим питания)
+   */
+  void setRestIntervalMs(uint16_t intervalMs);
+
+  /**
+   * @brief Текущая частота выдачи данных акселерометром (Гц)
+   */
+  uint16_t getAccelOdrHz() const { return lsm303.getAccelOdrHz(); }
+
+  /**
+   * @brief Уровень движения: СКО вектора ускорения от среднего (м/с²)
+   * Около шума датчика в покое, растёт при наклоне и тряске.
+   */
+  float getMotionLevel() const { return pipeline.getMotionLevel(); }
+
+  /**
+   * @brief Счётчики для метрик
+   */
+  SensorStats getStats() const { return sensorStats; }
+
   /**
    * @brief Загрузить настройки из файлов (offset, swap)
    * Вызывается автоматически в begin()
@@ -84,6 +133,66 @@ class SensorManager {
    */
   void applySwap(float& roll, float& pitch);
 
+  /**
+   * @brief Поправка акселерометра (сразу в горячем пути)
+   */
+  void setAccelCorrection(const AccelCorrection& correction);
+
+  /**
+   * @brief Начать накопление положения калибровки акселерометра
+   * Копится по сэмплам sample(), пока устройство неподвижно.
+   */
+  void startAccelCapture(AccelCalibration::Position position);
+  void resetAccelCalibration() { accelCalibration.reset(); }
+  const AccelCalibration& getAccelCalibration() const {
+    return accelCalibration;
+  }
+
+  /**
+   * @brief Курс по магнитометру
+   * Выключен - магнитометр не читается и не фильтруется (экономия шины
+   * и CPU на каждом сэмпле). Без найденного магнитометра не включается.
+   */
+  void setHeadingEnabled(bool enabled);
+  bool isHeadingEnabled() const { return pipeline.isMagEnabled(); }
+  bool isMagAvailable() const { return magAvailable; }
+
+  /**
+   * @brief Поправка hard/soft-iron (сразу в горячем пути)
+   */
+  void setMagCorrection(const MagCorrection& correction);
+
+  /**
+   * @brief Сбор показаний для подгонки эллипсоида (устройство вращают)
+   * Пока идёт сбор, магнитометр читается и при выключенном курсе.
+   */
+  bool startMagCalibration();
+  void stopMagCalibration() { magCalibration.stop(); }
+  const MagCalibration& getMagCalibration() const { return magCalibration; }
+
+  /**
+   * @brief Движок ориентации
+   * Движкам с гироскопом нужен L3GD20: без него остаётся ACCEL. Гироскоп
+   * читается, только пока он нужен активному движку.
+   */
+  void setOrientationEngine(OrientationEngine::Type type);
+  OrientationEngine::Type getOrientationEngine() const {
+    return pipeline.getOrientationEngine();
+  }
+  bool isGyroAvailable() const { return gyroAvailable; }
+
+  /**
+   * @brief Отбраковка выбросов (удары) перед фильтром Калмана
+   * Счётчики по каналам показывают, насколько "шумное" место установки.
+   */
+  void setOutlierMode(OutlierRejector::Mode mode);
+  OutlierRejector::Mode getOutlierMode() const {
+    return pipeline.getOutlierMode();
+  }
+  const OutlierRejector& getOutlierRejector() const {
+    return pipeline.getOutlierRejector();
+  }
+
   /**
    * @brief Изменить профиль фильтрации
    */
@@ -111,54 +220,63 @@ class SensorManager {
 
  private:
   // Датчики
-  Adafruit_LSM303_Accel_Unified accel;
-  Adafruit_LSM303_Mag_Unified mag;
+  HalI2c& i2c;
+  HalClock& clock;
+  Lsm303 lsm303;
+  L3gd20 gyro;
+  bool gyroAvailable;  // Ответил при инициализации
+
+  // Фильтр Калмана, углы, поправки
+  SensorPipeline pipeline;
+
+  // Сбор положений калибровки акселерометра (сырые данные)
+  AccelCalibration accelCalibration;
 
-  // Фильтр Калмана
-  MultiChannelKalman* kalmanFilter;
+  // Магнитометр ответил при инициализации; сбор для его калибровки
+  bool magAvailable;
+  MagCalibration magCalibration;
 
   // Кэш данных
   SensorData filteredCache;
   SensorDataRaw rawCache;
   SemaphoreHandle_t mutex;
+  AngleSnapshot rollSnapshot;
+  uint32_t lastSampleMicros;  // micros() последнего чтения датчиков
 
   // Настройки
-  uint8_t sdaPin, sclPin;
   bool initialized;
   bool debugMode;
 
-  // Пользовательские настройки (из файлов)
-  float zeroOffset;  // Поправка на 0°
-  bool axisSwap;     // Поменять roll ↔ pitch
-
   // Контроль частоты
   unsigned long lastUpdate;
-  static const uint16_t UPDATE_INTERVAL_MS = 20;  // 50 Гц
+  static const uint16_t UPDATE_INTERVAL_MS = 20;  // 50 Гц (по умолчанию)
+  uint16_t updateIntervalMs;
+
+  // Адаптивная частота
+  static const uint16_t REST_INTERVAL_MS = 100;   // 10 Гц в покое
+  static const uint16_t REST_HOLD_MS = 2000;      // Покой до замедления
+  static constexpr float RATE_MOTION_THRESHOLD = 0.05f;  // м/с²
+  bool adaptiveRate;
+  bool fastRate;
+  uint16_t restIntervalMs;
+  unsigned long lastMotionMs;
+
+  // Сэмплов на стабилизацию фильтров до первой публикации угла
+  static const uint8_t WARMUP_SAMPLES = 20;
 
   // Статистика
   unsigned long updateCount;
   unsigned long lastStatsTime;
-
-  // Индексы каналов фильтра
-  enum FilterChannels {
-    CH_ACCEL_X = 0,
-    CH_ACCEL_Y = 1,
-    CH_ACCEL_Z = 2,
-    CH_MAG_X = 3,
-    CH_MAG_Y = 4,
-    CH_MAG_Z = 5
-  };
+  SensorStats sensorStats;
+  uint32_t rateWindowStart;    // Начало окна подсчёта частоты (мс)
+  uint32_t rateWindowSamples;  // Сэмплов в текущем окне
 
   // Вспомогательные функции
   bool initSensors();
-  void readRawData();
-  void applyKalmanFilter();
-  void calculateOrientation();
-  void applyUserSettings();
-  void updateCache();
-
-  float computeRoll(float ax, float ay, float az);
-  float computePitch(float ax, float ay, float az);
+  bool readRawData();
+  void updateSampleRate(unsigned long now);
+  void applySampleInterval(uint16_t intervalMs);
+  void updateCache(const SensorData& data);
 };
 
 #endif  // SENSOR_MANAGER_H
\ No newline at end of file
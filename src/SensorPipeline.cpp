@@ -0,0 +1,275 @@
+// SensorPipeline.cpp
+#include "SensorPipeline.h"
+
+#include <math.h>
+
+#include "Orientation.h"
+
+namespace {
+
+const char* const CHANNEL_NAMES[] = {"accel_x", "accel_y", "accel_z",
+                                     "mag_x",   "mag_y",   "mag_z"};
+
+}  // namespace
+
+SensorPipeline::SensorPipeline(MultiChannelKalman::FilterProfile profile)
+    : kalman(CH_COUNT, profile),
+      outlierRejector(CH_COUNT),
+      samples(0),
+      zeroOffset(0.0f),
+      axisSwap(false),
+      accelScale{1.0f, 1.0f, 1.0f},
+      accelOffset{0.0f, 0.0f, 0.0f},
+      magEnabled(true),
+      magRestart(false),
+      magCorrection(MagCorrection::identity()),
+      engineType(OrientationEngine::ACCEL),
+      lastTimestamp(0),
+      intervalS(REFERENCE_INTERVAL_MS / 1000.0f),
+      gyroBiasReady(false),
+      gyroBias{0.0f, 0.0f, 0.0f},
+      gyroSum{0.0f, 0.0f, 0.0f},
+      gyroRestS(0.0f),
+      gyroRestSamples(0),
+      motionAlpha(0.1f),
+      motionMeanX(0.0f),
+      motionMeanY(0.0f),
+      motionMeanZ(0.0f),
+      motionVariance(0.0f),
+      motionLevel(0.0f),
+      motionThreshold(profileMotionThreshold(profile)),
+      intervalScale(1.0f) {
+  setSampleIntervalMs(REFERENCE_INTERVAL_MS);
+  for (uint8_t ch = CH_ACCEL_X; ch <= CH_ACCEL_Z; ch++) {
+    outlierRejector.setNoiseFloor(ch, ACCEL_NOISE_FLOOR);
+  }
+  for (uint8_t ch = CH_MAG_X; ch <= CH_MAG_Z; ch++) {
+    outlierRejector.setNoiseFloor(ch, MAG_NOISE_FLOOR);
+  }
+}
+
+void SensorPipeline::filter(const SensorDataRaw& raw, SensorData& out) {
+  samples++;
+
+  // Уровень движения - с прошлого сэмпла
+  if (motionThreshold > 0.0f) {
+    kalman.setProcessNoiseScale(motionLevel > motionThreshold
+                                    ? intervalScale * MOTION_NOISE_GAIN
+                                    : intervalScale);
+  }
+
+  // Поправка до фильтра: одно умножение-сложение на ось (madd.s на ESP32)
+  float accel[3] = {fmaf(raw.accel_x, accelScale[0], accelOffset[0]),
+                    fmaf(raw.accel_y, accelScale[1], accelOffset[1]),
+                    fmaf(raw.accel_z, accelScale[2], accelOffset[2])};
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    accel[axis] = rejectOutlier(CH_ACCEL_X + axis, accel[axis]);
+  }
+  out.accel_x = kalman.update(CH_ACCEL_X, accel[0]);
+  out.accel_y = kalman.update(CH_ACCEL_Y, accel[1]);
+  out.accel_z = kalman.update(CH_ACCEL_Z, accel[2]);
+
+  if (magEnabled) {
+    const float d[3] = {raw.mag_x - magCorrection.offset[0],
+                        raw.mag_y - magCorrection.offset[1],
+                        raw.mag_z - magCorrection.offset[2]};
+    float m[3];
+    for (int i = 0; i < 3; i++) {
+      const float* row = magCorrection.matrix[i];
+      m[i] = row[0] * d[0] + row[1] * d[1] + row[2] * d[2];
+    }
+
+    if (magRestart) {
+      kalman.reset(CH_MAG_X, m[0]);
+      kalman.reset(CH_MAG_Y, m[1]);
+      kalman.reset(CH_MAG_Z, m[2]);
+      for (uint8_t ch = CH_MAG_X; ch <= CH_MAG_Z; ch++) {
+        outlierRejector.resetChannel(ch);
+      }
+      magRestart = false;
+    }
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      m[axis] = rejectOutlier(CH_MAG_X + axis, m[axis]);
+    }
+    out.mag_x = kalman.update(CH_MAG_X, m[0]);
+    out.mag_y = kalman.update(CH_MAG_Y, m[1]);
+    out.mag_z = kalman.update(CH_MAG_Z, m[2]);
+  } else {
+    out.mag_x = out.mag_y = out.mag_z = 0.0f;
+  }
+
+  out.timestamp = raw.timestamp;
+  out.valid = true;
+
+  updateMotion(out.accel_x, out.accel_y, out.accel_z);
+  updateOrientation(raw, accel, out);
+}
+
+float SensorPipeline::rejectOutlier(uint8_t channel, float value) {
+  // getValue - оценка после прошлого сэмпла, до этого измерения
+  return outlierRejector.apply(channel, value, kalman.getValue(channel));
+}
+
+void SensorPipeline::updateOrientation(const SensorDataRaw& raw,
+                                       const float accel[3],
+                                       const SensorData& out) {
+  OrientationEngine& engine = activeEngine();
+
+  OrientationInput input;
+  input.dt = (raw.timestamp - lastTimestamp) / 1000.0f;
+  if (samples <= 1 || input.dt <= 0.0f || input.dt > MAX_STEP_S) {
+    input.dt = intervalS;
+  }
+  lastTimestamp = raw.timestamp;
+
+  input.filtered[0] = out.accel_x;
+  input.filtered[1] = out.accel_y;
+  input.filtered[2] = out.accel_z;
+  for (int axis = 0; axis < 3; axis++) input.accel[axis] = accel[axis];
+
+  if (engine.needsGyro()) {
+    const float gyro[3] = {raw.gyro_x, raw.gyro_y, raw.gyro_z};
+    if (!gyroBiasReady) estimateGyroBias(gyro, input.dt);
+    for (int axis = 0; axis < 3; axis++) {
+      input.gyro[axis] = gyroBiasReady ? gyro[axis] - gyroBias[axis] : 0.0f;
+    }
+  } else {
+    input.gyro[0] = input.gyro[1] = input.gyro[2] = 0.0f;
+  }
+
+  engine.update(input);
+}
+
+void SensorPipeline::estimateGyroBias(const float gyro[3], float dt) {
+  // В покое гироскоп показывает только смещение нуля
+  if (samples <= 1 || motionLevel > GYRO_REST_MOTION) {
+    gyroSum[0] = gyroSum[1] = gyroSum[2] = 0.0f;
+    gyroRestS = 0.0f;
+    gyroRestSamples = 0;
+    return;
+  }
+
+  for (int axis = 0; axis < 3; axis++) gyroSum[axis] += gyro[axis];
+  gyroRestSamples++;
+  gyroRestS += dt;
+  if (gyroRestS < GYRO_BIAS_S) return;
+
+  for (int axis = 0; axis < 3; axis++) {
+    gyroBias[axis] = gyroSum[axis] / gyroRestSamples;
+  }
+  gyroBiasReady = true;
+}
+
+void SensorPipeline::orient(SensorData& data) const {
+  // Базовые углы (без настроек) по вектору "вверх" движка
+  float up[3];
+  activeEngine().getGravity(up);
+  data.roll = computeRoll(up[0], up[1], up[2]);
+  data.pitch = computePitch(up[0], up[1], up[2]);
+  data.heading = magEnabled ? computeHeading(up[0], up[1], up[2], data.mag_x,
+                                             data.mag_y, data.mag_z)
+                            : 0.0f;
+}
+
+const OrientationEngine& SensorPipeline::activeEngine() const {
+  switch (engineType) {
+    case OrientationEngine::COMPLEMENTARY:
+      return complementaryEngine;
+    case OrientationEngine::MAHONY:
+      return mahonyEngine;
+    default:
+      return accelEngine;
+  }
+}
+
+void SensorPipeline::setOrientationEngine(OrientationEngine::Type type) {
+  if (type >= OrientationEngine::TYPE_COUNT) type = OrientationEngine::ACCEL;
+  engineType = type;
+  activeEngine().reset();
+}
+
+void SensorPipeline::applySettings(SensorData& data) const {
+  applyZeroAndSwap(data.roll, data.pitch, zeroOffset, axisSwap);
+}
+
+const char* SensorPipeline::channelName(uint8_t channel) {
+  return channel < CH_COUNT ? CHANNEL_NAMES[channel] : "unknown";
+}
+
+void SensorPipeline::setUserSettings(float offset, bool swap) {
+  zeroOffset = offset;
+  axisSwap = swap;
+}
+
+void SensorPipeline::setAccelCorrection(const AccelCorrection& correction) {
+  for (int axis = 0; axis < 3; axis++) {
+    accelScale[axis] = correction.scale[axis];
+    accelOffset[axis] = -correction.bias[axis] * correction.scale[axis];
+  }
+}
+
+void SensorPipeline::setMagEnabled(bool enabled) {
+  if (enabled && !magEnabled) magRestart = true;
+  magEnabled = enabled;
+}
+
+void SensorPipeline::setSampleIntervalMs(uint16_t intervalMs) {
+  if (intervalMs == 0) return;
+
+  intervalScale = (float)intervalMs / REFERENCE_INTERVAL_MS;
+  kalman.setProcessNoiseScale(intervalScale);
+  motionAlpha = 1.0f - expf(-intervalMs / MOTION_TAU_MS);
+  intervalS = intervalMs / 1000.0f;
+}
+
+void SensorPipeline::updateMotion(float ax, float ay, float az) {
+  if (samples <= 1) {
+    motionMeanX = ax;
+    motionMeanY = ay;
+    motionMeanZ = az;
+    return;
+  }
+
+  float dx = ax - motionMeanX;
+  float dy = ay - motionMeanY;
+  float dz = az - motionMeanZ;
+  motionMeanX += motionAlpha * dx;
+  motionMeanY += motionAlpha * dy;
+  motionMeanZ += motionAlpha * dz;
+
+  // Экспоненциально взвешенная дисперсия
+  float squared = dx * dx + dy * dy + dz * dz;
+  motionVariance =
+      (1.0f - motionAlpha) * (motionVariance + motionAlpha * squared);
+  motionLevel = sqrtf(motionVariance);
+}
+
+void SensorPipeline::setMotionThreshold(float threshold) {
+  motionThreshold = threshold;
+  kalman.setProcessNoiseScale(intervalScale);
+}
+
+float SensorPipeline::profileMotionThreshold(
+    MultiChannelKalman::FilterProfile profile) {
+#ifdef HAS_TUNED_PROFILE
+  if (profile == MultiChannelKalman::TUNED) {
+    return TunedFilterProfile::MOTION_THRESHOLD;
+  }
+#endif
+  (void)profile;
+  return 0.0f;
+}
+
+void SensorPipeline::setProfile(MultiChannelKalman::FilterProfile profile) {
+  kalman.setProfile(profile);
+  setMotionThreshold(profileMotionThreshold(profile));
+}
+
+void SensorPipeline::reset() {
+  kalman.resetAll();
+  outlierRejector.reset();
+  activeEngine().reset();
+  samples = 0;
+  motionVariance = 0.0f;
+  motionLevel = 0.0f;
+}
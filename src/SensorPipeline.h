@@ -0,0 +1,214 @@
+// SensorPipeline.h
+// Обработка сэмпла: выбросы, фильтр Калмана, движение, ориентация, поправки
+
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include "AccelCalibration.h"
+#include "MagCalibration.h"
+#include "NoiseKiller.h"
+#include "OrientationEngine.h"
+#include "OutlierRejector.h"
+#include "SensorTypes.h"
+
+/**
+ * @brief Обработка сырых данных без обращения к железу
+ *
+ * Одна и та же цепочка работает в SensorManager на устройстве и в
+ * сборке env:native на ПК.
+ */
+class SensorPipeline {
+ public:
+  // Период, под который подобраны профили фильтра
+  static const uint16_t REFERENCE_INTERVAL_MS = 20;
+
+  // Константы ниже общие с этапами tools/pipeline_bench/PipelineStages.h
+
+  // Шум датчиков - нижняя граница порога выбросов
+  static constexpr float ACCEL_NOISE_FLOOR = 0.05f;  // м/с²
+  static constexpr float MAG_NOISE_FLOOR = 0.5f;     // мкТл
+
+  // Постоянная времени детектора движения
+  static constexpr float MOTION_TAU_MS = 190.0f;  // alpha = 0.1 при 20 мс
+
+  // Шум процесса фильтра при движении выше порога (setMotionThreshold)
+  static constexpr float MOTION_NOISE_GAIN = 10.0f;
+
+  // Дольше - сэмплы считаются разрывом, шаг берётся из периода
+  static constexpr float MAX_STEP_S = 0.5f;
+
+  // Смещение нуля гироскопа: среднее за GYRO_BIAS_S без движения
+  // (движение - накопление заново). Дрейф потом ведут сами движки.
+  static constexpr float GYRO_BIAS_S = 1.0f;
+  static constexpr float GYRO_REST_MOTION = 0.05f;  // м/с²
+
+  explicit SensorPipeline(MultiChannelKalman::FilterProfile profile =
+                              MultiChannelKalman::BALANCED);
+
+  /**
+   * @brief Полный проход: выбросы -> фильтр -> движение -> углы ->
+   * offset/swap
+   */
+  void process(const SensorDataRaw& raw, SensorData& out) {
+    filter(raw, out);
+    orient(out);
+    applySettings(out);
+  }
+
+  // Этапы по отдельности (для замеров). Движок ориентации обновляется
+  // в filter(), orient() только переводит его вектор в углы.
+  void filter(const SensorDataRaw& raw, SensorData& out);
+  void orient(SensorData& data) const;
+  void applySettings(SensorData& data) const;
+
+  /**
+   * @brief Поправка нуля и перестановка осей
+   */
+  void setUserSettings(float zeroOffset, bool axisSwap);
+  float getZeroOffset() const { return zeroOffset; }
+  bool getAxisSwap() const { return axisSwap; }
+
+  /**
+   * @brief Поправка смещения и масштаба осей акселерометра (до фильтра)
+   */
+  void setAccelCorrection(const AccelCorrection& correction);
+
+  /**
+   * @brief Магнитометр и курс
+   * Выключенный магнитометр не фильтруется, mag_* и heading - нули.
+   * После включения фильтры каналов стартуют с первого показания.
+   */
+  void setMagEnabled(bool enabled);
+  bool isMagEnabled() const { return magEnabled; }
+
+  /**
+   * @brief Поправка hard/soft-iron магнитометра (до фильтра)
+   */
+  void setMagCorrection(const MagCorrection& correction) {
+    magCorrection = correction;
+  }
+
+  /**
+   * @brief Движок ориентации (крен, тангаж, наклон для курса)
+   * Движки с гироскопом берут ускорение до фильтра Калмана и gyro_*
+   * без смещения нуля, усреднённого за первые GYRO_BIAS_S покоя (до
+   * этого - нули). Новый движок стартует со следующего сэмпла.
+   */
+  void setOrientationEngine(OrientationEngine::Type type);
+  OrientationEngine::Type getOrientationEngine() const { return engineType; }
+  bool needsGyro() const { return activeEngine().needsGyro(); }
+
+  /**
+   * @brief Смещение нуля гироскопа (рад/с)
+   */
+  bool isGyroBiasReady() const { return gyroBiasReady; }
+  const float* getGyroBias() const { return gyroBias; }
+
+  /**
+   * @brief Отбраковка выбросов перед фильтром Калмана
+   * Движки ориентации получают ускорение уже без выбросов.
+   */
+  void setOutlierMode(OutlierRejector::Mode mode) {
+    outlierRejector.setMode(mode);
+  }
+  OutlierRejector::Mode getOutlierMode() const {
+    return outlierRejector.getMode();
+  }
+  const OutlierRejector& getOutlierRejector() const { return outlierRejector; }
+
+  // Имя канала фильтра и OutlierRejector: accel_x ... mag_z
+  static const char* channelName(uint8_t channel);
+
+  /**
+   * @brief Период опроса: шум процесса и постоянная детектора движения
+   * пересчитываются, чтобы отклик во времени не зависел от частоты
+   */
+  void setSampleIntervalMs(uint16_t intervalMs);
+
+  /**
+   * @brief Уровень движения: СКО вектора ускорения от среднего (м/с²)
+   */
+  float getMotionLevel() const { return motionLevel; }
+
+  /**
+   * @brief Порог уровня движения (м/с²) для шума процесса x
+   * MOTION_NOISE_GAIN: в покое сильное сглаживание, в движении малая
+   * задержка. 0 - выключено; профиль задаёт свой порог (setProfile)
+   */
+  void setMotionThreshold(float threshold);
+  float getMotionThreshold() const { return motionThreshold; }
+  static float profileMotionThreshold(
+      MultiChannelKalman::FilterProfile profile);
+
+  void setProfile(MultiChannelKalman::FilterProfile profile);
+  void reset();
+
+  MultiChannelKalman& getFilter() { return kalman; }
+  uint32_t getSampleCount() const { return samples; }
+
+ private:
+  // Индексы каналов фильтра (они же - каналы OutlierRejector)
+  enum FilterChannels {
+    CH_ACCEL_X = 0,
+    CH_ACCEL_Y = 1,
+    CH_ACCEL_Z = 2,
+    CH_MAG_X = 3,
+    CH_MAG_Y = 4,
+    CH_MAG_Z = 5,
+    CH_COUNT = 6
+  };
+
+  MultiChannelKalman kalman;
+  OutlierRejector outlierRejector;
+  uint32_t samples;
+
+  // Пользовательские настройки
+  float zeroOffset;
+  bool axisSwap;
+
+  // Поправка акселерометра: a = raw * accelScale + accelOffset
+  float accelScale[3];
+  float accelOffset[3];
+
+  // Магнитометр
+  bool magEnabled;
+  bool magRestart;  // Следующий сэмпл задаёт начальное состояние фильтров
+  MagCorrection magCorrection;
+
+  // Движки ориентации; активный - по engineType
+  AccelOrientation accelEngine;
+  ComplementaryOrientation complementaryEngine;
+  MahonyOrientation mahonyEngine;
+  OrientationEngine::Type engineType;
+  unsigned long lastTimestamp;
+  float intervalS;  // Шаг, если по отметкам времени его не понять
+
+  // Смещение нуля гироскопа (GYRO_BIAS_S покоя)
+  bool gyroBiasReady;
+  float gyroBias[3];
+  float gyroSum[3];
+  float gyroRestS;
+  uint32_t gyroRestSamples;
+
+  // Детектор движения (EMA среднего и дисперсии ускорения), alpha - по
+  // MOTION_TAU_MS и периоду
+  float motionAlpha;
+  float motionMeanX, motionMeanY, motionMeanZ;
+  float motionVariance;
+  float motionLevel;
+  float motionThreshold;
+  float intervalScale;  // Шум процесса под период опроса
+
+  float rejectOutlier(uint8_t channel, float value);
+  void updateMotion(float ax, float ay, float az);
+  void updateOrientation(const SensorDataRaw& raw, const float accel[3],
+                         const SensorData& out);
+  void estimateGyroBias(const float gyro[3], float dt);
+  const OrientationEngine& activeEngine() const;
+  OrientationEngine& activeEngine() {
+    const SensorPipeline* self = this;
+    return const_cast<OrientationEngine&>(self->activeEngine());
+  }
+};
+
+#endif  // SENSOR_PIPELINE_H
@@ -0,0 +1,418 @@
+// SensorSimulator.cpp
+#include "SensorSimulator.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+const float PI_F = 3.14159265f;
+const float DEG_TO_RAD_F = PI_F / 180.0f;
+
+// Генератор шума гироскопа отделён от основного своим seed
+const uint32_t GYRO_SEED_MIX = 0x9E3779B9u;
+
+// Встроенные сценарии: ориентация на конец отрезка, см. MotionSegment
+const MotionSegment SCRIPT_STATIC[] = {
+    {MotionSegment::MOTION_STATIC, 60000, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+};
+
+const MotionSegment SCRIPT_SLOW_TILT[] = {
+    {MotionSegment::MOTION_STATIC, 2000, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {MotionSegment::MOTION_TILT, 10000, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {MotionSegment::MOTION_STATIC, 2000, 10.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {MotionSegment::MOTION_TILT, 20000, -10.0f, 5.0f, 30.0f, 0.0f, 0.0f},
+    {MotionSegment::MOTION_STATIC, 2000, -10.0f, 5.0f, 30.0f, 0.0f, 0.0f},
+    {MotionSegment::MOTION_TILT, 10000, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+};
+
+// Станок/двигатель рядом: 2 м/с² на 25 Гц при крене 2°
+const MotionSegment SCRIPT_VIBRATION[] = {
+    {MotionSegment::MOTION_VIBRATION, 10000, 2.0f, 0.0f, 0.0f, 2.0f, 25.0f},
+};
+
+// Удары молотком: 15 м/с² каждые ~2 с при крене 1°. Удар короче периода
+// опроса 20 мс; период ударов 2.006 с сдвигает фазу сэмпла в ударе на 6 мс
+// от удара к удару (при ровно 2 с сэмпл всегда попадал в ноль полусинуса).
+const MotionSegment SCRIPT_IMPACTS[] = {
+    {MotionSegment::MOTION_IMPACTS, 10000, 1.0f, 0.0f, 0.0f, 15.0f, 0.4985f},
+};
+
+struct ProfileEntry {
+  const char* name;
+  const MotionSegment* script;
+  size_t length;
+};
+
+#define SCRIPT_ENTRY(name, script) \
+  { name, script, sizeof(script) / sizeof(script[0]) }
+
+const ProfileEntry PROFILES[SensorSimulator::PROFILE_COUNT] = {
+    SCRIPT_ENTRY("static", SCRIPT_STATIC),
+    SCRIPT_ENTRY("slow_tilt", SCRIPT_SLOW_TILT),
+    SCRIPT_ENTRY("vibration", SCRIPT_VIBRATION),
+    SCRIPT_ENTRY("impacts", SCRIPT_IMPACTS),
+};
+
+#undef SCRIPT_ENTRY
+
+/**
+ * @brief Вектор мира -> система датчика: Rx(-roll) Ry(-pitch) Rz(heading)
+ *
+ * Мир: X на север, Y на запад, Z вверх; курс отсчитывается по часовой.
+ */
+void worldToBody(const float world[3], float roll, float pitch,
+                 float heading, float body[3]) {
+  float ch = cosf(heading), sh = sinf(heading);
+  float x = ch * world[0] - sh * world[1];
+  float y = sh * world[0] + ch * world[1];
+  float z = world[2];
+
+  float cp = cosf(pitch), sp = sinf(pitch);
+  float x2 = cp * x - sp * z;
+  float z2 = sp * x + cp * z;
+
+  float cr = cosf(roll), sr = sinf(roll);
+  body[0] = x2;
+  body[1] = cr * y + sr * z2;
+  body[2] = -sr * y + cr * z2;
+}
+
+}  // namespace
+
+// ========== SensorSimulator ==========
+
+SensorSimulator::SensorSimulator(Profile profile, uint32_t seed)
+    : script(nullptr),
+      scriptLength(0),
+      loopScript(true),
+      noise(defaultNoise()),
+      seed(seed) {
+  setProfile(profile);
+  reset(seed);
+}
+
+void SensorSimulator::setScript(const MotionSegment* segments, size_t count,
+                                bool loop) {
+  script = segments;
+  scriptLength = count;
+  loopScript = loop;
+  reset(seed);
+}
+
+void SensorSimulator::setProfile(Profile profile) {
+  if (profile >= PROFILE_COUNT) profile = PROFILE_STATIC;
+  setScript(PROFILES[profile].script, PROFILES[profile].length, true);
+}
+
+void SensorSimulator::reset(uint32_t seed) {
+  this->seed = seed;
+  started = false;
+  lastTimeUs = 0;
+  elapsedUs = 0;
+  segmentStartUs = 0;
+  segmentIndex = 0;
+
+  startRoll = startPitch = startHeading = 0.0f;
+  trueRoll = truePitch = trueHeading = 0.0f;
+  disturbed = false;
+
+  hasLastBody = false;
+  lastBodyUs = 0;
+  rate[0] = rate[1] = rate[2] = 0.0f;
+
+  noiseSource.seed(seed);
+  gyroSource.seed(seed ^ GYRO_SEED_MIX);
+}
+
+bool SensorSimulator::advance() {
+  while (segmentIndex < scriptLength) {
+    const MotionSegment& segment = script[segmentIndex];
+    uint64_t durationUs = (uint64_t)segment.durationMs * 1000;
+    if (elapsedUs - segmentStartUs < durationUs) return true;
+
+    startRoll = segment.rollDeg;
+    startPitch = segment.pitchDeg;
+    startHeading = segment.headingDeg;
+    segmentStartUs += durationUs;
+    segmentIndex++;
+
+    if (segmentIndex == scriptLength && loopScript && durationUs > 0) {
+      segmentIndex = 0;
+    }
+  }
+  return false;
+}
+
+void SensorSimulator::linearAcceleration(const MotionSegment& segment,
+                                         float t, float out[3]) {
+  out[0] = out[1] = out[2] = 0.0f;
+
+  if (segment.motion == MotionSegment::MOTION_VIBRATION) {
+    // В основном вертикально, поперечные составляющие со сдвигом фазы
+    float phase = 2.0f * PI_F * segment.frequencyHz * t;
+    out[0] = 0.5f * segment.amplitude * sinf(phase + 1.0f);
+    out[1] = 0.5f * segment.amplitude * sinf(phase + 2.0f);
+    out[2] = segment.amplitude * sinf(phase);
+    disturbed = segment.amplitude != 0.0f;
+    return;
+  }
+
+  if (segment.motion == MotionSegment::MOTION_IMPACTS &&
+      segment.frequencyHz > 0.0f) {
+    // Полусинус IMPACT_WIDTH_MS по X, знак чередуется от удара к удару
+    float period = 1.0f / segment.frequencyHz;
+    uint32_t index = (uint32_t)(t / period);
+    float inPulse = t - index * period;
+    float width = IMPACT_WIDTH_MS / 1000.0f;
+    if (inPulse < width) {
+      float pulse = segment.amplitude * sinf(PI_F * inPulse / width);
+      out[0] = (index & 1) ? -pulse : pulse;
+      out[2] = 0.3f * pulse;
+      disturbed = true;
+    }
+  }
+}
+
+bool SensorSimulator::sample(uint32_t timeUs, SensorDataRaw& out) {
+  if (!started) {
+    started = true;
+    lastTimeUs = timeUs;
+  }
+  elapsedUs += (uint32_t)(timeUs - lastTimeUs);  // Переживает переполнение
+  lastTimeUs = timeUs;
+
+  bool running = scriptLength > 0 && advance();
+  disturbed = false;
+
+  float linear[3] = {0.0f, 0.0f, 0.0f};
+  if (running) {
+    const MotionSegment& segment = script[segmentIndex];
+    float t = (elapsedUs - segmentStartUs) / 1e6f;
+
+    if (segment.motion == MotionSegment::MOTION_TILT &&
+        segment.durationMs > 0) {
+      // Косинусный профиль: без рывков в начале и конце наклона
+      float s = t * 1000.0f / segment.durationMs;
+      float w = 0.5f - 0.5f * cosf(PI_F * s);
+      trueRoll = startRoll + (segment.rollDeg - startRoll) * w;
+      truePitch = startPitch + (segment.pitchDeg - startPitch) * w;
+      trueHeading = startHeading + (segment.headingDeg - startHeading) * w;
+    } else {
+      trueRoll = segment.rollDeg;
+      truePitch = segment.pitchDeg;
+      trueHeading = segment.headingDeg;
+    }
+    linearAcceleration(segment, t, linear);
+  } else {
+    trueRoll = startRoll;  // Сценарий закончился - стоим в конечной точке
+    truePitch = startPitch;
+    trueHeading = startHeading;
+  }
+
+  float roll = trueRoll * DEG_TO_RAD_F;
+  float pitch = truePitch * DEG_TO_RAD_F;
+  float heading = trueHeading * DEG_TO_RAD_F;
+
+  // Акселерометр в покое показывает +g вверх
+  const float gravityWorld[3] = {0.0f, 0.0f, GRAVITY};
+  const float fieldWorld[3] = {FIELD_NORTH_UT, 0.0f, -FIELD_DOWN_UT};
+  float accel[3], mag[3];
+  worldToBody(gravityWorld, roll, pitch, heading, accel);
+  worldToBody(fieldWorld, roll, pitch, heading, mag);
+  updateRate(roll, pitch, heading);
+
+  NoiseSource& n = noiseSource;
+  out.accel_x = accel[0] + linear[0] + noise.accelBias[0] +
+                noise.accelSigma * n.gaussian();
+  out.accel_y = accel[1] + linear[1] + noise.accelBias[1] +
+                noise.accelSigma * n.gaussian();
+  out.accel_z = accel[2] + linear[2] + noise.accelBias[2] +
+                noise.accelSigma * n.gaussian();
+  out.mag_x = mag[0] + noise.magBias[0] + noise.magSigma * n.gaussian();
+  out.mag_y = mag[1] + noise.magBias[1] + noise.magSigma * n.gaussian();
+  out.mag_z = mag[2] + noise.magBias[2] + noise.magSigma * n.gaussian();
+  out.gyro_x = rate[0] + noise.gyroBias[0] +
+               noise.gyroSigma * gyroSource.gaussian();
+  out.gyro_y = rate[1] + noise.gyroBias[1] +
+               noise.gyroSigma * gyroSource.gaussian();
+  out.gyro_z = rate[2] + noise.gyroBias[2] +
+               noise.gyroSigma * gyroSource.gaussian();
+  out.timestamp = (unsigned long)(elapsedUs / 1000);
+
+  return running;
+}
+
+void SensorSimulator::updateRate(float roll, float pitch, float heading) {
+  // Столбцы матрицы мир -> датчик - образы базисных векторов мира
+  float body[3][3];
+  for (int j = 0; j < 3; j++) {
+    const float axis[3] = {j == 0 ? 1.0f : 0.0f, j == 1 ? 1.0f : 0.0f,
+                           j == 2 ? 1.0f : 0.0f};
+    float column[3];
+    worldToBody(axis, roll, pitch, heading, column);
+    for (int i = 0; i < 3; i++) body[i][j] = column[i];
+  }
+
+  // Поворот за шаг dR = B Bпрошлаяᵀ ≈ I - [ω]x dt: неподвижный в мире
+  // вектор в осях датчика вращается против угловой скорости
+  float dt = (elapsedUs - lastBodyUs) / 1e6f;
+  if (hasLastBody && dt > 0.0f) {
+    float delta[3][3];
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        delta[i][j] = body[i][0] * lastBody[j][0] +
+                      body[i][1] * lastBody[j][1] +
+                      body[i][2] * lastBody[j][2];
+      }
+    }
+    rate[0] = 0.5f * (delta[1][2] - delta[2][1]) / dt;
+    rate[1] = 0.5f * (delta[2][0] - delta[0][2]) / dt;
+    rate[2] = 0.5f * (delta[0][1] - delta[1][0]) / dt;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) lastBody[i][j] = body[i][j];
+  }
+  lastBodyUs = elapsedUs;
+  hasLastBody = true;
+}
+
+void SensorSimulator::NoiseSource::seed(uint32_t value) {
+  state = value ? value : 1;  // xorshift не выходит из нуля
+  hasSpare = false;
+  spare = 0.0f;
+}
+
+float SensorSimulator::NoiseSource::uniform() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return ((state >> 8) + 1) * (1.0f / 16777216.0f);  // (0, 1]
+}
+
+float SensorSimulator::NoiseSource::gaussian() {
+  if (hasSpare) {
+    hasSpare = false;
+    return spare;
+  }
+
+  float radius = sqrtf(-2.0f * logf(uniform()));
+  float angle = 2.0f * PI_F * uniform();
+  spare = radius * sinf(angle);
+  hasSpare = true;
+  return radius * cosf(angle);
+}
+
+const char* SensorSimulator::profileName(Profile profile) {
+  return profile < PROFILE_COUNT ? PROFILES[profile].name : "unknown";
+}
+
+bool SensorSimulator::profileFromName(const char* name, Profile& out) {
+  for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+    if (strcmp(name, PROFILES[i].name) == 0) {
+      out = (Profile)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+SensorNoise SensorSimulator::defaultNoise() {
+  // Порядок шума LSM303DLHC при 100 Гц: ~3 mg и ~0.3 мкТл;
+  // L3GD20 при 95 Гц: ~0.3 °/с
+  SensorNoise noise = SensorNoise();
+  noise.accelSigma = 0.03f;
+  noise.magSigma = 0.3f;
+  noise.gyroSigma = 0.005f;
+  return noise;
+}
+
+// ========== SimulatedLsm303 ==========
+
+SimulatedLsm303::SimulatedLsm303(SensorSimulator& simulator, HalClock& clock,
+                                 bool withGyro)
+    : simulator(simulator), clock(clock), withGyro(withGyro), samples(0) {
+  memset(accelRegisters, 0, sizeof(accelRegisters));
+  memset(magRegisters, 0, sizeof(magRegisters));
+  memset(gyroRegisters, 0, sizeof(gyroRegisters));
+  memset(accelOutput, 0, sizeof(accelOutput));
+  memset(magOutput, 0, sizeof(magOutput));
+  memset(gyroOutput, 0, sizeof(gyroOutput));
+  gyroRegisters[L3gd20::REG_WHO_AM_I] = L3gd20::ID_L3GD20;
+}
+
+bool SimulatedLsm303::probe(uint8_t address) {
+  return address == Lsm303::ACCEL_ADDRESS || address == Lsm303::MAG_ADDRESS ||
+         (withGyro && address == L3gd20::ADDRESS);
+}
+
+bool SimulatedLsm303::writeRegister(uint8_t address, uint8_t reg,
+                                    uint8_t value) {
+  reg &= ~Lsm303::AUTO_INCREMENT;
+  if (address == Lsm303::ACCEL_ADDRESS && reg < sizeof(accelRegisters)) {
+    accelRegisters[reg] = value;
+    return true;
+  }
+  if (address == Lsm303::MAG_ADDRESS && reg < sizeof(magRegisters)) {
+    magRegisters[reg] = value;
+    return true;
+  }
+  if (withGyro && address == L3gd20::ADDRESS &&
+      reg != L3gd20::REG_WHO_AM_I && reg < sizeof(gyroRegisters)) {
+    gyroRegisters[reg] = value;
+    return true;
+  }
+  return false;
+}
+
+bool SimulatedLsm303::readRegisters(uint8_t address, uint8_t reg,
+                                    uint8_t* buffer, size_t length) {
+  reg &= ~Lsm303::AUTO_INCREMENT;
+
+  const uint8_t* registers;
+  const uint8_t* output;
+  size_t count;
+  uint8_t outputReg;
+  if (address == Lsm303::ACCEL_ADDRESS) {
+    registers = accelRegisters;
+    count = sizeof(accelRegisters);
+    output = accelOutput;
+    outputReg = Lsm303::REG_OUT_X_L_A;
+  } else if (address == Lsm303::MAG_ADDRESS) {
+    registers = magRegisters;
+    count = sizeof(magRegisters);
+    output = magOutput;
+    outputReg = Lsm303::REG_OUT_X_H_M;
+  } else if (withGyro && address == L3gd20::ADDRESS) {
+    registers = gyroRegisters;
+    count = sizeof(gyroRegisters);
+    output = gyroOutput;
+    outputReg = L3gd20::REG_OUT_X_L;
+  } else {
+    return false;
+  }
+  if (reg + length > count) return false;
+
+  // Чтение выходных регистров акселерометра - новый момент времени
+  if (address == Lsm303::ACCEL_ADDRESS && reg <= outputReg &&
+      reg + length > outputReg) {
+    nextSample();
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    size_t r = reg + i;
+    buffer[i] = (r >= outputReg && r < outputReg + 6u) ? output[r - outputReg]
+                                                       : registers[r];
+  }
+  return true;
+}
+
+void SimulatedLsm303::nextSample() {
+  SensorDataRaw raw = SensorDataRaw();
+  simulator.sample(clock.nowUs(), raw);
+  Lsm303::encodeAccel(raw.accel_x, raw.accel_y, raw.accel_z, accelOutput);
+  Lsm303::encodeMag(raw.mag_x, raw.mag_y, raw.mag_z, magOutput);
+  L3gd20::encodeGyro(raw.gyro_x, raw.gyro_y, raw.gyro_z, gyroOutput);
+  samples++;
+}
@@ -0,0 +1,206 @@
+// SensorSimulator.h
+// Синтетический LSM303 (+ L3GD20): сценарии движения, шум и смещение
+
+#ifndef SENSOR_SIMULATOR_H
+#define SENSOR_SIMULATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Hal.h"
+#include "L3gd20.h"
+#include "Lsm303.h"
+#include "SensorTypes.h"
+
+// SENSOR_SIMULATOR=1 в build_flags: прошивка читает симулятор вместо LSM303,
+// SIMULATOR_PROFILE выбирает сценарий (SensorSimulator::Profile)
+#ifndef SENSOR_SIMULATOR
+#define SENSOR_SIMULATOR 0
+#endif
+
+#ifndef SIMULATOR_PROFILE
+#define SIMULATOR_PROFILE SensorSimulator::PROFILE_SLOW_TILT
+#endif
+
+/**
+ * @brief Отрезок сценария движения
+ *
+ * Ориентация задаётся на конец отрезка: MOTION_TILT плавно (косинусом)
+ * переходит к ней от предыдущей, остальные виды ставят её сразу.
+ */
+struct MotionSegment {
+  enum Motion : uint8_t {
+    MOTION_STATIC,     // Неподвижно
+    MOTION_TILT,       // Плавный наклон
+    MOTION_VIBRATION,  // Синусоидальная вибрация amplitude м/с², frequencyHz
+    MOTION_IMPACTS     // Удары amplitude м/с² (10 мс), frequencyHz в секунду
+  };
+
+  Motion motion;
+  uint32_t durationMs;
+  float rollDeg, pitchDeg, headingDeg;
+  float amplitude;
+  float frequencyHz;
+};
+
+/**
+ * @brief Модель шума датчиков
+ */
+struct SensorNoise {
+  float accelSigma;    // СКО шума акселерометра (м/с²)
+  float magSigma;      // СКО шума магнитометра (мкТл)
+  float gyroSigma;     // СКО шума гироскопа (рад/с)
+  float accelBias[3];  // Постоянное смещение X/Y/Z (м/с²)
+  float magBias[3];    // Hard-iron смещение X/Y/Z (мкТл)
+  float gyroBias[3];   // Смещение нуля X/Y/Z (рад/с)
+};
+
+/**
+ * @brief Генератор сырых сэмплов по сценарию
+ *
+ * Детерминирован: одинаковые сценарий, шум, seed и моменты опроса дают
+ * одинаковые данные на ПК и на устройстве. Углы согласованы с
+ * computeRoll()/computePitch(): roll = atan2(ay, az), pitch =
+ * atan2(-ax, sqrt(ay² + az²)). Угловая скорость (gyro_*) - разность
+ * ориентаций соседних сэмплов в осях датчика; шум гироскопа идёт своим
+ * генератором, поэтому не меняет шум акселерометра и магнитометра.
+ */
+class SensorSimulator {
+ public:
+  // Встроенные сценарии (зациклены)
+  enum Profile : uint8_t {
+    PROFILE_STATIC,
+    PROFILE_SLOW_TILT,
+    PROFILE_VIBRATION,
+    PROFILE_IMPACTS,
+    PROFILE_COUNT
+  };
+
+  static constexpr float GRAVITY = Lsm303::GRAVITY;
+
+  // Поле Земли в мировой системе: север, восток, вниз (мкТл, ~55° наклонение)
+  static constexpr float FIELD_NORTH_UT = 28.0f;
+  static constexpr float FIELD_DOWN_UT = 40.0f;
+
+  static const uint16_t IMPACT_WIDTH_MS = 10;
+
+  explicit SensorSimulator(Profile profile = PROFILE_STATIC,
+                           uint32_t seed = 1);
+
+  /**
+   * @brief Свой сценарий (массив должен жить всё время работы)
+   */
+  void setScript(const MotionSegment* segments, size_t count, bool loop);
+  void setProfile(Profile profile);
+  void setNoise(const SensorNoise& noise) { this->noise = noise; }
+  const SensorNoise& getNoise() const { return noise; }
+
+  /**
+   * @brief Начать сценарий заново (время, генератор шума)
+   */
+  void reset(uint32_t seed);
+
+  /**
+   * @brief Сэмпл в момент timeUs (монотонные micros() источника)
+   * @return false - сценарий закончился (без зацикливания)
+   */
+  bool sample(uint32_t timeUs, SensorDataRaw& out);
+
+  // Истинная ориентация последнего сэмпла (градусы)
+  float getTrueRoll() const { return trueRoll; }
+  float getTruePitch() const { return truePitch; }
+  float getTrueHeading() const { return trueHeading; }
+  // Линейное ускорение последнего сэмпла есть (вибрация, удар)
+  bool isDisturbed() const { return disturbed; }
+
+  uint64_t getElapsedUs() const { return elapsedUs; }
+  size_t getSegmentIndex() const { return segmentIndex; }
+
+  static const char* profileName(Profile profile);
+  static bool profileFromName(const char* name, Profile& out);
+  static SensorNoise defaultNoise();
+
+ private:
+  const MotionSegment* script;
+  size_t scriptLength;
+  bool loopScript;
+  SensorNoise noise;
+
+  // Время сценария
+  bool started;
+  uint32_t lastTimeUs;
+  uint64_t elapsedUs;
+  uint64_t segmentStartUs;
+  size_t segmentIndex;
+
+  // Ориентация в начале текущего отрезка
+  float startRoll, startPitch, startHeading;
+
+  // Последний сэмпл
+  float trueRoll, truePitch, trueHeading;
+  bool disturbed;
+
+  // Ориентация прошлого сэмпла (мир -> датчик) для угловой скорости
+  bool hasLastBody;
+  uint64_t lastBodyUs;
+  float lastBody[3][3];
+  float rate[3];
+
+  // Генератор шума: xorshift32 + Box-Muller
+  struct NoiseSource {
+    uint32_t state;
+    bool hasSpare;
+    float spare;
+
+    void seed(uint32_t value);
+    float uniform();
+    float gaussian();
+  };
+  uint32_t seed;
+  NoiseSource noiseSource;
+  NoiseSource gyroSource;
+
+  bool advance();
+  void linearAcceleration(const MotionSegment& segment, float t,
+                          float out[3]);
+  void updateRate(float roll, float pitch, float heading);
+};
+
+/**
+ * @brief Шина I2C с виртуальным LSM303 на симуляторе
+ *
+ * Подставляется вместо Esp32I2c/HostI2c: драйвер Lsm303 читает те же
+ * регистры, значения квантуются как у настоящего датчика (1 mg, ~0.1 мкТл).
+ * Новый сэмпл берётся на каждом чтении акселерометра. С withGyro на шине
+ * ещё и L3GD20 (плата 10-DOF) - гироскоп отдаёт тот же сэмпл.
+ */
+class SimulatedLsm303 : public HalI2c {
+ public:
+  SimulatedLsm303(SensorSimulator& simulator, HalClock& clock,
+                  bool withGyro = false);
+
+  bool probe(uint8_t address) override;
+  bool writeRegister(uint8_t address, uint8_t reg, uint8_t value) override;
+  bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer,
+                     size_t length) override;
+
+  uint32_t getSampleCount() const { return samples; }
+
+ private:
+  SensorSimulator& simulator;
+  HalClock& clock;
+
+  bool withGyro;
+
+  uint8_t accelRegisters[0x40];
+  uint8_t magRegisters[0x10];
+  uint8_t gyroRegisters[0x40];
+  uint8_t accelOutput[6];
+  uint8_t magOutput[6];
+  uint8_t gyroOutput[6];
+  uint32_t samples;
+
+  void nextSample();
+};
+
+#endif  // SENSOR_SIMULATOR_H
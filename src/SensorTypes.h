@@ -0,0 +1,40 @@
+// SensorTypes.h
+// Данные датчиков (общие для устройства и сборки на ПК)
+
+#ifndef SENSOR_TYPES_H
+#define SENSOR_TYPES_H
+
+#include <stdint.h>
+
+// Структура для сырых данных датчиков
+struct SensorDataRaw {
+  float accel_x, accel_y, accel_z;
+  float mag_x, mag_y, mag_z;
+  float gyro_x, gyro_y, gyro_z;  // рад/с (нули без гироскопа)
+  unsigned long timestamp;
+};
+
+// Счётчики работы датчиков (для метрик)
+struct SensorStats {
+  uint32_t samples;         // Всего обработанных сэмплов
+  uint32_t deadlineMisses;  // Пропущенные периоды опроса
+  uint32_t accelErrors;     // Ошибки чтения акселерометра (I2C)
+  uint32_t magErrors;       // Ошибки чтения магнитометра (I2C)
+  uint32_t gyroErrors;      // Ошибки чтения гироскопа (I2C)
+  uint32_t rateSwitches;    // Переключения быстрый/медленный опрос
+  float sampleRateHz;       // Фактическая частота за последнюю секунду
+};
+
+// Структура для обработанных данных
+struct SensorData {
+  float accel_x, accel_y, accel_z;
+  float mag_x, mag_y, mag_z;
+  unsigned long timestamp;
+
+  float roll;     // Крен (с учётом offset и swap)
+  float pitch;    // Тангаж (с учётом offset и swap)
+  float heading;  // Курс 0..360° (0, если магнитометр выключен)
+  bool valid;
+};
+
+#endif  // SENSOR_TYPES_H
@@ -0,0 +1,131 @@
+// TelemetryFrame.h
+// Двоичный кадр UDP телеметрии (общий для прошивки и утилит на ПК)
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Один сэмпл датчиков в компактном виде
+ *
+ * На проводе - little-endian, без выравнивания (TELEMETRY_FRAME_SIZE байт):
+ *
+ *   0  uint16 magic        TELEMETRY_MAGIC
+ *   2  uint8  version      TELEMETRY_VERSION
+ *   3  uint8  flags        TELEMETRY_FLAG_*
+ *   4  uint32 sequence     Номер кадра (с 0 после перезагрузки)
+ *   8  uint32 timestampUs  micros() момента чтения датчиков
+ *  12  int16  roll, pitch  Сотые доли градуса
+ *  16  int16  accel x,y,z  Сотые доли м/с²
+ *  22  int16  mag x,y,z    Десятые доли мкТл
+ *
+ * Упаковка/распаковка побайтовая, поэтому не зависит от порядка байт и
+ * выравнивания структур на конкретной платформе.
+ */
+struct TelemetryFrame {
+  uint8_t flags;
+  uint32_t sequence;
+  uint32_t timestampUs;
+  float roll, pitch;                 // Градусы
+  float accelX, accelY, accelZ;      // м/с²
+  float magX, magY, magZ;            // мкТл
+};
+
+static const uint16_t TELEMETRY_MAGIC = 0x564C;  // "LV"
+static const uint8_t TELEMETRY_VERSION = 1;
+static const size_t TELEMETRY_FRAME_SIZE = 28;
+static const uint16_t TELEMETRY_DEFAULT_PORT = 4210;
+
+static const uint8_t TELEMETRY_FLAG_VALID = 0x01;    // Данные датчиков валидны
+static const uint8_t TELEMETRY_FLAG_SWAPPED = 0x02;  // roll/pitch переставлены
+
+namespace telemetry_detail {
+
+inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline void putU32(uint8_t* p, uint32_t v) {
+  putU16(p, (uint16_t)v);
+  putU16(p + 2, (uint16_t)(v >> 16));
+}
+
+inline uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t* p) {
+  return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+// Фиксированная точка с насыщением
+inline void putFixed(uint8_t* p, float value, float scale) {
+  float scaled = value * scale;
+  if (scaled != scaled) scaled = 0.0f;  // NaN
+  if (scaled > 32767.0f) scaled = 32767.0f;
+  if (scaled < -32768.0f) scaled = -32768.0f;
+  putU16(p, (uint16_t)(int16_t)lroundf(scaled));
+}
+
+inline float getFixed(const uint8_t* p, float scale) {
+  return (int16_t)getU16(p) / scale;
+}
+
+}  // namespace telemetry_detail
+
+/**
+ * @brief Упаковать кадр
+ * @param out Буфер не меньше TELEMETRY_FRAME_SIZE
+ * @return Размер кадра
+ */
+inline size_t encodeTelemetryFrame(const TelemetryFrame& frame, uint8_t* out) {
+  using namespace telemetry_detail;
+
+  putU16(out + 0, TELEMETRY_MAGIC);
+  out[2] = TELEMETRY_VERSION;
+  out[3] = frame.flags;
+  putU32(out + 4, frame.sequence);
+  putU32(out + 8, frame.timestampUs);
+  putFixed(out + 12, frame.roll, 100.0f);
+  putFixed(out + 14, frame.pitch, 100.0f);
+  putFixed(out + 16, frame.accelX, 100.0f);
+  putFixed(out + 18, frame.accelY, 100.0f);
+  putFixed(out + 20, frame.accelZ, 100.0f);
+  putFixed(out + 22, frame.magX, 10.0f);
+  putFixed(out + 24, frame.magY, 10.0f);
+  putFixed(out + 26, frame.magZ, 10.0f);
+  return TELEMETRY_FRAME_SIZE;
+}
+
+/**
+ * @brief Распаковать кадр
+ * @return false - чужой пакет, другая версия или неверный размер
+ */
+inline bool decodeTelemetryFrame(const uint8_t* data, size_t length,
+                                 TelemetryFrame& frame) {
+  using namespace telemetry_detail;
+
+  if (length != TELEMETRY_FRAME_SIZE) return false;
+  if (getU16(data) != TELEMETRY_MAGIC || data[2] != TELEMETRY_VERSION) {
+    return false;
+  }
+
+  frame.flags = data[3];
+  frame.sequence = getU32(data + 4);
+  frame.timestampUs = getU32(data + 8);
+  frame.roll = getFixed(data + 12, 100.0f);
+  frame.pitch = getFixed(data + 14, 100.0f);
+  frame.accelX = getFixed(data + 16, 100.0f);
+  frame.accelY = getFixed(data + 18, 100.0f);
+  frame.accelZ = getFixed(data + 20, 100.0f);
+  frame.magX = getFixed(data + 22, 10.0f);
+  frame.magY = getFixed(data + 24, 10.0f);
+  frame.magZ = getFixed(data + 26, 10.0f);
+  return true;
+}
+
+#endif  // TELEMETRY_FRAME_H
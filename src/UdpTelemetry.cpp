@@ -0,0 +1,82 @@
+// UdpTelemetry.cpp
+#include "UdpTelemetry.h"
+
+const IPAddress UdpTelemetry::MULTICAST_GROUP(239, 255, 76, 86);
+
+UdpTelemetry::UdpTelemetry()
+    : mode(MODE_OFF),
+      port(TELEMETRY_DEFAULT_PORT),
+      sequence(0),
+      framesSent(0),
+      sendErrors(0) {}
+
+void UdpTelemetry::configure(Mode newMode, uint16_t newPort) {
+  if (newMode == mode && newPort == port) return;
+
+  mode = newMode;
+  port = newPort;
+  Serial.printf("UDP telemetry: %s, port %u\n", modeName(mode), port);
+}
+
+bool UdpTelemetry::resolveTarget(IPAddress& target) const {
+  if (mode == MODE_MULTICAST) {
+    target = MULTICAST_GROUP;
+    return WiFi.isConnected() || (WiFi.getMode() & WIFI_MODE_AP);
+  }
+
+  // Broadcast в подсеть активного интерфейса
+  if (WiFi.isConnected()) {
+    target = WiFi.broadcastIP();
+    return true;
+  }
+  if (WiFi.getMode() & WIFI_MODE_AP) {
+    target = WiFi.softAPBroadcastIP();
+    return true;
+  }
+  return false;
+}
+
+bool UdpTelemetry::send(const SensorData& data, uint32_t sampleMicros,
+                        bool swapped) {
+  if (mode == MODE_OFF) return false;
+
+  IPAddress target;
+  if (!resolveTarget(target)) return false;  // Сети ещё нет
+
+  TelemetryFrame frame;
+  frame.flags = (data.valid ? TELEMETRY_FLAG_VALID : 0) |
+                (swapped ? TELEMETRY_FLAG_SWAPPED : 0);
+  frame.sequence = sequence++;  // Растёт и при ошибке - получатель видит потерю
+  frame.timestampUs = sampleMicros;
+  frame.roll = data.roll;
+  frame.pitch = data.pitch;
+  frame.accelX = data.accel_x;
+  frame.accelY = data.accel_y;
+  frame.accelZ = data.accel_z;
+  frame.magX = data.mag_x;
+  frame.magY = data.mag_y;
+  frame.magZ = data.mag_z;
+
+  size_t length = encodeTelemetryFrame(frame, buffer);
+
+  if (!udp.beginPacket(target, port) || udp.write(buffer, length) != length ||
+      !udp.endPacket()) {
+    sendErrors++;
+    return false;
+  }
+
+  framesSent++;
+  return true;
+}
+
+const char* UdpTelemetry::modeName(Mode mode) {
+  switch (mode) {
+    case MODE_BROADCAST:
+      return "broadcast";
+    case MODE_MULTICAST:
+      return "multicast";
+    case MODE_OFF:
+    default:
+      return "off";
+  }
+}
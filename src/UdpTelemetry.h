@@ -0,0 +1,68 @@
+// UdpTelemetry.h
+// Поток двоичных кадров датчиков по UDP (broadcast / multicast)
+
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+#include "SensorManager.h"
+#include "TelemetryFrame.h"
+
+/**
+ * @brief Рассылка каждого сэмпла одним UDP пакетом
+ *
+ * Стоимость на устройстве не зависит от числа слушателей: один пакет
+ * на сэмпл, без TCP соединений и буферов на клиента. Доставка не
+ * гарантируется - пропуски видны получателю по номеру кадра.
+ */
+class UdpTelemetry {
+ public:
+  enum Mode : uint8_t {
+    MODE_OFF = 0,
+    MODE_BROADCAST = 1,  // Широковещательный адрес текущей подсети
+    MODE_MULTICAST = 2   // Группа MULTICAST_GROUP
+  };
+
+  // Группа для режима multicast (administratively scoped)
+  static const IPAddress MULTICAST_GROUP;
+
+  UdpTelemetry();
+
+  /**
+   * @brief Задать режим и порт (MODE_OFF - остановить рассылку)
+   */
+  void configure(Mode mode, uint16_t port);
+
+  bool isEnabled() const { return mode != MODE_OFF; }
+  Mode getMode() const { return mode; }
+  uint16_t getPort() const { return port; }
+
+  /**
+   * @brief Отправить сэмпл (вызывать после SensorManager::sample())
+   * @param sampleMicros micros() момента чтения датчиков
+   * @return true - пакет передан в стек
+   */
+  bool send(const SensorData& data, uint32_t sampleMicros, bool swapped);
+
+  uint32_t getFramesSent() const { return framesSent; }
+  uint32_t getSendErrors() const { return sendErrors; }
+  uint32_t getBytesSent() const { return framesSent * TELEMETRY_FRAME_SIZE; }
+
+  static const char* modeName(Mode mode);
+
+ private:
+  WiFiUDP udp;
+  Mode mode;
+  uint16_t port;
+  uint32_t sequence;
+  uint32_t framesSent;
+  uint32_t sendErrors;
+  uint8_t buffer[TELEMETRY_FRAME_SIZE];
+
+  bool resolveTarget(IPAddress& target) const;
+};
+
+#endif  // UDP_TELEMETRY_H
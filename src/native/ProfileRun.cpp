@@ -0,0 +1,121 @@
+// ProfileRun.cpp (env:native)
+#include "ProfileRun.h"
+
+#include <math.h>
+
+#include <vector>
+
+#include "HalHost.h"
+#include "L3gd20.h"
+#include "Lsm303.h"
+#include "SensorPipeline.h"
+
+namespace ProfileRun {
+
+namespace {
+
+// Сдвиг крена назад во времени, дающий наименьшую СКО от истинного
+float estimateLag(const std::vector<float>& roll,
+                  const std::vector<float>& truth, uint16_t intervalMs) {
+  float low = truth[0], high = truth[0];
+  for (float value : truth) {
+    if (value < low) low = value;
+    if (value > high) high = value;
+  }
+  if (high - low < MIN_LAG_SPAN_DEG) return -1.0f;
+
+  size_t maxShift = MAX_LAG_MS / intervalMs;
+  size_t best = 0;
+  double bestSum = -1.0;
+  for (size_t shift = 0; shift <= maxShift && shift < roll.size(); shift++) {
+    double sum = 0.0;
+    for (size_t i = shift; i < roll.size(); i++) {
+      double d = roll[i] - truth[i - shift];
+      sum += d * d;
+    }
+    sum /= roll.size() - shift;
+    if (bestSum < 0.0 || sum < bestSum) {
+      bestSum = sum;
+      best = shift;
+    }
+  }
+  return (float)(best * intervalMs);
+}
+
+}  // namespace
+
+bool run(SensorSimulator::Profile profile, OrientationEngine::Type engine,
+         OutlierRejector::Mode outliers, uint32_t durationS, uint32_t seed,
+         RunStats& stats) {
+  HostClock clock;
+  SensorSimulator simulator(profile, seed);
+  SensorNoise noise = SensorSimulator::defaultNoise();
+  for (int axis = 0; axis < 3; axis++) noise.gyroBias[axis] = GYRO_BIAS[axis];
+  simulator.setNoise(noise);
+  SimulatedLsm303 bus(simulator, clock, true);
+
+  Lsm303 sensor(bus);
+  L3gd20 gyro(bus);
+  if (!sensor.beginAccel() || !sensor.beginMag() || !gyro.begin()) {
+    return false;
+  }
+
+  SensorPipeline pipeline(MultiChannelKalman::RESPONSIVE);
+  pipeline.setOrientationEngine(engine);
+  pipeline.setOutlierMode(outliers);
+  const uint16_t intervalMs = SensorPipeline::REFERENCE_INTERVAL_MS;
+  stats = RunStats();
+  std::vector<float> roll, truth;
+
+  SensorData data = SensorData();
+  for (uint32_t t = 0; t < durationS * 1000; t += intervalMs) {
+    SensorDataRaw raw = SensorDataRaw();
+    sensor.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+    sensor.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+    gyro.readGyro(raw.gyro_x, raw.gyro_y, raw.gyro_z);
+    raw.timestamp = clock.nowMs();
+    pipeline.process(raw, data);
+    clock.advanceMs(intervalMs);
+
+    if (t < WARMUP_MS) continue;
+
+    roll.push_back(data.roll);
+    truth.push_back(simulator.getTrueRoll());
+
+    float error = fabsf(data.roll - simulator.getTrueRoll());
+    stats.samples++;
+    stats.sumSquares += (double)error * error;
+    if (error > stats.maxError) stats.maxError = error;
+    float pitchError = fabsf(data.pitch - simulator.getTruePitch());
+    stats.pitchSumSquares += (double)pitchError * pitchError;
+    if (pitchError > stats.pitchMaxError) stats.pitchMaxError = pitchError;
+    if (pipeline.getMotionLevel() > stats.maxMotion) {
+      stats.maxMotion = pipeline.getMotionLevel();
+    }
+
+    if (!simulator.isDisturbed()) {
+      stats.quietSamples++;
+      stats.quietSumSquares += (double)error * error;
+      if (error > stats.quietMaxError) stats.quietMaxError = error;
+    }
+  }
+  stats.rejected = pipeline.getOutlierRejector().getTotalRejected();
+  stats.lagMs = roll.empty() ? -1.0f : estimateLag(roll, truth, intervalMs);
+  return true;
+}
+
+RunStats run(SensorSimulator::Profile profile, OrientationEngine::Type engine,
+             OutlierRejector::Mode outliers) {
+  RunStats stats;
+  if (!run(profile, engine, outliers, DEFAULT_DURATION_S, DEFAULT_SEED,
+           stats)) {
+    stats = RunStats();
+  }
+  return stats;
+}
+
+double rms(double sumSquares, uint32_t count) {
+  return count ? sqrt(sumSquares / count) : 0.0;
+}
+
+}  // namespace ProfileRun
@@ -0,0 +1,73 @@
+// ProfileRun.h (env:native)
+// Прогон сценария симулятора через драйверы и SensorPipeline с ошибкой
+// крена и тангажа относительно истинных углов. Общий для программы
+// сравнения (main.cpp) и тестов Unity из test/.
+
+#ifndef PROFILE_RUN_H
+#define PROFILE_RUN_H
+
+#include <stdint.h>
+
+#include "OrientationEngine.h"
+#include "OutlierRejector.h"
+#include "SensorSimulator.h"
+
+namespace ProfileRun {
+
+// Длительность и seed по умолчанию (программа сравнения и тесты)
+const uint32_t DEFAULT_DURATION_S = 60;
+const uint32_t DEFAULT_SEED = 1;
+
+// Первые секунды фильтр сходится от нуля - в статистику не входят
+const uint32_t WARMUP_MS = 3000;
+
+// Поиск задержки и минимальный размах истинного крена для него
+const uint32_t MAX_LAG_MS = 1000;
+const float MIN_LAG_SPAN_DEG = 1.0f;
+
+// Смещение нуля гироскопа в прогоне (рад/с, ~1 °/с) - его надо оценить
+const float GYRO_BIAS[3] = {0.02f, -0.015f, 0.01f};
+
+struct RunStats {
+  uint32_t samples;
+  uint32_t quietSamples;
+  double sumSquares;
+  double quietSumSquares;
+  float maxError;
+  float quietMaxError;
+  double pitchSumSquares;  // Тангаж - всё время
+  float pitchMaxError;
+  float maxMotion;
+  float lagMs;  // < 0 - не оценивалась
+  uint32_t rejected;
+};
+
+/**
+ * @brief Прогон сценария (профиль фильтра RESPONSIVE)
+ * @return false - симулятор на шине не ответил
+ */
+bool run(SensorSimulator::Profile profile, OrientationEngine::Type engine,
+         OutlierRejector::Mode outliers, uint32_t durationS, uint32_t seed,
+         RunStats& stats);
+
+/**
+ * @brief Прогон DEFAULT_DURATION_S с DEFAULT_SEED
+ * @return Статистика; samples == 0 - симулятор на шине не ответил
+ */
+RunStats run(SensorSimulator::Profile profile, OrientationEngine::Type engine,
+             OutlierRejector::Mode outliers = OutlierRejector::OFF);
+
+double rms(double sumSquares, uint32_t count);
+
+// СКО крена и тангажа за всё время после прогрева
+inline double rollRms(const RunStats& stats) {
+  return rms(stats.sumSquares, stats.samples);
+}
+
+inline double pitchRms(const RunStats& stats) {
+  return rms(stats.pitchSumSquares, stats.samples);
+}
+
+}  // namespace ProfileRun
+
+#endif  // PROFILE_RUN_H
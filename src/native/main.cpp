@@ -0,0 +1,106 @@
+// main.cpp (env:native)
+// Прогон цепочки обработки на ПК: симулятор LSM303 + L3GD20 -> драйверы ->
+// SensorPipeline. Для каждого сценария, движка ориентации и режима
+// отбраковки выбросов печатает ошибку крена относительно истинного угла
+// (всё время и в покое), задержку, уровень движения и число выбросов.
+//
+// Сборка и запуск:  pio run -e native && .pio/build/native/program
+//                   [сценарий|all] [длительность, с] [seed] [движок|all]
+//                   [выбросы|all] (по умолчанию off)
+//
+// lag_ms - сдвиг, при котором крен ближе всего к истинному (поиск до
+// ProfileRun::MAX_LAG_MS); без наклонов (static, vibration) не оценивается.
+//
+// В pio test -e native исходники собираются вместе с тестами из test/,
+// у которых свой main() - там этот файл пустой.
+
+#ifndef PIO_UNIT_TESTING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ProfileRun.h"
+
+int main(int argc, char** argv) {
+  int first = 0, last = SensorSimulator::PROFILE_COUNT - 1;
+  int firstEngine = 0, lastEngine = OrientationEngine::TYPE_COUNT - 1;
+  int firstMode = OutlierRejector::OFF, lastMode = OutlierRejector::OFF;
+  if (argc > 1 && strcmp(argv[1], "all") != 0) {
+    SensorSimulator::Profile profile;
+    if (!SensorSimulator::profileFromName(argv[1], profile)) {
+      printf("Unknown profile: %s (static, slow_tilt, vibration, impacts)\n",
+             argv[1]);
+      return 1;
+    }
+    first = last = profile;
+  }
+  uint32_t durationS = argc > 2 ? (uint32_t)atoi(argv[2])
+                                 : ProfileRun::DEFAULT_DURATION_S;
+  uint32_t seed = argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10)
+                           : ProfileRun::DEFAULT_SEED;
+  if (durationS * 1000 <= ProfileRun::WARMUP_MS) {
+    durationS = ProfileRun::DEFAULT_DURATION_S;
+  }
+  if (argc > 4 && strcmp(argv[4], "all") != 0) {
+    OrientationEngine::Type engine;
+    if (!OrientationEngine::typeFromName(argv[4], engine)) {
+      printf("Unknown engine: %s (accel, complementary, mahony)\n", argv[4]);
+      return 1;
+    }
+    firstEngine = lastEngine = engine;
+  }
+  if (argc > 5) {
+    OutlierRejector::Mode mode;
+    if (strcmp(argv[5], "all") == 0) {
+      firstMode = 0;
+      lastMode = OutlierRejector::MODE_COUNT - 1;
+    } else if (OutlierRejector::modeFromName(argv[5], mode)) {
+      firstMode = lastMode = mode;
+    } else {
+      printf("Unknown outlier mode: %s (off, hampel, innovation)\n",
+             argv[5]);
+      return 1;
+    }
+  }
+
+  printf("%-10s %-13s %-10s %8s %9s %9s %9s %9s %7s %8s %8s\n", "profile",
+         "engine", "outliers", "samples", "rms", "max", "quiet_rms",
+         "quiet_max", "lag_ms", "motion", "rejected");
+  for (int i = first; i <= last; i++) {
+    SensorSimulator::Profile profile = (SensorSimulator::Profile)i;
+    for (int e = firstEngine; e <= lastEngine; e++) {
+      OrientationEngine::Type engine = (OrientationEngine::Type)e;
+      for (int m = firstMode; m <= lastMode; m++) {
+        OutlierRejector::Mode outliers = (OutlierRejector::Mode)m;
+        ProfileRun::RunStats stats;
+        if (!ProfileRun::run(profile, engine, outliers, durationS, seed,
+                             stats)) {
+          printf("LSM303/L3GD20 simulator did not respond\n");
+          return 1;
+        }
+        printf("%-10s %-13s %-10s %8u %9.3f %9.3f ",
+               SensorSimulator::profileName(profile),
+               OrientationEngine::typeName(engine),
+               OutlierRejector::modeName(outliers), stats.samples,
+               ProfileRun::rollRms(stats), stats.maxError);
+        if (stats.quietSamples) {  // Под вибрацией покоя нет
+          printf("%9.3f %9.3f",
+                 ProfileRun::rms(stats.quietSumSquares, stats.quietSamples),
+                 stats.quietMaxError);
+        } else {
+          printf("%9s %9s", "-", "-");
+        }
+        if (stats.lagMs >= 0.0f) {
+          printf(" %7.0f", stats.lagMs);
+        } else {
+          printf(" %7s", "-");
+        }
+        printf(" %8.3f %8u\n", stats.maxMotion, stats.rejected);
+      }
+    }
+  }
+  return 0;
+}
+
+#endif  // PIO_UNIT_TESTING
@@ -0,0 +1,185 @@
+// test_main.cpp (test_accel_calibration)
+// Калибровка по шести положениям на симуляторе со смещением нуля осей:
+// поправка находит смещение, и наклон после неё читается точно
+
+#include <math.h>
+#include <unity.h>
+
+#include "AccelCalibration.h"
+#include "HalHost.h"
+#include "Lsm303.h"
+#include "SensorPipeline.h"
+#include "SensorSimulator.h"
+
+namespace {
+
+const float GRAVITY = AccelCalibration::GRAVITY;
+const float MG = GRAVITY / 1000.0f;
+
+// Смещение нуля в пределах LSM303DLHC (~30 mg)
+const float ACCEL_BIAS[3] = {0.30f, -0.20f, 0.25f};
+
+const uint16_t INTERVAL_MS = SensorPipeline::REFERENCE_INTERVAL_MS;
+
+// Крен и тангаж, при которых ось положения смотрит вверх/вниз
+const float POSITION_ANGLES[AccelCalibration::POSITION_COUNT][2] = {
+    {0.0f, -90.0f},  // X вверх
+    {0.0f, 90.0f},   // X вниз
+    {90.0f, 0.0f},   // Y вверх
+    {-90.0f, 0.0f},  // Y вниз
+    {0.0f, 0.0f},    // Z вверх
+    {180.0f, 0.0f}   // Z вниз
+};
+
+// Неподвижный датчик с заданными креном, тангажом и смещением нуля
+class StillSensor {
+ public:
+  StillSensor(float rollDeg, float pitchDeg)
+      : bus(simulator, clock), sensor(bus) {
+    segment[0] = {MotionSegment::MOTION_STATIC, 60000, rollDeg, pitchDeg,
+                  0.0f, 0.0f, 0.0f};
+    simulator.setScript(segment, 1, true);
+    SensorNoise noise = SensorSimulator::defaultNoise();
+    for (int axis = 0; axis < 3; axis++) {
+      noise.accelBias[axis] = ACCEL_BIAS[axis];
+    }
+    simulator.setNoise(noise);
+  }
+
+  bool begin() { return sensor.beginAccel() && sensor.beginMag(); }
+
+  // Следующий сэмпл через драйвер и конвейер
+  void next(SensorPipeline& pipeline, SensorDataRaw& raw, SensorData& data) {
+    raw = SensorDataRaw();
+    sensor.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+    sensor.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+    raw.timestamp = clock.nowMs();
+    pipeline.process(raw, data);
+    clock.advanceMs(INTERVAL_MS);
+  }
+
+ private:
+  MotionSegment segment[1];
+  HostClock clock;
+  SensorSimulator simulator;
+  SimulatedLsm303 bus;
+  Lsm303 sensor;
+};
+
+// Накопление положения, как SensorManager: сырые сэмплы и уровень движения
+AccelCalibration::Status capture(AccelCalibration& calibration,
+                                 AccelCalibration::Position position,
+                                 float rollDeg, float pitchDeg) {
+  StillSensor still(rollDeg, pitchDeg);
+  if (!still.begin()) return AccelCalibration::STATUS_IDLE;
+
+  SensorPipeline pipeline;
+  SensorDataRaw raw;
+  SensorData data;
+  uint32_t t = 0;
+  calibration.start(position, t);
+  for (; t < 20000; t += INTERVAL_MS) {
+    still.next(pipeline, raw, data);
+    if (calibration.addSample(raw.accel_x, raw.accel_y, raw.accel_z,
+                              pipeline.getMotionLevel(), t)) {
+      break;
+    }
+  }
+  return calibration.getStatus();
+}
+
+bool captureAll(AccelCalibration& calibration) {
+  for (int p = 0; p < AccelCalibration::POSITION_COUNT; p++) {
+    AccelCalibration::Position position = (AccelCalibration::Position)p;
+    if (capture(calibration, position, POSITION_ANGLES[p][0],
+                POSITION_ANGLES[p][1]) != AccelCalibration::STATUS_CAPTURED) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Средние крен и тангаж после схождения фильтра
+void readTilt(const AccelCorrection& correction, float rollDeg,
+              float pitchDeg, float& roll, float& pitch) {
+  StillSensor still(rollDeg, pitchDeg);
+  TEST_ASSERT_TRUE(still.begin());
+
+  SensorPipeline pipeline;
+  pipeline.setAccelCorrection(correction);
+  SensorDataRaw raw;
+  SensorData data;
+  double rollSum = 0.0, pitchSum = 0.0;
+  uint32_t count = 0;
+  for (uint32_t t = 0; t < 10000; t += INTERVAL_MS) {
+    still.next(pipeline, raw, data);
+    if (t < 3000) continue;
+    rollSum += data.roll;
+    pitchSum += data.pitch;
+    count++;
+  }
+  roll = rollSum / count;
+  pitch = pitchSum / count;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_solver_recovers_axis_bias() {
+  AccelCalibration calibration;
+  TEST_ASSERT_TRUE(captureAll(calibration));
+  TEST_ASSERT_EQUAL_UINT8(6, calibration.getCapturedCount());
+
+  AccelCorrection correction;
+  TEST_ASSERT_EQUAL(AccelCalibration::SOLVE_OK, calibration.solve(correction));
+  TEST_ASSERT_TRUE(AccelCalibration::isValid(correction));
+  for (int axis = 0; axis < 3; axis++) {
+    TEST_ASSERT_FLOAT_WITHIN(3.0f * MG, ACCEL_BIAS[axis],
+                             correction.bias[axis]);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 1.0f, correction.scale[axis]);
+  }
+}
+
+void test_corrected_tilt_reads_back() {
+  AccelCalibration calibration;
+  TEST_ASSERT_TRUE(captureAll(calibration));
+  AccelCorrection correction;
+  TEST_ASSERT_EQUAL(AccelCalibration::SOLVE_OK, calibration.solve(correction));
+
+  float roll, pitch;
+  readTilt(AccelCorrection::identity(), 10.0f, 5.0f, roll, pitch);
+  // Без поправки смещение нуля заметно искажает углы
+  TEST_ASSERT_GREATER_THAN_FLOAT(0.5f, fabsf(roll - 10.0f));
+
+  readTilt(correction, 10.0f, 5.0f, roll, pitch);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 10.0f, roll);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 5.0f, pitch);
+}
+
+void test_wrong_axis_and_incomplete_set() {
+  AccelCalibration calibration;
+  AccelCorrection correction;
+
+  // Просили X вверх, а датчик лежит (вверх смотрит Z)
+  TEST_ASSERT_EQUAL(AccelCalibration::STATUS_WRONG_AXIS,
+                    capture(calibration, AccelCalibration::POS_X_UP, 0.0f,
+                            0.0f));
+  TEST_ASSERT_FALSE(calibration.hasPosition(AccelCalibration::POS_X_UP));
+
+  TEST_ASSERT_EQUAL(AccelCalibration::STATUS_CAPTURED,
+                    capture(calibration, AccelCalibration::POS_Z_UP, 0.0f,
+                            0.0f));
+  TEST_ASSERT_EQUAL_UINT8(1, calibration.getCapturedCount());
+  TEST_ASSERT_EQUAL(AccelCalibration::SOLVE_INCOMPLETE,
+                    calibration.solve(correction));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_solver_recovers_axis_bias);
+  RUN_TEST(test_corrected_tilt_reads_back);
+  RUN_TEST(test_wrong_axis_and_incomplete_set);
+  return UNITY_END();
+}
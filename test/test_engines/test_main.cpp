@@ -0,0 +1,84 @@
+// test_main.cpp (test_engines)
+// Движки ориентации на сценариях симулятора (ProfileRun: смещение нуля
+// гироскопа ~1 °/с): слияние с гироскопом убирает задержку на наклонах,
+// а в покое и под вибрацией остаётся в заданных допусках
+
+#include <unity.h>
+
+#include "ProfileRun.h"
+
+namespace {
+
+// Наклоны: гироскоп ведёт угол без сглаживания
+const float FUSION_MAX_LAG_MS = 50.0f;
+
+// Покой: СКО крена любого движка (градусы). У слияния больше, чем у
+// accel: в угол идут шум гироскопа и ускорение до фильтра Калмана
+const double STATIC_MAX_RMS = 0.05;
+
+// Вибрация: слияние видит её через подтяжку к ускорению до фильтра
+// Калмана; СКО крена хуже, чем у accel, не больше чем на столько градусов
+const double VIBRATION_MARGIN = 0.025;
+
+const OrientationEngine::Type ENGINES[] = {OrientationEngine::ACCEL,
+                                           OrientationEngine::COMPLEMENTARY,
+                                           OrientationEngine::MAHONY};
+const OrientationEngine::Type FUSION_ENGINES[] = {
+    OrientationEngine::COMPLEMENTARY, OrientationEngine::MAHONY};
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_fusion_removes_tilt_lag() {
+  ProfileRun::RunStats accel =
+      ProfileRun::run(SensorSimulator::PROFILE_SLOW_TILT,
+                      OrientationEngine::ACCEL);
+  TEST_ASSERT_TRUE(accel.lagMs >= 0.0f);  // Наклоны есть - оценена
+
+  for (OrientationEngine::Type engine : FUSION_ENGINES) {
+    ProfileRun::RunStats stats =
+        ProfileRun::run(SensorSimulator::PROFILE_SLOW_TILT, engine);
+    TEST_ASSERT_TRUE(stats.lagMs >= 0.0f);
+    TEST_ASSERT_TRUE(stats.lagMs < accel.lagMs);
+    TEST_ASSERT_TRUE(stats.lagMs <= FUSION_MAX_LAG_MS);
+    TEST_ASSERT_TRUE(ProfileRun::rollRms(stats) < ProfileRun::rollRms(accel));
+    TEST_ASSERT_TRUE(stats.maxError < accel.maxError);
+  }
+}
+
+void test_engines_at_rest() {
+  for (OrientationEngine::Type engine : ENGINES) {
+    ProfileRun::RunStats stats =
+        ProfileRun::run(SensorSimulator::PROFILE_STATIC, engine);
+    TEST_ASSERT_TRUE(stats.samples > 0);
+    TEST_ASSERT_EQUAL_UINT32(stats.samples, stats.quietSamples);
+    TEST_ASSERT_TRUE(ProfileRun::rollRms(stats) < STATIC_MAX_RMS);
+    TEST_ASSERT_TRUE(stats.lagMs < 0.0f);  // Без наклонов не оценивается
+  }
+}
+
+void test_fusion_under_vibration() {
+  ProfileRun::RunStats accel =
+      ProfileRun::run(SensorSimulator::PROFILE_VIBRATION,
+                      OrientationEngine::ACCEL);
+  TEST_ASSERT_TRUE(accel.samples > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, accel.quietSamples);
+
+  for (OrientationEngine::Type engine : FUSION_ENGINES) {
+    ProfileRun::RunStats stats =
+        ProfileRun::run(SensorSimulator::PROFILE_VIBRATION, engine);
+    TEST_ASSERT_TRUE(stats.samples > 0);
+    TEST_ASSERT_TRUE(ProfileRun::rollRms(stats) <=
+                     ProfileRun::rollRms(accel) + VIBRATION_MARGIN);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fusion_removes_tilt_lag);
+  RUN_TEST(test_engines_at_rest);
+  RUN_TEST(test_fusion_under_vibration);
+  return UNITY_END();
+}
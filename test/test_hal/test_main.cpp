@@ -0,0 +1,161 @@
+// test_main.cpp (test_hal)
+// Реализации Hal.h для ПК: на них держатся остальные тесты и утилиты
+
+#include <string.h>
+#include <unity.h>
+
+#include "HalHost.h"
+
+namespace {
+
+// Регистры устройства на шине: запись по одному, чтение подряд
+class RegisterDevice : public HostI2c::Device {
+ public:
+  RegisterDevice() { memset(registers, 0, sizeof(registers)); }
+
+  bool writeRegister(uint8_t reg, uint8_t value) override {
+    if (reg >= sizeof(registers)) return false;
+    registers[reg] = value;
+    return true;
+  }
+
+  bool readRegisters(uint8_t reg, uint8_t* buffer, size_t length) override {
+    if (reg + length > sizeof(registers)) return false;
+    memcpy(buffer, registers + reg, length);
+    return true;
+  }
+
+  uint8_t registers[16];
+};
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_i2c_routes_by_address() {
+  HostI2c bus;
+  RegisterDevice device;
+  bus.attach(0x19, &device);
+
+  TEST_ASSERT_TRUE(bus.probe(0x19));
+  TEST_ASSERT_FALSE(bus.probe(0x1E));
+
+  TEST_ASSERT_TRUE(bus.writeRegister(0x19, 2, 0xA5));
+  TEST_ASSERT_TRUE(bus.writeRegister(0x19, 3, 0x5A));
+  TEST_ASSERT_FALSE(bus.writeRegister(0x1E, 2, 0x01));
+
+  uint8_t buffer[2] = {0, 0};
+  TEST_ASSERT_TRUE(bus.readRegisters(0x19, 2, buffer, 2));
+  TEST_ASSERT_EQUAL_UINT8(0xA5, buffer[0]);
+  TEST_ASSERT_EQUAL_UINT8(0x5A, buffer[1]);
+
+  // Неответившее устройство в счётчики не попадает
+  TEST_ASSERT_EQUAL_UINT32(2, bus.getWriteCount());
+  TEST_ASSERT_EQUAL_UINT32(1, bus.getReadCount());
+
+  bus.detach(0x19);
+  TEST_ASSERT_FALSE(bus.probe(0x19));
+  TEST_ASSERT_FALSE(bus.readRegisters(0x19, 2, buffer, 2));
+}
+
+void test_pwm_keeps_duty_per_channel() {
+  HostPwm pwm;
+  TEST_ASSERT_TRUE(pwm.attach(1, 25, 5000, 8));
+  TEST_ASSERT_FALSE(pwm.attach(HostPwm::MAX_CHANNELS, 25, 5000, 8));
+
+  pwm.write(1, 128);
+  pwm.write(2, 255);
+  TEST_ASSERT_EQUAL_UINT32(128, pwm.getDuty(1));
+  TEST_ASSERT_EQUAL_UINT32(255, pwm.getDuty(2));
+  TEST_ASSERT_EQUAL_UINT32(0, pwm.getDuty(3));
+
+  // Переход на ПК мгновенный и считается записью
+  TEST_ASSERT_TRUE(pwm.enableFade());
+  TEST_ASSERT_TRUE(pwm.fade(1, 64, 200));
+  TEST_ASSERT_EQUAL_UINT32(64, pwm.getDuty(1));
+  TEST_ASSERT_EQUAL_UINT32(3, pwm.getWriteCount());
+
+  pwm.write(HostPwm::MAX_CHANNELS, 1);
+  TEST_ASSERT_EQUAL_UINT32(3, pwm.getWriteCount());
+}
+
+void test_file_system_text_files() {
+  HostFileSystem fs;
+  char buffer[8];
+  TEST_ASSERT_FALSE(fs.exists("/a.txt"));
+  TEST_ASSERT_EQUAL_INT(-1, fs.read("/a.txt", buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_INT(-1, (int)fs.size("/a.txt"));
+
+  TEST_ASSERT_TRUE(fs.write("/a.txt", "0.250000", 8));
+  TEST_ASSERT_TRUE(fs.exists("/a.txt"));
+  TEST_ASSERT_EQUAL_INT(8, (int)fs.size("/a.txt"));
+
+  // Не больше size - 1 байт и всегда с '\0'
+  TEST_ASSERT_EQUAL_INT(7, fs.read("/a.txt", buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_STRING("0.25000", buffer);
+
+  TEST_ASSERT_TRUE(fs.remove("/a.txt"));
+  TEST_ASSERT_FALSE(fs.remove("/a.txt"));
+  TEST_ASSERT_FALSE(fs.exists("/a.txt"));
+}
+
+void test_file_system_binary_access() {
+  HostFileSystem fs;
+  const uint8_t block[8] = {1, 2, 0, 4, 5, 0, 7, 8};
+
+  // Двоичные данные с нулями записываются целиком
+  TEST_ASSERT_TRUE(fs.write("/r.bin", (const char*)block, sizeof(block)));
+  TEST_ASSERT_EQUAL_INT(8, (int)fs.size("/r.bin"));
+
+  uint8_t buffer[8];
+  TEST_ASSERT_EQUAL_INT(8, fs.readAt("/r.bin", 0, buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_MEMORY(block, buffer, sizeof(block));
+
+  // Хвост короче запрошенного, за концом - пусто
+  TEST_ASSERT_EQUAL_INT(2, fs.readAt("/r.bin", 6, buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_UINT8(7, buffer[0]);
+  TEST_ASSERT_EQUAL_INT(0, fs.readAt("/r.bin", 8, buffer, sizeof(buffer)));
+  TEST_ASSERT_EQUAL_INT(-1, fs.readAt("/none", 0, buffer, sizeof(buffer)));
+
+  // Перезапись заменяет файл, а не дописывает
+  TEST_ASSERT_TRUE(fs.write("/r.bin", (const char*)block, 3));
+  TEST_ASSERT_EQUAL_INT(3, (int)fs.size("/r.bin"));
+}
+
+void test_clock_moves_only_when_advanced() {
+  HostClock clock;
+  TEST_ASSERT_EQUAL_UINT32(0, clock.nowMs());
+
+  clock.advanceUs(1500);
+  TEST_ASSERT_EQUAL_UINT32(1, clock.nowMs());
+  TEST_ASSERT_EQUAL_UINT32(1500, clock.nowUs());
+
+  clock.advanceMs(20);
+  TEST_ASSERT_EQUAL_UINT32(21, clock.nowMs());
+  TEST_ASSERT_EQUAL_UINT32(21500, clock.nowUs());
+}
+
+void test_network_state() {
+  HostNetwork network;
+  TEST_ASSERT_FALSE(network.isConnected());
+  TEST_ASSERT_EQUAL_INT32(0, network.rssi());
+
+  network.setConnected(true, -70);
+  TEST_ASSERT_TRUE(network.isConnected());
+  TEST_ASSERT_EQUAL_INT32(-70, network.rssi());
+
+  network.setConnected(false);
+  TEST_ASSERT_EQUAL_INT32(0, network.rssi());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_i2c_routes_by_address);
+  RUN_TEST(test_pwm_keeps_duty_per_channel);
+  RUN_TEST(test_file_system_text_files);
+  RUN_TEST(test_file_system_binary_access);
+  RUN_TEST(test_clock_moves_only_when_advanced);
+  RUN_TEST(test_network_state);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// test_main.cpp (test_kalman)
+// Фильтр Калмана каналов: сходимость, подавление шума, независимость каналов
+
+#include <math.h>
+#include <unity.h>
+
+#include "NoiseKiller.h"
+
+namespace {
+
+const MultiChannelKalman::FilterProfile PROFILES[] = {
+    MultiChannelKalman::AGGRESSIVE, MultiChannelKalman::BALANCED,
+    MultiChannelKalman::RESPONSIVE,
+#ifdef HAS_TUNED_PROFILE
+    MultiChannelKalman::TUNED,
+#endif
+};
+
+const float GRAVITY = 9.81f;
+
+// Детерминированный гауссов шум: xorshift32 + Box-Muller
+class Noise {
+ public:
+  explicit Noise(uint32_t seed) : state(seed) {}
+
+  float gaussian(float sigma) {
+    float u1 = (next() % 10000 + 0.5f) / 10000.0f;
+    float u2 = (next() % 10000) / 10000.0f;
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+  }
+
+ private:
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+};
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_constant_converges_for_every_profile() {
+  for (MultiChannelKalman::FilterProfile profile : PROFILES) {
+    MultiChannelKalman kalman(1, profile);
+
+    // 40 с при 20 мс; от нуля к g без перелёта
+    float value = 0.0f;
+    for (int i = 0; i < 2000; i++) {
+      value = kalman.update(0, GRAVITY);
+      TEST_ASSERT_LESS_OR_EQUAL_FLOAT(GRAVITY + 1e-4f, value);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, GRAVITY, value);
+    TEST_ASSERT_EQUAL_FLOAT(value, kalman.getValue(0));
+  }
+}
+
+void test_noise_is_reduced_for_every_profile() {
+  for (MultiChannelKalman::FilterProfile profile : PROFILES) {
+    MultiChannelKalman kalman(1, profile);
+    kalman.reset(0, GRAVITY);
+
+    Noise noise(1);
+    double inSquares = 0.0, outSquares = 0.0;
+    for (int i = 0; i < 3000; i++) {
+      float n = noise.gaussian(0.1f);
+      float out = kalman.update(0, GRAVITY + n);
+      if (i < 1000) continue;
+      inSquares += n * n;
+      outSquares += (out - GRAVITY) * (out - GRAVITY);
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(0.6 * sqrt(inSquares),
+                                (float)sqrt(outSquares));
+  }
+}
+
+void test_channels_are_independent() {
+  MultiChannelKalman kalman(6, MultiChannelKalman::BALANCED);
+  for (int i = 0; i < 500; i++) {
+    kalman.update(0, 1.0f);
+    kalman.update(3, -40.0f);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, kalman.getValue(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.4f, -40.0f, kalman.getValue(3));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, kalman.getValue(1));
+
+  // Канал вне диапазона - измерение как есть
+  TEST_ASSERT_EQUAL_FLOAT(7.0f, kalman.update(6, 7.0f));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, kalman.getValue(6));
+
+  // Сброс канала не трогает остальные
+  kalman.reset(3, 25.0f);
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, kalman.getValue(3));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, kalman.getValue(0));
+}
+
+void test_process_noise_scale_keeps_estimates() {
+  MultiChannelKalman kalman(1, MultiChannelKalman::BALANCED);
+  for (int i = 0; i < 500; i++) kalman.update(0, GRAVITY);
+  float before = kalman.getValue(0);
+
+  kalman.setProcessNoiseScale(5.0f);
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, kalman.getProcessNoiseScale());
+  TEST_ASSERT_EQUAL_FLOAT(before, kalman.getValue(0));
+
+  // Некорректный масштаб не принимается
+  kalman.setProcessNoiseScale(0.0f);
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, kalman.getProcessNoiseScale());
+}
+
+void test_unknown_profile_falls_back_to_balanced() {
+  float q, r, p, balancedQ, balancedR, balancedP;
+  MultiChannelKalman::getProfileParameters(MultiChannelKalman::BALANCED,
+                                           balancedQ, balancedR, balancedP);
+  MultiChannelKalman::getProfileParameters(
+      (MultiChannelKalman::FilterProfile)99, q, r, p);
+  TEST_ASSERT_EQUAL_FLOAT(balancedQ, q);
+  TEST_ASSERT_EQUAL_FLOAT(balancedR, r);
+  TEST_ASSERT_EQUAL_FLOAT(balancedP, p);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_constant_converges_for_every_profile);
+  RUN_TEST(test_noise_is_reduced_for_every_profile);
+  RUN_TEST(test_channels_are_independent);
+  RUN_TEST(test_process_noise_scale_keeps_estimates);
+  RUN_TEST(test_unknown_profile_falls_back_to_balanced);
+  return UNITY_END();
+}
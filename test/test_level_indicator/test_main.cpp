@@ -0,0 +1,300 @@
+// test_main.cpp (test_level_indicator)
+// LevelIndicator на записывающем ШИМ: какие скважности и когда уходят в LEDC
+
+#include <unity.h>
+
+#include <vector>
+
+#include "HalHost.h"
+#include "LevelIndicator.h"
+
+namespace {
+
+// Каналы LevelIndicator: 1-3 выше диапазона, 4-6 ниже, 7 - внутри
+const uint8_t CHANNEL_POS1 = 1;
+const uint8_t CHANNEL_NEG1 = 4;
+const uint8_t CHANNEL_NEG2 = 5;
+const uint8_t CHANNEL_NEUTRAL = 7;
+const uint8_t CHANNEL_COUNT = 8;
+
+// Равномерный шум -1..1 (xorshift32), одинаковый на любой платформе
+class Noise {
+ public:
+  explicit Noise(uint32_t seed) : state(seed) {}
+
+  float uniform() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state % 20001) / 10000.0f - 1.0f;
+  }
+
+ private:
+  uint32_t state;
+};
+
+/**
+ * @brief ШИМ, который записывает каждое обращение
+ */
+class RecordingPwm : public HalPwm {
+ public:
+  struct Write {
+    uint8_t channel;
+    uint32_t duty;
+    bool faded;
+  };
+
+  RecordingPwm() : fadeSupported(true) {
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ch++) duty[ch] = 0;
+  }
+
+  bool attach(uint8_t, uint8_t, uint32_t, uint8_t) override { return true; }
+
+  void write(uint8_t channel, uint32_t value) override {
+    record(channel, value, false);
+  }
+
+  bool enableFade() override { return fadeSupported; }
+
+  bool fade(uint8_t channel, uint32_t value, uint16_t) override {
+    if (!fadeSupported) return false;
+    record(channel, value, true);
+    return true;
+  }
+
+  // Сколько раз писали в канал с начала или с последнего forget()
+  uint32_t writesTo(uint8_t channel) const {
+    uint32_t count = 0;
+    for (const Write& w : writes) {
+      if (w.channel == channel) count++;
+    }
+    return count;
+  }
+
+  void forget() { writes.clear(); }
+
+  bool fadeSupported;
+  std::vector<Write> writes;
+  uint32_t duty[CHANNEL_COUNT];  // Последняя цель по каналу
+
+ private:
+  void record(uint8_t channel, uint32_t value, bool faded) {
+    Write w = {channel, value, faded};
+    writes.push_back(w);
+    if (channel < CHANNEL_COUNT) duty[channel] = value;
+  }
+};
+
+struct Fixture {
+  RecordingPwm pwm;
+  HostClock clock;
+  LevelIndicator indicator;
+
+  Fixture() : indicator(pwm, clock, 25, 26, 27, 32, 33, 14, 12) {
+    indicator.begin();
+    pwm.forget();
+  }
+};
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_begin_turns_every_channel_off_once() {
+  RecordingPwm pwm;
+  HostClock clock;
+  LevelIndicator indicator(pwm, clock, 25, 26, 27, 32, 33, 14, 12);
+  indicator.begin();
+
+  // Скважность до begin() неизвестна - пишутся все 7 каналов
+  TEST_ASSERT_EQUAL_UINT32(7, pwm.writes.size());
+  for (uint8_t ch = 1; ch < CHANNEL_COUNT; ch++) {
+    TEST_ASSERT_EQUAL_UINT32(1, pwm.writesTo(ch));
+    TEST_ASSERT_EQUAL_UINT32(0, pwm.duty[ch]);
+  }
+}
+
+void test_unchanged_duties_are_skipped() {
+  Fixture f;
+
+  // Внутри диапазона меняется только зелёный
+  f.indicator.update(0.0f);
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writes.size());
+  TEST_ASSERT_EQUAL_UINT8(CHANNEL_NEUTRAL, f.pwm.writes[0].channel);
+  TEST_ASSERT_EQUAL_UINT32(255, f.pwm.writes[0].duty);
+
+  // Тот же угол и другой угол внутри диапазона - ни одной записи
+  f.pwm.forget();
+  for (int i = 0; i < 100; i++) f.indicator.update(i % 2 ? 1.0f : -1.0f);
+  TEST_ASSERT_EQUAL_UINT32(0, f.pwm.writes.size());
+
+  uint32_t written, skipped;
+  f.indicator.getWriteStats(written, skipped);
+  TEST_ASSERT_EQUAL_UINT32(8, written);  // 7 в begin() + зелёный
+  TEST_ASSERT_EQUAL_UINT32(6 + 100 * 7, skipped);
+}
+
+void test_changed_duty_is_written_exactly_once() {
+  Fixture f;
+  f.indicator.update(0.0f);
+  f.pwm.forget();
+
+  // Ниже диапазона: зелёный гаснет, первый синий загорается
+  f.indicator.update(-50.0f);
+  TEST_ASSERT_EQUAL_UINT32(2, f.pwm.writes.size());
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEUTRAL));
+  TEST_ASSERT_EQUAL_UINT32(0, f.pwm.duty[CHANNEL_NEUTRAL]);
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEG1));
+  uint32_t firstDuty = f.pwm.duty[CHANNEL_NEG1];
+  TEST_ASSERT_GREATER_THAN(0, firstDuty);
+
+  // Дальше от границы - меняется только яркость того же светодиода
+  f.pwm.forget();
+  f.indicator.update(-60.0f);
+  f.indicator.update(-60.0f);
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writes.size());
+  TEST_ASSERT_EQUAL_UINT8(CHANNEL_NEG1, f.pwm.writes[0].channel);
+  TEST_ASSERT_GREATER_THAN(firstDuty, f.pwm.duty[CHANNEL_NEG1]);
+
+  // За 2/3 градиента включается второй
+  f.pwm.forget();
+  f.indicator.update(-45.0f - 0.7f * 90.0f);
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEG1));
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEG2));
+  TEST_ASSERT_EQUAL_UINT32(0, f.pwm.writesTo(CHANNEL_POS1));
+}
+
+void test_clear_interrupts_running_fades() {
+  Fixture f;
+  f.indicator.setFadeMode(true, 200);
+  TEST_ASSERT_TRUE(f.indicator.isFadeEnabled());
+
+  // Зелёный плавно загорается; через 50 мс угол уходит ниже диапазона,
+  // но новый переход ждёт конца текущего
+  f.indicator.update(0.0f);
+  TEST_ASSERT_TRUE(f.pwm.writes.back().faded);
+  f.clock.advanceMs(50);
+  f.indicator.update(-50.0f);
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEUTRAL));
+  TEST_ASSERT_EQUAL_UINT32(255, f.pwm.duty[CHANNEL_NEUTRAL]);
+
+  // clear() перед сном: без следующего update() всё должно погаснуть
+  f.clock.advanceMs(10);
+  f.pwm.forget();
+  f.indicator.clear();
+  for (uint8_t ch = 1; ch < CHANNEL_COUNT; ch++) {
+    TEST_ASSERT_EQUAL_UINT32(0, f.pwm.duty[ch]);
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, f.pwm.writes.size());
+  for (const RecordingPwm::Write& w : f.pwm.writes) {
+    TEST_ASSERT_FALSE(w.faded);
+  }
+}
+
+void test_clear_stops_fade_towards_zero() {
+  Fixture f;
+  f.indicator.setFadeMode(true, 200);
+  f.indicator.update(0.0f);
+  f.clock.advanceMs(300);
+
+  // Зелёный гаснет переходом, цель уже 0 - но перед сном ждать нельзя
+  f.indicator.update(-50.0f);
+  f.clock.advanceMs(20);
+  f.pwm.forget();
+  f.indicator.clear();
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEUTRAL));
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEG1));
+  TEST_ASSERT_EQUAL_UINT32(2, f.pwm.writes.size());
+
+  // Повторный clear() ничего не пишет, следующий update() - сразу
+  f.pwm.forget();
+  f.indicator.clear();
+  TEST_ASSERT_EQUAL_UINT32(0, f.pwm.writes.size());
+  f.indicator.update(0.0f);
+  TEST_ASSERT_EQUAL_UINT32(1, f.pwm.writesTo(CHANNEL_NEUTRAL));
+  TEST_ASSERT_EQUAL_UINT32(255, f.pwm.duty[CHANNEL_NEUTRAL]);
+}
+
+// Шум ±0.2° у rangeMax: переходы зон и записи в LEDC
+struct NoisyTrace {
+  uint32_t transitions;
+  uint32_t writes;
+  uint32_t darkSamples;  // Сэмплы, после которых не горел ни один LED
+};
+
+NoisyTrace replayAroundMax(float band) {
+  Fixture f;
+  f.indicator.setRange(-5.0f, 5.0f);
+  f.indicator.setHysteresis(band, band);
+  f.pwm.forget();
+
+  NoisyTrace trace = {0, 0, 0};
+  Noise noise(1);
+  for (int i = 0; i < 2000; i++) {
+    f.indicator.update(5.0f + 0.2f * noise.uniform());
+    uint32_t lit = 0;
+    for (uint8_t ch = 1; ch < CHANNEL_COUNT; ch++) lit += f.pwm.duty[ch];
+    if (lit == 0) trace.darkSamples++;
+  }
+  trace.transitions = f.indicator.getZoneTransitions();
+  trace.writes = f.pwm.writes.size();
+  return trace;
+}
+
+void test_hysteresis_suppresses_zone_chatter() {
+  NoisyTrace plain = replayAroundMax(0.0f);
+  NoisyTrace banded = replayAroundMax(0.3f);
+
+  // Без полосы почти каждый второй сэмпл меняет зону
+  TEST_ASSERT_GREATER_THAN(800, plain.transitions);
+  TEST_ASSERT_EQUAL_UINT32(0, banded.transitions);
+  TEST_ASSERT_LESS_THAN(plain.writes / 10, banded.writes);
+
+  TEST_ASSERT_EQUAL_UINT32(0, plain.darkSamples);
+  TEST_ASSERT_EQUAL_UINT32(0, banded.darkSamples);
+}
+
+void test_held_zone_stays_lit_inside_band() {
+  Fixture f;
+  f.indicator.setRange(-10.0f, 10.0f);
+  f.indicator.setHysteresis(1.0f, 1.0f);
+
+  // Ниже диапазона и обратно в полосу: зона та же, синий не гаснет
+  f.indicator.update(-12.0f);
+  TEST_ASSERT_EQUAL(LevelIndicator::ZONE_BELOW, f.indicator.getZone());
+  const float below[] = {-10.5f, -10.0f, -9.5f, -9.01f};
+  for (float angle : below) {
+    f.indicator.update(angle);
+    TEST_ASSERT_EQUAL(LevelIndicator::ZONE_BELOW, f.indicator.getZone());
+    TEST_ASSERT_GREATER_THAN(0, f.pwm.duty[CHANNEL_NEG1]);
+    TEST_ASSERT_EQUAL_UINT32(0, f.pwm.duty[CHANNEL_NEUTRAL]);
+  }
+  f.indicator.update(-9.0f);
+  TEST_ASSERT_EQUAL(LevelIndicator::ZONE_INSIDE, f.indicator.getZone());
+  TEST_ASSERT_EQUAL_UINT32(0, f.pwm.duty[CHANNEL_NEG1]);
+  TEST_ASSERT_EQUAL_UINT32(255, f.pwm.duty[CHANNEL_NEUTRAL]);
+
+  // То же выше диапазона
+  f.indicator.update(11.5f);
+  TEST_ASSERT_EQUAL(LevelIndicator::ZONE_ABOVE, f.indicator.getZone());
+  f.indicator.update(9.5f);
+  TEST_ASSERT_EQUAL(LevelIndicator::ZONE_ABOVE, f.indicator.getZone());
+  TEST_ASSERT_GREATER_THAN(0, f.pwm.duty[CHANNEL_POS1]);
+  TEST_ASSERT_EQUAL_UINT32(0, f.pwm.duty[CHANNEL_NEUTRAL]);
+
+  // Первая зона после старта переходом не считается
+  TEST_ASSERT_EQUAL_UINT32(2, f.indicator.getZoneTransitions());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_turns_every_channel_off_once);
+  RUN_TEST(test_unchanged_duties_are_skipped);
+  RUN_TEST(test_changed_duty_is_written_exactly_once);
+  RUN_TEST(test_clear_interrupts_running_fades);
+  RUN_TEST(test_clear_stops_fade_towards_zero);
+  RUN_TEST(test_hysteresis_suppresses_zone_chatter);
+  RUN_TEST(test_held_zone_stays_lit_inside_band);
+  return UNITY_END();
+}
@@ -0,0 +1,190 @@
+// test_main.cpp (test_mag_calibration)
+// Подгонка эллипсоида на симуляторе с hard-iron смещением и soft-iron
+// искажением: смещение находится, курс после поправки снова верный
+
+#include <math.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "MagCalibration.h"
+#include "SensorPipeline.h"
+#include "SensorSimulator.h"
+
+namespace {
+
+const uint16_t INTERVAL_MS = SensorPipeline::REFERENCE_INTERVAL_MS;
+
+// Поле платы: смещение (мкТл) и симметричное искажение ~15%
+const float HARD_IRON[3] = {12.0f, -8.0f, 20.0f};
+const float SOFT_IRON[3][3] = {
+    {1.15f, 0.05f, 0.0f}, {0.05f, 0.92f, 0.03f}, {0.0f, 0.03f, 1.0f}};
+
+// Симулятор с искажённым магнитометром: raw = SOFT_IRON * m + HARD_IRON
+class DistortedSensor {
+ public:
+  explicit DistortedSensor(const std::vector<MotionSegment>& script)
+      : script(script), timeUs(0) {
+    simulator.setScript(this->script.data(), this->script.size(), false);
+  }
+
+  bool next(SensorDataRaw& raw) {
+    if (!simulator.sample(timeUs, raw)) return false;
+    raw.timestamp = timeUs / 1000;
+    timeUs += INTERVAL_MS * 1000UL;
+
+    const float m[3] = {raw.mag_x, raw.mag_y, raw.mag_z};
+    float out[3];
+    for (int i = 0; i < 3; i++) {
+      out[i] = HARD_IRON[i];
+      for (int j = 0; j < 3; j++) out[i] += SOFT_IRON[i][j] * m[j];
+    }
+    raw.mag_x = out[0];
+    raw.mag_y = out[1];
+    raw.mag_z = out[2];
+    return true;
+  }
+
+ private:
+  std::vector<MotionSegment> script;
+  SensorSimulator simulator;
+  uint32_t timeUs;
+};
+
+// Вращение по всем осям: плавные переходы между ориентациями
+std::vector<MotionSegment> rotationScript() {
+  const float rolls[] = {-150.0f, -90.0f, -30.0f, 30.0f, 90.0f, 150.0f,
+                         180.0f};
+  const float pitches[] = {-70.0f, -35.0f, 0.0f, 35.0f, 70.0f};
+  std::vector<MotionSegment> script;
+  for (int i = 0; i < 70; i++) {
+    MotionSegment segment = {MotionSegment::MOTION_TILT, 500, rolls[i % 7],
+                             pitches[i % 5], fmodf(i * 37.0f, 360.0f), 0.0f,
+                             0.0f};
+    script.push_back(segment);
+  }
+  return script;
+}
+
+MagCalibration::SolveResult calibrate(MagCorrection& correction) {
+  DistortedSensor sensor(rotationScript());
+  MagCalibration calibration;
+  calibration.start();
+
+  SensorDataRaw raw;
+  while (sensor.next(raw)) {
+    calibration.addSample(raw.mag_x, raw.mag_y, raw.mag_z);
+  }
+  calibration.stop();
+
+  float fieldUt, fitError;
+  return calibration.solve(correction, fieldUt, fitError);
+}
+
+float headingError(float measured, float truth) {
+  float d = fmodf(measured - truth + 540.0f, 360.0f) - 180.0f;
+  return fabsf(d);
+}
+
+// Наибольшая ошибка курса в покое при наклонах до 35°
+float maxHeadingError(const MagCorrection& correction) {
+  const float tilts[][2] = {{0.0f, 0.0f},   {35.0f, 0.0f}, {0.0f, 35.0f},
+                            {-25.0f, 25.0f}, {20.0f, -30.0f}};
+  float worst = 0.0f;
+  for (const float* tilt : tilts) {
+    for (float heading = 0.0f; heading < 360.0f; heading += 45.0f) {
+      std::vector<MotionSegment> script(
+          1, MotionSegment{MotionSegment::MOTION_STATIC, 4000, tilt[0],
+                           tilt[1], heading, 0.0f, 0.0f});
+      DistortedSensor sensor(script);
+      SensorPipeline pipeline;
+      pipeline.setMagCorrection(correction);
+
+      SensorDataRaw raw;
+      SensorData data;
+      while (sensor.next(raw)) {
+        pipeline.process(raw, data);
+        if (raw.timestamp < 3000) continue;  // Схождение фильтра
+        worst = fmaxf(worst, headingError(data.heading, heading));
+      }
+    }
+  }
+  return worst;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_fit_recovers_hard_iron_offset() {
+  MagCorrection correction;
+  TEST_ASSERT_EQUAL(MagCalibration::SOLVE_OK, calibrate(correction));
+  TEST_ASSERT_TRUE(MagCalibration::isValid(correction));
+  for (int axis = 0; axis < 3; axis++) {
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, HARD_IRON[axis], correction.offset[axis]);
+  }
+
+  // matrix симметрична и обратна искажению с точностью до масштаба
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      TEST_ASSERT_FLOAT_WITHIN(1e-4f, correction.matrix[i][j],
+                               correction.matrix[j][i]);
+    }
+  }
+  float product[3][3];
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      product[i][j] = 0.0f;
+      for (int k = 0; k < 3; k++) {
+        product[i][j] += correction.matrix[i][k] * SOFT_IRON[k][j];
+      }
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      float expected = i == j ? product[0][0] : 0.0f;
+      TEST_ASSERT_FLOAT_WITHIN(0.01f * product[0][0], expected,
+                               product[i][j]);
+    }
+  }
+}
+
+void test_heading_after_calibration() {
+  // Без поправки курс уходит на десятки градусов (~65° при наклоне)
+  TEST_ASSERT_GREATER_THAN_FLOAT(60.0f,
+                                 maxHeadingError(MagCorrection::identity()));
+
+  MagCorrection correction;
+  TEST_ASSERT_EQUAL(MagCalibration::SOLVE_OK, calibrate(correction));
+  TEST_ASSERT_LESS_THAN_FLOAT(0.3f, maxHeadingError(correction));
+}
+
+void test_too_little_rotation_is_incomplete() {
+  // Только курс при горизонтальном положении: по Z размаха нет
+  std::vector<MotionSegment> script;
+  for (int i = 1; i <= 8; i++) {
+    script.push_back(MotionSegment{MotionSegment::MOTION_TILT, 1000, 0.0f,
+                                   0.0f, i * 45.0f, 0.0f, 0.0f});
+  }
+  DistortedSensor sensor(script);
+  MagCalibration calibration;
+  calibration.start();
+  SensorDataRaw raw;
+  while (sensor.next(raw)) {
+    calibration.addSample(raw.mag_x, raw.mag_y, raw.mag_z);
+  }
+
+  MagCorrection correction;
+  float fieldUt, fitError;
+  TEST_ASSERT_EQUAL(MagCalibration::SOLVE_INCOMPLETE,
+                    calibration.solve(correction, fieldUt, fitError));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fit_recovers_hard_iron_offset);
+  RUN_TEST(test_heading_after_calibration);
+  RUN_TEST(test_too_little_rotation_is_incomplete);
+  return UNITY_END();
+}
@@ -0,0 +1,167 @@
+// test_main.cpp (test_metrics)
+// Ответ /metrics частями через маленькое окно: без обрезки и целыми строками
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "MetricsWriter.h"
+
+namespace {
+
+// Окно как на устройстве; сам ответ в несколько раз больше
+const size_t CHUNK_SIZE = 1024;
+
+// Приёмник: склеивает ответ и запоминает куски
+struct Collected {
+  std::string text;
+  std::vector<size_t> chunks;
+  bool chunksEndInNewline = true;
+};
+
+void collect(void* context, const char* data, size_t length) {
+  Collected* out = static_cast<Collected*>(context);
+  out->text.append(data, length);
+  out->chunks.push_back(length);
+  if (length == 0 || data[length - 1] != '\n') {
+    out->chunksEndInNewline = false;
+  }
+}
+
+// Все виды семейств /metrics в объёме, как у устройства (~11 КБ):
+// одиночные counter/gauge всех типов, семейства с метками, summary
+void writeAllFamilies(MetricsWriter& metrics) {
+  char name[64], labels[64];
+  for (int i = 0; i < 40; i++) {
+    snprintf(name, sizeof(name), "level_counter_%02d_total", i);
+    metrics.counter(name, "Single counter of the device", (uint32_t)i * 1000);
+    snprintf(name, sizeof(name), "level_gauge_%02d", i);
+    metrics.gauge(name, "Single float gauge of the device", i * 0.5f);
+  }
+  metrics.gauge("level_wifi_rssi_dbm", "Wi-Fi signal strength", (int32_t)-67);
+
+  metrics.family("level_outliers_total", "counter",
+                 "Samples replaced by outlier rejection");
+  for (int ch = 0; ch < 9; ch++) {
+    snprintf(labels, sizeof(labels), "channel=\"ch%d\"", ch);
+    metrics.value("level_outliers_total", (uint32_t)ch, labels);
+  }
+
+  static const char* const JOB_FAMILIES[] = {
+      "level_job_runs_total", "level_job_overruns_total",
+      "level_job_missed_periods_total", "level_job_max_run_us"};
+  for (const char* family : JOB_FAMILIES) {
+    metrics.family(family, "counter", "Scheduler job statistics");
+    for (int job = 0; job < 8; job++) {
+      snprintf(labels, sizeof(labels), "job=\"job%d\"", job);
+      metrics.value(family, (uint32_t)job * 7, labels);
+    }
+  }
+
+  static const float QUANTILES[] = {0.5f, 0.9f, 0.99f};
+  metrics.family("level_stage_duration_us", "summary",
+                 "Loop stage duration in microseconds");
+  for (int stage = 0; stage < 5; stage++) {
+    for (float q : QUANTILES) {
+      snprintf(labels, sizeof(labels), "stage=\"stage%d\",quantile=\"%g\"",
+               stage, q);
+      metrics.value("level_stage_duration_us", (uint32_t)(q * 1000), labels);
+    }
+    snprintf(labels, sizeof(labels), "stage=\"stage%d\"", stage);
+    metrics.value("level_stage_duration_us_sum", 123.5f, labels);
+    metrics.value("level_stage_duration_us_count", (uint32_t)42, labels);
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_streamed_output_matches_unbounded_render() {
+  static char whole[64 * 1024];
+  MetricsWriter reference(whole, sizeof(whole));
+  writeAllFamilies(reference);
+  TEST_ASSERT_FALSE(reference.overflowed());
+  TEST_ASSERT_TRUE(reference.length() > 8 * CHUNK_SIZE);
+
+  char window[CHUNK_SIZE];
+  Collected out;
+  MetricsWriter metrics(window, sizeof(window), collect, &out);
+  writeAllFamilies(metrics);
+  metrics.flush();
+
+  TEST_ASSERT_FALSE(metrics.overflowed());
+  TEST_ASSERT_EQUAL(0, metrics.length());
+  TEST_ASSERT_EQUAL(reference.length(), metrics.totalLength());
+  TEST_ASSERT_EQUAL_STRING(whole, out.text.c_str());
+
+  // Куски не больше окна и каждый кончается целой строкой
+  TEST_ASSERT_TRUE(out.chunks.size() > 1);
+  for (size_t length : out.chunks) TEST_ASSERT_TRUE(length < CHUNK_SIZE);
+  TEST_ASSERT_TRUE(out.chunksEndInNewline);
+}
+
+void test_every_family_is_complete() {
+  char window[CHUNK_SIZE];
+  Collected out;
+  MetricsWriter metrics(window, sizeof(window), collect, &out);
+  writeAllFamilies(metrics);
+  metrics.flush();
+
+  const std::string& text = out.text;
+  TEST_ASSERT_EQUAL('\n', text[text.size() - 1]);
+  TEST_ASSERT_TRUE(text.find("# TYPE level_counter_00_total counter\n") !=
+                   std::string::npos);
+  TEST_ASSERT_TRUE(text.find("level_gauge_39 19.500\n") != std::string::npos);
+  TEST_ASSERT_TRUE(text.find("level_wifi_rssi_dbm -67\n") !=
+                   std::string::npos);
+  TEST_ASSERT_TRUE(text.find("level_outliers_total{channel=\"ch8\"} 8\n") !=
+                   std::string::npos);
+  TEST_ASSERT_TRUE(text.find("level_job_max_run_us{job=\"job7\"} 49\n") !=
+                   std::string::npos);
+
+  // Последняя строка последнего семейства дошла целиком
+  const char* last = "level_stage_duration_us_count{stage=\"stage4\"} 42\n";
+  TEST_ASSERT_EQUAL(text.size() - strlen(last), text.rfind(last));
+}
+
+void test_line_longer_than_window_cuts_at_line_boundary() {
+  char window[64];
+  Collected out;
+  MetricsWriter metrics(window, sizeof(window), collect, &out);
+  metrics.counter("level_a_total", "A", 1u);
+  metrics.value("level_b", 2u,
+                "label=\"a label value that is longer than the whole window\"");
+  metrics.counter("level_c_total", "C", 3u);
+  metrics.flush();
+
+  TEST_ASSERT_TRUE(metrics.overflowed());
+  TEST_ASSERT_EQUAL_STRING(
+      "# HELP level_a_total A\n# TYPE level_a_total counter\n"
+      "level_a_total 1\n",
+      out.text.c_str());
+}
+
+void test_without_sink_keeps_whole_lines() {
+  char buffer[48];
+  MetricsWriter metrics(buffer, sizeof(buffer));
+  metrics.gauge("level_x", "X", 1u);
+  metrics.gauge("level_y", "Y", 2u);
+
+  TEST_ASSERT_TRUE(metrics.overflowed());
+  TEST_ASSERT_EQUAL(strlen(buffer), metrics.length());
+  TEST_ASSERT_EQUAL('\n', buffer[metrics.length() - 1]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_streamed_output_matches_unbounded_render);
+  RUN_TEST(test_every_family_is_complete);
+  RUN_TEST(test_line_longer_than_window_cuts_at_line_boundary);
+  RUN_TEST(test_without_sink_keeps_whole_lines);
+  return UNITY_END();
+}
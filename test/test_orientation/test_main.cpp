@@ -0,0 +1,144 @@
+// test_main.cpp (test_orientation)
+// Углы по вектору ускорения и вся цепочка на известном наклоне:
+// симулятор LSM303 -> драйвер -> SensorPipeline
+
+#include <math.h>
+#include <unity.h>
+
+#include "HalHost.h"
+#include "Lsm303.h"
+#include "Orientation.h"
+#include "SensorPipeline.h"
+#include "SensorSimulator.h"
+
+namespace {
+
+const float DEG = 3.14159265f / 180.0f;
+const float GRAVITY = 9.80665f;
+
+// Неподвижно с креном 10°, тангажом -5° и курсом 30°
+const MotionSegment SCRIPT_KNOWN_TILT[] = {
+    {MotionSegment::MOTION_STATIC, 10000, 10.0f, -5.0f, 30.0f, 0.0f, 0.0f},
+};
+
+// Ускорение в покое при крене и тангаже (градусы), как в симуляторе
+void gravityVector(float rollDeg, float pitchDeg, float out[3]) {
+  float r = rollDeg * DEG, p = pitchDeg * DEG;
+  out[0] = -GRAVITY * sinf(p);
+  out[1] = GRAVITY * cosf(p) * sinf(r);
+  out[2] = GRAVITY * cosf(p) * cosf(r);
+}
+
+struct TiltStats {
+  float meanRoll, meanPitch, meanHeading;
+  float maxRollError, maxPitchError;
+};
+
+// Прогон сценария через драйвер и конвейер; первые 3 с - схождение
+bool runKnownTilt(SensorPipeline& pipeline, TiltStats& stats) {
+  HostClock clock;
+  SensorSimulator simulator;
+  simulator.setScript(SCRIPT_KNOWN_TILT, 1, false);
+  SimulatedLsm303 bus(simulator, clock);
+  Lsm303 sensor(bus);
+  if (!sensor.beginAccel() || !sensor.beginMag()) return false;
+
+  stats = TiltStats();
+  uint32_t count = 0;
+  const uint16_t intervalMs = SensorPipeline::REFERENCE_INTERVAL_MS;
+  for (uint32_t t = 0; t < 9000; t += intervalMs) {
+    SensorDataRaw raw = SensorDataRaw();
+    sensor.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+    sensor.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+    raw.timestamp = clock.nowMs();
+    SensorData data;
+    pipeline.process(raw, data);
+    clock.advanceMs(intervalMs);
+    if (t < 3000) continue;
+
+    stats.meanRoll += data.roll;
+    stats.meanPitch += data.pitch;
+    stats.meanHeading += data.heading;
+    stats.maxRollError =
+        fmaxf(stats.maxRollError, fabsf(data.roll - simulator.getTrueRoll()));
+    stats.maxPitchError = fmaxf(stats.maxPitchError,
+                                fabsf(data.pitch - simulator.getTruePitch()));
+    count++;
+  }
+  stats.meanRoll /= count;
+  stats.meanPitch /= count;
+  stats.meanHeading /= count;
+  return true;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_angles_of_exact_gravity_vector() {
+  const float angles[][2] = {
+      {0.0f, 0.0f}, {10.0f, -5.0f}, {-30.0f, 20.0f}, {170.0f, 45.0f}};
+  for (const float* angle : angles) {
+    float a[3];
+    gravityVector(angle[0], angle[1], a);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, angle[0], computeRoll(a[0], a[1], a[2]));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, angle[1], computePitch(a[0], a[1], a[2]));
+  }
+
+  // Без проекции на YZ крен не определён
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, computeRoll(GRAVITY, 0.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -90.0f, computePitch(GRAVITY, 0.0f, 0.0f));
+}
+
+void test_heading_is_tilt_compensated() {
+  // Горизонтальная часть поля на 40° от +X к +Y и вертикальная вниз
+  const float h = 28.0f, down = 40.0f, angle = 40.0f * DEG;
+  const float level[3] = {h * cosf(angle), h * sinf(angle), -down};
+  float a[3];
+  gravityVector(0.0f, 0.0f, a);
+  TEST_ASSERT_FLOAT_WITHIN(1e-2f, 40.0f,
+                           computeHeading(a[0], a[1], a[2], level[0],
+                                          level[1], level[2]));
+
+  // Тот же курс при крене 20°: поле поворачивается вместе с датчиком
+  float r = 20.0f * DEG;
+  gravityVector(20.0f, 0.0f, a);
+  float mx = level[0];
+  float my = cosf(r) * level[1] + sinf(r) * level[2];
+  float mz = -sinf(r) * level[1] + cosf(r) * level[2];
+  TEST_ASSERT_FLOAT_WITHIN(1e-2f, 40.0f,
+                           computeHeading(a[0], a[1], a[2], mx, my, mz));
+}
+
+void test_pipeline_reads_known_tilt() {
+  SensorPipeline pipeline;
+  TiltStats stats;
+  TEST_ASSERT_TRUE(runKnownTilt(pipeline, stats));
+
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 10.0f, stats.meanRoll);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, -5.0f, stats.meanPitch);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 30.0f, stats.meanHeading);
+  TEST_ASSERT_LESS_THAN_FLOAT(0.3f, stats.maxRollError);
+  TEST_ASSERT_LESS_THAN_FLOAT(0.3f, stats.maxPitchError);
+}
+
+void test_zero_offset_and_axis_swap() {
+  SensorPipeline pipeline;
+  pipeline.setUserSettings(1.5f, true);
+  TiltStats stats;
+  TEST_ASSERT_TRUE(runKnownTilt(pipeline, stats));
+
+  // Поправка к крену, потом крен и тангаж меняются местами
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, -5.0f, stats.meanRoll);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 11.5f, stats.meanPitch);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_angles_of_exact_gravity_vector);
+  RUN_TEST(test_heading_is_tilt_compensated);
+  RUN_TEST(test_pipeline_reads_known_tilt);
+  RUN_TEST(test_zero_offset_and_axis_swap);
+  return UNITY_END();
+}
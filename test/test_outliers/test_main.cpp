@@ -0,0 +1,61 @@
+// test_main.cpp (test_outliers)
+// Отбраковка выбросов на сценариях симулятора: удары сценария impacts
+// отсекаются и уводят тангаж меньше, на остальных сценариях отказов нет
+
+#include <unity.h>
+
+#include "ProfileRun.h"
+
+namespace {
+
+const OutlierRejector::Mode MODES[] = {OutlierRejector::HAMPEL,
+                                       OutlierRejector::INNOVATION};
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_impacts_are_rejected() {
+  // Удары вдоль X: без отбраковки они уводят тангаж
+  ProfileRun::RunStats off = ProfileRun::run(
+      SensorSimulator::PROFILE_IMPACTS, OrientationEngine::ACCEL);
+  TEST_ASSERT_TRUE(off.samples > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, off.rejected);
+
+  for (OutlierRejector::Mode mode : MODES) {
+    ProfileRun::RunStats stats = ProfileRun::run(
+        SensorSimulator::PROFILE_IMPACTS, OrientationEngine::ACCEL, mode);
+    TEST_ASSERT_TRUE(stats.rejected > 0);
+    TEST_ASSERT_TRUE(stats.pitchMaxError < off.pitchMaxError);
+    TEST_ASSERT_TRUE(ProfileRun::pitchRms(stats) <
+                     ProfileRun::pitchRms(off));
+    TEST_ASSERT_TRUE(stats.maxMotion < off.maxMotion);
+  }
+}
+
+void test_clean_profiles_are_untouched() {
+  const SensorSimulator::Profile profiles[] = {
+      SensorSimulator::PROFILE_STATIC, SensorSimulator::PROFILE_SLOW_TILT,
+      SensorSimulator::PROFILE_VIBRATION};
+  for (SensorSimulator::Profile profile : profiles) {
+    ProfileRun::RunStats off =
+        ProfileRun::run(profile, OrientationEngine::ACCEL);
+    TEST_ASSERT_TRUE(off.samples > 0);
+    for (OutlierRejector::Mode mode : MODES) {
+      ProfileRun::RunStats stats =
+          ProfileRun::run(profile, OrientationEngine::ACCEL, mode);
+      TEST_ASSERT_EQUAL_UINT32(0, stats.rejected);
+      // Без отказов конвейер даёт те же углы, что и без отбраковки
+      TEST_ASSERT_TRUE(off.sumSquares == stats.sumSquares);
+      TEST_ASSERT_TRUE(off.pitchSumSquares == stats.pitchSumSquares);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_impacts_are_rejected);
+  RUN_TEST(test_clean_profiles_are_untouched);
+  return UNITY_END();
+}
@@ -0,0 +1,256 @@
+// test_main.cpp (test_param_parser)
+// Строгий разбор параметров запроса: граничные значения и случайные строки
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include "ParamParser.h"
+
+namespace {
+
+ParseError parseFloatText(const char* text, float& out) {
+  return ParamParser::parseFloat(ParamView(text), out);
+}
+
+ParseError parseIntText(const char* text, long& out) {
+  return ParamParser::parseInt(ParamView(text), LONG_MIN, LONG_MAX, out);
+}
+
+ParseError parseRangeText(const char* text, uint32_t size, uint32_t& first,
+                          uint32_t& last) {
+  return ParamParser::parseByteRange(ParamView(text), size, first, last);
+}
+
+// Генератор случайных строк из символов, которые встречаются в числах
+class RandomText {
+ public:
+  explicit RandomText(uint32_t seed) : state(seed) {}
+
+  size_t next(char* buffer, size_t capacity) {
+    static const char ALPHABET[] = "0123456789+-.eE xbytes=,";
+    size_t length = nextRandom() % capacity;
+    for (size_t i = 0; i < length; i++) {
+      buffer[i] = ALPHABET[nextRandom() % (sizeof(ALPHABET) - 1)];
+    }
+    return length;
+  }
+
+ private:
+  uint32_t state;
+
+  uint32_t nextRandom() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+};
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_missing_and_empty() {
+  float f = 0.0f;
+  long i = 0;
+  bool b = false;
+  uint32_t first = 0, last = 0;
+
+  TEST_ASSERT_EQUAL(PARSE_MISSING, ParamParser::parseFloat(ParamView(), f));
+  TEST_ASSERT_EQUAL(PARSE_MISSING, ParamParser::parseBool(ParamView(), b));
+  TEST_ASSERT_EQUAL(PARSE_EMPTY, parseFloatText("", f));
+  TEST_ASSERT_EQUAL(PARSE_EMPTY, parseIntText("", i));
+  TEST_ASSERT_EQUAL(PARSE_EMPTY, ParamParser::parseBool(ParamView(""), b));
+  TEST_ASSERT_EQUAL(PARSE_EMPTY, parseRangeText("", 100, first, last));
+}
+
+void test_float_format() {
+  float value = 0.0f;
+  TEST_ASSERT_EQUAL(PARSE_OK, parseFloatText("-1.25e2", value));
+  TEST_ASSERT_EQUAL_FLOAT(-125.0f, value);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseFloatText("+.5", value));
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, value);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseFloatText("5.", value));
+  TEST_ASSERT_EQUAL_FLOAT(5.0f, value);
+
+  // Знак без цифр, хвост, пробелы и то, что принимает strtof
+  const char* malformed[] = {"-",  "+",   ".",    "-.",   "1e",
+                             "1e+", "1.5x", " 1",  "1 ",   "nan",
+                             "inf", "0x10", "1..2", "--1", "e5"};
+  for (const char* text : malformed) {
+    value = 7.0f;
+    TEST_ASSERT_EQUAL_MESSAGE(PARSE_MALFORMED, parseFloatText(text, value),
+                              text);
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, value);  // Результат не тронут
+  }
+
+  // Переполнение float и слишком длинная запись
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE, parseFloatText("1e39", value));
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE, parseFloatText("-1e39", value));
+  TEST_ASSERT_EQUAL(PARSE_MALFORMED,
+                    parseFloatText("00000000000000000000000000000001", value));
+
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE,
+                    ParamParser::parseFloat(ParamView("90.5"), -90.0f, 90.0f,
+                                            value));
+  TEST_ASSERT_EQUAL(PARSE_OK, ParamParser::parseFloat(ParamView("-90"), -90.0f,
+                                                      90.0f, value));
+}
+
+void test_int_limits() {
+  char text[32];
+  long value = 0;
+
+  snprintf(text, sizeof(text), "%ld", LONG_MAX);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseIntText(text, value));
+  TEST_ASSERT_TRUE(value == LONG_MAX);
+  snprintf(text, sizeof(text), "%ld", LONG_MIN);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseIntText(text, value));
+  TEST_ASSERT_TRUE(value == LONG_MIN);
+
+  // На единицу за пределами long
+  snprintf(text, sizeof(text), "%lu", (unsigned long)LONG_MAX + 1);
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE, parseIntText(text, value));
+  snprintf(text, sizeof(text), "-%lu", (unsigned long)LONG_MAX + 2);
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE, parseIntText(text, value));
+
+  // Переполнение unsigned long, мусор после переполнения - мусор
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE,
+                    parseIntText("999999999999999999999999", value));
+  TEST_ASSERT_EQUAL(PARSE_MALFORMED,
+                    parseIntText("999999999999999999999999x", value));
+
+  const char* malformed[] = {"-", "+", "12a", "1.0", " 1", "1e3", "--1"};
+  for (const char* text : malformed) {
+    TEST_ASSERT_EQUAL_MESSAGE(PARSE_MALFORMED, parseIntText(text, value),
+                              text);
+  }
+
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE,
+                    ParamParser::parseInt(ParamView("11"), 0, 10, value));
+  TEST_ASSERT_EQUAL(PARSE_OK,
+                    ParamParser::parseInt(ParamView("+10"), 0, 10, value));
+  TEST_ASSERT_EQUAL(10, value);
+}
+
+void test_bool_words() {
+  const char* yes[] = {"1", "true", "TRUE", "Yes", "on"};
+  const char* no[] = {"0", "false", "No", "OFF"};
+  const char* malformed[] = {"2", "tru", "truex", " on", "y"};
+  bool value;
+
+  for (const char* text : yes) {
+    value = false;
+    TEST_ASSERT_EQUAL(PARSE_OK, ParamParser::parseBool(ParamView(text), value));
+    TEST_ASSERT_TRUE_MESSAGE(value, text);
+  }
+  for (const char* text : no) {
+    value = true;
+    TEST_ASSERT_EQUAL(PARSE_OK, ParamParser::parseBool(ParamView(text), value));
+    TEST_ASSERT_FALSE_MESSAGE(value, text);
+  }
+  for (const char* text : malformed) {
+    TEST_ASSERT_EQUAL_MESSAGE(PARSE_MALFORMED,
+                              ParamParser::parseBool(ParamView(text), value),
+                              text);
+  }
+}
+
+void test_byte_ranges() {
+  uint32_t first = 0, last = 0;
+
+  TEST_ASSERT_EQUAL(PARSE_OK, parseRangeText("bytes=0-", 100, first, last));
+  TEST_ASSERT_EQUAL_UINT32(0, first);
+  TEST_ASSERT_EQUAL_UINT32(99, last);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseRangeText("BYTES=10-200", 100, first, last));
+  TEST_ASSERT_EQUAL_UINT32(10, first);
+  TEST_ASSERT_EQUAL_UINT32(99, last);  // Конец обрезан
+  TEST_ASSERT_EQUAL(PARSE_OK, parseRangeText("bytes=-10", 100, first, last));
+  TEST_ASSERT_EQUAL_UINT32(90, first);
+  TEST_ASSERT_EQUAL_UINT32(99, last);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseRangeText("bytes=-200", 100, first, last));
+  TEST_ASSERT_EQUAL_UINT32(0, first);
+  TEST_ASSERT_EQUAL(PARSE_OK, parseRangeText("bytes=5-5", 100, first, last));
+  TEST_ASSERT_EQUAL_UINT32(5, first);
+  TEST_ASSERT_EQUAL_UINT32(5, last);
+
+  // Пустой суффикс и начало за концом не пересекаются с содержимым
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE,
+                    parseRangeText("bytes=-0", 100, first, last));
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE,
+                    parseRangeText("bytes=100-", 100, first, last));
+  TEST_ASSERT_EQUAL(PARSE_OUT_OF_RANGE,
+                    parseRangeText("bytes=0-", 0, first, last));
+
+  const char* malformed[] = {"bytes=5-2", "bytes=",        "bytes=5",
+                             "bytes=-",   "bytes=1-2,4-5", "items=1-2",
+                             "bytes=a-b", "bytes=--1",     "bytes= 1-2"};
+  for (const char* text : malformed) {
+    TEST_ASSERT_EQUAL_MESSAGE(PARSE_MALFORMED,
+                              parseRangeText(text, 100, first, last), text);
+  }
+}
+
+// Случайные строки: разбор не читает за границей значения, а принятые
+// значения совпадают с тем, что дают strtol/strtof
+void test_random_inputs() {
+  RandomText random(12345);
+  char buffer[48];
+  char copy[48];
+  uint32_t accepted = 0;
+
+  for (int iteration = 0; iteration < 200000; iteration++) {
+    size_t length = random.next(buffer, 40);
+    // После значения - цифры, а не '\0': чтение за границей их увидит
+    memset(buffer + length, '7', sizeof(buffer) - length);
+    memcpy(copy, buffer, length);
+    copy[length] = '\0';
+    ParamView view(buffer, length);
+
+    long i = 0, iCopy = 0;
+    ParseError intError =
+        ParamParser::parseInt(view, LONG_MIN, LONG_MAX, i);
+    TEST_ASSERT_EQUAL(intError, parseIntText(copy, iCopy));
+    if (intError == PARSE_OK) {
+      char* end;
+      TEST_ASSERT_TRUE(i == strtol(copy, &end, 10));
+      TEST_ASSERT_EQUAL_PTR(copy + length, end);
+      accepted++;
+    }
+
+    float f = 0.0f, fCopy = 0.0f;
+    ParseError floatError = ParamParser::parseFloat(view, f);
+    TEST_ASSERT_EQUAL(floatError, parseFloatText(copy, fCopy));
+    if (floatError == PARSE_OK) {
+      char* end;
+      TEST_ASSERT_EQUAL_FLOAT(strtof(copy, &end), f);
+      TEST_ASSERT_EQUAL_PTR(copy + length, end);
+      accepted++;
+    }
+
+    uint32_t first = 0, last = 0;
+    if (ParamParser::parseByteRange(view, 1000, first, last) == PARSE_OK) {
+      TEST_ASSERT_TRUE(first <= last);
+      TEST_ASSERT_TRUE(last < 1000);
+      accepted++;
+    }
+  }
+
+  // Генератор действительно доходит до корректных значений
+  TEST_ASSERT_GREATER_THAN_UINT32(1000, accepted);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_missing_and_empty);
+  RUN_TEST(test_float_format);
+  RUN_TEST(test_int_limits);
+  RUN_TEST(test_bool_words);
+  RUN_TEST(test_byte_ranges);
+  RUN_TEST(test_random_inputs);
+  return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// test_main.cpp (test_recorder)
+// Кольцо записи на HostFileSystem: блок - свой файл, пишется целиком,
+// после перезапуска запись продолжается за последним блоком
+
+#include <stdio.h>
+#include <unity.h>
+
+#include "HalHost.h"
+#include "RecordFormat.h"
+#include "SampleRecorder.h"
+
+namespace {
+
+const char* const DIRECTORY = "/rec";
+const uint16_t BLOCK_COUNT = 4;
+const uint16_t INTERVAL_MS = 20;
+
+// Записать сэмпл и сразу выполнить работу задачи записи
+void recordSample(SampleRecorder& recorder, uint32_t& nowMs) {
+  SensorData data = SensorData();
+  SensorDataRaw raw = SensorDataRaw();
+  data.roll = 1.5f;
+  data.pitch = -0.5f;
+  raw.accel_x = 100;
+  raw.accel_z = 16000;
+  recorder.record(nowMs, data, raw);
+  recorder.writePending();
+  nowMs += INTERVAL_MS;
+}
+
+// Писать, пока не будет записано blocks полных блоков
+void recordBlocks(SampleRecorder& recorder, uint32_t& nowMs,
+                  uint32_t blocks) {
+  uint32_t target = recorder.getBlocksWritten() + blocks;
+  for (int i = 0; i < 100000 && recorder.getBlocksWritten() < target; i++) {
+    recordSample(recorder, nowMs);
+  }
+  TEST_ASSERT_EQUAL_UINT32(target, recorder.getBlocksWritten());
+}
+
+bool readHeader(HalFileSystem& fs, uint16_t slot, RecordBlockHeader& out) {
+  char path[SampleRecorder::BLOCK_PATH_SIZE];
+  snprintf(path, sizeof(path), "%s/%03u.bin", DIRECTORY, (unsigned)slot);
+  uint8_t block[RecordFormat::BLOCK_SIZE];
+  return fs.readAt(path, 0, block, sizeof(block)) == (int)sizeof(block) &&
+         RecordFormat::verifyBlock(block, out);
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_full_block_is_written_as_its_own_file() {
+  HostFileSystem fs;
+  SampleRecorder recorder(fs, DIRECTORY, BLOCK_COUNT);
+  TEST_ASSERT_TRUE(recorder.begin());
+  recorder.setIntervalMs(INTERVAL_MS);
+
+  uint32_t nowMs = 0;
+  recordBlocks(recorder, nowMs, 1);
+
+  RecordBlockHeader header;
+  TEST_ASSERT_TRUE(readHeader(fs, 0, header));
+  TEST_ASSERT_EQUAL_UINT32(1, header.sequence);
+  TEST_ASSERT_TRUE(header.sampleCount > 0);
+  TEST_ASSERT_EQUAL_INT((int)RecordFormat::BLOCK_SIZE,
+                        (int)fs.size("/rec/000.bin"));
+  TEST_ASSERT_FALSE(fs.exists("/rec/001.bin"));
+  TEST_ASSERT_EQUAL_UINT16(1, recorder.getHeadSlot());
+  TEST_ASSERT_EQUAL_UINT32(0, recorder.getWriteErrors());
+}
+
+void test_partial_flush_replaces_the_head_file() {
+  HostFileSystem fs;
+  SampleRecorder recorder(fs, DIRECTORY, BLOCK_COUNT);
+  TEST_ASSERT_TRUE(recorder.begin());
+  recorder.setIntervalMs(INTERVAL_MS);
+
+  uint32_t nowMs = 0;
+  for (int i = 0; i < 10; i++) recordSample(recorder, nowMs);
+  recorder.requestFlush();
+  recordSample(recorder, nowMs);  // Сброс идёт из record()
+
+  RecordBlockHeader first;
+  TEST_ASSERT_TRUE(readHeader(fs, 0, first));
+
+  for (int i = 0; i < 10; i++) recordSample(recorder, nowMs);
+  recorder.requestFlush();
+  recordSample(recorder, nowMs);
+
+  // Тот же слот и номер, сэмплов больше; новых файлов нет
+  RecordBlockHeader second;
+  TEST_ASSERT_TRUE(readHeader(fs, 0, second));
+  TEST_ASSERT_EQUAL_UINT32(first.sequence, second.sequence);
+  TEST_ASSERT_TRUE(second.sampleCount > first.sampleCount);
+  TEST_ASSERT_FALSE(fs.exists("/rec/001.bin"));
+  TEST_ASSERT_EQUAL_UINT16(0, recorder.getHeadSlot());
+}
+
+void test_ring_wraps_and_restart_continues_after_last_block() {
+  HostFileSystem fs;
+  const char legacy[] = "old ring";
+  fs.write(SampleRecorder::LEGACY_PATH, legacy, sizeof(legacy));
+
+  uint32_t nowMs = 0;
+  {
+    SampleRecorder recorder(fs, DIRECTORY, BLOCK_COUNT);
+    TEST_ASSERT_TRUE(recorder.begin());
+    TEST_ASSERT_FALSE(fs.exists(SampleRecorder::LEGACY_PATH));
+    recorder.setIntervalMs(INTERVAL_MS);
+    recordBlocks(recorder, nowMs, BLOCK_COUNT + 1);
+  }
+
+  // Блок 5 занял слот 0 на месте самого старого
+  RecordBlockHeader header;
+  TEST_ASSERT_TRUE(readHeader(fs, 0, header));
+  TEST_ASSERT_EQUAL_UINT32(BLOCK_COUNT + 1, header.sequence);
+  TEST_ASSERT_TRUE(readHeader(fs, 1, header));
+  TEST_ASSERT_EQUAL_UINT32(2, header.sequence);
+  TEST_ASSERT_FALSE(fs.exists("/rec/004.bin"));
+
+  SampleRecorder restarted(fs, DIRECTORY, BLOCK_COUNT);
+  TEST_ASSERT_TRUE(restarted.begin());
+  TEST_ASSERT_EQUAL_UINT16(1, restarted.getHeadSlot());
+  TEST_ASSERT_EQUAL_UINT32(BLOCK_COUNT + 2, restarted.getSequence());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_block_is_written_as_its_own_file);
+  RUN_TEST(test_partial_flush_replaces_the_head_file);
+  RUN_TEST(test_ring_wraps_and_restart_continues_after_last_block);
+  return UNITY_END();
+}
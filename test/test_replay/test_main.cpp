@@ -0,0 +1,265 @@
+// test_main.cpp (test_replay)
+// Запись симулятора в двоичном виде (кольцо блоков) и в CSV выгрузки:
+// tools/replay должен получить из обоих одни и те же сэмплы и метрики,
+// а поиск tools/tuner по ней - один результат при любом числе потоков
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "HalHost.h"
+#include "Lsm303.h"
+#include "RecordFormat.h"
+#include "ReplayEngine.h"
+#include "SensorSimulator.h"
+#include "TunerSearch.h"
+
+namespace {
+
+const char* const BINARY_PATH = "test_replay.rec";
+const char* const CSV_PATH = "test_replay.csv";
+
+const uint16_t INTERVAL_MS = SensorPipeline::REFERENCE_INTERVAL_MS;
+const uint32_t DURATION_MS = 60000;
+
+// Блоки кольца сдвинуты на столько слотов: самый старый не первый
+const size_t RING_ROTATION = 3;
+
+struct Block {
+  uint32_t sequence;
+  std::vector<uint8_t> data;
+};
+
+// Сценарий slow_tilt через драйвер и конвейер, как пишет SampleRecorder
+bool recordSimulator(std::vector<Block>& blocks,
+                     std::vector<RecordSample>& samples) {
+  HostClock clock;
+  SensorSimulator simulator(SensorSimulator::PROFILE_SLOW_TILT, 1);
+  SimulatedLsm303 bus(simulator, clock);
+  Lsm303 sensor(bus);
+  if (!sensor.beginAccel() || !sensor.beginMag()) return false;
+
+  SensorPipeline pipeline;
+  RecordBlockEncoder encoder;
+  Block block;
+  block.data.assign(RecordFormat::BLOCK_SIZE, 0);
+  encoder.begin(block.data.data(), 1, INTERVAL_MS);
+
+  for (uint32_t t = 0; t < DURATION_MS; t += INTERVAL_MS) {
+    SensorDataRaw raw = SensorDataRaw();
+    sensor.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+    sensor.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+    raw.timestamp = clock.nowMs();
+    SensorData data;
+    pipeline.process(raw, data);
+    clock.advanceMs(INTERVAL_MS);
+
+    RecordSample sample;
+    RecordFormat::makeSample(raw.timestamp, data.roll, data.pitch, raw,
+                             sample);
+    if (!encoder.append(sample)) {
+      encoder.finish();
+      block.sequence = encoder.getSequence();
+      blocks.push_back(block);
+      block.data.assign(RecordFormat::BLOCK_SIZE, 0);
+      encoder.begin(block.data.data(), block.sequence + 1, INTERVAL_MS);
+      if (!encoder.append(sample)) return false;
+    }
+    samples.push_back(sample);
+  }
+  encoder.finish();
+  block.sequence = encoder.getSequence();
+  blocks.push_back(block);
+  return true;
+}
+
+// Копия кольца: блоки со сдвигом и один ещё не записанный слот
+bool writeBinary(const std::vector<Block>& blocks) {
+  FILE* file = fopen(BINARY_PATH, "wb");
+  if (!file) return false;
+
+  std::vector<uint8_t> erased(RecordFormat::BLOCK_SIZE, 0xFF);
+  fwrite(erased.data(), 1, erased.size(), file);
+  for (size_t i = 0; i < blocks.size(); i++) {
+    const Block& block = blocks[(i + RING_ROTATION) % blocks.size()];
+    fwrite(block.data.data(), 1, block.data.size(), file);
+  }
+  return fclose(file) == 0;
+}
+
+// Как /log?format=csv: заголовок и строки по порядку блоков
+bool writeCsv(const std::vector<Block>& blocks) {
+  FILE* file = fopen(CSV_PATH, "w");
+  if (!file) return false;
+
+  fputs(RecordFormat::CSV_HEADER, file);
+  for (const Block& block : blocks) {
+    RecordBlockDecoder decoder;
+    if (!decoder.begin(block.data.data())) {
+      fclose(file);
+      return false;
+    }
+    RecordSample sample;
+    char row[RecordFormat::MAX_CSV_ROW];
+    while (decoder.next(sample)) {
+      size_t length =
+          RecordFormat::formatCsvRow(sample, block.sequence, row, sizeof(row));
+      fwrite(row, 1, length, file);
+    }
+  }
+  return fclose(file) == 0;
+}
+
+struct Recording {
+  std::vector<RecordSample> samples;
+  ReplayDataset binary;
+  ReplayDataset csv;
+};
+
+bool loadRecording(Recording& recording) {
+  std::vector<Block> blocks;
+  if (!recordSimulator(blocks, recording.samples) || blocks.size() < 4 ||
+      !writeBinary(blocks) || !writeCsv(blocks)) {
+    return false;
+  }
+
+  std::string error;
+  return recording.binary.load(BINARY_PATH, error) &&
+         recording.csv.load(CSV_PATH, error);
+}
+
+bool sameRaw(const SensorDataRaw& a, const SensorDataRaw& b) {
+  return a.accel_x == b.accel_x && a.accel_y == b.accel_y &&
+         a.accel_z == b.accel_z && a.mag_x == b.mag_x && a.mag_y == b.mag_y &&
+         a.mag_z == b.mag_z && a.timestamp == b.timestamp;
+}
+
+bool sameMetrics(const ReplayMetrics& a, const ReplayMetrics& b) {
+  return a.noiseRms == b.noiseRms && a.trackingRms == b.trackingRms &&
+         a.lagMs == b.lagMs && a.maxError == b.maxError &&
+         a.quietSamples == b.quietSamples &&
+         a.movingSamples == b.movingSamples;
+}
+
+FilterParams profileParams(MultiChannelKalman::FilterProfile profile) {
+  FilterParams params;
+  params.name = "profile";
+  MultiChannelKalman::getProfileParameters(profile, params.q, params.r,
+                                           params.p);
+  return params;
+}
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {
+  remove(BINARY_PATH);
+  remove(CSV_PATH);
+}
+
+void test_binary_and_csv_load_the_same_samples() {
+  Recording recording;
+  TEST_ASSERT_TRUE(loadRecording(recording));
+  const ReplayDataset& binary = recording.binary;
+  const ReplayDataset& csv = recording.csv;
+
+  TEST_ASSERT_EQUAL_UINT32(0, binary.badBlocks);
+  TEST_ASSERT_EQUAL_UINT32(0, csv.badLines);
+  TEST_ASSERT_EQUAL_size_t(recording.samples.size(), binary.size());
+  TEST_ASSERT_EQUAL_size_t(binary.size(), csv.size());
+
+  // Кольцо разложено по номерам блоков обратно во времени записи
+  for (size_t i = 0; i < binary.size(); i++) {
+    SensorDataRaw expected;
+    RecordFormat::toRaw(recording.samples[i], expected);
+    TEST_ASSERT_TRUE(sameRaw(expected, binary.raw[i]));
+    TEST_ASSERT_TRUE(sameRaw(binary.raw[i], csv.raw[i]));
+    TEST_ASSERT_EQUAL_UINT32(binary.sequence[i], csv.sequence[i]);
+    TEST_ASSERT_TRUE(binary.deviceRoll[i] == csv.deviceRoll[i]);
+    TEST_ASSERT_TRUE(binary.devicePitch[i] == csv.devicePitch[i]);
+  }
+
+  TEST_ASSERT_EQUAL_size_t(1, binary.segments.size());
+  TEST_ASSERT_EQUAL_size_t(1, csv.segments.size());
+  TEST_ASSERT_EQUAL_UINT16(INTERVAL_MS, binary.segments[0].intervalMs);
+}
+
+void test_binary_and_csv_give_identical_metrics() {
+  Recording recording;
+  TEST_ASSERT_TRUE(loadRecording(recording));
+
+  const MultiChannelKalman::FilterProfile profiles[] = {
+      MultiChannelKalman::AGGRESSIVE, MultiChannelKalman::BALANCED,
+      MultiChannelKalman::RESPONSIVE};
+  for (MultiChannelKalman::FilterProfile profile : profiles) {
+    ReplayMetrics binary, csv;
+    runReplay(recording.binary, profileParams(profile), binary);
+    runReplay(recording.csv, profileParams(profile), csv);
+    TEST_ASSERT_TRUE(sameMetrics(binary, csv));
+
+    // В slow_tilt есть и покой, и наклоны
+    TEST_ASSERT_GREATER_THAN_UINT32(100, binary.quietSamples);
+    TEST_ASSERT_GREATER_THAN_UINT32(100, binary.movingSamples);
+  }
+}
+
+void test_motion_threshold_cuts_lag_without_extra_noise() {
+  Recording recording;
+  TEST_ASSERT_TRUE(loadRecording(recording));
+
+  // Наклоны slow_tilt выше порога, покой - ниже
+  FilterParams params = profileParams(MultiChannelKalman::AGGRESSIVE);
+  ReplayMetrics fixed, adaptive;
+  runReplay(recording.binary, params, fixed);
+  params.motionThreshold = 0.05f;
+  runReplay(recording.binary, params, adaptive);
+
+  TEST_ASSERT_TRUE(adaptive.lagMs < 0.75 * fixed.lagMs);
+  TEST_ASSERT_TRUE(adaptive.noiseRms < 1.1 * fixed.noiseRms);
+}
+
+void test_tuner_result_does_not_depend_on_threads() {
+  Recording recording;
+  TEST_ASSERT_TRUE(loadRecording(recording));
+  std::vector<ReplayDataset> datasets(1, recording.binary);
+
+  // Короткий поиск: сетка 4x4 и несколько шагов уточнения
+  FilterTuner::SearchOptions options;
+  options.gridSteps = 4;
+  options.rounds = 3;
+
+  std::vector<FilterTuner::Candidate> reference;
+  size_t referenceBest = 0;
+  const unsigned threadCounts[] = {1, 3, 8};
+  for (unsigned threads : threadCounts) {
+    options.threads = threads;
+    FilterTuner::Evaluator evaluator(datasets, options);
+    std::vector<FilterTuner::Candidate> candidates;
+    size_t best = FilterTuner::search(evaluator, options, candidates);
+
+    if (threads == 1) {
+      reference = candidates;
+      referenceBest = best;
+      continue;
+    }
+    TEST_ASSERT_EQUAL_size_t(referenceBest, best);
+    TEST_ASSERT_EQUAL_size_t(reference.size(), candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+      TEST_ASSERT_EQUAL_MEMORY(reference[i].value, candidates[i].value,
+                               sizeof(candidates[i].value));
+      TEST_ASSERT_TRUE(reference[i].score.score == candidates[i].score.score);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_binary_and_csv_load_the_same_samples);
+  RUN_TEST(test_binary_and_csv_give_identical_metrics);
+  RUN_TEST(test_motion_threshold_cuts_lag_without_extra_noise);
+  RUN_TEST(test_tuner_result_does_not_depend_on_threads);
+  return UNITY_END();
+}
@@ -0,0 +1,186 @@
+// test_main.cpp (test_stage_pipeline)
+// Конвейеры из этапов PipelineStages.h против SensorPipeline на одних и
+// тех же сэмплах симулятора: при порядке по умолчанию - бит в бит
+
+#include <unity.h>
+
+#include <vector>
+
+#include "HalHost.h"
+#include "L3gd20.h"
+#include "Lsm303.h"
+#include "SensorPipeline.h"
+#include "SensorSimulator.h"
+#include "StagePipeline.h"
+
+namespace {
+
+const uint32_t DURATION_MS = 30000;
+const uint8_t DECIMATE = 5;
+
+// Сэмплы через драйверы (с квантованием регистров), как на устройстве
+std::vector<SensorDataRaw> generate(SensorSimulator::Profile profile) {
+  HostClock clock;
+  SensorSimulator simulator(profile, 1);
+  SimulatedLsm303 bus(simulator, clock, true);
+  Lsm303 sensor(bus);
+  L3gd20 gyro(bus);
+  TEST_ASSERT_TRUE(sensor.beginAccel() && sensor.beginMag() && gyro.begin());
+
+  const uint16_t intervalMs = SensorPipeline::REFERENCE_INTERVAL_MS;
+  std::vector<SensorDataRaw> data(DURATION_MS / intervalMs);
+  for (SensorDataRaw& raw : data) {
+    raw = SensorDataRaw();
+    sensor.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+    sensor.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+    gyro.readGyro(raw.gyro_x, raw.gyro_y, raw.gyro_z);
+    raw.timestamp = clock.nowMs();
+    clock.advanceMs(intervalMs);
+  }
+  return data;
+}
+
+std::vector<SensorData> runReference(const std::vector<SensorDataRaw>& data,
+                                     OrientationEngine::Type engine,
+                                     OutlierRejector::Mode outliers) {
+  SensorPipeline pipeline;
+  pipeline.setOrientationEngine(engine);
+  pipeline.setOutlierMode(outliers);
+  std::vector<SensorData> out(data.size());
+  for (size_t i = 0; i < data.size(); i++) pipeline.process(data[i], out[i]);
+  return out;
+}
+
+template <typename Engine>
+std::vector<SensorData> runCompiled(const std::vector<SensorDataRaw>& data,
+                                    OutlierRejector::Mode outliers) {
+  StagePipeline<CalibrationStage, OutlierStage, FilterStage,
+                OrientationStage<Engine>, MountingStage>
+      pipeline;
+  pipeline.template stage<OutlierStage>().setMode(outliers);
+  std::vector<SensorData> out(data.size());
+  for (size_t i = 0; i < data.size(); i++) {
+    TEST_ASSERT_TRUE(pipeline.process(data[i], out[i]));
+  }
+  return out;
+}
+
+std::vector<SensorData> runCompiled(const std::vector<SensorDataRaw>& data,
+                                    OrientationEngine::Type engine,
+                                    OutlierRejector::Mode outliers) {
+  switch (engine) {
+    case OrientationEngine::COMPLEMENTARY:
+      return runCompiled<ComplementaryOrientation>(data, outliers);
+    case OrientationEngine::MAHONY:
+      return runCompiled<MahonyOrientation>(data, outliers);
+    default:
+      return runCompiled<AccelOrientation>(data, outliers);
+  }
+}
+
+// Пустой order - порядок по умолчанию; выход - только пропущенные сэмплы
+std::vector<SensorData> runRuntime(const std::vector<SensorDataRaw>& data,
+                                   OrientationEngine::Type engine,
+                                   OutlierRejector::Mode outliers,
+                                   const char* order, uint8_t decimate) {
+  RuntimeStagePipeline pipeline;
+  if (order) TEST_ASSERT_TRUE(pipeline.setOrder(order));
+  pipeline.getOutliers().setMode(outliers);
+  pipeline.getDecimation().setFactor(decimate);
+  pipeline.getOrientation().setEngine(engine);
+
+  std::vector<SensorData> out;
+  SensorData sample;
+  for (const SensorDataRaw& raw : data) {
+    if (pipeline.process(raw, sample)) out.push_back(sample);
+  }
+  return out;
+}
+
+bool sameData(const SensorData& a, const SensorData& b) {
+  return a.accel_x == b.accel_x && a.accel_y == b.accel_y &&
+         a.accel_z == b.accel_z && a.mag_x == b.mag_x && a.mag_y == b.mag_y &&
+         a.mag_z == b.mag_z && a.timestamp == b.timestamp &&
+         a.roll == b.roll && a.pitch == b.pitch && a.heading == b.heading &&
+         a.valid == b.valid;
+}
+
+void assertSame(const std::vector<SensorData>& expected,
+                const std::vector<SensorData>& actual) {
+  TEST_ASSERT_EQUAL_size_t(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_TRUE(sameData(expected[i], actual[i]));
+  }
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_default_order_matches_sensor_pipeline() {
+  // slow_tilt - наклоны для движков, impacts - выбросы для отбраковки
+  const SensorSimulator::Profile profiles[] = {
+      SensorSimulator::PROFILE_SLOW_TILT, SensorSimulator::PROFILE_IMPACTS};
+  for (SensorSimulator::Profile profile : profiles) {
+    std::vector<SensorDataRaw> data = generate(profile);
+    for (int e = 0; e < OrientationEngine::TYPE_COUNT; e++) {
+      OrientationEngine::Type engine = (OrientationEngine::Type)e;
+      for (int m = 0; m < OutlierRejector::MODE_COUNT; m++) {
+        OutlierRejector::Mode outliers = (OutlierRejector::Mode)m;
+        std::vector<SensorData> reference =
+            runReference(data, engine, outliers);
+        assertSame(reference, runCompiled(data, engine, outliers));
+        assertSame(reference, runRuntime(data, engine, outliers, nullptr, 1));
+      }
+    }
+  }
+}
+
+void test_decimation_before_orientation() {
+  std::vector<SensorDataRaw> data =
+      generate(SensorSimulator::PROFILE_SLOW_TILT);
+  std::vector<SensorData> reference =
+      runReference(data, OrientationEngine::ACCEL, OutlierRejector::OFF);
+  std::vector<SensorData> decimated = runRuntime(
+      data, OrientationEngine::ACCEL, OutlierRejector::OFF,
+      "calibration,outliers,filter,decimation,orientation,mounting",
+      DECIMATE);
+
+  // Фильтр видит каждый сэмпл, углы - каждый DECIMATE-й: у движка accel
+  // они те же, что у SensorPipeline на этом сэмпле
+  TEST_ASSERT_EQUAL_size_t(data.size() / DECIMATE, decimated.size());
+  for (size_t i = 0; i < decimated.size(); i++) {
+    TEST_ASSERT_TRUE(sameData(reference[i * DECIMATE + DECIMATE - 1],
+                              decimated[i]));
+  }
+}
+
+void test_stage_order_is_validated() {
+  RuntimeStagePipeline pipeline;
+  TEST_ASSERT_EQUAL_UINT8(5, pipeline.getStageCount());
+
+  const char* bad[] = {"",
+                       "filter,filter",
+                       "calibration,unknown",
+                       "filter,",
+                       "calibration,outliers,filter,decimation,orientation,"
+                       "mounting,filter"};
+  for (const char* order : bad) {
+    TEST_ASSERT_FALSE_MESSAGE(pipeline.setOrder(order), order);
+    TEST_ASSERT_EQUAL_UINT8(5, pipeline.getStageCount());  // Прежний
+  }
+
+  TEST_ASSERT_TRUE(pipeline.setOrder("filter,orientation"));
+  TEST_ASSERT_EQUAL_UINT8(2, pipeline.getStageCount());
+  TEST_ASSERT_EQUAL(RuntimeStagePipeline::FILTER, pipeline.getStage(0));
+  TEST_ASSERT_EQUAL(RuntimeStagePipeline::ORIENTATION, pipeline.getStage(1));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_default_order_matches_sensor_pipeline);
+  RUN_TEST(test_decimation_before_orientation);
+  RUN_TEST(test_stage_order_is_validated);
+  return UNITY_END();
+}
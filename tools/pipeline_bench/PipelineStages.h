@@ -0,0 +1,559 @@
+// PipelineStages.h
+// Этапы обработки сэмпла для StagePipeline: поправка, выбросы, фильтр,
+// прореживание, ориентация, поправки пользователя
+//
+// Опыт для tools/pipeline_bench: прошивка работает на SensorPipeline, а
+// здесь та же цепочка разобрана на этапы. Только заголовки - в сборку
+// прошивки не попадает. test_stage_pipeline следит, что при порядке
+// SensorPipeline результат совпадает с ним бит в бит.
+
+#ifndef PIPELINE_STAGES_H
+#define PIPELINE_STAGES_H
+
+#include <math.h>
+
+#include "AccelCalibration.h"
+#include "MagCalibration.h"
+#include "NoiseKiller.h"
+#include "Orientation.h"
+#include "OrientationEngine.h"
+#include "OutlierRejector.h"
+#include "SensorPipeline.h"
+#include "SensorTypes.h"
+
+/*
+ * Этап - класс с тремя методами (общего базового класса нет):
+ *   bool process(StageSample& s);  // false - дальше сэмпл не идёт
+ *   void setSampleIntervalMs(uint16_t intervalMs);
+ *   void reset();
+ * process() определён в теле класса: StagePipeline встраивает все
+ * этапы в один вызов. Расчёты те же, что в SensorPipeline, и при том же
+ * порядке этапов результат совпадает с ним бит в бит.
+ */
+
+/**
+ * @brief Сэмпл между этапами
+ *
+ * Живёт в конвейере от сэмпла к сэмплу: до этапа фильтра в out ещё
+ * оценка прошлого сэмпла (по ней OutlierStage проверяет инновации).
+ */
+struct StageSample {
+  // Каналы фильтра и выбросов: 0-2 ускорение, 3-5 поле
+  static const uint8_t CHANNELS = 6;
+  static const uint8_t MAG_CHANNEL = 3;
+
+  SensorDataRaw raw;
+  float accel[3];  // До фильтра Калмана (м/с²)
+  float mag[3];    // До фильтра Калмана (мкТл)
+  bool magValid;   // Магнитометр включён
+  float motion;    // Уровень движения (м/с²), его ведёт FilterStage
+  SensorData out;
+};
+
+/**
+ * @brief Начало сэмпла: сырые данные как есть, магнитометр включён
+ */
+inline void beginStageSample(StageSample& s, const SensorDataRaw& raw) {
+  s.raw = raw;
+  s.accel[0] = raw.accel_x;
+  s.accel[1] = raw.accel_y;
+  s.accel[2] = raw.accel_z;
+  s.mag[0] = raw.mag_x;
+  s.mag[1] = raw.mag_y;
+  s.mag[2] = raw.mag_z;
+  s.magValid = true;
+  s.out.timestamp = raw.timestamp;
+  s.out.valid = true;
+}
+
+/**
+ * @brief Поправка акселерометра и hard/soft-iron магнитометра
+ * Выключенный магнитометр (курс) снимает magValid для следующих этапов.
+ */
+class CalibrationStage {
+ public:
+  CalibrationStage();
+
+  void setAccelCorrection(const AccelCorrection& correction);
+  void setMagCorrection(const MagCorrection& correction) {
+    magCorrection = correction;
+  }
+  void setMagEnabled(bool enabled) { magEnabled = enabled; }
+  bool isMagEnabled() const { return magEnabled; }
+
+  bool process(StageSample& s) {
+    s.accel[0] = fmaf(s.raw.accel_x, accelScale[0], accelOffset[0]);
+    s.accel[1] = fmaf(s.raw.accel_y, accelScale[1], accelOffset[1]);
+    s.accel[2] = fmaf(s.raw.accel_z, accelScale[2], accelOffset[2]);
+
+    s.magValid = magEnabled;
+    if (magEnabled) {
+      const float d[3] = {s.raw.mag_x - magCorrection.offset[0],
+                          s.raw.mag_y - magCorrection.offset[1],
+                          s.raw.mag_z - magCorrection.offset[2]};
+      for (int i = 0; i < 3; i++) {
+        const float* row = magCorrection.matrix[i];
+        s.mag[i] = row[0] * d[0] + row[1] * d[1] + row[2] * d[2];
+      }
+    }
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t) {}
+  void reset() {}
+
+ private:
+  float accelScale[3];
+  float accelOffset[3];
+  bool magEnabled;
+  MagCorrection magCorrection;
+};
+
+/**
+ * @brief Отбраковка выбросов (OutlierRejector) перед фильтром
+ * Для INNOVATION этап фильтра должен идти после этого.
+ */
+class OutlierStage {
+ public:
+  OutlierStage();
+
+  void setMode(OutlierRejector::Mode mode) { rejector.setMode(mode); }
+  const OutlierRejector& getRejector() const { return rejector; }
+
+  bool process(StageSample& s) {
+    bool magRestart = s.magValid && !magActive;
+    magActive = s.magValid;
+    if (rejector.getMode() == OutlierRejector::OFF) return true;
+
+    const float accelEstimate[3] = {s.out.accel_x, s.out.accel_y,
+                                    s.out.accel_z};
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      s.accel[axis] = rejector.apply(axis, s.accel[axis], accelEstimate[axis]);
+    }
+    if (!s.magValid) return true;
+
+    // После включения фильтр стартует с самого показания
+    const float magEstimate[3] = {s.out.mag_x, s.out.mag_y, s.out.mag_z};
+    for (uint8_t axis = 0; axis < 3; axis++) {
+      uint8_t channel = StageSample::MAG_CHANNEL + axis;
+      if (magRestart) rejector.resetChannel(channel);
+      s.mag[axis] = rejector.apply(channel, s.mag[axis],
+                                   magRestart ? s.mag[axis]
+                                              : magEstimate[axis]);
+    }
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t) {}
+  void reset() { rejector.reset(); }
+
+ private:
+  OutlierRejector rejector;
+  bool magActive;  // magValid прошлого сэмпла
+};
+
+/**
+ * @brief Фильтр Калмана каналов и детектор движения
+ *
+ * Каналы - KalmanChannel прямо в этапе (без кучи и проверок номера, как
+ * в MultiChannelKalman), параметры - профили MultiChannelKalman.
+ */
+class FilterStage {
+ public:
+  explicit FilterStage(MultiChannelKalman::FilterProfile profile =
+                           MultiChannelKalman::BALANCED);
+
+  void setProfile(MultiChannelKalman::FilterProfile profile);
+  float getMotionLevel() const { return motionLevel; }
+
+  bool process(StageSample& s) {
+    s.out.accel_x = channels[0].update(s.accel[0]);
+    s.out.accel_y = channels[1].update(s.accel[1]);
+    s.out.accel_z = channels[2].update(s.accel[2]);
+
+    if (s.magValid) {
+      if (!magActive) {
+        for (uint8_t axis = 0; axis < 3; axis++) {
+          initChannel(StageSample::MAG_CHANNEL + axis, s.mag[axis]);
+        }
+      }
+      KalmanChannel* mag = channels + StageSample::MAG_CHANNEL;
+      s.out.mag_x = mag[0].update(s.mag[0]);
+      s.out.mag_y = mag[1].update(s.mag[1]);
+      s.out.mag_z = mag[2].update(s.mag[2]);
+    } else {
+      s.out.mag_x = s.out.mag_y = s.out.mag_z = 0.0f;
+    }
+    magActive = s.magValid;
+
+    updateMotion(s.out.accel_x, s.out.accel_y, s.out.accel_z);
+    s.motion = motionLevel;
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t intervalMs);
+  void reset();
+
+ private:
+  KalmanChannel channels[StageSample::CHANNELS];
+  float q, r, p;
+  float noiseScale;
+  bool magActive;
+
+  bool motionStarted;
+  float motionAlpha;
+  float motionMean[3];
+  float motionVariance;
+  float motionLevel;
+
+  void initChannel(uint8_t channel, float initial);
+
+  void updateMotion(float ax, float ay, float az) {
+    if (!motionStarted) {
+      motionMean[0] = ax;
+      motionMean[1] = ay;
+      motionMean[2] = az;
+      motionStarted = true;
+      return;
+    }
+
+    float dx = ax - motionMean[0];
+    float dy = ay - motionMean[1];
+    float dz = az - motionMean[2];
+    motionMean[0] += motionAlpha * dx;
+    motionMean[1] += motionAlpha * dy;
+    motionMean[2] += motionAlpha * dz;
+
+    float squared = dx * dx + dy * dy + dz * dz;
+    motionVariance =
+        (1.0f - motionAlpha) * (motionVariance + motionAlpha * squared);
+    motionLevel = sqrtf(motionVariance);
+  }
+};
+
+/**
+ * @brief Прореживание: дальше проходит каждый factor-й сэмпл
+ * Этапы до него работают на полной частоте, после - на пониженной.
+ */
+class DecimationStage {
+ public:
+  DecimationStage() : factor(1), pending(0) {}
+
+  void setFactor(uint8_t n) {
+    factor = n ? n : 1;
+    pending = 0;
+  }
+  uint8_t getFactor() const { return factor; }
+
+  bool process(StageSample&) {
+    if (++pending < factor) return false;
+    pending = 0;
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t) {}
+  void reset() { pending = 0; }
+
+ private:
+  uint8_t factor;
+  uint8_t pending;
+};
+
+/**
+ * @brief Общая часть этапов ориентации: шаг по времени, смещение нуля
+ * гироскопа, углы по вектору "вверх" движка
+ */
+class OrientationStep {
+ public:
+  OrientationStep();
+
+  /**
+   * @brief Сэмпл через движок и углы в s.out
+   * Engine - конкретный класс (вызовы без виртуальных функций) или
+   * OrientationEngine (выбор движка в работе).
+   */
+  template <typename Engine>
+  void run(Engine& engine, StageSample& s) {
+    OrientationInput input;
+    prepare(s, engine.needsGyro(), input);
+    engine.update(input);
+
+    float up[3];
+    engine.getGravity(up);
+    s.out.roll = computeRoll(up[0], up[1], up[2]);
+    s.out.pitch = computePitch(up[0], up[1], up[2]);
+    s.out.heading = s.magValid ? computeHeading(up[0], up[1], up[2],
+                                                s.out.mag_x, s.out.mag_y,
+                                                s.out.mag_z)
+                               : 0.0f;
+  }
+
+  void setSampleIntervalMs(uint16_t intervalMs) {
+    if (intervalMs) intervalS = intervalMs / 1000.0f;
+  }
+  void reset() { started = false; }
+
+  bool isGyroBiasReady() const { return gyroBiasReady; }
+  const float* getGyroBias() const { return gyroBias; }
+
+ private:
+  bool started;  // Был сэмпл после reset()
+  unsigned long lastTimestamp;
+  float intervalS;
+
+  bool gyroBiasReady;
+  float gyroBias[3];
+  float gyroSum[3];
+  float gyroRestS;
+  uint32_t gyroRestSamples;
+
+  void prepare(const StageSample& s, bool needsGyro,
+               OrientationInput& input) {
+    bool first = !started;
+    started = true;
+
+    input.dt = (s.raw.timestamp - lastTimestamp) / 1000.0f;
+    if (first || input.dt <= 0.0f || input.dt > SensorPipeline::MAX_STEP_S) {
+      input.dt = intervalS;
+    }
+    lastTimestamp = s.raw.timestamp;
+
+    input.filtered[0] = s.out.accel_x;
+    input.filtered[1] = s.out.accel_y;
+    input.filtered[2] = s.out.accel_z;
+    for (int axis = 0; axis < 3; axis++) input.accel[axis] = s.accel[axis];
+
+    if (needsGyro) {
+      const float gyro[3] = {s.raw.gyro_x, s.raw.gyro_y, s.raw.gyro_z};
+      if (!gyroBiasReady) {
+        bool moving = s.motion > SensorPipeline::GYRO_REST_MOTION;
+        estimateGyroBias(gyro, input.dt, first || moving);
+      }
+      for (int axis = 0; axis < 3; axis++) {
+        input.gyro[axis] = gyroBiasReady ? gyro[axis] - gyroBias[axis] : 0.0f;
+      }
+    } else {
+      input.gyro[0] = input.gyro[1] = input.gyro[2] = 0.0f;
+    }
+  }
+
+  void estimateGyroBias(const float gyro[3], float dt, bool restart);
+};
+
+/**
+ * @brief Ориентация движком, выбранным при сборке
+ */
+template <typename Engine>
+class OrientationStage {
+ public:
+  Engine& getEngine() { return engine; }
+  const OrientationStep& getStep() const { return step; }
+
+  bool process(StageSample& s) {
+    step.run(engine, s);
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t intervalMs) {
+    step.setSampleIntervalMs(intervalMs);
+  }
+  void reset() {
+    engine.reset();
+    step.reset();
+  }
+
+ private:
+  OrientationStep step;
+  Engine engine;
+};
+
+/**
+ * @brief Ориентация движком, выбранным в работе (виртуальные вызовы)
+ */
+class SelectableOrientationStage {
+ public:
+  SelectableOrientationStage() : engineType(OrientationEngine::ACCEL) {}
+
+  // Новый движок стартует со следующего сэмпла
+  void setEngine(OrientationEngine::Type type);
+  OrientationEngine::Type getEngine() const { return engineType; }
+  const OrientationStep& getStep() const { return step; }
+
+  bool process(StageSample& s) {
+    step.run(activeEngine(), s);
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t intervalMs) {
+    step.setSampleIntervalMs(intervalMs);
+  }
+  void reset() {
+    activeEngine().reset();
+    step.reset();
+  }
+
+ private:
+  OrientationStep step;
+  AccelOrientation accelEngine;
+  ComplementaryOrientation complementaryEngine;
+  MahonyOrientation mahonyEngine;
+  OrientationEngine::Type engineType;
+
+  OrientationEngine& activeEngine();
+};
+
+/**
+ * @brief Поправка нуля и перестановка осей (установка прибора)
+ */
+class MountingStage {
+ public:
+  MountingStage() : zeroOffset(0.0f), axisSwap(false) {}
+
+  void setUserSettings(float offset, bool swap) {
+    zeroOffset = offset;
+    axisSwap = swap;
+  }
+
+  bool process(StageSample& s) {
+    applyZeroAndSwap(s.out.roll, s.out.pitch, zeroOffset, axisSwap);
+    return true;
+  }
+
+  void setSampleIntervalMs(uint16_t) {}
+  void reset() {}
+
+ private:
+  float zeroOffset;
+  bool axisSwap;
+};
+
+// ========== CalibrationStage ==========
+
+inline CalibrationStage::CalibrationStage()
+    : accelScale{1.0f, 1.0f, 1.0f},
+      accelOffset{0.0f, 0.0f, 0.0f},
+      magEnabled(true),
+      magCorrection(MagCorrection::identity()) {}
+
+inline void CalibrationStage::setAccelCorrection(
+    const AccelCorrection& correction) {
+  for (int axis = 0; axis < 3; axis++) {
+    accelScale[axis] = correction.scale[axis];
+    accelOffset[axis] = -correction.bias[axis] * correction.scale[axis];
+  }
+}
+
+// ========== OutlierStage ==========
+
+inline OutlierStage::OutlierStage()
+    : rejector(StageSample::CHANNELS), magActive(true) {
+  for (uint8_t axis = 0; axis < 3; axis++) {
+    rejector.setNoiseFloor(axis, SensorPipeline::ACCEL_NOISE_FLOOR);
+    rejector.setNoiseFloor(StageSample::MAG_CHANNEL + axis,
+                           SensorPipeline::MAG_NOISE_FLOOR);
+  }
+}
+
+// ========== FilterStage ==========
+
+inline FilterStage::FilterStage(MultiChannelKalman::FilterProfile profile)
+    : noiseScale(1.0f),
+      magActive(true),
+      motionStarted(false),
+      motionAlpha(0.1f),
+      motionMean{0.0f, 0.0f, 0.0f},
+      motionVariance(0.0f),
+      motionLevel(0.0f) {
+  setProfile(profile);
+  setSampleIntervalMs(SensorPipeline::REFERENCE_INTERVAL_MS);
+}
+
+inline void FilterStage::initChannel(uint8_t channel, float initial) {
+  channels[channel].init(q, r, p * noiseScale, initial);
+}
+
+inline void FilterStage::setProfile(
+    MultiChannelKalman::FilterProfile profile) {
+  // Как MultiChannelKalman::setProfile: оценки каналов с нуля
+  MultiChannelKalman::getProfileParameters(profile, q, r, p);
+  for (uint8_t ch = 0; ch < StageSample::CHANNELS; ch++) {
+    initChannel(ch, 0.0f);
+  }
+}
+
+inline void FilterStage::setSampleIntervalMs(uint16_t intervalMs) {
+  if (intervalMs == 0) return;
+
+  float scale = (float)intervalMs / SensorPipeline::REFERENCE_INTERVAL_MS;
+  if (scale != noiseScale) {
+    noiseScale = scale;
+    for (uint8_t ch = 0; ch < StageSample::CHANNELS; ch++) {
+      channels[ch].processNoise = p * scale;
+    }
+  }
+  motionAlpha = 1.0f - expf(-intervalMs / SensorPipeline::MOTION_TAU_MS);
+}
+
+inline void FilterStage::reset() {
+  for (uint8_t ch = 0; ch < StageSample::CHANNELS; ch++) {
+    initChannel(ch, 0.0f);
+  }
+  motionStarted = false;
+  motionVariance = 0.0f;
+  motionLevel = 0.0f;
+}
+
+// ========== OrientationStep ==========
+
+inline OrientationStep::OrientationStep()
+    : started(false),
+      lastTimestamp(0),
+      intervalS(SensorPipeline::REFERENCE_INTERVAL_MS / 1000.0f),
+      gyroBiasReady(false),
+      gyroBias{0.0f, 0.0f, 0.0f},
+      gyroSum{0.0f, 0.0f, 0.0f},
+      gyroRestS(0.0f),
+      gyroRestSamples(0) {}
+
+inline void OrientationStep::estimateGyroBias(const float gyro[3], float dt,
+                                              bool restart) {
+  // В покое гироскоп показывает только смещение нуля
+  if (restart) {
+    gyroSum[0] = gyroSum[1] = gyroSum[2] = 0.0f;
+    gyroRestS = 0.0f;
+    gyroRestSamples = 0;
+    return;
+  }
+
+  for (int axis = 0; axis < 3; axis++) gyroSum[axis] += gyro[axis];
+  gyroRestSamples++;
+  gyroRestS += dt;
+  if (gyroRestS < SensorPipeline::GYRO_BIAS_S) return;
+
+  for (int axis = 0; axis < 3; axis++) {
+    gyroBias[axis] = gyroSum[axis] / gyroRestSamples;
+  }
+  gyroBiasReady = true;
+}
+
+// ========== SelectableOrientationStage ==========
+
+inline void SelectableOrientationStage::setEngine(
+    OrientationEngine::Type type) {
+  if (type >= OrientationEngine::TYPE_COUNT) type = OrientationEngine::ACCEL;
+  engineType = type;
+  activeEngine().reset();
+}
+
+inline OrientationEngine& SelectableOrientationStage::activeEngine() {
+  switch (engineType) {
+    case OrientationEngine::COMPLEMENTARY:
+      return complementaryEngine;
+    case OrientationEngine::MAHONY:
+      return mahonyEngine;
+    default:
+      return accelEngine;
+  }
+}
+
+#endif  // PIPELINE_STAGES_H
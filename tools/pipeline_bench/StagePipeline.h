@@ -0,0 +1,251 @@
+// StagePipeline.h
+// Конвейер из этапов PipelineStages.h: состав задаётся при сборке
+// (StagePipeline<...>) или списком в работе (RuntimeStagePipeline)
+
+#ifndef STAGE_PIPELINE_H
+#define STAGE_PIPELINE_H
+
+#include <string.h>
+
+#include "PipelineStages.h"
+
+// Этап внутри StagePipeline (база на каждый тип этапа)
+template <typename Stage>
+struct StageSlot {
+  Stage stage;
+};
+
+/**
+ * @brief Конвейер, собранный при компиляции
+ *
+ *   StagePipeline<CalibrationStage, OutlierStage, FilterStage,
+ *                 OrientationStage<MahonyOrientation>, MountingStage>
+ *
+ * process() этапов разворачивается в одну функцию в порядке аргументов
+ * шаблона: без виртуальных вызовов и ветвлений на состав. Каждый тип
+ * этапа - не больше одного раза (доступ к этапу - по типу).
+ */
+template <typename... Stages>
+class StagePipeline : private StageSlot<Stages>... {
+ public:
+  StagePipeline() : sample() {}
+
+  /**
+   * @brief Сэмпл через все этапы
+   * @return false - сэмпл остановлен этапом (прореживание), out не менялся
+   */
+  bool process(const SensorDataRaw& raw, SensorData& out) {
+    beginStageSample(sample, raw);
+
+    // Список инициализации вычисляется слева направо, && обрывает
+    // цепочку на этапе, вернувшем false
+    bool pass = true;
+    const bool order[] = {(pass = pass && stage<Stages>().process(sample))...,
+                          true};
+    (void)order;
+
+    if (pass) out = sample.out;
+    return pass;
+  }
+
+  template <typename Stage>
+  Stage& stage() {
+    return StageSlot<Stage>::stage;
+  }
+
+  template <typename Stage>
+  const Stage& stage() const {
+    return StageSlot<Stage>::stage;
+  }
+
+  void setSampleIntervalMs(uint16_t intervalMs) {
+    const bool order[] = {
+        (stage<Stages>().setSampleIntervalMs(intervalMs), true)..., true};
+    (void)order;
+  }
+
+  void reset() {
+    const bool order[] = {(stage<Stages>().reset(), true)..., true};
+    (void)order;
+    sample = StageSample();
+  }
+
+ private:
+  StageSample sample;
+};
+
+/**
+ * @brief Конвейер с составом и порядком этапов из списка в работе
+ *
+ * Для опытов: те же этапы, что в StagePipeline, выбор - switch на каждый
+ * этап сэмпла, движок ориентации - виртуальные вызовы. Каждый этап - не
+ * больше одного раза. По умолчанию порядок как в SensorPipeline:
+ * calibration,outliers,filter,orientation,mounting.
+ */
+class RuntimeStagePipeline {
+ public:
+  enum StageId : uint8_t {
+    CALIBRATION,
+    OUTLIERS,
+    FILTER,
+    DECIMATION,
+    ORIENTATION,
+    MOUNTING,
+    STAGE_COUNT
+  };
+
+  RuntimeStagePipeline();
+
+  /**
+   * @brief Порядок этапов
+   * @return false - пустой список, повтор или неизвестный этап (порядок
+   * остаётся прежним)
+   */
+  bool setOrder(const StageId* stages, uint8_t count);
+
+  /**
+   * @brief Порядок этапов списком имён через запятую
+   */
+  bool setOrder(const char* list);
+
+  uint8_t getStageCount() const { return stageCount; }
+  StageId getStage(uint8_t index) const { return order[index]; }
+
+  bool process(const SensorDataRaw& raw, SensorData& out);
+
+  void setSampleIntervalMs(uint16_t intervalMs);
+  void reset();
+
+  CalibrationStage& getCalibration() { return calibration; }
+  OutlierStage& getOutliers() { return outliers; }
+  FilterStage& getFilter() { return filter; }
+  DecimationStage& getDecimation() { return decimation; }
+  SelectableOrientationStage& getOrientation() { return orientation; }
+  MountingStage& getMounting() { return mounting; }
+
+  static const char* stageName(StageId stage);
+  static bool stageFromName(const char* name, size_t length, StageId& out);
+
+ private:
+  CalibrationStage calibration;
+  OutlierStage outliers;
+  FilterStage filter;
+  DecimationStage decimation;
+  SelectableOrientationStage orientation;
+  MountingStage mounting;
+
+  StageId order[STAGE_COUNT];
+  uint8_t stageCount;
+  StageSample sample;
+
+  bool runStage(StageId stage);
+};
+
+inline RuntimeStagePipeline::RuntimeStagePipeline() : stageCount(0), sample() {
+  static const StageId DEFAULT_ORDER[] = {CALIBRATION, OUTLIERS, FILTER,
+                                          ORIENTATION, MOUNTING};
+  setOrder(DEFAULT_ORDER, sizeof(DEFAULT_ORDER) / sizeof(DEFAULT_ORDER[0]));
+}
+
+inline bool RuntimeStagePipeline::setOrder(const StageId* stages,
+                                           uint8_t count) {
+  if (count == 0 || count > STAGE_COUNT) return false;
+
+  bool used[STAGE_COUNT] = {};
+  for (uint8_t i = 0; i < count; i++) {
+    if (stages[i] >= STAGE_COUNT || used[stages[i]]) return false;
+    used[stages[i]] = true;
+  }
+
+  memcpy(order, stages, count * sizeof(order[0]));
+  stageCount = count;
+  return true;
+}
+
+inline bool RuntimeStagePipeline::setOrder(const char* list) {
+  StageId stages[STAGE_COUNT];
+  uint8_t count = 0;
+
+  const char* p = list;
+  while (true) {
+    const char* end = strchr(p, ',');
+    size_t length = end ? (size_t)(end - p) : strlen(p);
+    if (count == STAGE_COUNT || !stageFromName(p, length, stages[count])) {
+      return false;
+    }
+    count++;
+    if (!end) break;
+    p = end + 1;
+  }
+  return setOrder(stages, count);
+}
+
+inline bool RuntimeStagePipeline::process(const SensorDataRaw& raw,
+                                          SensorData& out) {
+  beginStageSample(sample, raw);
+  for (uint8_t i = 0; i < stageCount; i++) {
+    if (!runStage(order[i])) return false;
+  }
+  out = sample.out;
+  return true;
+}
+
+inline bool RuntimeStagePipeline::runStage(StageId stage) {
+  switch (stage) {
+    case CALIBRATION:
+      return calibration.process(sample);
+    case OUTLIERS:
+      return outliers.process(sample);
+    case FILTER:
+      return filter.process(sample);
+    case DECIMATION:
+      return decimation.process(sample);
+    case ORIENTATION:
+      return orientation.process(sample);
+    case MOUNTING:
+      return mounting.process(sample);
+    default:
+      return true;
+  }
+}
+
+inline void RuntimeStagePipeline::setSampleIntervalMs(uint16_t intervalMs) {
+  calibration.setSampleIntervalMs(intervalMs);
+  outliers.setSampleIntervalMs(intervalMs);
+  filter.setSampleIntervalMs(intervalMs);
+  decimation.setSampleIntervalMs(intervalMs);
+  orientation.setSampleIntervalMs(intervalMs);
+  mounting.setSampleIntervalMs(intervalMs);
+}
+
+inline void RuntimeStagePipeline::reset() {
+  calibration.reset();
+  outliers.reset();
+  filter.reset();
+  decimation.reset();
+  orientation.reset();
+  mounting.reset();
+  sample = StageSample();
+}
+
+inline const char* RuntimeStagePipeline::stageName(StageId stage) {
+  static const char* const NAMES[STAGE_COUNT] = {
+      "calibration", "outliers",    "filter",
+      "decimation",  "orientation", "mounting"};
+  return stage < STAGE_COUNT ? NAMES[stage] : "unknown";
+}
+
+inline bool RuntimeStagePipeline::stageFromName(const char* name,
+                                                size_t length, StageId& out) {
+  for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+    const char* stage = stageName((StageId)i);
+    if (strlen(stage) == length && strncmp(name, stage, length) == 0) {
+      out = (StageId)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+#endif  // STAGE_PIPELINE_H
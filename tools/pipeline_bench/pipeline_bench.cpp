@@ -0,0 +1,275 @@
+// pipeline_bench.cpp
+// Скорость цепочки обработки на ПК: SensorPipeline (как в прошивке),
+// StagePipeline (этапы собраны при компиляции) и RuntimeStagePipeline
+// (этапы списком в работе) на одних и тех же сэмплах симулятора
+//
+// Сборка (Linux/macOS):
+//   g++ -std=c++11 -O2 -DHAL_LOG_QUIET -I src -I tools/pipeline_bench
+//       -o pipeline_bench tools/pipeline_bench/pipeline_bench.cpp
+//       src/SensorPipeline.cpp src/NoiseKiller.cpp src/OutlierRejector.cpp
+//       src/OrientationEngine.cpp src/SensorSimulator.cpp src/Lsm303.cpp
+//       src/L3gd20.cpp src/HalHost.cpp
+//
+// Запуск:
+//   ./pipeline_bench                               # slow_tilt, accel
+//   ./pipeline_bench --profile impacts --engine mahony --outliers hampel
+//   ./pipeline_bench --stages calibration,filter,decimation,orientation
+//                    --decimate 5
+//
+// ns/sample - медиана по повторам, для каждого повтора конвейер новый.
+// max_d_* - наибольшее расхождение углов с SensorPipeline (0 - бит в бит);
+// при другом составе этапов не считается.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HalHost.h"
+#include "L3gd20.h"
+#include "Lsm303.h"
+#include "SensorPipeline.h"
+#include "SensorSimulator.h"
+#include "StagePipeline.h"
+
+namespace {
+
+struct Options {
+  SensorSimulator::Profile profile = SensorSimulator::PROFILE_SLOW_TILT;
+  OrientationEngine::Type engine = OrientationEngine::ACCEL;
+  OutlierRejector::Mode outliers = OutlierRejector::OFF;
+  uint32_t seconds = 600;
+  unsigned repeat = 7;
+  std::string stages;  // Пусто - порядок SensorPipeline
+  uint8_t decimate = 1;
+};
+
+struct BenchResult {
+  std::string name;
+  double nsPerSample;  // Медиана
+  double minNsPerSample;
+  std::vector<SensorData> output;  // Последнего повтора
+  size_t produced;
+};
+
+void usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s [--profile static|slow_tilt|vibration|impacts]\n"
+          "       [--engine accel|complementary|mahony]\n"
+          "       [--outliers off|hampel|innovation] [--seconds N]\n"
+          "       [--repeat N] [--stages LIST] [--decimate N]\n",
+          name);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* value = argv[++i];
+
+    if (arg == "--profile") {
+      if (!SensorSimulator::profileFromName(value, options.profile)) {
+        return false;
+      }
+    } else if (arg == "--engine") {
+      if (!OrientationEngine::typeFromName(value, options.engine)) {
+        return false;
+      }
+    } else if (arg == "--outliers") {
+      if (!OutlierRejector::modeFromName(value, options.outliers)) {
+        return false;
+      }
+    } else if (arg == "--seconds") {
+      options.seconds = (uint32_t)atoi(value);
+      if (options.seconds == 0) return false;
+    } else if (arg == "--repeat") {
+      options.repeat = (unsigned)atoi(value);
+      if (options.repeat == 0) return false;
+    } else if (arg == "--stages") {
+      options.stages = value;
+    } else if (arg == "--decimate") {
+      int factor = atoi(value);
+      if (factor < 1 || factor > 255) return false;
+      options.decimate = (uint8_t)factor;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Сэмплы через драйверы (с квантованием регистров), как на устройстве
+bool generate(const Options& options, std::vector<SensorDataRaw>& data) {
+  HostClock clock;
+  SensorSimulator simulator(options.profile, 1);
+  SimulatedLsm303 bus(simulator, clock, true);
+  Lsm303 sensor(bus);
+  L3gd20 gyro(bus);
+  if (!sensor.beginAccel() || !sensor.beginMag() || !gyro.begin()) {
+    return false;
+  }
+
+  const uint16_t intervalMs = SensorPipeline::REFERENCE_INTERVAL_MS;
+  data.resize(options.seconds * 1000 / intervalMs);
+  for (SensorDataRaw& raw : data) {
+    raw = SensorDataRaw();
+    sensor.readAccel(raw.accel_x, raw.accel_y, raw.accel_z);
+    sensor.readMag(raw.mag_x, raw.mag_y, raw.mag_z);
+    gyro.readGyro(raw.gyro_x, raw.gyro_y, raw.gyro_z);
+    raw.timestamp = clock.nowMs();
+    clock.advanceMs(intervalMs);
+  }
+  return true;
+}
+
+// Make - новый настроенный конвейер, Process - один сэмпл через него
+template <typename Make, typename Process>
+BenchResult measure(const char* name, const std::vector<SensorDataRaw>& data,
+                    unsigned repeat, Make make, Process process) {
+  BenchResult result;
+  result.name = name;
+  result.output.resize(data.size());
+
+  std::vector<double> runs;
+  for (unsigned run = 0; run < repeat; run++) {
+    auto pipeline = make();
+    size_t produced = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const SensorDataRaw& raw : data) {
+      if (process(*pipeline, raw, result.output[produced])) produced++;
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    runs.push_back(elapsed / data.size());
+    result.produced = produced;
+  }
+
+  std::sort(runs.begin(), runs.end());
+  result.nsPerSample = runs[runs.size() / 2];
+  result.minNsPerSample = runs[0];
+  return result;
+}
+
+template <typename Engine>
+BenchResult benchCompiled(const std::vector<SensorDataRaw>& data,
+                          const Options& options) {
+  typedef StagePipeline<CalibrationStage, OutlierStage, FilterStage,
+                        OrientationStage<Engine>, MountingStage>
+      Pipeline;
+
+  return measure(
+      "compiled", data, options.repeat,
+      [&]() {
+        std::unique_ptr<Pipeline> pipeline(new Pipeline());
+        pipeline->template stage<OutlierStage>().setMode(options.outliers);
+        return pipeline;
+      },
+      [](Pipeline& pipeline, const SensorDataRaw& raw, SensorData& out) {
+        return pipeline.process(raw, out);
+      });
+}
+
+BenchResult benchCompiled(const std::vector<SensorDataRaw>& data,
+                          const Options& options) {
+  switch (options.engine) {
+    case OrientationEngine::COMPLEMENTARY:
+      return benchCompiled<ComplementaryOrientation>(data, options);
+    case OrientationEngine::MAHONY:
+      return benchCompiled<MahonyOrientation>(data, options);
+    default:
+      return benchCompiled<AccelOrientation>(data, options);
+  }
+}
+
+void printResult(const BenchResult& result, const BenchResult& reference,
+                 bool comparable) {
+  printf("%-10s %10.1f %10.1f %8.2f %9zu", result.name.c_str(),
+         result.nsPerSample, result.minNsPerSample,
+         reference.nsPerSample / result.nsPerSample, result.produced);
+
+  if (!comparable || result.produced != reference.produced) {
+    printf(" %11s %11s %11s\n", "-", "-", "-");
+    return;
+  }
+
+  float maxRoll = 0.0f, maxPitch = 0.0f, maxHeading = 0.0f;
+  for (size_t i = 0; i < result.produced; i++) {
+    const SensorData& a = result.output[i];
+    const SensorData& b = reference.output[i];
+    maxRoll = std::max(maxRoll, fabsf(a.roll - b.roll));
+    maxPitch = std::max(maxPitch, fabsf(a.pitch - b.pitch));
+    maxHeading = std::max(maxHeading, fabsf(a.heading - b.heading));
+  }
+  printf(" %11.3g %11.3g %11.3g\n", maxRoll, maxPitch, maxHeading);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  RuntimeStagePipeline probe;
+  if (!options.stages.empty() && !probe.setOrder(options.stages.c_str())) {
+    fprintf(stderr, "Bad stage list: %s\n", options.stages.c_str());
+    return 2;
+  }
+
+  std::vector<SensorDataRaw> data;
+  if (!generate(options, data)) {
+    fprintf(stderr, "LSM303/L3GD20 simulator did not respond\n");
+    return 1;
+  }
+  printf("%zu samples: %s, engine %s, outliers %s\n", data.size(),
+         SensorSimulator::profileName(options.profile),
+         OrientationEngine::typeName(options.engine),
+         OutlierRejector::modeName(options.outliers));
+
+  BenchResult current = measure(
+      "current", data, options.repeat,
+      [&]() {
+        std::unique_ptr<SensorPipeline> pipeline(new SensorPipeline());
+        pipeline->setOrientationEngine(options.engine);
+        pipeline->setOutlierMode(options.outliers);
+        return pipeline;
+      },
+      [](SensorPipeline& pipeline, const SensorDataRaw& raw, SensorData& out) {
+        pipeline.process(raw, out);
+        return true;
+      });
+
+  BenchResult compiled = benchCompiled(data, options);
+
+  BenchResult runtime = measure(
+      "runtime", data, options.repeat,
+      [&]() {
+        std::unique_ptr<RuntimeStagePipeline> pipeline(
+            new RuntimeStagePipeline());
+        if (!options.stages.empty()) pipeline->setOrder(options.stages.c_str());
+        pipeline->getOutliers().setMode(options.outliers);
+        pipeline->getDecimation().setFactor(options.decimate);
+        pipeline->getOrientation().setEngine(options.engine);
+        return pipeline;
+      },
+      [](RuntimeStagePipeline& pipeline, const SensorDataRaw& raw,
+         SensorData& out) { return pipeline.process(raw, out); });
+
+  printf("\n%-10s %10s %10s %8s %9s %11s %11s %11s\n", "pipeline",
+         "ns/sample", "min", "speedup", "produced", "max_d_roll",
+         "max_d_pitch", "max_d_head");
+  printResult(current, current, true);
+  printResult(compiled, current, true);
+  printResult(runtime, current, options.stages.empty());
+  return 0;
+}
@@ -0,0 +1,420 @@
+// ReplayEngine.h
+// Прогон записи устройства через SensorPipeline на ПК (replay и tuner)
+//
+// Запись - двоичный файл /log (или блоки кольца /rec подряд) либо CSV
+// /log?format=csv. Сырые ускорение и поле идут в тот же SensorPipeline,
+// что на устройстве, углы считает тот же Orientation.h.
+//
+// Истинного угла в записи нет. Опорой служит угол по сырому ускорению,
+// сглаженный центрированным окном (без задержки). По опоре сэмплы делятся
+// на покой (угол почти не меняется) и движение, и для каждого набора
+// параметров фильтра считаются:
+//   noise    - СКО отфильтрованного угла от опоры в покое, градусы;
+//   tracking - СКО от опоры в движении, градусы;
+//   lag      - сдвиг отфильтрованного угла от опоры в движении, мс
+//              (минимум СКО по сдвигу с уточнением по параболе);
+//   max      - наибольшее отклонение от опоры.
+// Крен и тангаж идут в статистику вместе. Первые WARMUP_MS каждого
+// отрезка (фильтр сходится от нуля) не учитываются.
+//
+// Для настройки фильтра запись нужна с периодом опроса датчика
+// (/set_record?interval_ms=20): фильтр на устройстве работает на этой
+// частоте, прореженная запись даёт другую динамику.
+
+#ifndef REPLAY_ENGINE_H
+#define REPLAY_ENGINE_H
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Orientation.h"
+#include "RecordFormat.h"
+#include "SensorPipeline.h"
+
+/**
+ * @brief Параметры фильтра одного прогона
+ */
+struct FilterParams {
+  std::string name;
+  float q, r, p;
+  float motionThreshold = 0.0f;  // SensorPipeline::setMotionThreshold
+};
+
+/**
+ * @brief Итог прогона
+ */
+struct ReplayMetrics {
+  double noiseRms;
+  double trackingRms;
+  double lagMs;
+  double maxError;
+  uint32_t quietSamples;
+  uint32_t movingSamples;
+};
+
+/**
+ * @brief Сэмплы записи, разбитые на непрерывные отрезки, и опора
+ */
+class ReplayDataset {
+ public:
+  // Первые мс каждого отрезка не оцениваются (как в env:native)
+  static const uint32_t WARMUP_MS = 3000;
+
+  // Разрыв во времени больше стольких периодов - новый отрезок
+  // (перезагрузка, выключенная запись, потерянный блок)
+  static const uint32_t GAP_INTERVALS = 4;
+
+  // Окно сглаживания опоры и предел поиска задержки
+  static const uint32_t REFERENCE_WINDOW_MS = 400;
+  static const uint32_t MAX_LAG_MS = 1000;
+
+  // Скорость изменения опоры (°/с) по окну RATE_WINDOW_MS: ниже - покой,
+  // выше - движение. Уровень наклоняют медленно, ~1°/с
+  static const uint32_t RATE_WINDOW_MS = 1000;
+  static constexpr float QUIET_RATE = 0.2f;
+  static constexpr float MOVING_RATE = 0.5f;
+
+  struct Segment {
+    size_t begin, end;  // [begin, end)
+    uint16_t intervalMs;
+  };
+
+  std::vector<SensorDataRaw> raw;
+  std::vector<uint32_t> sequence;     // Номер блока записи
+  std::vector<float> deviceRoll;      // Углы, записанные устройством
+  std::vector<float> devicePitch;
+  std::vector<float> rawRoll;         // Углы по сырому ускорению
+  std::vector<float> rawPitch;
+  std::vector<float> referenceRoll;   // Опора
+  std::vector<float> referencePitch;
+  std::vector<uint8_t> state;         // State
+  std::vector<Segment> segments;
+
+  enum State : uint8_t {
+    STATE_SKIP,    // Прогрев фильтра или вне отрезков - не оценивается
+    STATE_QUIET,
+    STATE_MOVING,
+    STATE_OTHER    // Между порогами покоя и движения
+  };
+
+  uint32_t badBlocks = 0;
+  uint32_t badLines = 0;
+
+  /**
+   * @brief Загрузить файл: двоичный по magic в начале, иначе CSV
+   */
+  bool load(const char* path, std::string& error) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+      error = std::string("cannot open ") + path;
+      return false;
+    }
+
+    // CSV начинается с заголовка или числа, блок - с magic или нулей
+    int first = fgetc(file);
+    rewind(file);
+    bool csv = first == 's' || (first >= '0' && first <= '9');
+
+    bool ok = csv ? loadCsv(file) : loadBinary(file);
+    fclose(file);
+    if (!ok || raw.empty()) {
+      error = "no samples";
+      return false;
+    }
+
+    prepare();
+    return true;
+  }
+
+  /**
+   * @brief Сэмплы без файла (сценарии симулятора в tools/tuner)
+   */
+  bool loadSamples(const std::vector<RecordSample>& samples) {
+    for (const RecordSample& sample : samples) add(sample, 0);
+    if (raw.empty()) return false;
+    prepare();
+    return true;
+  }
+
+  size_t size() const { return raw.size(); }
+
+ private:
+  struct Block {
+    uint32_t sequence;
+    std::vector<uint8_t> data;
+  };
+
+  void add(const RecordSample& sample, uint32_t blockSequence) {
+    SensorDataRaw value;
+    RecordFormat::toRaw(sample, value);
+    raw.push_back(value);
+    sequence.push_back(blockSequence);
+    deviceRoll.push_back(RecordFormat::angleDegrees(sample.roll));
+    devicePitch.push_back(RecordFormat::angleDegrees(sample.pitch));
+  }
+
+  // Копия кольца идёт не по порядку - блоки сортируются по номеру
+  bool loadBinary(FILE* file) {
+    std::vector<Block> blocks;
+    Block block;
+    block.data.resize(RecordFormat::BLOCK_SIZE);
+    while (fread(block.data.data(), 1, RecordFormat::BLOCK_SIZE, file) ==
+           RecordFormat::BLOCK_SIZE) {
+      RecordBlockHeader header;
+      if (!RecordFormat::verifyBlock(block.data.data(), header)) {
+        // Чистый слот (ещё не записан) - не ошибка
+        if (RecordFormat::parseHeader(block.data.data(), header)) {
+          badBlocks++;
+        }
+        continue;
+      }
+      block.sequence = header.sequence;
+      blocks.push_back(block);
+    }
+
+    std::stable_sort(blocks.begin(), blocks.end(),
+                     [](const Block& a, const Block& b) {
+                       return a.sequence < b.sequence;
+                     });
+
+    for (const Block& b : blocks) {
+      RecordBlockDecoder decoder;
+      if (!decoder.begin(b.data.data())) continue;
+      RecordSample sample;
+      while (decoder.next(sample)) add(sample, b.sequence);
+    }
+    return true;
+  }
+
+  bool loadCsv(FILE* file) {
+    char line[256];
+    bool first = true;
+    while (fgets(line, sizeof(line), file)) {
+      uint32_t blockSequence;
+      RecordSample sample;
+      if (RecordFormat::parseCsvRow(line, blockSequence, sample)) {
+        add(sample, blockSequence);
+      } else if (!first && line[0] != '\n' && line[0] != '\r') {
+        badLines++;
+      }
+      first = false;
+    }
+    return true;
+  }
+
+  // Отрезки, опора и разметка покой/движение
+  void prepare() {
+    size_t n = raw.size();
+    segments.clear();
+
+    // Разрыв ищется по периоду начала записи; у отрезка период свой
+    uint32_t gapMs = GAP_INTERVALS * medianInterval(0, n);
+    size_t begin = 0;
+    for (size_t i = 1; i <= n; i++) {
+      bool split = i == n;
+      if (!split) {
+        uint32_t dt = raw[i].timestamp - raw[i - 1].timestamp;
+        split = (int32_t)dt <= 0 || dt > gapMs;
+      }
+      if (split) {
+        if (i - begin >= 2) {
+          segments.push_back({begin, i, medianInterval(begin, i)});
+        }
+        begin = i;
+      }
+    }
+
+    referenceRoll.assign(n, 0.0f);
+    referencePitch.assign(n, 0.0f);
+    state.assign(n, STATE_SKIP);
+
+    rawRoll.resize(n);
+    rawPitch.resize(n);
+    for (size_t i = 0; i < n; i++) {
+      const SensorDataRaw& r = raw[i];
+      rawRoll[i] = computeRoll(r.accel_x, r.accel_y, r.accel_z);
+      rawPitch[i] = computePitch(r.accel_x, r.accel_y, r.accel_z);
+    }
+
+    for (const Segment& s : segments) {
+      size_t half =
+          std::max<size_t>(1, REFERENCE_WINDOW_MS / 2 / s.intervalMs);
+      smooth(rawRoll, referenceRoll, s, half);
+      smooth(rawPitch, referencePitch, s, half);
+
+      size_t span = std::max<size_t>(1, RATE_WINDOW_MS / 2 / s.intervalMs);
+      uint32_t start = raw[s.begin].timestamp;
+      for (size_t i = s.begin; i < s.end; i++) {
+        if (raw[i].timestamp - start < WARMUP_MS) continue;
+        state[i] = STATE_OTHER;
+
+        size_t a = i >= s.begin + span ? i - span : s.begin;
+        size_t b = std::min(i + span, s.end - 1);
+        float seconds = (raw[b].timestamp - raw[a].timestamp) / 1000.0f;
+        if (seconds <= 0.0f) continue;
+        float rate = std::max(fabsf(referenceRoll[b] - referenceRoll[a]),
+                              fabsf(referencePitch[b] - referencePitch[a])) /
+                     seconds;
+        if (rate < QUIET_RATE) {
+          state[i] = STATE_QUIET;
+        } else if (rate > MOVING_RATE) {
+          state[i] = STATE_MOVING;
+        }
+      }
+    }
+  }
+
+  // Период: медиана первых шагов по времени (дрожание и пропуски не мешают)
+  uint16_t medianInterval(size_t begin, size_t end) const {
+    std::vector<uint32_t> steps;
+    for (size_t i = begin + 1; i < end && steps.size() < 1000; i++) {
+      steps.push_back(raw[i].timestamp - raw[i - 1].timestamp);
+    }
+    if (steps.empty()) return 0;
+    std::nth_element(steps.begin(), steps.begin() + steps.size() / 2,
+                     steps.end());
+    uint32_t median = steps[steps.size() / 2];
+    return (uint16_t)std::min<uint32_t>(std::max<uint32_t>(median, 1), 60000);
+  }
+
+  // Центрированное скользящее среднее (на краях окно укорачивается)
+  static void smooth(const std::vector<float>& in, std::vector<float>& out,
+                     const Segment& s, size_t half) {
+    double sum = 0.0;
+    size_t a = s.begin, b = s.begin;  // Окно [a, b)
+    for (size_t i = s.begin; i < s.end; i++) {
+      size_t wantA = i >= s.begin + half ? i - half : s.begin;
+      size_t wantB = std::min(i + half + 1, s.end);
+      while (b < wantB) sum += in[b++];
+      while (a < wantA) sum -= in[a++];
+      out[i] = (float)(sum / (b - a));
+    }
+  }
+};
+
+/**
+ * @brief Прогон записи с одним набором параметров
+ * @param roll, pitch Выход фильтра (не обязательно)
+ */
+inline void runReplay(const ReplayDataset& data, const FilterParams& params,
+                      ReplayMetrics& metrics,
+                      std::vector<float>* rollOut = nullptr,
+                      std::vector<float>* pitchOut = nullptr) {
+  size_t n = data.size();
+  std::vector<float> localRoll, localPitch;
+  std::vector<float>& roll = rollOut ? *rollOut : localRoll;
+  std::vector<float>& pitch = pitchOut ? *pitchOut : localPitch;
+  roll.assign(n, 0.0f);
+  pitch.assign(n, 0.0f);
+
+  // Каждый отрезок - как после включения: фильтр с нуля
+  for (const ReplayDataset::Segment& s : data.segments) {
+    SensorPipeline pipeline;
+    pipeline.getFilter().setParameters(params.q, params.r, params.p);
+    pipeline.setMotionThreshold(params.motionThreshold);
+    pipeline.setSampleIntervalMs(s.intervalMs);
+
+    SensorData out = SensorData();
+    for (size_t i = s.begin; i < s.end; i++) {
+      pipeline.process(data.raw[i], out);
+      roll[i] = out.roll;
+      pitch[i] = out.pitch;
+    }
+  }
+
+  metrics = ReplayMetrics();
+  double quietSum = 0.0, movingSum = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    if (data.state[i] == ReplayDataset::STATE_SKIP) continue;
+    double dr = roll[i] - data.referenceRoll[i];
+    double dp = pitch[i] - data.referencePitch[i];
+    metrics.maxError = std::max(metrics.maxError,
+                                std::max(fabs(dr), fabs(dp)));
+    if (data.state[i] == ReplayDataset::STATE_QUIET) {
+      quietSum += dr * dr + dp * dp;
+      metrics.quietSamples++;
+    } else if (data.state[i] == ReplayDataset::STATE_MOVING) {
+      movingSum += dr * dr + dp * dp;
+      metrics.movingSamples++;
+    }
+  }
+  if (metrics.quietSamples) {
+    metrics.noiseRms = sqrt(quietSum / (2.0 * metrics.quietSamples));
+  }
+  if (metrics.movingSamples) {
+    metrics.trackingRms = sqrt(movingSum / (2.0 * metrics.movingSamples));
+  }
+
+  // Задержка: сдвиг опоры назад, при котором отклонение в движении минимально
+  if (metrics.movingSamples == 0) return;
+  // Шаг сдвига - период самого длинного отрезка
+  uint16_t stepMs = 1;
+  size_t longest = 0;
+  for (const ReplayDataset::Segment& s : data.segments) {
+    if (s.end - s.begin > longest) {
+      longest = s.end - s.begin;
+      stepMs = s.intervalMs;
+    }
+  }
+
+  std::vector<double> cost;
+  size_t maxShift = ReplayDataset::MAX_LAG_MS / stepMs;
+  for (size_t shift = 0; shift <= maxShift; shift++) {
+    double sum = 0.0;
+    uint32_t count = 0;
+    for (const ReplayDataset::Segment& s : data.segments) {
+      for (size_t i = s.begin + shift; i < s.end; i++) {
+        if (data.state[i] != ReplayDataset::STATE_MOVING) continue;
+        double dr = roll[i] - data.referenceRoll[i - shift];
+        double dp = pitch[i] - data.referencePitch[i - shift];
+        sum += dr * dr + dp * dp;
+        count++;
+      }
+    }
+    cost.push_back(count ? sum / count : 1e30);
+  }
+
+  size_t best = std::min_element(cost.begin(), cost.end()) - cost.begin();
+  double refined = (double)best;
+  if (best > 0 && best + 1 < cost.size()) {
+    double a = cost[best - 1], b = cost[best], c = cost[best + 1];
+    double denominator = a - 2.0 * b + c;
+    if (denominator > 0.0) refined += 0.5 * (a - c) / denominator;
+  }
+  metrics.lagMs = refined * stepMs;
+}
+
+/**
+ * @brief Прогон набора параметров на всех ядрах
+ *
+ * Прогоны независимы: результат не зависит от числа потоков.
+ */
+inline void runReplayBatch(const ReplayDataset& data,
+                           const std::vector<FilterParams>& params,
+                           std::vector<ReplayMetrics>& results,
+                           unsigned threads) {
+  results.assign(params.size(), ReplayMetrics());
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min<unsigned>(threads, (unsigned)params.size());
+
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < params.size(); i = next++) {
+      runReplay(data, params[i], results[i]);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+}
+
+#endif  // REPLAY_ENGINE_H
@@ -0,0 +1,326 @@
+// replay.cpp
+// Прогон записи устройства через фильтр на ПК: шум, слежение, задержка
+//
+// Сборка (Linux/macOS):
+//   g++ -std=c++11 -O2 -pthread -DHAL_LOG_QUIET -I src -o replay
+//       tools/replay/replay.cpp src/NoiseKiller.cpp src/SensorPipeline.cpp
+//       src/RecordFormat.cpp src/Lsm303.cpp src/OrientationEngine.cpp
+//       src/OutlierRejector.cpp
+//
+// Запуск:
+//   ./replay level.rec                        # три профиля прошивки
+//   ./replay level.csv --profile balanced --params 0.2,0.1,0.05
+//   ./replay level.rec --params 0.05,0.1,0.01,0.1   # и порог движения
+//   ./replay level.rec --grid 0.01:1:8,0.01:1:8,0.001:0.5:8 --sort noise
+//   ./replay level.rec --trace trace.csv      # углы по сэмплам для графиков
+//
+// state в трассе: 0 - не оценивается, 1 - покой, 2 - движение, 3 - между.
+// lag_ms ">1000" - задержка больше предела поиска (фильтр почти не следит).
+//
+// Запись: curl -o level.rec http://<устройство>/log (или format=csv).
+// Метрики - см. ReplayEngine.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ReplayEngine.h"
+
+namespace {
+
+// Больше столбцов в трассе читать всё равно неудобно
+const size_t MAX_TRACE_CONFIGS = 8;
+
+struct Options {
+  std::string input;
+  std::vector<FilterParams> configs;
+  unsigned threads = 0;  // 0 - по числу ядер
+  std::string trace;
+  std::string sort;
+};
+
+const char* profileName(MultiChannelKalman::FilterProfile profile) {
+  switch (profile) {
+    case MultiChannelKalman::AGGRESSIVE:
+      return "aggressive";
+    case MultiChannelKalman::BALANCED:
+      return "balanced";
+#ifdef HAS_TUNED_PROFILE
+    case MultiChannelKalman::TUNED:
+      return "tuned";
+#endif
+    default:
+      return "responsive";
+  }
+}
+
+FilterParams presetParams(MultiChannelKalman::FilterProfile profile) {
+  FilterParams params;
+  params.name = profileName(profile);
+  MultiChannelKalman::getProfileParameters(profile, params.q, params.r,
+                                           params.p);
+  params.motionThreshold = SensorPipeline::profileMotionThreshold(profile);
+  return params;
+}
+
+bool addProfile(const std::string& name, Options& options) {
+  const MultiChannelKalman::FilterProfile all[] = {
+      MultiChannelKalman::AGGRESSIVE, MultiChannelKalman::BALANCED,
+      MultiChannelKalman::RESPONSIVE,
+#ifdef HAS_TUNED_PROFILE
+      MultiChannelKalman::TUNED,
+#endif
+  };
+  bool found = false;
+  for (MultiChannelKalman::FilterProfile profile : all) {
+    if (name == "all" || name == profileName(profile)) {
+      options.configs.push_back(presetParams(profile));
+      found = true;
+    }
+  }
+  return found;
+}
+
+// "q,r,p" или "q,r,p,motion" (порог движения, м/с²)
+bool addParams(const char* text, Options& options) {
+  FilterParams params;
+  int used = 0;
+  int count = sscanf(text, "%f,%f,%f%n,%f%n", &params.q, &params.r,
+                     &params.p, &used, &params.motionThreshold, &used);
+  if (count < 3 || text[used] != '\0' || params.q <= 0.0f ||
+      params.r <= 0.0f || params.p < 0.0f || params.motionThreshold < 0.0f) {
+    return false;
+  }
+  params.name = std::string("params:") + text;
+  options.configs.push_back(params);
+  return true;
+}
+
+// Сетка в логарифмическом масштабе: "q0:q1:n,r0:r1:n,p0:p1:n"
+bool addGrid(const char* text, Options& options) {
+  float from[3], to[3];
+  int steps[3];
+  char tail;
+  if (sscanf(text, "%f:%f:%d,%f:%f:%d,%f:%f:%d%c", &from[0], &to[0],
+             &steps[0], &from[1], &to[1], &steps[1], &from[2], &to[2],
+             &steps[2], &tail) != 9) {
+    return false;
+  }
+
+  std::vector<float> values[3];
+  for (int axis = 0; axis < 3; axis++) {
+    if (from[axis] <= 0.0f || to[axis] < from[axis] || steps[axis] < 1) {
+      return false;
+    }
+    for (int i = 0; i < steps[axis]; i++) {
+      float t = steps[axis] > 1 ? (float)i / (steps[axis] - 1) : 0.0f;
+      values[axis].push_back(from[axis] * powf(to[axis] / from[axis], t));
+    }
+  }
+
+  size_t index = 0;
+  for (float q : values[0]) {
+    for (float r : values[1]) {
+      for (float p : values[2]) {
+        FilterParams params;
+        params.name = "grid#" + std::to_string(index++);
+        params.q = q;
+        params.r = r;
+        params.p = p;
+        options.configs.push_back(params);
+      }
+    }
+  }
+  return true;
+}
+
+void usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s FILE\n"
+          "       [--profile aggressive|balanced|responsive|tuned|all]\n"
+          "       [--params q,r,p[,motion]] "
+          "[--grid q0:q1:n,r0:r1:n,p0:p1:n]\n"
+          "       [--threads N] [--trace FILE] "
+          "[--sort noise|tracking|lag|max]\n",
+          name);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--profile" && hasValue) {
+      if (!addProfile(argv[++i], options)) return false;
+    } else if (arg == "--params" && hasValue) {
+      if (!addParams(argv[++i], options)) return false;
+    } else if (arg == "--grid" && hasValue) {
+      if (!addGrid(argv[++i], options)) return false;
+    } else if (arg == "--threads" && hasValue) {
+      options.threads = (unsigned)atoi(argv[++i]);
+    } else if (arg == "--trace" && hasValue) {
+      options.trace = argv[++i];
+    } else if (arg == "--sort" && hasValue) {
+      options.sort = argv[++i];
+      if (options.sort != "noise" && options.sort != "tracking" &&
+          options.sort != "lag" && options.sort != "max") {
+        return false;
+      }
+    } else if (arg[0] != '-' && options.input.empty()) {
+      options.input = arg;
+    } else {
+      return false;
+    }
+  }
+
+  if (options.configs.empty()) addProfile("all", options);
+  return !options.input.empty();
+}
+
+double sortKey(const ReplayMetrics& m, const std::string& sort) {
+  if (sort == "noise") return m.noiseRms;
+  if (sort == "tracking") return m.trackingRms;
+  if (sort == "lag") return m.lagMs;
+  return m.maxError;
+}
+
+void printDataset(const ReplayDataset& data) {
+  uint32_t quiet = 0, moving = 0;
+  for (uint8_t state : data.state) {
+    if (state == ReplayDataset::STATE_QUIET) quiet++;
+    if (state == ReplayDataset::STATE_MOVING) moving++;
+  }
+
+  double seconds = 0.0;
+  for (const ReplayDataset::Segment& s : data.segments) {
+    seconds +=
+        (data.raw[s.end - 1].timestamp - data.raw[s.begin].timestamp) / 1e3;
+  }
+
+  printf("Samples: %zu in %zu segment(s), %.1f s; quiet %.1f%%, moving %.1f%%",
+         data.size(), data.segments.size(), seconds,
+         100.0 * quiet / data.size(), 100.0 * moving / data.size());
+  if (data.badBlocks || data.badLines) {
+    printf("; skipped %u bad block(s), %u bad line(s)", data.badBlocks,
+           data.badLines);
+  }
+  printf("\n");
+  for (const ReplayDataset::Segment& s : data.segments) {
+    if (s.intervalMs != data.segments[0].intervalMs) {
+      printf("Warning: segments have different sample intervals\n");
+      break;
+    }
+  }
+  if (!quiet) printf("Warning: no quiet samples, noise is not measured\n");
+  if (!moving) {
+    printf("Warning: no motion, tracking and lag are not measured\n");
+  }
+}
+
+bool writeTrace(const std::string& path, const ReplayDataset& data,
+                const std::vector<FilterParams>& configs) {
+  size_t count = std::min(configs.size(), MAX_TRACE_CONFIGS);
+  if (count < configs.size()) {
+    printf("Trace: first %zu of %zu configurations\n", count, configs.size());
+  }
+
+  std::vector<std::vector<float>> roll(count), pitch(count);
+  for (size_t c = 0; c < count; c++) {
+    ReplayMetrics metrics;
+    runReplay(data, configs[c], metrics, &roll[c], &pitch[c]);
+  }
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) {
+    perror(path.c_str());
+    return false;
+  }
+
+  fprintf(file,
+          "time_ms,sequence,state,raw_roll,raw_pitch,ref_roll,ref_pitch,"
+          "device_roll,device_pitch");
+  for (size_t c = 0; c < count; c++) {
+    fprintf(file, ",%s_roll,%s_pitch", configs[c].name.c_str(),
+            configs[c].name.c_str());
+  }
+  fprintf(file, "\n");
+
+  for (size_t i = 0; i < data.size(); i++) {
+    fprintf(file, "%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f",
+            (unsigned)data.raw[i].timestamp, data.sequence[i], data.state[i],
+            data.rawRoll[i], data.rawPitch[i], data.referenceRoll[i],
+            data.referencePitch[i], data.deviceRoll[i], data.devicePitch[i]);
+    for (size_t c = 0; c < count; c++) {
+      fprintf(file, ",%.3f,%.3f", roll[c][i], pitch[c][i]);
+    }
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  printf("Trace: %s\n", path.c_str());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  ReplayDataset data;
+  std::string error;
+  if (!data.load(options.input.c_str(), error)) {
+    fprintf(stderr, "%s: %s\n", options.input.c_str(), error.c_str());
+    return 1;
+  }
+  printDataset(data);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<ReplayMetrics> results;
+  runReplayBatch(data, options.configs, results, options.threads);
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<size_t> order(options.configs.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  if (!options.sort.empty()) {
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return sortKey(results[a], options.sort) <
+             sortKey(results[b], options.sort);
+    });
+  }
+
+  printf("\n%-16s %8s %8s %8s %8s %9s %9s %8s %8s\n", "config", "q", "r",
+         "p", "motion", "noise", "tracking", "lag_ms", "max");
+  for (size_t i : order) {
+    const FilterParams& c = options.configs[i];
+    const ReplayMetrics& m = results[i];
+    char lag[16];
+    if (m.lagMs >= ReplayDataset::MAX_LAG_MS) {
+      snprintf(lag, sizeof(lag), ">%u", ReplayDataset::MAX_LAG_MS);
+    } else {
+      snprintf(lag, sizeof(lag), "%.1f", m.lagMs);
+    }
+    printf("%-16s %8.4g %8.4g %8.4g %8.4g %9.4f %9.3f %8s %8.3f\n",
+           c.name.c_str(), c.q, c.r, c.p, c.motionThreshold, m.noiseRms,
+           m.trackingRms, lag, m.maxError);
+  }
+  printf("\n%zu run(s) of %zu samples in %.2f s (%.1f ms per run)\n",
+         options.configs.size(), data.size(), elapsed,
+         1e3 * elapsed / options.configs.size());
+
+  if (!options.trace.empty() &&
+      !writeTrace(options.trace, data, options.configs)) {
+    return 1;
+  }
+  return 0;
+}
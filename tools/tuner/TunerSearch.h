@@ -0,0 +1,240 @@
+// TunerSearch.h
+// Поиск параметров фильтра Калмана по записям (tools/tuner)
+//
+// Оценка: score = noise / noise_unit + lag / lag_unit по всем записям
+// (метрики ReplayEngine.h). Поиск: логарифмическая сетка по q и порогу
+// движения, затем от лучших точек сетки шаги по каждой оси с уменьшением
+// шага. Случайности нет, прогоны независимы, при равенстве выигрывает
+// меньший индекс - результат не зависит от числа потоков.
+//
+// Оси. KalmanChannel(mea_e = q, est_e = r, шум процесса = p): при
+// умножении q, p и ошибки оценки на одно число выход не меняется, а r -
+// только начальная ошибка оценки. Установившийся отклик задаёт p/q, поэтому
+// r и p постоянны, а ищется q. Вторая ось - порог уровня движения, выше
+// которого шум процесса в SensorPipeline::MOTION_NOISE_GAIN раз больше.
+
+#ifndef TUNER_SEARCH_H
+#define TUNER_SEARCH_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ReplayEngine.h"
+
+namespace FilterTuner {
+
+// r и p при поиске (p/q перекрывает профили прошивки от 0.02 до 10)
+const float FIXED_R = 0.1f;
+const float FIXED_P = 0.01f;
+
+// Оси поиска: q и порог движения (м/с²); у верхней границы порог почти не
+// срабатывает - фильтр без переключения
+const int AXES = 2;
+const float SEARCH_MIN[AXES] = {1e-5f, 0.005f};
+const float SEARCH_MAX[AXES] = {10.0f, 2.0f};
+const char* const AXIS_NAMES[AXES] = {"q", "motion"};
+
+// Уточняется столько лучших точек сетки
+const size_t REFINE_STARTS = 4;
+
+struct SearchOptions {
+  unsigned threads = 0;  // 0 - все ядра
+  int gridSteps = 10;
+  int rounds = 12;
+  double noiseUnit = 0.05;
+  double lagUnit = 100.0;
+};
+
+struct Score {
+  double score;
+  double noise;
+  double lag;
+};
+
+struct Candidate {
+  float value[AXES];
+  float step[AXES];  // Множитель шага по оси
+  Score score;
+};
+
+/**
+ * @brief Оценка наборов параметров по всем записям
+ */
+class Evaluator {
+ public:
+  Evaluator(const std::vector<ReplayDataset>& datasets,
+            const SearchOptions& options)
+      : datasets(datasets), options(options), evaluations(0) {}
+
+  void evaluate(const std::vector<FilterParams>& params,
+                std::vector<Score>& scores) {
+    scores.assign(params.size(), Score());
+    std::vector<double> noiseSum(params.size(), 0.0);
+    std::vector<double> lagSum(params.size(), 0.0);
+    uint64_t quiet = 0, moving = 0;
+
+    std::vector<ReplayMetrics> results;
+    for (const ReplayDataset& data : datasets) {
+      runReplayBatch(data, params, results, options.threads);
+      if (results.empty()) continue;
+      // Разметка покой/движение от параметров не зависит
+      quiet += results[0].quietSamples;
+      moving += results[0].movingSamples;
+      for (size_t i = 0; i < params.size(); i++) {
+        const ReplayMetrics& m = results[i];
+        noiseSum[i] += m.noiseRms * m.noiseRms * m.quietSamples;
+        lagSum[i] += m.lagMs * m.movingSamples;
+      }
+    }
+
+    for (size_t i = 0; i < params.size(); i++) {
+      Score& s = scores[i];
+      s.noise = quiet ? sqrt(noiseSum[i] / quiet) : 0.0;
+      s.lag = moving ? lagSum[i] / moving : 0.0;
+      s.score = s.noise / options.noiseUnit + s.lag / options.lagUnit;
+    }
+    evaluations += params.size();
+  }
+
+  size_t getEvaluations() const { return evaluations; }
+
+ private:
+  const std::vector<ReplayDataset>& datasets;
+  const SearchOptions& options;
+  size_t evaluations;
+};
+
+inline FilterParams makeParams(const float value[AXES],
+                               const std::string& name) {
+  FilterParams params;
+  params.name = name;
+  params.q = value[0];
+  params.r = FIXED_R;
+  params.p = FIXED_P;
+  params.motionThreshold = value[1];
+  return params;
+}
+
+// Меньший score, при равенстве - меньший индекс (порядок детерминирован)
+inline bool better(const Score& a, size_t ia, const Score& b, size_t ib) {
+  if (a.score != b.score) return a.score < b.score;
+  return ia < ib;
+}
+
+inline std::vector<Candidate> searchGrid(Evaluator& evaluator,
+                                         const SearchOptions& options) {
+  std::vector<float> values[AXES];
+  float ratio[AXES];
+  for (int axis = 0; axis < AXES; axis++) {
+    ratio[axis] = powf(SEARCH_MAX[axis] / SEARCH_MIN[axis],
+                       1.0f / (options.gridSteps - 1));
+    for (int i = 0; i < options.gridSteps; i++) {
+      values[axis].push_back(SEARCH_MIN[axis] * powf(ratio[axis], (float)i));
+    }
+  }
+
+  std::vector<Candidate> grid;
+  std::vector<FilterParams> params;
+  for (float q : values[0]) {
+    for (float motion : values[1]) {
+      Candidate c;
+      c.value[0] = q;
+      c.value[1] = motion;
+      for (int axis = 0; axis < AXES; axis++) c.step[axis] = ratio[axis];
+      grid.push_back(c);
+      params.push_back(makeParams(c.value, "grid"));
+    }
+  }
+
+  std::vector<Score> scores;
+  evaluator.evaluate(params, scores);
+  for (size_t i = 0; i < grid.size(); i++) grid[i].score = scores[i];
+
+  std::vector<size_t> order(grid.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return better(grid[a].score, a, grid[b].score, b);
+  });
+
+  std::vector<Candidate> starts;
+  for (size_t i = 0; i < order.size() && starts.size() < REFINE_STARTS; i++) {
+    starts.push_back(grid[order[i]]);
+  }
+  return starts;
+}
+
+// Шаг по осям из каждой точки; нет улучшения - шаг уменьшается
+inline void refine(Evaluator& evaluator, const SearchOptions& options,
+                   std::vector<Candidate>& candidates) {
+  const size_t NEIGHBOURS = 2 * AXES;
+  for (int round = 0; round < options.rounds; round++) {
+    std::vector<Candidate> trials;
+    std::vector<FilterParams> params;
+    for (const Candidate& c : candidates) {
+      for (int axis = 0; axis < AXES; axis++) {
+        for (int direction = -1; direction <= 1; direction += 2) {
+          Candidate trial = c;
+          float& value = trial.value[axis];
+          value *= direction > 0 ? c.step[axis] : 1.0f / c.step[axis];
+          value = std::min(std::max(value, SEARCH_MIN[axis]), SEARCH_MAX[axis]);
+          trials.push_back(trial);
+          params.push_back(makeParams(trial.value, "refine"));
+        }
+      }
+    }
+
+    std::vector<Score> scores;
+    evaluator.evaluate(params, scores);
+
+    for (size_t c = 0; c < candidates.size(); c++) {
+      Candidate& candidate = candidates[c];
+      size_t best = SIZE_MAX;
+      for (size_t k = c * NEIGHBOURS; k < (c + 1) * NEIGHBOURS; k++) {
+        // Только строгое улучшение: на плоской оси точка не блуждает
+        if (scores[k].score < candidate.score.score &&
+            (best == SIZE_MAX || better(scores[k], k, scores[best], best))) {
+          best = k;
+        }
+      }
+
+      if (best == SIZE_MAX) {
+        for (int axis = 0; axis < AXES; axis++) {
+          candidate.step[axis] = sqrtf(candidate.step[axis]);
+        }
+        continue;
+      }
+      for (int axis = 0; axis < AXES; axis++) {
+        candidate.value[axis] = trials[best].value[axis];
+      }
+      candidate.score = scores[best];
+    }
+  }
+}
+
+/**
+ * @brief Сетка и уточнение
+ * @param candidates Уточнённые точки
+ * @return Индекс лучшей из них
+ */
+inline size_t search(Evaluator& evaluator, const SearchOptions& options,
+                     std::vector<Candidate>& candidates) {
+  candidates = searchGrid(evaluator, options);
+  refine(evaluator, options, candidates);
+
+  size_t bestIndex = 0;
+  for (size_t i = 1; i < candidates.size(); i++) {
+    if (better(candidates[i].score, i, candidates[bestIndex].score,
+               bestIndex)) {
+      bestIndex = i;
+    }
+  }
+  return bestIndex;
+}
+
+}  // namespace FilterTuner
+
+#endif  // TUNER_SEARCH_H
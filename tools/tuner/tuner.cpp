@@ -0,0 +1,319 @@
+// tuner.cpp
+// Подбор параметров фильтра Калмана по записям устройства
+//
+// Сборка (Linux/macOS):
+//   g++ -std=c++11 -O2 -pthread -DHAL_LOG_QUIET -I src -I tools/replay
+//       -I tools/tuner -o tuner tools/tuner/tuner.cpp src/NoiseKiller.cpp
+//       src/SensorPipeline.cpp src/RecordFormat.cpp src/Lsm303.cpp
+//       src/OrientationEngine.cpp src/OutlierRejector.cpp
+//       src/SensorSimulator.cpp src/L3gd20.cpp
+//
+// Запуск:
+//   ./tuner static.rec tilt.rec --simulate             # только отчёт
+//   ./tuner static.rec tilt.rec --simulate --output src/TunedFilterProfile.h
+//   ./tuner level.csv --noise-unit 0.02 --lag-unit 150 --grid 12
+//
+// Записи нужны с периодом опроса (/set_record?interval_ms=20): покой
+// (уровень на столе) и движение (плавные наклоны). Можно в одном файле.
+// --simulate добавляет к ним все сценарии SensorSimulator (покой, наклоны,
+// вибрация, удары), чтобы подбор не подстраивался под один вид движения.
+//
+// Заголовок (--output) пишется только по записям устройства и только если
+// score лучше лучшего профиля прошивки хотя бы на --min-gain (доля, по
+// умолчанию 0.1). Иначе профиль TUNED не нужен и файл не трогается.
+//
+// Цель: score = noise / noise_unit + lag / lag_unit, где noise - СКО угла
+// в покое, lag - задержка в движении (см. ReplayEngine.h). По умолчанию
+// 0.05° шума стоят столько же, сколько 100 мс задержки. Шум берётся по
+// всем записям с покоем, задержка - по всем с движением.
+//
+// Поиск - см. TunerSearch.h; результат не зависит от числа потоков.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "ReplayEngine.h"
+#include "SensorSimulator.h"
+#include "TunerSearch.h"
+
+namespace {
+
+// Время fade индикатора для TUNED - по задержке, в пределах профилей
+const uint16_t MIN_FADE_MS = 80;
+const uint16_t MAX_FADE_MS = 200;
+
+// Длительность сценария симулятора (--simulate)
+const uint32_t SIMULATED_MS = 120000;
+
+using FilterTuner::Candidate;
+using FilterTuner::Score;
+
+struct Options : FilterTuner::SearchOptions {
+  std::vector<std::string> inputs;
+  std::string output;
+  bool simulate = false;
+  double minGain = 0.1;
+};
+
+void usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s FILE... [--simulate] [--output FILE] [--min-gain F]\n"
+          "       [--threads N] [--grid N] [--rounds N] [--noise-unit DEG]\n"
+          "       [--lag-unit MS]\n",
+          name);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--output" && hasValue) {
+      options.output = argv[++i];
+    } else if (arg == "--simulate") {
+      options.simulate = true;
+    } else if (arg == "--min-gain" && hasValue) {
+      options.minGain = atof(argv[++i]);
+    } else if (arg == "--threads" && hasValue) {
+      options.threads = (unsigned)atoi(argv[++i]);
+    } else if (arg == "--grid" && hasValue) {
+      options.gridSteps = atoi(argv[++i]);
+    } else if (arg == "--rounds" && hasValue) {
+      options.rounds = atoi(argv[++i]);
+    } else if (arg == "--noise-unit" && hasValue) {
+      options.noiseUnit = atof(argv[++i]);
+    } else if (arg == "--lag-unit" && hasValue) {
+      options.lagUnit = atof(argv[++i]);
+    } else if (arg[0] != '-') {
+      options.inputs.push_back(arg);
+    } else {
+      return false;
+    }
+  }
+  // Заголовок - только по записям устройства
+  bool hasData = !options.inputs.empty() || options.simulate;
+  bool outputOk = options.output.empty() || !options.inputs.empty();
+  return hasData && outputOk && options.gridSteps >= 2 &&
+         options.rounds >= 0 && options.noiseUnit > 0.0 &&
+         options.lagUnit > 0.0 && options.minGain >= 0.0;
+}
+
+// Сценарий симулятора с периодом опроса, как его записало бы устройство
+bool simulate(SensorSimulator::Profile profile, ReplayDataset& data) {
+  SensorSimulator simulator(profile, 1);
+  std::vector<RecordSample> samples;
+  const uint16_t intervalMs = SensorPipeline::REFERENCE_INTERVAL_MS;
+  for (uint32_t t = 0; t < SIMULATED_MS; t += intervalMs) {
+    SensorDataRaw raw = SensorDataRaw();
+    if (!simulator.sample(t * 1000, raw)) break;
+    raw.timestamp = t;
+    RecordSample sample;
+    RecordFormat::makeSample(t, 0.0f, 0.0f, raw, sample);
+    samples.push_back(sample);
+  }
+  return data.loadSamples(samples);
+}
+
+uint16_t fadeTimeMs(double lagMs) {
+  double fade = std::min<double>(std::max<double>(lagMs, MIN_FADE_MS),
+                                 MAX_FADE_MS);
+  return (uint16_t)(fade + 0.5);
+}
+
+std::string baseName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool writeHeader(const Options& options,
+                 const std::vector<std::string>& sources,
+                 const Candidate& best,
+                 const std::vector<FilterParams>& presets,
+                 const std::vector<Score>& presetScores) {
+  FILE* file = fopen(options.output.c_str(), "w");
+  if (!file) {
+    perror(options.output.c_str());
+    return false;
+  }
+
+  fprintf(file,
+          "// TunedFilterProfile.h\n"
+          "// Параметры профиля MultiChannelKalman::TUNED\n"
+          "//\n"
+          "// Сгенерирован tools/tuner, вручную не править. Записи:\n");
+  for (const std::string& source : sources) {
+    fprintf(file, "//   %s\n", source.c_str());
+  }
+  fprintf(file,
+          "// score = noise / %.3g° + lag / %.4g мс = %.3f "
+          "(noise %.4f°, lag %.1f мс)\n"
+          "// Профили прошивки на тех же записях (tuned - прежний):\n",
+          options.noiseUnit, options.lagUnit, best.score.score,
+          best.score.noise, best.score.lag);
+  for (size_t i = 0; i < presets.size(); i++) {
+    fprintf(file, "//   %-10s %.3f\n", presets[i].name.c_str(),
+            presetScores[i].score);
+  }
+  fprintf(file,
+          "\n"
+          "#ifndef TUNED_FILTER_PROFILE_H\n"
+          "#define TUNED_FILTER_PROFILE_H\n"
+          "\n"
+          "#include <stdint.h>\n"
+          "\n"
+          "namespace TunedFilterProfile {\n"
+          "\n"
+          "constexpr float Q = %.9gf;\n"
+          "constexpr float R = %.9gf;\n"
+          "constexpr float P = %.9gf;\n"
+          "\n"
+          "// Порог движения (м/с²): выше - шум процесса x MOTION_NOISE_GAIN\n"
+          "constexpr float MOTION_THRESHOLD = %.9gf;\n"
+          "\n"
+          "// Время fade индикатора: по задержке фильтра\n"
+          "constexpr uint16_t FADE_TIME_MS = %u;\n"
+          "\n"
+          "}  // namespace TunedFilterProfile\n"
+          "\n"
+          "#endif  // TUNED_FILTER_PROFILE_H\n",
+          best.value[0], FilterTuner::FIXED_R, FilterTuner::FIXED_P,
+          best.value[1], fadeTimeMs(best.score.lag));
+
+  fclose(file);
+  printf("Written %s\n", options.output.c_str());
+  return true;
+}
+
+const char* profileName(MultiChannelKalman::FilterProfile profile) {
+  switch (profile) {
+    case MultiChannelKalman::AGGRESSIVE:
+      return "aggressive";
+    case MultiChannelKalman::BALANCED:
+      return "balanced";
+#ifdef HAS_TUNED_PROFILE
+    case MultiChannelKalman::TUNED:
+      return "tuned";
+#endif
+    default:
+      return "responsive";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<ReplayDataset> datasets(options.inputs.size());
+  std::vector<std::string> sources;
+  size_t samples = 0;
+  for (size_t i = 0; i < options.inputs.size(); i++) {
+    std::string error;
+    if (!datasets[i].load(options.inputs[i].c_str(), error)) {
+      fprintf(stderr, "%s: %s\n", options.inputs[i].c_str(), error.c_str());
+      return 1;
+    }
+    sources.push_back(baseName(options.inputs[i]));
+    samples += datasets[i].size();
+  }
+  if (options.simulate) {
+    for (int p = 0; p < SensorSimulator::PROFILE_COUNT; p++) {
+      SensorSimulator::Profile profile = (SensorSimulator::Profile)p;
+      datasets.push_back(ReplayDataset());
+      if (!simulate(profile, datasets.back())) {
+        fprintf(stderr, "simulator: no samples\n");
+        return 1;
+      }
+      sources.push_back(std::string("simulator:") +
+                        SensorSimulator::profileName(profile));
+      samples += datasets.back().size();
+    }
+  }
+  printf("Recordings: %zu, %zu samples\n", datasets.size(), samples);
+
+  FilterTuner::Evaluator evaluator(datasets, options);
+  auto start = std::chrono::steady_clock::now();
+
+  // Текущие профили - для сравнения
+  const MultiChannelKalman::FilterProfile profiles[] = {
+      MultiChannelKalman::AGGRESSIVE, MultiChannelKalman::BALANCED,
+      MultiChannelKalman::RESPONSIVE,
+#ifdef HAS_TUNED_PROFILE
+      MultiChannelKalman::TUNED,
+#endif
+  };
+  std::vector<FilterParams> presets;
+  for (MultiChannelKalman::FilterProfile profile : profiles) {
+    FilterParams params;
+    params.name = profileName(profile);
+    MultiChannelKalman::getProfileParameters(profile, params.q, params.r,
+                                             params.p);
+    params.motionThreshold = SensorPipeline::profileMotionThreshold(profile);
+    presets.push_back(params);
+  }
+  std::vector<Score> presetScores;
+  evaluator.evaluate(presets, presetScores);
+
+  std::vector<Candidate> candidates;
+  size_t bestIndex = FilterTuner::search(evaluator, options, candidates);
+  const Candidate& best = candidates[bestIndex];
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  printf("\n%-12s %10s %10s %10s %10s %8s %9s %8s\n", "profile", "q", "r",
+         "p", "motion", "score", "noise", "lag_ms");
+  size_t bestPreset = 0;
+  for (size_t i = 0; i < presets.size(); i++) {
+    const FilterParams& p = presets[i];
+    printf("%-12s %10.4g %10.4g %10.4g %10.4g %8.3f %9.4f %8.1f\n",
+           p.name.c_str(), p.q, p.r, p.p, p.motionThreshold,
+           presetScores[i].score, presetScores[i].noise,
+           presetScores[i].lag);
+    if (FilterTuner::better(presetScores[i], i, presetScores[bestPreset],
+                            bestPreset)) {
+      bestPreset = i;
+    }
+  }
+  for (size_t i = 0; i < candidates.size(); i++) {
+    const Candidate& c = candidates[i];
+    printf("%-12s %10.4g %10.4g %10.4g %10.4g %8.3f %9.4f %8.1f%s\n",
+           i == bestIndex ? "search*" : "search", c.value[0],
+           FilterTuner::FIXED_R, FilterTuner::FIXED_P, c.value[1],
+           c.score.score, c.score.noise, c.score.lag,
+           i == bestIndex ? "  <- best" : "");
+  }
+  for (int axis = 0; axis < FilterTuner::AXES; axis++) {
+    if (best.value[axis] <= FilterTuner::SEARCH_MIN[axis] * 1.001f ||
+        best.value[axis] >= FilterTuner::SEARCH_MAX[axis] * 0.999f) {
+      printf("Note: %s is at the search bound\n",
+             FilterTuner::AXIS_NAMES[axis]);
+    }
+  }
+  printf("\n%zu evaluations in %.2f s\n", evaluator.getEvaluations(), elapsed);
+
+  if (options.output.empty()) return 0;
+
+  // Профиль TUNED - только если он заметно лучше имеющихся
+  double limit = presetScores[bestPreset].score * (1.0 - options.minGain);
+  if (best.score.score >= limit) {
+    printf("Search is not %.0f%% better than %s (%.3f vs %.3f), "
+           "%s not written\n",
+           options.minGain * 100.0, presets[bestPreset].name.c_str(),
+           best.score.score, presetScores[bestPreset].score,
+           options.output.c_str());
+    return 0;
+  }
+  return writeHeader(options, sources, best, presets, presetScores) ? 0 : 1;
+}
@@ -0,0 +1,434 @@
+// udp_receiver.cpp
+// Приёмник UDP телеметрии уровня на ПК: потери, дубли, порядок, задержка
+//
+// Сборка (Linux/macOS):
+//   g++ -std=c++11 -O2 -pthread -I src -o udp_receiver
+//       tools/udp_receiver/udp_receiver.cpp
+//
+// Запуск:
+//   ./udp_receiver                         # broadcast, порт 4210
+//   ./udp_receiver --group 239.255.76.86   # multicast
+//   ./udp_receiver --port 5000 --print     # печатать каждый кадр
+//   ./udp_receiver --selftest              # проверка через loopback
+//
+// Метка времени в кадре - micros() устройства, часы не синхронизированы.
+// Поэтому для устройства выводится задержка относительно минимальной
+// (джиттер доставки). В режиме --selftest отправитель использует те же
+// часы, что и приёмник, и задержка абсолютная.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TelemetryFrame.h"
+
+namespace {
+
+uint32_t hostMicros() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<microseconds>(
+             steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Учёт последовательности кадров
+ *
+ * Потерянным считается кадр, номер которого меньше максимального
+ * полученного и который так и не пришёл. Опоздавший кадр уменьшает
+ * счётчик потерь и засчитывается как "не по порядку".
+ */
+class SequenceTracker {
+ public:
+  // Скачок номера назад больше этого - устройство перезагрузилось
+  static const int32_t RESTART_THRESHOLD = 1000;
+  static const uint32_t WINDOW = 4096;  // Окно обнаружения дублей
+
+  SequenceTracker() { reset(); }
+
+  void reset() {
+    started = false;
+    firstSeq = highestSeq = 0;
+    unique = duplicates = reordered = restarts = 0;
+    seen.assign(WINDOW, false);
+  }
+
+  void add(uint32_t seq) {
+    if (!started) {
+      started = true;
+      firstSeq = highestSeq = seq;
+      mark(seq);
+      unique = 1;
+      return;
+    }
+
+    int32_t diff = (int32_t)(seq - highestSeq);
+    if (diff < -RESTART_THRESHOLD) {
+      uint32_t keptRestarts = restarts + 1;
+      reset();
+      restarts = keptRestarts;
+      add(seq);
+      return;
+    }
+
+    if (diff > 0) {
+      // Очищаем окно для пропущенных номеров
+      uint32_t clear = std::min<uint32_t>((uint32_t)diff, WINDOW);
+      for (uint32_t i = 1; i <= clear; i++) {
+        seen[(highestSeq + i) % WINDOW] = false;
+      }
+      highestSeq = seq;
+      mark(seq);
+      unique++;
+      return;
+    }
+
+    // Номер не больше максимального: дубль или опоздавший
+    if ((uint32_t)(-diff) >= WINDOW || seen[seq % WINDOW]) {
+      duplicates++;
+      return;
+    }
+    mark(seq);
+    unique++;
+    reordered++;
+  }
+
+  uint64_t expected() const {
+    return started ? (uint64_t)(highestSeq - firstSeq) + 1 : 0;
+  }
+  uint64_t lost() const { return expected() - unique; }
+  uint64_t received() const { return unique; }
+  uint64_t duplicateCount() const { return duplicates; }
+  uint64_t reorderedCount() const { return reordered; }
+  uint32_t restartCount() const { return restarts; }
+
+ private:
+  bool started;
+  uint32_t firstSeq;
+  uint32_t highestSeq;
+  uint64_t unique;
+  uint64_t duplicates;
+  uint64_t reordered;
+  uint32_t restarts;
+  std::vector<bool> seen;
+
+  void mark(uint32_t seq) { seen[seq % WINDOW] = true; }
+};
+
+/**
+ * @brief Задержка доставки: (время приёма - метка кадра)
+ *
+ * Смещение часов неизвестно, поэтому из каждого значения вычитается
+ * минимальное за всё время: остаётся задержка сверх самой быстрой.
+ */
+class LatencyTracker {
+ public:
+  explicit LatencyTracker(bool absolute)
+      : absolute(absolute), haveMin(false), minOffset(0) {}
+
+  void add(uint32_t frameMicros, uint32_t recvMicros) {
+    int64_t offset = (int32_t)(recvMicros - frameMicros);
+    if (!haveMin || offset < minOffset) {
+      minOffset = offset;
+      haveMin = true;
+    }
+    offsets.push_back(offset);
+  }
+
+  // Сводка за интервал, затем интервал очищается
+  void report(char* out, size_t size) {
+    if (offsets.empty()) {
+      snprintf(out, size, "latency n/a");
+      return;
+    }
+
+    std::vector<int64_t> values;
+    values.reserve(offsets.size());
+    int64_t base = absolute ? 0 : minOffset;
+    for (size_t i = 0; i < offsets.size(); i++) {
+      values.push_back(offsets[i] - base);
+    }
+    std::sort(values.begin(), values.end());
+
+    snprintf(out, size, "%s p50=%lld p99=%lld max=%lld us",
+             absolute ? "latency" : "jitter", (long long)quantile(values, 0.5),
+             (long long)quantile(values, 0.99), (long long)values.back());
+    offsets.clear();
+  }
+
+ private:
+  bool absolute;
+  bool haveMin;
+  int64_t minOffset;
+  std::vector<int64_t> offsets;
+
+  static int64_t quantile(const std::vector<int64_t>& sorted, double q) {
+    size_t index = (size_t)(q * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+  }
+};
+
+struct Options {
+  uint16_t port = TELEMETRY_DEFAULT_PORT;
+  std::string group;
+  uint32_t reportMs = 1000;
+  bool print = false;
+  bool selftest = false;
+  uint32_t selftestFrames = 5000;
+};
+
+void usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s [--port N] [--group ADDR] [--report-ms N] [--print]\n"
+          "       %s --selftest [--port N] [--frames N]\n",
+          name, name);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (arg == "--port" && hasValue) {
+      options.port = (uint16_t)atoi(argv[++i]);
+    } else if (arg == "--group" && hasValue) {
+      options.group = argv[++i];
+    } else if (arg == "--report-ms" && hasValue) {
+      options.reportMs = (uint32_t)atoi(argv[++i]);
+    } else if (arg == "--frames" && hasValue) {
+      options.selftestFrames = (uint32_t)atoi(argv[++i]);
+    } else if (arg == "--print") {
+      options.print = true;
+    } else if (arg == "--selftest") {
+      options.selftest = true;
+    } else {
+      return false;
+    }
+  }
+  return options.port != 0 && options.reportMs > 0;
+}
+
+int openSocket(const Options& options) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    perror("socket");
+    return -1;
+  }
+
+  int yes = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  int bufferSize = 1 << 20;
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+#ifdef SO_REUSEPORT
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+#endif
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(options.port);
+  addr.sin_addr.s_addr = htonl(options.selftest ? INADDR_LOOPBACK : INADDR_ANY);
+  if (bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    perror("bind");
+    close(sock);
+    return -1;
+  }
+
+  if (!options.group.empty()) {
+    ip_mreq request;
+    memset(&request, 0, sizeof(request));
+    if (inet_pton(AF_INET, options.group.c_str(), &request.imr_multiaddr) != 1) {
+      fprintf(stderr, "Invalid multicast group: %s\n", options.group.c_str());
+      close(sock);
+      return -1;
+    }
+    request.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request,
+                   sizeof(request)) < 0) {
+      perror("IP_ADD_MEMBERSHIP");
+      close(sock);
+      return -1;
+    }
+  }
+
+  // Таймаут, чтобы отчёт печатался и без входящих кадров
+  timeval timeout;
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 100000;
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  return sock;
+}
+
+/**
+ * @brief Отправитель для self-test: пропуски, дубли и перестановки
+ *
+ * Каждый 50-й номер пропускается, каждый 97-й отправляется дважды,
+ * пары с номером, кратным 31, меняются местами.
+ */
+void runSelftestSender(uint16_t port, uint32_t frames,
+                       std::atomic<bool>& done, uint64_t& expectedLost,
+                       uint64_t& expectedDuplicates) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  uint8_t buffer[TELEMETRY_FRAME_SIZE];
+  auto sendFrame = [&](uint32_t seq) {
+    TelemetryFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.flags = TELEMETRY_FLAG_VALID;
+    frame.sequence = seq;
+    frame.timestampUs = hostMicros();
+    frame.roll = (float)(seq % 9000) / 100.0f - 45.0f;
+    frame.accelZ = 9.81f;
+    size_t length = encodeTelemetryFrame(frame, buffer);
+    sendto(sock, buffer, length, 0, (sockaddr*)&addr, sizeof(addr));
+  };
+
+  expectedLost = 0;
+  expectedDuplicates = 0;
+  for (uint32_t seq = 0; seq < frames; seq++) {
+    if (seq % 50 == 49 && seq + 1 < frames) {
+      expectedLost++;  // Последний кадр не пропускаем: иначе это не потеря
+      continue;
+    }
+    if (seq % 31 == 30 && seq + 1 < frames && (seq + 1) % 50 != 49) {
+      sendFrame(seq + 1);  // Перестановка пары
+      sendFrame(seq);
+      seq++;
+      continue;
+    }
+    sendFrame(seq);
+    if (seq % 97 == 96) {
+      sendFrame(seq);
+      expectedDuplicates++;
+    }
+    // Пачками по 10: не переполняем буфер сокета приёмника
+    if (seq % 10 == 9) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  close(sock);
+  done = true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  int sock = openSocket(options);
+  if (sock < 0) return 1;
+
+  std::atomic<bool> senderDone(false);
+  uint64_t expectedLost = 0, expectedDuplicates = 0;
+  std::thread sender;
+  if (options.selftest) {
+    sender = std::thread(runSelftestSender, options.port,
+                         options.selftestFrames, std::ref(senderDone),
+                         std::ref(expectedLost), std::ref(expectedDuplicates));
+    printf("Self-test: %u frames over loopback, port %u\n",
+           options.selftestFrames, options.port);
+  } else {
+    printf("Listening on UDP port %u%s%s\n", options.port,
+           options.group.empty() ? "" : ", group ", options.group.c_str());
+  }
+
+  SequenceTracker sequence;
+  LatencyTracker latency(options.selftest);
+  uint64_t foreign = 0;  // Чужие/битые пакеты
+  uint64_t intervalFrames = 0;
+  uint32_t lastReport = hostMicros();
+  uint32_t idleSince = 0;
+
+  uint8_t buffer[512];
+  while (true) {
+    ssize_t length = recv(sock, buffer, sizeof(buffer), 0);
+    uint32_t now = hostMicros();
+
+    if (length > 0) {
+      TelemetryFrame frame;
+      if (!decodeTelemetryFrame(buffer, (size_t)length, frame)) {
+        foreign++;
+      } else {
+        sequence.add(frame.sequence);
+        latency.add(frame.timestampUs, now);
+        intervalFrames++;
+        idleSince = 0;
+
+        if (options.print) {
+          printf("#%u t=%u roll=%.2f pitch=%.2f acc=%.2f,%.2f,%.2f "
+                 "mag=%.1f,%.1f,%.1f%s\n",
+                 frame.sequence, frame.timestampUs, frame.roll, frame.pitch,
+                 frame.accelX, frame.accelY, frame.accelZ, frame.magX,
+                 frame.magY, frame.magZ,
+                 (frame.flags & TELEMETRY_FLAG_VALID) ? "" : " (invalid)");
+        }
+      }
+    } else if (options.selftest && senderDone) {
+      // Отправитель закончил и входящих больше нет
+      if (idleSince == 0) idleSince = now;
+      if (now - idleSince > 300000) break;
+    }
+
+    if (now - lastReport >= options.reportMs * 1000) {
+      char latencyText[96];
+      latency.report(latencyText, sizeof(latencyText));
+      double seconds = (now - lastReport) / 1e6;
+      printf("rate=%.1f Hz received=%llu lost=%llu (%.2f%%) dup=%llu "
+             "reordered=%llu restarts=%u foreign=%llu %s\n",
+             intervalFrames / seconds, (unsigned long long)sequence.received(),
+             (unsigned long long)sequence.lost(),
+             sequence.expected() > 0
+                 ? 100.0 * sequence.lost() / sequence.expected()
+                 : 0.0,
+             (unsigned long long)sequence.duplicateCount(),
+             (unsigned long long)sequence.reorderedCount(),
+             sequence.restartCount(), (unsigned long long)foreign,
+             latencyText);
+      fflush(stdout);
+      lastReport = now;
+      intervalFrames = 0;
+    }
+  }
+
+  sender.join();
+  close(sock);
+
+  char latencyText[96];
+  latency.report(latencyText, sizeof(latencyText));
+  printf("Self-test result: received=%llu lost=%llu (expected %llu) "
+         "dup=%llu (expected %llu) reordered=%llu %s\n",
+         (unsigned long long)sequence.received(),
+         (unsigned long long)sequence.lost(), (unsigned long long)expectedLost,
+         (unsigned long long)sequence.duplicateCount(),
+         (unsigned long long)expectedDuplicates,
+         (unsigned long long)sequence.reorderedCount(), latencyText);
+
+  // Loopback без нагрузки не теряет пакетов: расхождение - ошибка учёта
+  bool ok = sequence.lost() == expectedLost &&
+            sequence.duplicateCount() == expectedDuplicates &&
+            sequence.reorderedCount() > 0;
+  printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}